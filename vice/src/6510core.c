@@ -52,10 +52,6 @@
 
 #include "traps.h"
 
-#ifndef DRIVE_CPU
-#include "profiler.h"
-#endif
-
 #ifndef C64DTV
 /* The C64DTV can use different shadow registers for accu read/write. */
 /* For standard 6510, this is not the case. */
@@ -371,25 +367,26 @@
 #endif
 #endif
 
-#if !defined(DRIVE_CPU)
+/* the including file defines PROFILER to the profiler_cpu_t of the CPU */
+#ifdef PROFILER
 #define CHECK_PROFILE_INTERRUPT(dest_addr, handler)                        \
 do {                                                                   \
-        profile_int(dest_addr, handler, reg_sp + 1, CLK - profiling_clock_start); \
+        profile_int(PROFILER, dest_addr, handler, (uint8_t)(reg_sp + 1), CLK - profiling_clock_start); \
 } while (0)
 
 #define CHECK_PROFILE_JSR(dest_addr)     \
     do {                                 \
-        profile_jsr(dest_addr, reg_pc, reg_sp); \
+        profile_jsr(PROFILER, dest_addr, reg_pc, reg_sp); \
 } while (0)
 
 #define CHECK_PROFILE_RTS()      \
     do {                         \
-            profile_rtx(reg_sp); \
+            profile_rtx(PROFILER, reg_sp); \
     } while (0)
 
 #define CHECK_PROFILE_RTI()          \
         do {                             \
-            profile_rtx(reg_sp + 1); \
+            profile_rtx(PROFILER, (uint8_t)(reg_sp + 1)); \
     } while (0)
 
 #else
@@ -2275,7 +2272,7 @@ static const uint8_t rewind_fetch_tab[] = {
 #warning "CPU_IS_JAMMED not defined, using default (internal)"
 #endif
     unsigned int tmpa; /* needed for some of the opcode macros */
-#if !defined(DRIVE_CPU)
+#ifdef PROFILER
     CLOCK profiling_clock_start;
 #endif
 
@@ -2313,7 +2310,7 @@ static const uint8_t rewind_fetch_tab[] = {
 
         pending_interrupt = CPU_INT_STATUS->global_pending_int;
         if (pending_interrupt != IK_NONE) {
-#if !defined(DRIVE_CPU)
+#ifdef PROFILER
             profiling_clock_start = CLK;
 #endif
 
@@ -2349,10 +2346,10 @@ static const uint8_t rewind_fetch_tab[] = {
 #endif
 #endif
 
-#if !defined(DRIVE_CPU)
+#ifdef PROFILER
         profiling_clock_start = CLK;
-        if (maincpu_profiling) {
-            profile_sample_start(reg_pc);
+        if (PROFILER->profiling) {
+            profile_sample_start(PROFILER, reg_pc);
         }
 #endif
 
@@ -3432,9 +3429,9 @@ trap_skipped:
                 break;
         }
 
-#if !defined(DRIVE_CPU)
-        if (maincpu_profiling) {
-            profile_sample_finish(CLK - profiling_clock_start, 0 /* stolen_cycles */);
+#ifdef PROFILER
+        if (PROFILER->profiling) {
+            profile_sample_finish(PROFILER, CLK - profiling_clock_start, 0 /* stolen_cycles */);
         }
 #endif
 
@@ -50,8 +50,6 @@
 
 #include "traps.h"
 
-#include "profiler.h"
-
 #ifndef C64DTV
 /* The C64DTV can use different shadow registers for accu read/write. */
 /* For standard 6510, this is not the case. */
@@ -254,22 +252,22 @@
 #if !defined(DRIVE_CPU)
 #define CHECK_PROFILE_INTERRUPT(dest_addr, handler)                        \
     do {                                                                   \
-            profile_int(dest_addr, handler, reg_sp + 1, CLK - profiling_clock_start); \
+            profile_int(PROFILER, dest_addr, handler, (uint8_t)(reg_sp + 1), CLK - profiling_clock_start); \
     } while (0)
 
 #define CHECK_PROFILE_JSR(dest_addr)     \
     do {                                 \
-            profile_jsr(dest_addr, reg_pc, reg_sp); \
+            profile_jsr(PROFILER, dest_addr, reg_pc, reg_sp); \
     } while (0)
 
 #define CHECK_PROFILE_RTS()      \
     do {                         \
-            profile_rtx(reg_sp); \
+            profile_rtx(PROFILER, reg_sp); \
     } while (0)
 
 #define CHECK_PROFILE_RTI()          \
     do {                             \
-            profile_rtx(reg_sp + 1); \
+            profile_rtx(PROFILER, (uint8_t)(reg_sp + 1)); \
     } while (0)
 
 #else
@@ -1768,8 +1766,8 @@ static const uint8_t fetch_tab[] = {
 #if !defined(DRIVE_CPU)
         profiling_clock_start = CLK;
         stolen_cycles = 0;
-        if (maincpu_profiling) {
-            profile_sample_start(reg_pc);
+        if (PROFILER->profiling) {
+            profile_sample_start(PROFILER, reg_pc);
         }
 #endif
 
@@ -2756,8 +2754,8 @@ trap_skipped:
         }
 
 #if !defined(DRIVE_CPU)
-        if (maincpu_profiling) {
-            profile_sample_finish(CLK - profiling_clock_start - stolen_cycles, stolen_cycles);
+        if (PROFILER->profiling) {
+            profile_sample_finish(PROFILER, CLK - profiling_clock_start - stolen_cycles, stolen_cycles);
         }
 #endif
 
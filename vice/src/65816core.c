@@ -344,6 +344,36 @@
 #define TRACE_COP()
 #endif
 
+/* the including file defines PROFILER to the profiler_cpu_t of the CPU.
+   Interrupts are executed as pseudo opcodes inside the instruction loop,
+   so their cycles are sampled together with the instruction.  */
+#ifdef PROFILER
+#define CHECK_PROFILE_INTERRUPT(dest_addr, handler)                                         \
+    do {                                                                                    \
+        profile_jsr(PROFILER, (uint16_t)(dest_addr), handler, (uint16_t)(reg_sp + 1));      \
+    } while (0)
+
+#define CHECK_PROFILE_JSR(dest_addr, src_addr)                                              \
+    do {                                                                                    \
+        profile_jsr(PROFILER, (uint16_t)(dest_addr), (uint16_t)(src_addr), (uint16_t)reg_sp); \
+    } while (0)
+
+#define CHECK_PROFILE_RTS()                            \
+    do {                                               \
+        profile_rtx(PROFILER, (uint16_t)reg_sp);       \
+    } while (0)
+
+#define CHECK_PROFILE_RTI()                            \
+    do {                                               \
+        profile_rtx(PROFILER, (uint16_t)(reg_sp + 1)); \
+    } while (0)
+#else
+#define CHECK_PROFILE_INTERRUPT(dest_addr, handler)
+#define CHECK_PROFILE_JSR(dest_addr, src_addr)
+#define CHECK_PROFILE_RTS()
+#define CHECK_PROFILE_RTI()
+#endif
+
 /* Perform the interrupts in `int_kind'.  If we have both NMI and IRQ,
    execute NMI.  */
 #define DO_INTERRUPT(ik)                                                       \
@@ -1556,6 +1586,7 @@
       }                               \
       reg_pbr = 0;                    \
       JUMP(reg_pc);                   \
+      CHECK_PROFILE_INTERRUPT(reg_pc, 0xfffe);\
   } while (0)
 
 #define CLC()                    \
@@ -1650,6 +1681,7 @@
       }                               \
       reg_pbr = 0;                    \
       JUMP(reg_pc);                   \
+      CHECK_PROFILE_INTERRUPT(reg_pc, 0xfffe);\
   } while (0)
 
 #define CPX(load_func) CMPI(load_func, reg_x)
@@ -1751,6 +1783,7 @@
       }                                       \
       reg_pbr = 0;                            \
       JUMP(reg_pc);                           \
+      CHECK_PROFILE_INTERRUPT(reg_pc, 0xfffe);\
   } while (0)
 
 #define JMP()                        \
@@ -1835,13 +1868,14 @@
       CHECK_INTERRUPT();             \
       PUSH(reg_pc >> 8);             \
       PUSH(reg_pc);                  \
+      CHECK_PROFILE_JSR(p1 + p2, reg_pc); \
       reg_pc = p1 + p2;              \
       JUMP(reg_pc);                  \
   } while (0)
 
 #define JSR_IND_X()                                  \
   do {                                               \
-      unsigned int ea;                               \
+      unsigned int ea, src;                          \
                                                      \
       INC_PC(SIZE_1);                                \
       p1 = FETCH_PARAM(reg_pc);                      \
@@ -1853,8 +1887,10 @@
       ea = (p1 + p2 + reg_x) & 0xffff;               \
       FETCH_PARAM_DUMMY(reg_pc);                     \
       CHECK_INTERRUPT();                             \
+      src = reg_pc;                                  \
       reg_pc = FETCH_PARAM(ea);                      \
       reg_pc |= FETCH_PARAM((ea + 1) & 0xffff) << 8; \
+      CHECK_PROFILE_JSR(reg_pc, src);                \
       JUMP(reg_pc);                                  \
   } while (0)
 
@@ -1874,6 +1910,7 @@
       STORE_LONG(reg_sp, reg_pc >> 8); \
       reg_sp--;                        \
       PUSH(reg_pc);                    \
+      CHECK_PROFILE_JSR(p1 + p2, reg_pc - 1); \
       reg_pc = p1 + p2;                \
       JUMP(reg_pc);                    \
   } while (0)
@@ -1985,6 +2022,7 @@
       }                                       \
       reg_pbr = 0;                            \
       JUMP(reg_pc);                           \
+      CHECK_PROFILE_INTERRUPT(reg_pc, 0xfffa);\
   } while (0)
 
 #define NOP()                    \
@@ -2207,6 +2245,7 @@
       CHECK_INTERRUPT();                                 \
       LOAD_INT_ADDR(0xfffc);                             \
       JUMP(reg_pc);                                      \
+      CHECK_PROFILE_INTERRUPT(reg_pc, 0xfffc);           \
       DMA_ON_RESET;                                      \
   } while (0)
 
@@ -2218,6 +2257,7 @@
   do {                           \
       unsigned int tmp;          \
                                  \
+      CHECK_PROFILE_RTI();       \
       INC_PC(SIZE_1);            \
       FETCH_PARAM_DUMMY(reg_pc); \
       FETCH_PARAM_DUMMY(reg_pc); \
@@ -2242,6 +2282,7 @@
 
 #define RTL()                               \
   do {                                      \
+      CHECK_PROFILE_RTS();                  \
       INC_PC(SIZE_1);                       \
       FETCH_PARAM_DUMMY(reg_pc);            \
       FETCH_PARAM_DUMMY(reg_pc);            \
@@ -2261,6 +2302,7 @@
 
 #define RTS()                    \
   do {                           \
+      CHECK_PROFILE_RTS();       \
       INC_PC(SIZE_1);            \
       FETCH_PARAM_DUMMY(reg_pc); \
       FETCH_PARAM_DUMMY(reg_pc); \
@@ -2552,6 +2594,9 @@
         unsigned int p1 = 0;
         unsigned int p2 = 0;
         unsigned int p3 = 0;
+#ifdef PROFILER
+        CLOCK profiling_clock_start = CLK;
+#endif
 #ifdef DEBUG
         CLOCK debug_clk = 0;
         unsigned int debug_pc = 0;
@@ -2590,6 +2635,12 @@
         }
         SET_LAST_ADDR(reg_pc);
 
+#ifdef PROFILER
+        if (PROFILER->profiling) {
+            profile_sample_start(PROFILER, (uint16_t)reg_pc);
+        }
+#endif
+
 #ifdef DEBUG
         if (debug.perform_break_into_monitor)
         {
@@ -3640,6 +3691,12 @@ trap_skipped:
             RES();
             break;
         }
+
+#ifdef PROFILER
+        if (PROFILER->profiling) {
+            profile_sample_finish(PROFILER, CLK - profiling_clock_start, 0 /* stolen_cycles */);
+        }
+#endif
 #ifdef DEBUG
         if (TRACEFLG && p0 < 0x100) {
             uint8_t op = (uint8_t)(p0);
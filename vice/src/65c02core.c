@@ -291,6 +291,34 @@
 #define TRACE_BRK()
 #endif
 
+/* the including file defines PROFILER to the profiler_cpu_t of the CPU */
+#ifdef PROFILER
+#define CHECK_PROFILE_INTERRUPT(dest_addr, handler)                                                  \
+    do {                                                                                             \
+        profile_int(PROFILER, dest_addr, handler, (uint8_t)(reg_sp + 1), CLK - profiling_clock_start); \
+    } while (0)
+
+#define CHECK_PROFILE_JSR(dest_addr)                      \
+    do {                                                  \
+        profile_jsr(PROFILER, dest_addr, reg_pc, reg_sp); \
+    } while (0)
+
+#define CHECK_PROFILE_RTS()                \
+    do {                                   \
+        profile_rtx(PROFILER, reg_sp);     \
+    } while (0)
+
+#define CHECK_PROFILE_RTI()                               \
+    do {                                                  \
+        profile_rtx(PROFILER, (uint8_t)(reg_sp + 1));     \
+    } while (0)
+#else
+#define CHECK_PROFILE_INTERRUPT(dest_addr, handler)
+#define CHECK_PROFILE_JSR(dest_addr)
+#define CHECK_PROFILE_RTS()
+#define CHECK_PROFILE_RTI()
+#endif
+
 /* Perform the interrupts in `int_kind'.  If we have both NMI and IRQ,
    execute NMI. NMI can _not_ take over an in progress IRQ. */
 /* FIXME: LOCAL_STATUS() should check byte ready first.  */
@@ -321,6 +349,7 @@
                 LOCAL_SET_DECIMAL(0);                                                                         \
                 LOCAL_SET_INTERRUPT(1);                                                                       \
                 JUMP(LOAD_ADDR(0xfffa));                                                                      \
+                CHECK_PROFILE_INTERRUPT(reg_pc, 0xfffa);                                                      \
                 SET_LAST_OPCODE(0);                                                                           \
                 CLK_ADD(CLK, 2);                                                                              \
             }                                                                                                 \
@@ -346,6 +375,7 @@
                 LOCAL_SET_DECIMAL(0);                                                                         \
                 LOCAL_SET_INTERRUPT(1);                                                                       \
                 JUMP(LOAD_ADDR(0xfffe));                                                                      \
+                CHECK_PROFILE_INTERRUPT(reg_pc, 0xfffe);                                                      \
                 SET_LAST_OPCODE(0);                                                                           \
                 CLK_ADD(CLK, 2);                                                                              \
             }                                                                                                 \
@@ -365,6 +395,7 @@
                 bank_start = bank_limit = 0; /* prevent caching */                                            \
                 LOCAL_SET_INTERRUPT(1);                                                                       \
                 JUMP(LOAD_ADDR(0xfffc));                                                                      \
+                CHECK_PROFILE_INTERRUPT(reg_pc, 0xfffc);                                                      \
                 DMA_ON_RESET;                                                                                 \
             }                                                                                                 \
         }                                                                                                     \
@@ -725,6 +756,7 @@
         LOCAL_SET_DECIMAL(0);    \
         LOCAL_SET_INTERRUPT(1);  \
         JUMP(LOAD_ADDR(0xfffe)); \
+        CHECK_PROFILE_INTERRUPT(reg_pc, 0xfffe); \
         CLK_ADD(CLK, CYCLES_2);  \
     } while (0)
 
@@ -926,6 +958,7 @@
         PUSH((reg_pc) & 0xff);                 \
         tmp_addr = (p1 | (LOAD(reg_pc) << 8)); \
         CLK_ADD(CLK, CYCLES_1);                \
+        CHECK_PROFILE_JSR(tmp_addr);           \
         JUMP(tmp_addr);                        \
     } while (0)
 
@@ -1177,6 +1210,7 @@
     do {                             \
         uint16_t tmp;                    \
                                      \
+        CHECK_PROFILE_RTI();         \
         LOAD(reg_sp | 0x100);        \
         CLK_ADD(CLK, CYCLES_4);      \
         tmp = (uint16_t)PULL();          \
@@ -1190,6 +1224,7 @@
     do {                           \
         uint16_t tmp;                  \
                                    \
+        CHECK_PROFILE_RTS();       \
         LOAD(reg_sp | 0x100);      \
         CLK_ADD(CLK, CYCLES_3);    \
         tmp = PULL();              \
@@ -1600,6 +1635,10 @@
 /* Here, the CPU is emulated. */
 
 {
+#ifdef PROFILER
+    CLOCK profiling_clock_start;
+#endif
+
     CPU_DELAY_CLK;
 
     PROCESS_ALARMS;
@@ -1615,6 +1654,9 @@
 
         pending_interrupt = CPU_INT_STATUS->global_pending_int;
         if (pending_interrupt != IK_NONE) {
+#ifdef PROFILER
+            profiling_clock_start = CLK;
+#endif
             DO_INTERRUPT(pending_interrupt);
             if (!(CPU_INT_STATUS->global_pending_int & IK_IRQ)
                 && CPU_INT_STATUS->global_pending_int & IK_IRQPEND) {
@@ -1646,6 +1688,14 @@
         history_clk = CLK;
 #endif
 #endif
+
+#ifdef PROFILER
+        profiling_clock_start = CLK;
+        if (PROFILER->profiling) {
+            profile_sample_start(PROFILER, reg_pc);
+        }
+#endif
+
         SET_LAST_ADDR(reg_pc);
         FETCH_OPCODE(opcode);
 
@@ -2591,5 +2641,11 @@ trap_skipped:
                 BBS(BIT_7);
                 break;
         }
+
+#ifdef PROFILER
+        if (PROFILER->profiling) {
+            profile_sample_finish(PROFILER, CLK - profiling_clock_start, 0 /* stolen_cycles */);
+        }
+#endif
     }
 }
@@ -2,7 +2,8 @@
  * \brief   Simplified stat(2) call
  * \author  Bas Wassink <b.wassink@ziggo.nl>
  *
- * Determine if file exists, its length and if its a directory.
+ * Determine if file exists, its length and if its a directory, or query its
+ * modification time.
  *
  */
 
@@ -69,3 +70,27 @@ int archdep_stat(const char *path, size_t *len, unsigned int *isdir)
     }
     return 0;
 }
+
+
+/** \brief  Get the modification time of \a path
+ *
+ * Used by callers that cache information derived from a directory listing,
+ * the mtime of a directory changes whenever an entry is added, removed or
+ * renamed.
+ *
+ * \param[in]   path    pathname
+ * \param[out]  mtime   modification time of \a path
+ *
+ * \return  0 on success, -1 on failure
+ */
+int archdep_stat_mtime(const char *path, time_t *mtime)
+{
+    struct stat statbuf;
+
+    if (stat(path, &statbuf) < 0) {
+        *mtime = 0;
+        return -1;
+    }
+    *mtime = statbuf.st_mtime;
+    return 0;
+}
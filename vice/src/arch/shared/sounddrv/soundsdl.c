@@ -47,12 +47,43 @@ static volatile int sdl_inptr = 0;
 static volatile int sdl_outptr = 0;
 static volatile int sdl_full = 0;
 static int sdl_len = 0;
+static int sdl_ring = 0;    /* play from the ring of the sound core */
+
+#if defined(WORDS_BIGENDIAN) && (!defined(HAVE_SWAB) || defined(BEOS_COMPILE))
+void swab(void *src, void *dst, size_t length)
+{
+    const char *from = src;
+    char *to = dst;
+    size_t ptr;
+
+    for (ptr = 1; ptr < length; ptr += 2) {
+        char p = from[ptr];
+        char q = from[ptr - 1];
+        to[ptr - 1] = p;
+        to[ptr] = q;
+    }
+
+    if (ptr == length) {
+        to[ptr - 1] = 0;
+    }
+}
+#endif
 
 static void sdl_callback(void *userdata, Uint8 *stream, int len)
 {
     int amount, total;
     total = 0;
 
+    if (sdl_ring) {
+        sound_ring_read((int16_t *)stream, (size_t)len / sizeof(int16_t));
+#ifdef WORDS_BIGENDIAN
+        if (sdl_spec.format != AUDIO_S16MSB) {
+            swab(stream, stream, (size_t)len);
+        }
+#endif
+        return;
+    }
+
     while (total < (len / (int)sizeof(int16_t))) {
         amount = sdl_inptr - sdl_outptr;
         if (amount <= 0) {
@@ -161,30 +192,11 @@ static int sdl_init(const char *param, int *speed,
     *speed = sdl_spec.freq;
     *fragsize = sdl_spec.samples;
     *fragnr = nr;
+    sdl_ring = (sound_ring_attach() == 0);
     SDL_PauseAudio(0);
     return 0;
 }
 
-#if defined(WORDS_BIGENDIAN) && (!defined(HAVE_SWAB) || defined(BEOS_COMPILE))
-void swab(void *src, void *dst, size_t length)
-{
-    const char *from = src;
-    char *to = dst;
-    size_t ptr;
-
-    for (ptr = 1; ptr < length; ptr += 2) {
-        char p = from[ptr];
-        char q = from[ptr - 1];
-        to[ptr - 1] = p;
-        to[ptr] = q;
-    }
-
-    if (ptr == length) {
-        to[ptr - 1] = 0;
-    }
-}
-#endif
-
 static int sdl_write(int16_t *pbuf, size_t nr)
 {
     int total, amount;
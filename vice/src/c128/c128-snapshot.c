@@ -33,6 +33,7 @@
 #include "c128memsnapshot.h"
 #include "c128.h"
 #include "cia.h"
+#include "datasette.h"
 #include "drive-snapshot.h"
 #include "drive.h"
 #include "serial.h"
@@ -69,6 +70,9 @@ int c128_snapshot_write(const char *name, int save_roms, int save_disks, int eve
 
     sound_snapshot_prepare();
 
+    /* Deliver coalesced tape pulses before the CIA is saved.  */
+    datasette_flux_catch_up(TAPEPORT_PORT_1);
+
     if (maincpu_snapshot_write_module(s) < 0
         || c128_snapshot_write_module(s, save_roms) < 0
         || ciacore_snapshot_write_module(machine_context.cia1, s) < 0
@@ -36,6 +36,7 @@
 #include "c64.h"
 #include "c64cia.h"
 #include "cia.h"
+#include "datasette.h"
 #include "drive.h"
 #include "interrupt.h"
 #include "joyport.h"
@@ -45,6 +46,7 @@
 #include "log.h"
 #include "machine.h"
 #include "maincpu.h"
+#include "tapeport.h"
 #include "types.h"
 #include "userport.h"
 #include "vicii.h"
@@ -55,6 +57,15 @@
 
 void cia1_store(uint16_t addr, uint8_t data)
 {
+    if ((addr & 0xf) == CIA_ICR) {
+        /* deliver pending tape pulses before the mask changes, and stop
+           coalescing them if the FLAG interrupt gets enabled */
+        datasette_flux_catch_up(TAPEPORT_PORT_1);
+        ciacore_store(machine_context.cia1, addr, data);
+        datasette_flux_catch_up(TAPEPORT_PORT_1);
+        return;
+    }
+
     ciacore_store(machine_context.cia1, addr, data);
 }
 
@@ -65,6 +76,9 @@ uint8_t cia1_read(uint16_t addr)
 
 uint8_t cia1_peek(uint16_t addr)
 {
+    if ((addr & 0xf) == CIA_ICR) {
+        datasette_flux_catch_up(TAPEPORT_PORT_1);
+    }
     return ciacore_peek(machine_context.cia1, addr);
 }
 
@@ -252,6 +266,7 @@ static uint8_t read_ciapb(cia_context_t *cia_context)
 static void read_ciaicr(cia_context_t *cia_context)
 {
     drive_cpu_execute_all(maincpu_clk);
+    datasette_flux_catch_up(TAPEPORT_PORT_1);
 }
 
 static void read_sdr(cia_context_t *cia_context)
@@ -1346,6 +1346,30 @@ void top_shared_store(uint16_t addr, uint8_t value)
     }
 }
 
+/* Return a pointer to the start of the RAM page the handlers of the given
+   area access in C128 mode, or NULL if the page is relocated by the MMU or a
+   cartridge hooks into the RAM accesses. Used by the Z80 direct access
+   tables, which are rebuilt whenever the MMU configuration changes.  */
+uint8_t *c128_mem_ram_page_ptr(int page, int area)
+{
+    if (in_c64_mode != 0 || page < 2 || page == c128_mem_mmu_page_0 || page == c128_mem_mmu_page_1) {
+        return NULL;
+    }
+
+    switch (area) {
+        case C128_MEM_AREA_RAM:
+            if (c128cartridge_ram_hooked()) {
+                return NULL;
+            }
+            return ram_bank + (page << 8);
+        case C128_MEM_AREA_BOTTOM_SHARED:
+            return (((page << 8) < bottom_shared_limit) ? mem_ram : ram_bank) + (page << 8);
+        case C128_MEM_AREA_TOP_SHARED:
+            return (((page << 8) > top_shared_limit) ? mem_ram : ram_bank) + (page << 8);
+    }
+    return NULL;
+}
+
 /* ------------------------------------------------------------------------- */
 
 void colorram_store(uint16_t addr, uint8_t value)
@@ -955,6 +955,12 @@ uint8_t c128cartridge_ram_store(uint16_t addr, uint8_t value)
     return ret;
 }
 
+/* returns 1 if the cartridge at the port hooks into the RAM accesses */
+int c128cartridge_ram_hooked(void)
+{
+    return cartridge_get_id(0) == CARTRIDGE_LT_KERNAL;
+}
+
 /* mmu translation: return 0 if no translation applied, leave it for the tables */
 int c128cartridge_mmu_translate(unsigned int addr, uint8_t **base, int *start, int *limit, int mem_config)
 {
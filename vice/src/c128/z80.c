@@ -36,7 +36,9 @@
 #include "log.h"
 #include "maincpu.h"
 #include "monitor.h"
+#include "profiler.h"
 #include "types.h"
+#include "viciitypes.h"
 #include "z80.h"
 #include "z80mem.h"
 #include "z80regs.h"
@@ -86,9 +88,54 @@ inline static int z80mem_read_limit(int addr)
         reg_wz = addr;                                  \
     } while (0)
 
-#define LOAD(addr) ((uint32_t)(*_z80mem_read_tab_ptr[(addr) >> 8])((uint16_t)(addr)))
+/* Plain RAM pages are accessed directly, everything else goes through the
+   memory handlers.  */
+inline static uint8_t z80_load(uint32_t addr)
+{
+    uint8_t *p = z80mem_direct_read_tab[addr >> 8];
+
+    if (p != NULL) {
+        vicii.last_cpu_val = p[addr & 0xff];
+        return vicii.last_cpu_val;
+    }
+    return (*_z80mem_read_tab_ptr[addr >> 8])((uint16_t)addr);
+}
+
+inline static void z80_store(uint32_t addr, uint8_t value)
+{
+    uint8_t *p = z80mem_direct_write_tab[addr >> 8];
 
-#define STORE(addr, value) (*_z80mem_write_tab_ptr[(addr) >> 8])((uint16_t)(addr), (uint8_t)(value))
+    if (p != NULL) {
+        vicii.last_cpu_val = value;
+        p[addr & 0xff] = value;
+    } else {
+        (*_z80mem_write_tab_ptr[addr >> 8])((uint16_t)addr, value);
+    }
+}
+
+#define LOAD(addr) ((uint32_t)z80_load((uint32_t)(addr)))
+
+#define STORE(addr, value) z80_store((uint32_t)(addr), (uint8_t)(value))
+
+/* Fetch all four opcode bytes at once if they are in the same RAM page.  */
+#define FETCH_OPCODE(o)                                                           \
+    do {                                                                          \
+        uint8_t *fetch_p = NULL;                                                  \
+                                                                                  \
+        if (z80_reg_pc < 0x10000 && (z80_reg_pc & 0xff) < 0xfd) {                 \
+            fetch_p = z80mem_direct_read_tab[z80_reg_pc >> 8];                    \
+        }                                                                         \
+        if (fetch_p != NULL) {                                                    \
+            fetch_p += z80_reg_pc & 0xff;                                         \
+            (o) = fetch_p[0] | (fetch_p[1] << 8) | (fetch_p[2] << 16) | ((uint32_t)fetch_p[3] << 24); \
+            vicii.last_cpu_val = fetch_p[3];                                      \
+        } else {                                                                  \
+            (o) = (LOAD(z80_reg_pc)                                               \
+                   | (LOAD(z80_reg_pc + 1) << 8)                                  \
+                   | (LOAD(z80_reg_pc + 2) << 16)                                 \
+                   | (LOAD(z80_reg_pc + 3) << 24));                               \
+        }                                                                         \
+    } while (0)
 
 /* undefine IN and OUT first for platforms that have them already defined as something else */
 #undef IN
@@ -137,6 +184,7 @@ void z80_clock_stretch(void)
 
 #define Z80_SET_DMA_REQUEST(x) dma_request = x;
 #define Z80_LOOP_COND !dma_request
+#define PROFILER (&z80_profiler)
 
 #include "z80core.c"
 
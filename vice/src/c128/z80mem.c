@@ -77,6 +77,12 @@ static int mem_read_limit_tab[NUM_CONFIGS][0x101];
 store_func_ptr_t io_write_tab[0x101];
 read_func_ptr_t io_read_tab[0x101];
 
+/* Direct access tables: pointers to the start of the RAM page for the pages
+   which are plain RAM in the current configuration, NULL if the handlers
+   have to be used.  */
+uint8_t *z80mem_direct_read_tab[0x101];
+uint8_t *z80mem_direct_write_tab[0x101];
+
 /* ------------------------------------------------------------------------- */
 
 /* Generic memory access.  */
@@ -1047,6 +1053,70 @@ void z80mem_initialize(void)
     io_write_tab[0xdf] = z80_c64io_df00_store;
 }
 
+/* Find the RAM area behind a page of the C128 mode memory map, depends on
+   the ROM/RAM selection of the MMU for the ROM areas.  */
+static int z80mem_direct_read_area(read_func_ptr_t f)
+{
+    if (f == ram_read) {
+        return C128_MEM_AREA_RAM;
+    } else if (f == lo_read) {
+        return C128_MEM_AREA_BOTTOM_SHARED;
+    } else if (f == z80mem_lo_rom_area_read) {
+        return (mmu[0] & 2) ? C128_MEM_AREA_RAM : -1;
+    } else if (f == z80mem_mid_rom_area_read) {
+        return (((mmu[0] & 0xc) >> 2) == Z80_C128_RAM) ? C128_MEM_AREA_RAM : -1;
+    } else if (f == z80mem_editor_rom_area_read || f == z80mem_hi_rom_area_read) {
+        return (((mmu[0] & 0x30) >> 4) == Z80_C128_RAM) ? C128_MEM_AREA_TOP_SHARED : -1;
+    } else if (f == z80mem_chargen_rom_area_read) {
+        switch ((mmu[0] & 0x30) >> 4) {
+            case Z80_C128_ROM:
+            case Z80_C128_RAM:
+                return C128_MEM_AREA_TOP_SHARED;
+        }
+    }
+    return -1;
+}
+
+static int z80mem_direct_write_area(store_func_ptr_t f)
+{
+    if (f == ram_store) {
+        return C128_MEM_AREA_RAM;
+    } else if (f == lo_store) {
+        return C128_MEM_AREA_BOTTOM_SHARED;
+    } else if (f == z80mem_lo_rom_area_store) {
+        return (mmu[0] & 2) ? C128_MEM_AREA_RAM : -1;
+    } else if (f == z80mem_mid_rom_area_store) {
+        return (((mmu[0] & 0xc) >> 2) == Z80_C128_RAM) ? C128_MEM_AREA_RAM : -1;
+    } else if (f == z80mem_editor_rom_area_store || f == z80mem_chargen_rom_area_store) {
+        return (((mmu[0] & 0xc) >> 2) == Z80_C128_RAM) ? C128_MEM_AREA_TOP_SHARED : -1;
+    } else if (f == z80mem_hi_rom_area_store) {
+        return (((mmu[0] & 0x30) >> 4) == Z80_C128_RAM) ? C128_MEM_AREA_TOP_SHARED : -1;
+    }
+    return -1;
+}
+
+/* Rebuild the direct access tables, only the C128 mode configurations are
+   handled, the C64 mode ones always use the handlers.  */
+static void z80mem_direct_update(int config)
+{
+    int i, area;
+
+    for (i = 0; i <= 0x100; i++) {
+        z80mem_direct_read_tab[i] = NULL;
+        z80mem_direct_write_tab[i] = NULL;
+        if (config < NUM_Z80_C128MODE_CONFIGS && i < 0x100) {
+            area = z80mem_direct_read_area(mem_read_tab[config][i]);
+            if (area >= 0) {
+                z80mem_direct_read_tab[i] = c128_mem_ram_page_ptr(i, area);
+            }
+            area = z80mem_direct_write_area(mem_write_tab[config][i]);
+            if (area >= 0) {
+                z80mem_direct_write_tab[i] = c128_mem_ram_page_ptr(i, area);
+            }
+        }
+    }
+}
+
 static int c64mode_bit = 0;
 
 void z80mem_update_config(int config)
@@ -1072,6 +1142,8 @@ void z80mem_update_config(int config)
         c64mode_bit = 0;
     }
 
+    z80mem_direct_update(config);
+
     z80_resync_limits();
 }
 
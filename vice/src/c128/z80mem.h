@@ -51,6 +51,10 @@ extern store_func_ptr_t *_z80mem_write_tab_ptr;
 extern uint8_t **_z80mem_read_base_tab_ptr;
 extern int *z80mem_read_limit_tab_ptr;
 
+/* Direct access tables for plain RAM pages, NULL if a handler is needed.  */
+extern uint8_t *z80mem_direct_read_tab[];
+extern uint8_t *z80mem_direct_write_tab[];
+
 uint8_t bios_read(uint16_t addr);
 void bios_store(uint16_t addr, uint8_t value);
 
@@ -35,6 +35,7 @@
 #include "c64gluelogic.h"
 #include "c64memsnapshot.h"
 #include "cia.h"
+#include "datasette.h"
 #include "drive-snapshot.h"
 #include "drive.h"
 #include "serial.h"
@@ -73,6 +74,9 @@ int c64_snapshot_write(const char *name, int save_roms, int save_disks, int even
     /* Execute drive CPUs to get in sync with the main CPU.  */
     drive_cpu_execute_all(maincpu_clk);
 
+    /* Deliver coalesced tape pulses before the CIA is saved.  */
+    datasette_flux_catch_up(TAPEPORT_PORT_1);
+
     if (maincpu_snapshot_write_module(s) < 0
         || c64_snapshot_write_module(s, save_roms) < 0
         || ciacore_snapshot_write_module(machine_context.cia1, s) < 0
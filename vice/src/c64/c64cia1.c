@@ -38,6 +38,7 @@
 #include "c64iec.h"
 #include "c64keyboard.h"
 #include "cia.h"
+#include "datasette.h"
 #include "interrupt.h"
 #include "drive.h"
 #include "joyport.h"
@@ -47,6 +48,7 @@
 #include "log.h"
 #include "machine.h"
 #include "maincpu.h"
+#include "tapeport.h"
 #include "types.h"
 #include "userport.h"
 #include "vicii.h"
@@ -72,6 +74,15 @@ void cia1_store(uint16_t addr, uint8_t data)
         DBG(("cia1_store cra: %02x\n", data));
     }
 
+    if ((addr & 0xf) == CIA_ICR) {
+        /* deliver pending tape pulses before the mask changes, and stop
+           coalescing them if the FLAG interrupt gets enabled */
+        datasette_flux_catch_up(TAPEPORT_PORT_1);
+        ciacore_store(machine_context.cia1, addr, data);
+        datasette_flux_catch_up(TAPEPORT_PORT_1);
+        return;
+    }
+
     ciacore_store(machine_context.cia1, addr, data);
 }
 
@@ -82,6 +93,9 @@ uint8_t cia1_read(uint16_t addr)
 
 uint8_t cia1_peek(uint16_t addr)
 {
+    if ((addr & 0xf) == CIA_ICR) {
+        datasette_flux_catch_up(TAPEPORT_PORT_1);
+    }
     return ciacore_peek(machine_context.cia1, addr);
 }
 
@@ -438,6 +452,7 @@ static void read_ciaicr(cia_context_t *cia_context)
     if (burst_mod == BURST_MOD_CIA1) {
         drive_cpu_execute_all(maincpu_clk);
     }
+    datasette_flux_catch_up(TAPEPORT_PORT_1);
 }
 
 static void read_sdr(cia_context_t *cia_context)
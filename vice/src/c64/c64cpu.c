@@ -104,13 +104,18 @@ inline static void memmap_mem_update(unsigned int addr, int write)
 static void memmap_mem_store(unsigned int addr, unsigned int value)
 {
     memmap_mem_update(addr, 1);
+    monitor_cputrace_fix_value(value);
     (*_mem_write_tab_ptr[(addr) >> 8])((uint16_t)(addr), (uint8_t)(value));
 }
 
 static uint8_t memmap_mem_read(unsigned int addr)
 {
+    uint8_t value;
+
     memmap_mem_update(addr, 0);
-    return (*_mem_read_tab_ptr[(addr) >> 8])((uint16_t)(addr));
+    value = (*_mem_read_tab_ptr[(addr) >> 8])((uint16_t)(addr));
+    monitor_cputrace_fix_value(value);
+    return value;
 }
 
 static void memmap_mark_read(unsigned int addr)
@@ -121,13 +126,18 @@ static void memmap_mark_read(unsigned int addr)
 static void memmap_mem_store_dummy(unsigned int addr, unsigned int value)
 {
     memmap_mem_update(addr, 1);
+    monitor_cputrace_fix_value(value);
     (*_mem_write_tab_ptr_dummy[(addr) >> 8])((uint16_t)(addr), (uint8_t)(value));
 }
 
 static uint8_t memmap_mem_read_dummy(unsigned int addr)
 {
+    uint8_t value;
+
     memmap_mem_update(addr, 0);
-    return (*_mem_read_tab_ptr_dummy[(addr) >> 8])((uint16_t)(addr));
+    value = (*_mem_read_tab_ptr_dummy[(addr) >> 8])((uint16_t)(addr));
+    monitor_cputrace_fix_value(value);
+    return value;
 }
 #endif
 
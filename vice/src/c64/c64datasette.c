@@ -40,6 +40,16 @@ void machine_trigger_flux_change(int port, unsigned int on)
     }
 }
 
+int machine_tape_flux_observed(int port)
+{
+    /* with the FLAG interrupt masked the flux changes are only visible in the
+       ICR, which catches up on them before it is accessed */
+    if (port == TAPEPORT_PORT_1) {
+        return (machine_context.cia1->c_cia[CIA_ICR] & CIA_IM_FLG) ? 1 : 0;
+    }
+    return 1;
+}
+
 void machine_set_tape_sense(int port, int sense)
 {
     if (port == TAPEPORT_PORT_1) {
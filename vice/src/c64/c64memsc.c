@@ -157,10 +157,32 @@ static void store_watch(uint16_t addr, uint8_t value)
     mem_write_tab[mem_config][addr >> 8](addr, value);
 }
 
+/* Route the pages covered by watchpoints through the watch functions, all
+   others go to the current memory configuration directly.
+   called by mem_update_tab_ptrs(), mem_initialize_memory() */
+static void mem_update_watch_tabs(void)
+{
+    int i;
+
+    for (i = 0; i <= 0x100; i++) {
+        if (monitor_watch_load_page(e_comp_space, i)) {
+            mem_read_tab_watch[i] = (i == 0) ? zero_read_watch : read_watch;
+        } else {
+            mem_read_tab_watch[i] = mem_read_tab[mem_config][i];
+        }
+        if (monitor_watch_store_page(e_comp_space, i)) {
+            mem_write_tab_watch[i] = (i == 0) ? zero_store_watch : store_watch;
+        } else {
+            mem_write_tab_watch[i] = mem_write_tab[mem_config][i];
+        }
+    }
+}
+
 /* called by mem_pla_config_changed(), mem_toggle_watchpoints() */
 static void mem_update_tab_ptrs(int flag)
 {
     if (flag) {
+        mem_update_watch_tabs();
         _mem_read_tab_ptr = mem_read_tab_watch;
         _mem_write_tab_ptr = mem_write_tab_watch;
         if (flag > 1) {
@@ -682,14 +704,6 @@ void mem_initialize_memory(void)
 
     mem_limit_init();
 
-    /* setup watchpoint tables */
-    mem_read_tab_watch[0] = zero_read_watch;
-    mem_write_tab_watch[0] = zero_store_watch;
-    for (i = 1; i <= 0x100; i++) {
-        mem_read_tab_watch[i] = read_watch;
-        mem_write_tab_watch[i] = store_watch;
-    }
-
     resources_get_int("BoardType", &board);
 
     /* first init everything to "nothing" */
@@ -777,6 +791,11 @@ void mem_initialize_memory(void)
     if (board == 1) {
         mem_limit_max_init();
     }
+
+    /* unwatched pages must follow the new mappings */
+    if (watchpoints_active) {
+        mem_update_watch_tabs();
+    }
 }
 
 void mem_mmu_translate(unsigned int addr, uint8_t **base, int *start, int *limit)
@@ -378,25 +378,37 @@ struct sfx_soundexpander_sound_s {
 
 static struct sfx_soundexpander_sound_s snd;
 
-#ifdef SOUND_SYSTEM_FLOAT
-/* FIXME */
-static int sfx_soundexpander_sound_machine_calculate_samples(sound_t **psid, float *pbuf, int nr, int scc, CLOCK *delta_t)
-{
-    int i;
-    int16_t *buffer;
+/* OPL output of a calculate_samples call, grown as needed */
+static int16_t *sfx_soundexpander_buffer = NULL;
+static int sfx_soundexpander_buffer_size = 0;
 
-    buffer = lib_malloc(nr * sizeof(int16_t));
+static int16_t *sfx_soundexpander_render(int nr)
+{
+    if (nr > sfx_soundexpander_buffer_size) {
+        sfx_soundexpander_buffer = lib_realloc(sfx_soundexpander_buffer, nr * sizeof(int16_t));
+        sfx_soundexpander_buffer_size = nr;
+    }
 
     if (sfx_soundexpander_chip == 3812 && YM3812_chip) {
-        ym3812_update_one(YM3812_chip, buffer, nr);
+        ym3812_update_one(YM3812_chip, sfx_soundexpander_buffer, nr);
     } else if (sfx_soundexpander_chip == 3526 && YM3526_chip) {
-        ym3526_update_one(YM3526_chip, buffer, nr);
+        ym3526_update_one(YM3526_chip, sfx_soundexpander_buffer, nr);
+    } else {
+        memset(sfx_soundexpander_buffer, 0, nr * sizeof(int16_t));
     }
+    return sfx_soundexpander_buffer;
+}
+
+#ifdef SOUND_SYSTEM_FLOAT
+/* FIXME */
+static int sfx_soundexpander_sound_machine_calculate_samples(sound_t **psid, float *pbuf, int nr, int scc, CLOCK *delta_t)
+{
+    int i;
+    int16_t *buffer = sfx_soundexpander_render(nr);
 
     for (i = 0; i < nr; i++) {
         pbuf[i] = buffer[i] / 32767.0;
     }
-    lib_free(buffer);
 
     return nr;
 }
@@ -404,15 +416,7 @@ static int sfx_soundexpander_sound_machine_calculate_samples(sound_t **psid, flo
 static int sfx_soundexpander_sound_machine_calculate_samples(sound_t **psid, int16_t *pbuf, int nr, int soc, int scc, CLOCK *delta_t)
 {
     int i;
-    int16_t *buffer;
-
-    buffer = lib_malloc(nr * 2);
-
-    if (sfx_soundexpander_chip == 3812 && YM3812_chip) {
-        ym3812_update_one(YM3812_chip, buffer, nr);
-    } else if (sfx_soundexpander_chip == 3526 && YM3526_chip) {
-        ym3526_update_one(YM3526_chip, buffer, nr);
-    }
+    int16_t *buffer = sfx_soundexpander_render(nr);
 
     for (i = 0; i < nr; i++) {
         pbuf[i * soc] = sound_audio_mix(pbuf[i * soc], buffer[i]);
@@ -420,7 +424,6 @@ static int sfx_soundexpander_sound_machine_calculate_samples(sound_t **psid, int
             pbuf[(i * soc) + 1] = sound_audio_mix(pbuf[(i * soc) + 1], buffer[i]);
         }
     }
-    lib_free(buffer);
 
     return nr;
 }
@@ -454,6 +457,9 @@ static void sfx_soundexpander_sound_machine_close(sound_t *psid)
         ym3812_shutdown(YM3812_chip);
         YM3812_chip = NULL;
     }
+    lib_free(sfx_soundexpander_buffer);
+    sfx_soundexpander_buffer = NULL;
+    sfx_soundexpander_buffer_size = 0;
 }
 
 static void sfx_soundexpander_sound_machine_store(sound_t *psid, uint16_t addr, uint8_t val)
@@ -1096,6 +1096,11 @@ void tapeport_trigger_flux_change(unsigned int on, int port)
 {
 }
 
+int tapeport_flux_observed(int port)
+{
+    return 1;
+}
+
 void tapeport_set_tape_sense(int sense, int port)
 {
 }
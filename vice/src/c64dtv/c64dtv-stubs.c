@@ -80,6 +80,11 @@ void tapeport_trigger_flux_change(unsigned int on, int port)
 {
 }
 
+int tapeport_flux_observed(int port)
+{
+    return 1;
+}
+
 void tapeport_set_tape_sense(int sense, int port)
 {
 }
@@ -108,6 +113,10 @@ void machine_set_tape_motor_in(int port, int val)
 void machine_trigger_flux_change(int port, unsigned int on)
 {
 }
+int machine_tape_flux_observed(int port)
+{
+    return 1;
+}
 void machine_set_tape_sense(int port, int sense)
 {
 }
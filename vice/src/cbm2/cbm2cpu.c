@@ -72,6 +72,7 @@
 static void memmap_mem_store(unsigned int addr, unsigned int value)
 {
     monitor_memmap_store(addr, MEMMAP_RAM_W);
+    monitor_cputrace_fix_value(value);
     (*_mem_write_tab_ptr[(addr) >> 8])((uint16_t)(addr), (uint8_t)(value));
 }
 
@@ -83,19 +84,28 @@ static void memmap_mark_read(unsigned int addr)
 
 static uint8_t memmap_mem_read(unsigned int addr)
 {
+    uint8_t value;
+
     memmap_mark_read(addr);
-    return (*_mem_read_tab_ptr[(addr) >> 8])((uint16_t)(addr));
+    value = (*_mem_read_tab_ptr[(addr) >> 8])((uint16_t)(addr));
+    monitor_cputrace_fix_value(value);
+    return value;
 }
 
 static uint8_t memmap_mem_read_dummy(unsigned int addr)
 {
+    uint8_t value;
+
     memmap_mark_read(addr);
-    return (*_mem_read_tab_ptr_dummy[(addr) >> 8])((uint16_t)(addr));
+    value = (*_mem_read_tab_ptr_dummy[(addr) >> 8])((uint16_t)(addr));
+    monitor_cputrace_fix_value(value);
+    return value;
 }
 
 static void memmap_mem_store_dummy(unsigned int addr, unsigned int value)
 {
     monitor_memmap_store(addr, MEMMAP_RAM_W);
+    monitor_cputrace_fix_value(value);
     (*_mem_write_tab_ptr_dummy[(addr) >> 8])((uint16_t)(addr), (uint8_t)(value));
 }
 #endif
@@ -69,6 +69,11 @@ void machine_trigger_flux_change(int port, unsigned int on)
     }
 }
 
+int machine_tape_flux_observed(int port)
+{
+    return 1;
+}
+
 void machine_set_tape_sense(int port, int sense)
 {
     if (port == TAPEPORT_PORT_1) {
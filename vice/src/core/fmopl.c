@@ -554,103 +554,89 @@ inline static void advance_lfo(FM_OPL *OPL)
     LFO_PM = ((OPL->lfo_pm_cnt >> LFO_SH) & 7) | OPL->lfo_pm_depth_range;
 }
 
-/* advance to next sample */
-inline static void advance(FM_OPL *OPL)
+/* advance the envelope generator of an operator by one step */
+inline static void advance_eg(OPL_SLOT *op, UINT32 eg_cnt)
 {
-    OPL_CH *CH;
-    OPL_SLOT *op;
-    int i;
-
-    OPL->eg_timer += OPL->eg_timer_add;
-
-    while (OPL->eg_timer >= OPL->eg_timer_overflow) {
-        OPL->eg_timer -= OPL->eg_timer_overflow;
-
-        OPL->eg_cnt++;
-
-        for (i = 0; i < 9 * 2; i++) {
-            CH = &OPL->P_CH[i / 2];
-            op = &CH->SLOT[i & 1];
-
-            /* Envelope Generator */
-            switch (op->state) {
-                case EG_ATT:            /* attack phase */
-                    if (!(OPL->eg_cnt & ((1 << op->eg_sh_ar) - 1))) {
-                        op->volume += (~op->volume * (eg_inc[op->eg_sel_ar + ((OPL->eg_cnt >> op->eg_sh_ar) & 7)])) >> 3;
-
-                        if (op->volume <= MIN_ATT_INDEX) {
-                            op->volume = MIN_ATT_INDEX;
-                            op->state = EG_DEC;
-                        }
-                    }
-                    break;
-                case EG_DEC:    /* decay phase */
-                    if (!(OPL->eg_cnt & ((1 << op->eg_sh_dr) - 1))) {
-                        op->volume += eg_inc[op->eg_sel_dr + ((OPL->eg_cnt >> op->eg_sh_dr) & 7)];
+    switch (op->state) {
+        case EG_ATT:            /* attack phase */
+            if (!(eg_cnt & ((1 << op->eg_sh_ar) - 1))) {
+                op->volume += (~op->volume * (eg_inc[op->eg_sel_ar + ((eg_cnt >> op->eg_sh_ar) & 7)])) >> 3;
+
+                if (op->volume <= MIN_ATT_INDEX) {
+                    op->volume = MIN_ATT_INDEX;
+                    op->state = EG_DEC;
+                }
+            }
+            break;
+        case EG_DEC:    /* decay phase */
+            if (!(eg_cnt & ((1 << op->eg_sh_dr) - 1))) {
+                op->volume += eg_inc[op->eg_sel_dr + ((eg_cnt >> op->eg_sh_dr) & 7)];
 
-                        if ((UINT32)(op->volume) >= op->sl) {
-                            op->state = EG_SUS;
-                        }
-                    }
-                    break;
-                case EG_SUS:    /* sustain phase */
+                if ((UINT32)(op->volume) >= op->sl) {
+                    op->state = EG_SUS;
+                }
+            }
+            break;
+        case EG_SUS:    /* sustain phase */
 
-                    /* this is important behaviour:
-                       one can change percusive/non-percussive modes on the fly and
-                       the chip will remain in sustain phase - verified on real YM3812 */
+            /* this is important behaviour:
+               one can change percusive/non-percussive modes on the fly and
+               the chip will remain in sustain phase - verified on real YM3812 */
 
-                    if (op->eg_type) {          /* non-percussive mode */
-                        /* do nothing */
-                    } else {                            /* percussive mode */
-                        /* during sustain phase chip adds Release Rate (in percussive mode) */
-                        if (!(OPL->eg_cnt & ((1 << op->eg_sh_rr) - 1))) {
-                            op->volume += eg_inc[op->eg_sel_rr + ((OPL->eg_cnt >> op->eg_sh_rr) & 7)];
+            if (op->eg_type) {          /* non-percussive mode */
+                /* do nothing */
+            } else {                            /* percussive mode */
+                /* during sustain phase chip adds Release Rate (in percussive mode) */
+                if (!(eg_cnt & ((1 << op->eg_sh_rr) - 1))) {
+                    op->volume += eg_inc[op->eg_sel_rr + ((eg_cnt >> op->eg_sh_rr) & 7)];
 
-                            if (op->volume >= MAX_ATT_INDEX) {
-                                op->volume = MAX_ATT_INDEX;
-                            }
-                        }
-                        /* else do nothing in sustain phase */
+                    if (op->volume >= MAX_ATT_INDEX) {
+                        op->volume = MAX_ATT_INDEX;
                     }
-                    break;
-                case EG_REL:    /* release phase */
-                    if (!(OPL->eg_cnt & ((1 << op->eg_sh_rr) - 1))) {
-                        op->volume += eg_inc[op->eg_sel_rr + ((OPL->eg_cnt >> op->eg_sh_rr) & 7)];
+                }
+                /* else do nothing in sustain phase */
+            }
+            break;
+        case EG_REL:    /* release phase */
+            if (!(eg_cnt & ((1 << op->eg_sh_rr) - 1))) {
+                op->volume += eg_inc[op->eg_sel_rr + ((eg_cnt >> op->eg_sh_rr) & 7)];
 
-                        if (op->volume >= MAX_ATT_INDEX) {
-                            op->volume = MAX_ATT_INDEX;
-                            op->state = EG_OFF;
-                        }
-                    }
-                    break;
-                default:
-                    break;
+                if (op->volume >= MAX_ATT_INDEX) {
+                    op->volume = MAX_ATT_INDEX;
+                    op->state = EG_OFF;
+                }
             }
-        }
+            break;
+        default:
+            break;
     }
+}
 
-    for (i = 0; i < 9 * 2; i++) {
-        CH = &OPL->P_CH[i / 2];
-        op = &CH->SLOT[i & 1];
-
-        /* Phase Generator */
-        if (op->vib) {
-            UINT8 block;
-            unsigned int block_fnum = CH->block_fnum;
-            unsigned int fnum_lfo = (block_fnum & 0x0380) >> 7;
-            signed int lfo_fn_table_index_offset = lfo_pm_table[LFO_PM + 16 * fnum_lfo];
-
-            if (lfo_fn_table_index_offset) {    /* LFO phase modulation active */
-                block_fnum += lfo_fn_table_index_offset;
-                block = (block_fnum & 0x1c00) >> 10;
-                op->Cnt += (OPL->fn_tab[block_fnum & 0x03ff] >> (7 - block)) * op->mul;
-            } else {    /* LFO phase modulation  = zero */
-                op->Cnt += op->Incr;
-            }
-        } else {        /* LFO phase modulation disabled for this operator */
+/* advance the phase generator of an operator to the next sample */
+inline static void advance_pg(FM_OPL *OPL, OPL_CH *CH, OPL_SLOT *op, INT32 lfo_pm)
+{
+    if (op->vib) {
+        UINT8 block;
+        unsigned int block_fnum = CH->block_fnum;
+        unsigned int fnum_lfo = (block_fnum & 0x0380) >> 7;
+        signed int lfo_fn_table_index_offset = lfo_pm_table[lfo_pm + 16 * fnum_lfo];
+
+        if (lfo_fn_table_index_offset) {    /* LFO phase modulation active */
+            block_fnum += lfo_fn_table_index_offset;
+            block = (block_fnum & 0x1c00) >> 10;
+            op->Cnt += (OPL->fn_tab[block_fnum & 0x03ff] >> (7 - block)) * op->mul;
+        } else {    /* LFO phase modulation  = zero */
             op->Cnt += op->Incr;
         }
+    } else {        /* LFO phase modulation disabled for this operator */
+        op->Cnt += op->Incr;
     }
+}
+
+/* advance the noise generator to the next sample */
+inline static void advance_noise(FM_OPL *OPL)
+{
+    int i;
 
     /*  The Noise Generator of the YM3812 is 23-bit shift register.
      *   Period is equal to 2^23-2 samples.
@@ -710,37 +696,6 @@ inline static signed int op_calc1(UINT32 phase, unsigned int env, signed int pm,
 
 #define volume_calc(OP) ((OP)->TLL + ((UINT32)(OP)->volume) + (LFO_AM & (OP)->AMmask))
 
-/* calculate output */
-inline static void OPL_CALC_CH(OPL_CH *CH)
-{
-    OPL_SLOT *SLOT;
-    unsigned int env;
-    signed int out;
-
-    phase_modulation = 0;
-
-    /* SLOT 1 */
-    SLOT = &CH->SLOT[SLOT1];
-    env = volume_calc(SLOT);
-    out = SLOT->op1_out[0] + SLOT->op1_out[1];
-    SLOT->op1_out[0] = SLOT->op1_out[1];
-    *SLOT->connect1 += SLOT->op1_out[0];
-    SLOT->op1_out[1] = 0;
-    if (env < ENV_QUIET) {
-        if (!SLOT->FB) {
-            out = 0;
-        }
-        SLOT->op1_out[1] = op_calc1(SLOT->Cnt, env, (out << SLOT->FB), SLOT->wavetable);
-    }
-
-    /* SLOT 2 */
-    SLOT++;
-    env = volume_calc(SLOT);
-    if (env < ENV_QUIET) {
-        output[0] += op_calc(SLOT->Cnt, env, phase_modulation, SLOT->wavetable);
-    }
-}
-
 /*
     operators used in the rhythm sounds generation process:
 
@@ -943,6 +898,192 @@ inline static void OPL_CALC_RH(OPL_CH *CH, unsigned int noise)
     }
 }
 
+/* Block rendering.
+
+   The samples are generated in blocks of up to OPL_BLOCK_LEN samples. The
+   state shared by all channels (LFO, envelope generator timer and noise) is
+   stepped through the block first, then every channel renders the whole
+   block into block_mix[] in one go. Channels which are keyed off and have
+   faded out only need their phase generators advanced.  */
+
+#define OPL_BLOCK_LEN 256
+
+static UINT32 block_lfo_am[OPL_BLOCK_LEN];  /* LFO_AM of each sample */
+static INT32 block_lfo_pm[OPL_BLOCK_LEN];   /* LFO_PM of each sample */
+static UINT8 block_eg_ticks[OPL_BLOCK_LEN]; /* envelope generator steps after each sample */
+static UINT8 block_noise[OPL_BLOCK_LEN];    /* noise bit of each sample */
+static INT32 block_mix[OPL_BLOCK_LEN];
+
+/* step the state shared by all channels through the block */
+static void OPL_prepare_block(FM_OPL *OPL, int length)
+{
+    int i;
+
+    for (i = 0; i < length; i++) {
+        UINT8 ticks = 0;
+
+        advance_lfo(OPL);
+        block_lfo_am[i] = LFO_AM;
+        block_lfo_pm[i] = LFO_PM;
+        block_noise[i] = OPL->noise_rng & 1;
+        block_mix[i] = 0;
+
+        OPL->eg_timer += OPL->eg_timer_add;
+        while (OPL->eg_timer >= OPL->eg_timer_overflow) {
+            OPL->eg_timer -= OPL->eg_timer_overflow;
+            OPL->eg_cnt++;
+            ticks++;
+        }
+        block_eg_ticks[i] = ticks;
+
+        advance_noise(OPL);
+    }
+}
+
+/* advance the phase generators of a silent operator pair through the block */
+static void OPL_advance_pg_block(FM_OPL *OPL, OPL_CH *CH, OPL_SLOT *op, int count, int length)
+{
+    int i, s;
+
+    for (s = 0; s < count; s++) {
+        if (op[s].vib) {
+            for (i = 0; i < length; i++) {
+                advance_pg(OPL, CH, &op[s], block_lfo_pm[i]);
+            }
+        } else {
+            op[s].Cnt += op[s].Incr * (UINT32)length;
+        }
+    }
+}
+
+/* render a melody channel */
+static void OPL_render_ch(FM_OPL *OPL, OPL_CH *CH, UINT32 eg_cnt, int length)
+{
+    OPL_SLOT *op1 = &CH->SLOT[SLOT1];
+    OPL_SLOT *op2 = &CH->SLOT[SLOT2];
+    int to_output = (op1->connect1 == &output[0]);
+    int i, t;
+
+    if (op1->state == EG_OFF && op2->state == EG_OFF
+        && !op1->op1_out[0] && !op1->op1_out[1]) {
+        OPL_advance_pg_block(OPL, CH, CH->SLOT, 2, length);
+        return;
+    }
+
+    for (i = 0; i < length; i++) {
+        UINT32 am = block_lfo_am[i];
+        unsigned int env;
+        signed int out, pm = 0;
+
+        /* SLOT 1 */
+        env = op1->TLL + ((UINT32)op1->volume) + (am & op1->AMmask);
+        out = op1->op1_out[0] + op1->op1_out[1];
+        op1->op1_out[0] = op1->op1_out[1];
+        if (to_output) {
+            block_mix[i] += op1->op1_out[0];
+        } else {
+            pm = op1->op1_out[0];
+        }
+        op1->op1_out[1] = 0;
+        if (env < ENV_QUIET) {
+            if (!op1->FB) {
+                out = 0;
+            }
+            op1->op1_out[1] = op_calc1(op1->Cnt, env, (out << op1->FB), op1->wavetable);
+        }
+
+        /* SLOT 2 */
+        env = op2->TLL + ((UINT32)op2->volume) + (am & op2->AMmask);
+        if (env < ENV_QUIET) {
+            block_mix[i] += op_calc(op2->Cnt, env, pm, op2->wavetable);
+        }
+
+        for (t = 0; t < block_eg_ticks[i]; t++) {
+            eg_cnt++;
+            advance_eg(op1, eg_cnt);
+            advance_eg(op2, eg_cnt);
+        }
+        advance_pg(OPL, CH, op1, block_lfo_pm[i]);
+        advance_pg(OPL, CH, op2, block_lfo_pm[i]);
+    }
+}
+
+/* render the rhythm channels 6-8, they depend on each other's phases */
+static void OPL_render_rh(FM_OPL *OPL, UINT32 eg_cnt, int length)
+{
+    OPL_SLOT *op = OPL->P_CH[6].SLOT;
+    int i, s, t;
+
+    if (op[0].state == EG_OFF && op[1].state == EG_OFF
+        && SLOT7_1->state == EG_OFF && SLOT7_2->state == EG_OFF
+        && SLOT8_1->state == EG_OFF && SLOT8_2->state == EG_OFF
+        && !op[0].op1_out[0] && !op[0].op1_out[1]) {
+        for (s = 6; s < 9; s++) {
+            OPL_advance_pg_block(OPL, &OPL->P_CH[s], OPL->P_CH[s].SLOT, 2, length);
+        }
+        return;
+    }
+
+    for (i = 0; i < length; i++) {
+        LFO_AM = block_lfo_am[i];
+        output[0] = 0;
+        OPL_CALC_RH(&OPL->P_CH[0], block_noise[i]);
+        block_mix[i] += output[0];
+
+        for (t = 0; t < block_eg_ticks[i]; t++) {
+            eg_cnt++;
+            for (s = 6 * 2; s < 9 * 2; s++) {
+                advance_eg(&OPL->P_CH[s / 2].SLOT[s & 1], eg_cnt);
+            }
+        }
+        for (s = 6 * 2; s < 9 * 2; s++) {
+            advance_pg(OPL, &OPL->P_CH[s / 2], &OPL->P_CH[s / 2].SLOT[s & 1], block_lfo_pm[i]);
+        }
+    }
+}
+
+/* generate 'length' samples */
+static void OPLUpdate(FM_OPL *OPL, OPLSAMPLE *buffer, int length)
+{
+    UINT8 rhythm = OPL->rhythm & 0x20;
+    int i, ch;
+
+    if ((void *)OPL != cur_chip) {
+        cur_chip = (void *)OPL;
+        /* rhythm slots */
+        SLOT7_1 = &OPL->P_CH[7].SLOT[SLOT1];
+        SLOT7_2 = &OPL->P_CH[7].SLOT[SLOT2];
+        SLOT8_1 = &OPL->P_CH[8].SLOT[SLOT1];
+        SLOT8_2 = &OPL->P_CH[8].SLOT[SLOT2];
+    }
+
+    while (length > 0) {
+        int n = (length > OPL_BLOCK_LEN) ? OPL_BLOCK_LEN : length;
+        UINT32 eg_cnt = OPL->eg_cnt;
+
+        OPL_prepare_block(OPL, n);
+
+        /* FM part */
+        for (ch = 0; ch < (rhythm ? 6 : 9); ch++) {
+            OPL_render_ch(OPL, &OPL->P_CH[ch], eg_cnt, n);
+        }
+        if (rhythm) {           /* Rhythm part */
+            OPL_render_rh(OPL, eg_cnt, n);
+        }
+
+        for (i = 0; i < n; i++) {
+            int lt = block_mix[i];
+
+            lt >>= FINAL_SH;
+
+            /* limit check */
+            buffer[i] = limit(lt, MAXOUT, MINOUT);
+        }
+        buffer += n;
+        length -= n;
+    }
+}
+
 /* generic table initialize */
 static int init_tables(void)
 {
@@ -1691,54 +1832,7 @@ int ym3812_timer_over(FM_OPL *chip, int c)
 */
 void ym3812_update_one(FM_OPL *chip, OPLSAMPLE *buffer, int length)
 {
-    FM_OPL *OPL = (FM_OPL *)chip;
-    UINT8 rhythm = OPL->rhythm & 0x20;
-    OPLSAMPLE *buf = buffer;
-    int i;
-
-    if ((void *)OPL != cur_chip) {
-        cur_chip = (void *)OPL;
-        /* rhythm slots */
-        SLOT7_1 = &OPL->P_CH[7].SLOT[SLOT1];
-        SLOT7_2 = &OPL->P_CH[7].SLOT[SLOT2];
-        SLOT8_1 = &OPL->P_CH[8].SLOT[SLOT1];
-        SLOT8_2 = &OPL->P_CH[8].SLOT[SLOT2];
-    }
-    for (i = 0; i < length; i++) {
-        int lt;
-
-        output[0] = 0;
-
-        advance_lfo(OPL);
-
-        /* FM part */
-        OPL_CALC_CH(&OPL->P_CH[0]);
-        OPL_CALC_CH(&OPL->P_CH[1]);
-        OPL_CALC_CH(&OPL->P_CH[2]);
-        OPL_CALC_CH(&OPL->P_CH[3]);
-        OPL_CALC_CH(&OPL->P_CH[4]);
-        OPL_CALC_CH(&OPL->P_CH[5]);
-
-        if (!rhythm) {
-            OPL_CALC_CH(&OPL->P_CH[6]);
-            OPL_CALC_CH(&OPL->P_CH[7]);
-            OPL_CALC_CH(&OPL->P_CH[8]);
-        } else {                /* Rhythm part */
-            OPL_CALC_RH(&OPL->P_CH[0], (OPL->noise_rng >> 0) & 1 );
-        }
-
-        lt = output[0];
-
-        lt >>= FINAL_SH;
-
-        /* limit check */
-        lt = limit(lt, MAXOUT, MINOUT);
-
-        /* store to sound buffer */
-        buf[i] = lt;
-
-        advance(OPL);
-    }
+    OPLUpdate(chip, buffer, length);
 }
 
 FM_OPL *ym3526_init(UINT32 clock, UINT32 rate)
@@ -1792,54 +1886,7 @@ int ym3526_timer_over(FM_OPL *chip, int c)
 */
 void ym3526_update_one(FM_OPL *chip, OPLSAMPLE *buffer, int length)
 {
-    FM_OPL *OPL = (FM_OPL *)chip;
-    UINT8 rhythm = OPL->rhythm & 0x20;
-    OPLSAMPLE *buf = buffer;
-    int i;
-
-    if ((void *)OPL != cur_chip) {
-        cur_chip = (void *)OPL;
-        /* rhythm slots */
-        SLOT7_1 = &OPL->P_CH[7].SLOT[SLOT1];
-        SLOT7_2 = &OPL->P_CH[7].SLOT[SLOT2];
-        SLOT8_1 = &OPL->P_CH[8].SLOT[SLOT1];
-        SLOT8_2 = &OPL->P_CH[8].SLOT[SLOT2];
-    }
-    for (i = 0; i < length; i++) {
-        int lt;
-
-        output[0] = 0;
-
-        advance_lfo(OPL);
-
-        /* FM part */
-        OPL_CALC_CH(&OPL->P_CH[0]);
-        OPL_CALC_CH(&OPL->P_CH[1]);
-        OPL_CALC_CH(&OPL->P_CH[2]);
-        OPL_CALC_CH(&OPL->P_CH[3]);
-        OPL_CALC_CH(&OPL->P_CH[4]);
-        OPL_CALC_CH(&OPL->P_CH[5]);
-
-        if (!rhythm) {
-            OPL_CALC_CH(&OPL->P_CH[6]);
-            OPL_CALC_CH(&OPL->P_CH[7]);
-            OPL_CALC_CH(&OPL->P_CH[8]);
-        } else {                /* Rhythm part */
-            OPL_CALC_RH(&OPL->P_CH[0], (OPL->noise_rng >> 0) & 1);
-        }
-
-        lt = output[0];
-
-        lt >>= FINAL_SH;
-
-        /* limit check */
-        lt = limit(lt, MAXOUT, MINOUT);
-
-        /* store to sound buffer */
-        buf[i] = lt;
-
-        advance(OPL);
-    }
+    OPLUpdate(chip, buffer, length);
 }
 
 /* ---------------------------------------------------------------------*/
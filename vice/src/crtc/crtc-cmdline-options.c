@@ -50,7 +50,8 @@ static const cmdline_option_t cmdline_options[] =
 
 int crtc_cmdline_options_init(void)
 {
-    if (raster_cmdline_options_chip_init("CRTC", crtc.video_chip_cap) < 0) {
+    if (raster_cmdline_options_chip_init("CRTC", crtc.video_chip_cap) < 0
+        || raster_cmdline_options_chip_async_init("CRTC") < 0) {
         return -1;
     }
 
@@ -33,10 +33,129 @@
 #include "crtc-draw.h"
 #include "crtc.h"
 #include "crtctypes.h"
+#include "raster-async.h"
 #include "raster-modes.h"
 #include "types.h"
 
 
+/* The drawing code reads the CRTC state through this pointer, so the raster
+   lines can be drawn from a copy of it on a separate thread.  The screen
+   memory and the character rows a line uses are captured with the line and
+   put into buffers of their own, at the same offsets DRAW() reads them
+   from.  */
+static crtc_t *crtc_draw_state = &crtc;
+
+#define CRTC_ASYNC_CHARS    512
+
+typedef struct crtc_draw_async_data_s {
+    int drawn;
+    uint8_t screen[2][CRTC_ASYNC_CHARS];
+    uint8_t chars[2][CRTC_ASYNC_CHARS];
+} crtc_draw_async_data_t;
+
+static uint8_t async_screen[0x4000];
+static uint8_t async_chargen[0x1000];
+
+/* Get the characters DRAW() is called with for part 0 (left of rl_pos) and
+   part 1 of the line, see draw_standard_line().  */
+static int async_part(const crtc_t *c, int part, int *scr_rel, int *xs, int *xc)
+{
+    int rl_pos = c->xoffset + c->hjitter;
+
+    if (part == 0) {
+        if (rl_pos <= 8) {
+            return 0;
+        }
+        *scr_rel = c->prev_screen_rel;
+        *xs = (c->prev_rl_len + 1) * c->hw_cols - (rl_pos / 8);
+        *xc = c->prev_rl_visible * c->hw_cols;
+    } else {
+        *scr_rel = c->screen_rel;
+        *xs = 0;
+        *xc = c->rl_visible * c->hw_cols;
+    }
+    return *xc > *xs;
+}
+
+static int crtc_draw_async_capture(void *data, int blank)
+{
+    crtc_draw_async_data_t *async = data;
+    uint8_t *chargen_ptr;
+    int part, scr_rel, xs, xc, i;
+
+    async->drawn = !blank;
+    if (blank) {
+        return 0;
+    }
+
+    if (crtc.hires_draw_callback != NULL
+        || crtc.vaddr_mask_eff >= (int)sizeof(async_screen)) {
+        return -1;
+    }
+
+    chargen_ptr = crtc.chargen_base + crtc.chargen_rel + (crtc.raster.ycounter & 0x0f);
+
+    for (part = 0; part < 2; part++) {
+        if (!async_part(&crtc, part, &scr_rel, &xs, &xc)) {
+            continue;
+        }
+        if (xc - xs > CRTC_ASYNC_CHARS) {
+            return -1;
+        }
+        for (i = xs; i < xc; i++) {
+            uint8_t d;
+
+#if CRTC_BEAM_RACING
+            if (xs == 0) {
+                d = crtc.prefetch[i & crtc.vaddr_mask_eff];
+            } else
+#endif
+            {
+                d = crtc.screen_base[(scr_rel + i) & crtc.vaddr_mask_eff];
+            }
+            async->screen[part][i - xs] = d;
+            async->chars[part][i - xs] = chargen_ptr[d << 4];
+        }
+    }
+    return 0;
+}
+
+static void crtc_draw_async_prepare(void *state, const void *data)
+{
+    crtc_t *view = state;
+    const crtc_draw_async_data_t *async = data;
+    int row, part, scr_rel, xs, xc, i;
+
+    if (!async->drawn) {
+        return;
+    }
+
+    row = view->raster.ycounter & 0x0f;
+
+    for (part = 0; part < 2; part++) {
+        if (!async_part(view, part, &scr_rel, &xs, &xc)) {
+            continue;
+        }
+        for (i = xs; i < xc; i++) {
+            uint8_t d = async->screen[part][i - xs];
+
+            async_screen[(scr_rel + i) & view->vaddr_mask_eff] = d;
+            async_chargen[row + (d << 4)] = async->chars[part][i - xs];
+        }
+    }
+    view->screen_base = async_screen;
+    view->chargen_base = async_chargen;
+    view->chargen_rel = 0;
+}
+
+const raster_async_chip_t crtc_draw_async_chip = {
+    &crtc, sizeof(crtc_t), (void **)&crtc_draw_state, sizeof(crtc_draw_async_data_t),
+    crtc_draw_async_capture, crtc_draw_async_prepare
+};
+
+#define crtc (*crtc_draw_state)
+
+
 /*
  * Bit expansion table: expands 4 bits to 4 bytes,
  * placing each bit in the lsb of the bytes.
@@ -34,6 +34,10 @@
 
 #include "types.h"
 
+struct raster_async_chip_s;
+
+extern const struct raster_async_chip_s crtc_draw_async_chip;
+
 void crtc_draw_init(void);
 
 extern uint32_t dwg_table[16];
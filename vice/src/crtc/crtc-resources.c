@@ -39,6 +39,7 @@
 #include <stdio.h>
 
 #include "archdep.h"
+#include "crtc-draw.h"
 #include "crtc-resources.h"
 #include "crtctypes.h"
 #include "fullscreen.h"
@@ -102,7 +103,8 @@ int crtc_resources_init(void)
     video_chip_cap.external_palette_name = "green";
     fullscreen_capability(&(video_chip_cap.fullscreen));
 
-    if (raster_resources_chip_init("Crtc", &crtc.raster, &video_chip_cap) < 0) {
+    if (raster_resources_chip_init("Crtc", &crtc.raster, &video_chip_cap) < 0
+        || raster_resources_chip_async_init("Crtc", &crtc.raster, &crtc_draw_async_chip) < 0) {
         return -1;
     }
     crtc.video_chip_cap = &video_chip_cap;
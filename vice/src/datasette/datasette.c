@@ -66,6 +66,10 @@
 /* at least every DATASETTE_MAX_GAP cycle there should be an alarm */
 #define DATASETTE_MAX_GAP   100000
 
+/* while pulses are coalesced, catch up at least every DATASETTE_DEFER_HORIZON
+   cycles so the counter and the end of tape do not lag behind too far */
+#define DATASETTE_DEFER_HORIZON DATASETTE_MAX_GAP
+
 
 /* Attached TAP tape image.  */
 static tap_t *current_image[TAPEPORT_MAX_PORTS];
@@ -100,6 +104,11 @@ static int datasette_last_direction[TAPEPORT_MAX_PORTS];
 
 static long datasette_cycles_per_second;
 
+/* Pulses are coalesced while nobody can see them. datasette_deferred_clk is
+   the time of the next flux change that has not been delivered yet.  */
+static int datasette_deferred[TAPEPORT_MAX_PORTS];
+static CLOCK datasette_deferred_clk[TAPEPORT_MAX_PORTS];
+
 /* Remember the reset of tape-counter.  */
 static int datasette_counter_offset[TAPEPORT_MAX_PORTS];
 
@@ -150,6 +159,8 @@ static int datasette_read_snapshot(int port, snapshot_t *s);
 
 static int datasette_enable(int port, int val);
 
+static void datasette_flux_resume(int port);
+
 static tapeport_device_t datasette_device = {
     "Datasette",                /* device name */
     TAPEPORT_DEVICE_TYPE_TAPE,  /* device is a 'tape' type of device */
@@ -244,6 +255,7 @@ static int datasette_enable(int port, int value)
 
     DBG(("set_datasette_enable: %d", value));
 
+    datasette_flux_resume(port);
     datasette_enabled[port] = val;
 
     return 0;
@@ -718,16 +730,150 @@ static void datasette_alarm_unset(int port)
           played back on a NTSC machine, the pulses must be scaled accordingly
           - which is not happening right now. */
 
+/* advance the tape to the next flux change (or to the next split point of a
+   long gap), returns the number of cycles until then or 0 at the end of tape */
+static CLOCK datasette_advance(int port, int direction)
+{
+    CLOCK gap;
+
+    if (direction + datasette_last_direction[port] == 0) {
+        /* the direction changed; read the gap from file,
+        but use only the elapsed gap */
+        gap = datasette_read_gap(port, direction);
+        datasette_long_gap_pending[port] = datasette_long_gap_elapsed[port];
+        datasette_long_gap_elapsed[port] = (CLOCK)(gap - datasette_long_gap_elapsed[port]);
+    }
+    if (datasette_long_gap_pending[port]) {
+        gap = datasette_long_gap_pending[port];
+        datasette_long_gap_pending[port] = 0;
+    } else {
+        gap = datasette_read_gap(port, direction);
+        if (gap) {
+            datasette_long_gap_elapsed[port] = 0;
+        }
+    }
+    if (!gap) {
+        return 0;
+    }
+    if (gap > DATASETTE_MAX_GAP) {
+        datasette_long_gap_pending[port] = (CLOCK)(gap - DATASETTE_MAX_GAP);
+        gap = DATASETTE_MAX_GAP;
+    }
+    datasette_long_gap_elapsed[port] += gap;
+    datasette_last_direction[port] = direction;
+
+    if (direction > 0) {
+        current_image[port]->cycle_counter += gap / 8;
+    } else {
+        current_image[port]->cycle_counter -= gap / 8;
+    }
+
+    if (current_image[port]->mode == DATASETTE_CONTROL_START) {
+        datasette_sound_add_to_circular_buffer(gap);
+    }
+
+    return gap;
+}
+
+/* returns non-zero if the flux changes of a playing tape can currently not be
+   seen by anyone, so they do not need an alarm each */
+static int datasette_can_coalesce(int port)
+{
+    if (current_image[port] == NULL
+        || current_image[port]->mode != DATASETTE_CONTROL_START
+        || !datasette_enabled[port]
+        || !datasette_motor[port]
+        || motor_stop_clk[port] > 0
+        || datasette_sound_emulation) {
+        return 0;
+    }
+    return !tapeport_flux_observed(port);
+}
+
+/* deliver all coalesced flux changes that happened before clk. Since nobody
+   was watching, a single flux change has the same effect as all of them. */
+static void datasette_deferred_catch_up(int port, CLOCK clk)
+{
+    int pulses = 0;
+    unsigned int on = 0;
+    CLOCK gap;
+
+    while (datasette_deferred_clk[port] < clk) {
+        if (!datasette_long_gap_pending[port]) {
+            on = fullwave[port];
+            pulses++;
+        }
+        gap = datasette_advance(port, 1);
+        if (!gap) {
+            if (pulses) {
+                tapeport_trigger_flux_change(on, port);
+            }
+            datasette_deferred[port] = 0;
+            datasette_control(port, DATASETTE_CONTROL_STOP);
+            return;
+        }
+        datasette_deferred_clk[port] += gap;
+    }
+
+    if (pulses) {
+        tapeport_trigger_flux_change(on, port);
+    }
+    datasette_update_ui_counter(port);
+}
+
+/* catch up and go back to one alarm per flux change */
+static void datasette_flux_resume(int port)
+{
+    if (!datasette_deferred[port]) {
+        return;
+    }
+    datasette_deferred_catch_up(port, maincpu_clk);
+    if (datasette_deferred[port]) {
+        datasette_deferred[port] = 0;
+        datasette_alarm_unset(port);
+        datasette_alarm_set(port, datasette_deferred_clk[port]);
+    }
+}
+
+/* called by the machine before something that may observe the flux changes
+   (like reading or writing the CIA ICR) happens */
+void datasette_flux_catch_up(int port)
+{
+    if (!datasette_deferred[port]) {
+        return;
+    }
+    if (datasette_can_coalesce(port)) {
+        datasette_deferred_catch_up(port, maincpu_clk);
+    } else {
+        datasette_flux_resume(port);
+    }
+}
+
 /* this is the alarm function */
 static void datasette_read_bit(CLOCK offset, void *data)
 {
     double speed_of_tape = DS_V_PLAY;
     int direction = 1;
     long gap;
+    CLOCK next_clk;
     int port = vice_ptr_to_int(data);
 
     datasette_alarm_unset(port);
 
+    if (datasette_deferred[port]) {
+        datasette_deferred_catch_up(port, maincpu_clk - offset);
+        if (!datasette_deferred[port]) {
+            return;
+        }
+        if (datasette_can_coalesce(port)) {
+            datasette_alarm_set(port, datasette_deferred_clk[port] + DATASETTE_DEFER_HORIZON);
+        } else {
+            datasette_deferred[port] = 0;
+            datasette_alarm_set(port, datasette_deferred_clk[port]);
+        }
+        return;
+    }
+
     DBG(("datasette_read_bit(motor:%d) maincpu_clk: 0x%"PRIx64" motor_stop_clk: 0x%"PRIx64" (image present:%s)",
          datasette_motor[port], maincpu_clk, motor_stop_clk[port], current_image[port] ? "yes" : "no"));
 
@@ -803,51 +949,29 @@ static void datasette_read_bit(CLOCK offset, void *data)
             return;
     }
 
-    if (direction + datasette_last_direction[port] == 0) {
-        /* the direction changed; read the gap from file,
-        but use only the elapsed gap */
-        gap = datasette_read_gap(port, direction);
-        datasette_long_gap_pending[port] = datasette_long_gap_elapsed[port];
-        datasette_long_gap_elapsed[port] = (CLOCK)(gap - datasette_long_gap_elapsed[port]);
-    }
-    if (datasette_long_gap_pending[port]) {
-        gap = datasette_long_gap_pending[port];
-        datasette_long_gap_pending[port] = 0;
-    } else {
-        gap = datasette_read_gap(port, direction);
-        if (gap) {
-            datasette_long_gap_elapsed[port] = 0;
-        }
-    }
+    gap = (long)datasette_advance(port, direction);
     if (!gap) {
         datasette_control(port, DATASETTE_CONTROL_STOP);
         return;
     }
-    if (gap > DATASETTE_MAX_GAP) {
-        datasette_long_gap_pending[port] = (CLOCK)(gap - DATASETTE_MAX_GAP);
-        gap = DATASETTE_MAX_GAP;
-    }
-    datasette_long_gap_elapsed[port] += gap;
-    datasette_last_direction[port] = direction;
-
-    if (direction > 0) {
-        current_image[port]->cycle_counter += gap / 8;
-    } else {
-        current_image[port]->cycle_counter -= gap / 8;
-    }
-
-    if (current_image[port]->mode == DATASETTE_CONTROL_START) {
-        datasette_sound_add_to_circular_buffer((CLOCK)gap);
-    }
 
     gap -= offset;
 
     if (gap > 0) {
-        datasette_alarm_set(port, maincpu_clk + (CLOCK)(gap * (DS_V_PLAY / speed_of_tape)));
+        next_clk = maincpu_clk + (CLOCK)(gap * (DS_V_PLAY / speed_of_tape));
     } else {
         /* If the offset is geater than the gap to the next flux
            change, the change happend during DMA.  Schedule it now.  */
-        datasette_alarm_set(port, maincpu_clk);
+        next_clk = maincpu_clk;
+    }
+
+    if (datasette_can_coalesce(port)) {
+        /* nobody is listening, only wake up now and then to catch up */
+        datasette_deferred[port] = 1;
+        datasette_deferred_clk[port] = next_clk;
+        datasette_alarm_set(port, next_clk + DATASETTE_DEFER_HORIZON);
+    } else {
+        datasette_alarm_set(port, next_clk);
     }
     datasette_update_ui_counter(port);
 }
@@ -944,6 +1068,7 @@ static void datasette_internal_reset(int port)
 
     DBG(("datasette_internal_reset (mode:%d)", mode));
 
+    datasette_deferred[port] = 0;
     if (mode == DATASETTE_CONTROL_START ||
         mode == DATASETTE_CONTROL_FORWARD ||
         mode == DATASETTE_CONTROL_REWIND) {
@@ -1026,6 +1151,7 @@ static void tap_reset_gap(int port)
 static void datasette_control_internal(int port, int command)
 {
     DBG(("datasette_control_internal (%s) (image present:%s)", cmdstr[command], current_image[port] ? "yes" : "no"));
+    datasette_flux_resume(port);
     if (current_image[port]) {
         switch (command) {
             case DATASETTE_CONTROL_RESET_COUNTER:
@@ -1164,6 +1290,8 @@ static void datasette_set_motor(int port, int motor)
         return;
     }
 
+    datasette_flux_resume(port);
+
     if (motor) {
         /* abort pending motor stop */
         motor_stop_clk[port] = 0;
@@ -1359,7 +1487,11 @@ static int datasette_write_snapshot(int port, snapshot_t *s, int write_image)
         return -1;
     }
 
-    if (datasette_alarm_pending[port]) {
+    if (datasette_deferred[port]) {
+        /* the machine has caught up the coalesced flux changes before saving
+           the CIA, store the next one as a regular alarm */
+        alarm_clk = datasette_deferred_clk[port];
+    } else if (datasette_alarm_pending[port]) {
         alarm_clk = datasette_alarm[port]->context->pending_alarms[datasette_alarm[port]->pending_idx].clk;
     }
 
@@ -1428,6 +1560,7 @@ static int datasette_read_snapshot(int port, snapshot_t *s)
         return -1;
     }
 
+    datasette_deferred[port] = 0;
     if (datasette_alarm_pending[port]) {
         alarm_set(datasette_alarm[port], alarm_clk);
     } else {
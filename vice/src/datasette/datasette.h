@@ -89,12 +89,14 @@ void datasette_reset(void);
 void datasette_reset_counter(int port);
 void datasette_event_playback_port1(CLOCK offset, void *data);
 void datasette_event_playback_port2(CLOCK offset, void *data);
+void datasette_flux_catch_up(int port);
 
 /* Emulator specific functions.  */
 void machine_trigger_flux_change(int port, unsigned int on);
 void machine_set_tape_sense(int port, int sense);
 void machine_set_tape_write_in(int port, int val);
 void machine_set_tape_motor_in(int port, int val);
+int machine_tape_flux_observed(int port);
 
 void datasette_set_tape_sense(int port, int sense);
 
@@ -1419,145 +1419,209 @@ static const signed char bump[] = {
     -2, -3, -3
 };
 
-static const signed char nosound[1] = { 0 };
+/* A sample and the one played after it, the motor hum loops forever.  */
+typedef struct drive_sound_sample_s {
+    const signed char *data;
+    unsigned int len;
+    const struct drive_sound_sample_s *next;   /* NULL: silence */
+} drive_sound_sample_t;
+
+static const drive_sound_sample_t hum_sample = { hum, sizeof(hum), &hum_sample };
+static const drive_sound_sample_t spinup_sample = { spinup, sizeof(spinup), &hum_sample };
+static const drive_sound_sample_t spindown_sample = { spindown, sizeof(spindown), NULL };
+static const drive_sound_sample_t stepping_sample = { stepping, sizeof(stepping), NULL };
+static const drive_sound_sample_t stepping2_sample = { stepping2, sizeof(stepping2), NULL };
+static const drive_sound_sample_t bump_sample = { bump, sizeof(bump), NULL };
+
+/* One sound of a drive, all drives play from the same sample data.  */
+typedef struct drive_sound_voice_s {
+    const drive_sound_sample_t *sample;     /* NULL: silent */
+    unsigned int pos;
+} drive_sound_voice_t;
 
 static sound_chip_t drive_sound;
 
 static uint16_t drive_sound_offset;
-static const signed char *step[NUM_DISK_UNITS];
-static const signed char *motor[NUM_DISK_UNITS];
+static drive_sound_voice_t step[NUM_DISK_UNITS];
+static drive_sound_voice_t motor[NUM_DISK_UNITS];
 static int stepvol[NUM_DISK_UNITS];
 static int motorvol[NUM_DISK_UNITS];
 
 static int cycles_per_sec = 1000000;
 static int sample_rate = 22050;
 
+/* The samples are recorded at 44100Hz, this steps through them at the
+   output sample rate.  */
+static int sample_div = 0;
+
+/* Output samples are rendered in blocks, the sample positions advance the
+   same way for all voices so the steps are calculated once per block.  */
+#define DRIVE_SOUND_BLOCK 256
+
+static int drive_sound_advance_block(unsigned int *adv, int nr)
+{
+    int i;
+
+    for (i = 0; i < nr; i++) {
+        unsigned int n = 0;
+
+        sample_div += 44100;
+        while (sample_div >= sample_rate) {
+            sample_div -= sample_rate;
+            n++;
+        }
+        adv[i] = n;
+    }
+    return nr;
+}
+
+/* Render the scaled samples of a voice for a block, returns the number of
+   samples rendered before the voice went silent.  */
+static int drive_sound_render_voice(drive_sound_voice_t *voice, int vol,
+                                    int *out, const unsigned int *adv, int nr)
+{
+    const drive_sound_sample_t *sample = voice->sample;
+    const signed char *data = sample->data;
+    unsigned int pos = voice->pos;
+    unsigned int len = sample->len;
+    int i;
+
+    for (i = 0; i < nr; i++) {
+        out[i] = (data[pos] * vol) >> 8;
+        pos += adv[i];
+        if (pos >= len) {
+            do {
+                pos -= len;
+                sample = sample->next;
+                if (sample == NULL) {
+                    voice->sample = NULL;
+                    voice->pos = 0;
+                    return i + 1;
+                }
+                len = sample->len;
+            } while (pos >= len);
+            data = sample->data;
+        }
+    }
+    voice->sample = sample;
+    voice->pos = pos;
+    return nr;
+}
+
+static int drive_sound_silent(void)
+{
+    int j;
+
+    for (j = 0; j < NUM_DISK_UNITS; j++) {
+        if (motor[j].sample != NULL || step[j].sample != NULL) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* Skip nr output samples while all voices are silent.  */
+static void drive_sound_advance_silent(int nr)
+{
+    sample_div = (int)((sample_div + (int64_t)nr * 44100) % sample_rate);
+}
+
 /* resources */
 #ifdef SOUND_SYSTEM_FLOAT
+/* Add a voice to a block, silent voices are skipped by the caller.  */
+static void drive_sound_mix_voice(drive_sound_voice_t *voice, int vol,
+                                  float *pbuf, const unsigned int *adv, int nr)
+{
+    int v[DRIVE_SOUND_BLOCK];
+    int i, n;
+
+    n = drive_sound_render_voice(voice, vol, v, adv, nr);
+    for (i = 0; i < n; i++) {
+        pbuf[i] += (float)(v[i] / 32767.0);
+    }
+}
+
 /* FIXME */
 static int drive_sound_machine_calculate_samples(sound_t **psid, float *pbuf, int nr, int scc, CLOCK *delta_t)
 {
-    int i, j, nos = 0;
-    static int div = 0;
-    float m, s;
+    unsigned int adv[DRIVE_SOUND_BLOCK];
+    int i, j, n;
 
     for (i = 0; i < nr; i++) {
         pbuf[i] = 0.0;
+    }
+    for (i = 0; i < nr && !drive_sound_silent(); i += n) {
+        n = drive_sound_advance_block(adv, nr - i < DRIVE_SOUND_BLOCK ? nr - i : DRIVE_SOUND_BLOCK);
 
         for (j = 0; j < NUM_DISK_UNITS; j++) {
-            m = ((((*motor[j]) * motorvol[j]) * drive_sound_emulation_volume) >> 8) / 32767.0;
-            s = ((((*step[j]) * stepvol[j]) * drive_sound_emulation_volume) >> 8) / 32767.0;
-
-            pbuf[i] += m;
-            pbuf[i] += s;
-        }
-        div += 44100;
-        while (div >= sample_rate) {
-            div -= sample_rate;
-            nos = 1;
-            for (j = 0; j < NUM_DISK_UNITS; j++) {
-                motor[j]++;
-                if (motor[j] == &spinup[sizeof(spinup)]) {
-                    motor[j] = hum;
-                }
-                if (motor[j] == &hum[sizeof(hum)]) {
-                    motor[j] = hum;
-                }
-                if (motor[j] == &spindown[sizeof(spindown)]) {
-                    motor[j] = nosound;
-                }
-                if (motor[j] == nosound + 1) {
-                    motor[j] = nosound;
-                } else {
-                    nos = 0;
-                }
-                step[j]++;
-                if (step[j] == &stepping[sizeof(stepping)]) {
-                    step[j] = nosound;
-                }
-                if (step[j] == &stepping2[sizeof(stepping2)]) {
-                    step[j] = nosound;
-                }
-                if (step[j] == &bump[sizeof(bump)]) {
-                    step[j] = nosound;
-                }
-                if (step[j] == nosound + 1) {
-                    step[j] = nosound;
-                } else {
-                    nos = 0;
-                }
+            if (motor[j].sample != NULL) {
+                drive_sound_mix_voice(&motor[j], motorvol[j] * drive_sound_emulation_volume,
+                                      pbuf + i, adv, n);
+            }
+            if (step[j].sample != NULL) {
+                drive_sound_mix_voice(&step[j], stepvol[j] * drive_sound_emulation_volume,
+                                      pbuf + i, adv, n);
             }
         }
     }
-    if (nos) {
+    if (i < nr) {
+        drive_sound_advance_silent(nr - i);
+    }
+    if (drive_sound_silent()) {
         drive_sound.chip_enabled = 0;
     }
     return nr;
 }
 #else
+/* Mix a voice into a block, silent voices are skipped by the caller.  */
+static void drive_sound_mix_voice(drive_sound_voice_t *voice, int vol,
+                                  int16_t *pbuf, int soc, const unsigned int *adv, int nr)
+{
+    int v[DRIVE_SOUND_BLOCK];
+    int i, n;
+
+    n = drive_sound_render_voice(voice, vol, v, adv, nr);
+    switch (soc) {
+        default:
+        case SOUND_OUTPUT_MONO:
+            for (i = 0; i < n; i++) {
+                pbuf[i] = sound_audio_mix(pbuf[i], v[i]);
+            }
+            break;
+        case SOUND_OUTPUT_STEREO:
+            for (i = 0; i < n; i++) {
+                pbuf[i * 2] = sound_audio_mix(pbuf[i * 2], v[i]);
+                pbuf[i * 2 + 1] = sound_audio_mix(pbuf[i * 2 + 1], v[i]);
+            }
+            break;
+    }
+}
+
 static int drive_sound_machine_calculate_samples(sound_t **psid, int16_t *pbuf, int nr, int soc, int scc, CLOCK *delta_t)
 {
-    int i, j, nos = 0;
-    static int div = 0;
-    int m, s;
+    unsigned int adv[DRIVE_SOUND_BLOCK];
+    int i, j, n;
 
-    for (i = 0; i < nr; i++) {
+    for (i = 0; i < nr && !drive_sound_silent(); i += n) {
+        n = drive_sound_advance_block(adv, nr - i < DRIVE_SOUND_BLOCK ? nr - i : DRIVE_SOUND_BLOCK);
+
+        /* same mixing order as sample by sample, sound_audio_mix() is not
+           associative */
         for (j = 0; j < NUM_DISK_UNITS; j++) {
-            m = (((*motor[j]) * motorvol[j]) * drive_sound_emulation_volume) >> 8;
-            s = (((*step[j]) * stepvol[j]) * drive_sound_emulation_volume) >> 8;
-            switch (soc) {
-                default:
-                case SOUND_OUTPUT_MONO:
-                    pbuf[i] = sound_audio_mix(pbuf[i], m);
-                    pbuf[i] = sound_audio_mix(pbuf[i], s);
-                    break;
-                case SOUND_OUTPUT_STEREO:
-                    pbuf[i * 2] = sound_audio_mix(pbuf[i * 2], m);
-                    pbuf[i * 2] = sound_audio_mix(pbuf[i * 2], s);
-                    pbuf[i * 2 + 1] = sound_audio_mix(pbuf[i * 2 + 1], m);
-                    pbuf[i * 2 + 1] = sound_audio_mix(pbuf[i * 2 + 1], s);
-                    break;
+            if (motor[j].sample != NULL) {
+                drive_sound_mix_voice(&motor[j], motorvol[j] * drive_sound_emulation_volume,
+                                      pbuf + i * soc, soc, adv, n);
             }
-        }
-        div += 44100;
-        while (div >= sample_rate) {
-            div -= sample_rate;
-            nos = 1;
-            for (j = 0; j < NUM_DISK_UNITS; j++) {
-                motor[j]++;
-                if (motor[j] == &spinup[sizeof(spinup)]) {
-                    motor[j] = hum;
-                }
-                if (motor[j] == &hum[sizeof(hum)]) {
-                    motor[j] = hum;
-                }
-                if (motor[j] == &spindown[sizeof(spindown)]) {
-                    motor[j] = nosound;
-                }
-                if (motor[j] == nosound + 1) {
-                    motor[j] = nosound;
-                } else {
-                    nos = 0;
-                }
-                step[j]++;
-                if (step[j] == &stepping[sizeof(stepping)]) {
-                    step[j] = nosound;
-                }
-                if (step[j] == &stepping2[sizeof(stepping2)]) {
-                    step[j] = nosound;
-                }
-                if (step[j] == &bump[sizeof(bump)]) {
-                    step[j] = nosound;
-                }
-                if (step[j] == nosound + 1) {
-                    step[j] = nosound;
-                } else {
-                    nos = 0;
-                }
+            if (step[j].sample != NULL) {
+                drive_sound_mix_voice(&step[j], stepvol[j] * drive_sound_emulation_volume,
+                                      pbuf + i * soc, soc, adv, n);
             }
         }
     }
-    if (nos) {
+    if (i < nr) {
+        drive_sound_advance_silent(nr - i);
+    }
+    if (drive_sound_silent()) {
         drive_sound.chip_enabled = 0;
     }
     return nr;
@@ -1617,11 +1681,13 @@ void drive_sound_update(int i, int unit)
     sound_store((uint16_t)drive_sound_offset, 0, 0);
     switch (i) {
         case DRIVE_SOUND_MOTOR_ON:
-            motor[unit] = spinup;
+            motor[unit].sample = &spinup_sample;
+            motor[unit].pos = 0;
             drive_sound.chip_enabled = 1;
             break;
         case DRIVE_SOUND_MOTOR_OFF:
-            motor[unit] = spindown;
+            motor[unit].sample = &spindown_sample;
+            motor[unit].pos = 0;
             drive_sound.chip_enabled = 1;
             break;
     }
@@ -1636,12 +1702,14 @@ void drive_sound_head(int track, int dir, int unit)
     sound_store((uint16_t)drive_sound_offset, 0, 0);
     stepvol[unit] = 100 - track;
     if (track == 2 && dir == -1) {
-        if (step[unit] == nosound) {
+        if (step[unit].sample == NULL) {
             drive_sound.chip_enabled = 1;
-            step[unit] = bump;
+            step[unit].sample = &bump_sample;
+            step[unit].pos = 0;
         }
     } else {
-        step[unit] = (track < 18) ? stepping : stepping2;
+        step[unit].sample = (track < 18) ? &stepping_sample : &stepping2_sample;
+        step[unit].pos = 0;
         drive_sound.chip_enabled = 1;
     }
 }
@@ -1650,8 +1718,10 @@ void drive_sound_stop(void)
 {
     int i;
     for (i = 0; i < NUM_DISK_UNITS; i++) {
-        motor[i] = nosound;
-        step[i] = nosound;
+        motor[i].sample = NULL;
+        motor[i].pos = 0;
+        step[i].sample = NULL;
+        step[i].pos = 0;
         stepvol[i] = 0;
     }
     drive_sound.chip_enabled = 0;
@@ -50,6 +50,7 @@
 #include "mem.h"
 #include "monitor.h"
 #include "mos6510.h"
+#include "profiler.h"
 #include "rotation.h"
 #include "snapshot.h"
 #include "types.h"
@@ -124,6 +125,8 @@ void drivecpu_setup_context(struct diskunit_context_s *drv, int i)
     if (i) {
         drv->cpu->alarm_context = alarm_context_new(drv->cpu->identification_string);
     }
+    profile_cpu_setup(&drivecpu_profiler[drv->mynumber], &(diskunit_clk[drv->mynumber]),
+                      &(drv->cpu->alarm_context));
 }
 
 /* ------------------------------------------------------------------------- */
@@ -408,6 +411,8 @@ void drivecpu_execute(diskunit_context_t *drv, CLOCK clk_value)
 
 #define ALARM_CONTEXT (cpu->alarm_context)
 
+#define PROFILER (&drivecpu_profiler[drv->mynumber])
+
 #define JAM() drivecpu_jam(drv)
 
 #define ROM_TRAP_ALLOWED() 1
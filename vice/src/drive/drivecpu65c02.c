@@ -43,6 +43,7 @@
 #include "machine.h"
 #include "mem.h"
 #include "monitor.h"
+#include "profiler.h"
 #include "r65c02.h"
 #include "rotation.h"
 #include "snapshot.h"
@@ -113,6 +114,8 @@ void drivecpu65c02_setup_context(struct diskunit_context_s *drv, int i)
     if (i) {
         drv->cpu->alarm_context = alarm_context_new(drv->cpu->identification_string);
     }
+    profile_cpu_setup(&drivecpu_profiler[drv->mynumber], &(diskunit_clk[drv->mynumber]),
+                      &(drv->cpu->alarm_context));
 }
 
 /* ------------------------------------------------------------------------- */
@@ -386,6 +389,8 @@ void drivecpu65c02_execute(diskunit_context_t *drv, CLOCK clk_value)
 
 #define ALARM_CONTEXT (cpu->alarm_context)
 
+#define PROFILER (&drivecpu_profiler[drv->mynumber])
+
 #define ROM_TRAP_ALLOWED() 1
 
 #define ROM_TRAP_HANDLER() drive_trap_handler(drv)
@@ -51,9 +51,6 @@
 #include "wd1770.h"
 #include "cmdhd.h"
 
-static drive_read_func_t *read_tab_watch[0x101];
-static drive_store_func_t *store_tab_watch[0x101];
-
 /* Current watchpoint state.
           0 = no watchpoints
     bit0; 1 = watchpoints active
@@ -111,17 +108,39 @@ static void drive_store_watch(diskunit_context_t *drv, uint16_t address, uint8_t
     drv->cpud->store_tab[0][address >> 8](drv, address, value);
 }
 
+/* Route the pages covered by watchpoints through the watch functions, all
+   others go to the memory functions directly.  */
+static void drivemem_update_watch_tabs(diskunit_context_t *drv)
+{
+    drivecpud_context_t *cpud = drv->cpud;
+    int i;
+
+    for (i = 0; i <= 0x100; i++) {
+        if (monitor_watch_load_page(drv->cpu->monspace, i)) {
+            cpud->read_tab_watch[i] = (i == 0) ? drive_zero_read_watch : drive_read_watch;
+        } else {
+            cpud->read_tab_watch[i] = cpud->read_tab[0][i];
+        }
+        if (monitor_watch_store_page(drv->cpu->monspace, i)) {
+            cpud->store_tab_watch[i] = (i == 0) ? drive_zero_store_watch : drive_store_watch;
+        } else {
+            cpud->store_tab_watch[i] = cpud->store_tab[0][i];
+        }
+    }
+}
+
 void drivemem_toggle_watchpoints(int flag, void *context)
 {
     diskunit_context_t *drv = (diskunit_context_t *)context;
 
     if (flag) {
-        drv->cpud->read_func_ptr = read_tab_watch;
-        drv->cpud->store_func_ptr = store_tab_watch;
+        drivemem_update_watch_tabs(drv);
+        drv->cpud->read_func_ptr = drv->cpud->read_tab_watch;
+        drv->cpud->store_func_ptr = drv->cpud->store_tab_watch;
         if (flag > 1) {
             /* enable watchpoints on dummy accesses */
-            drv->cpud->read_func_ptr_dummy = read_tab_watch;
-            drv->cpud->store_func_ptr_dummy = store_tab_watch;
+            drv->cpud->read_func_ptr_dummy = drv->cpud->read_tab_watch;
+            drv->cpud->store_func_ptr_dummy = drv->cpud->store_tab_watch;
         } else {
             drv->cpud->read_func_ptr_dummy = drv->cpud->read_tab[0];
             drv->cpud->store_func_ptr_dummy = drv->cpud->store_tab[0];
@@ -205,18 +224,6 @@ void drivemem_bank_poke(int bank, uint16_t addr, uint8_t value, void *context)
 
 void drivemem_init(diskunit_context_t *unit)
 {
-    int i;
-
-    /* setup watchpoint tables */
-    if (!read_tab_watch[0]) {
-        read_tab_watch[0] = drive_zero_read_watch;
-        store_tab_watch[0] = drive_zero_store_watch;
-        for (i = 1; i < 0x101; i++) {
-            read_tab_watch[i] = drive_read_watch;
-            store_tab_watch[i] = drive_store_watch;
-        }
-    }
-
     drivemem_set_func(unit->cpud, 0x00, 0x101, drive_read_free, drive_store_free, drive_peek_free, NULL, 0);
 
     machine_drive_mem_init(unit, unit->type);
@@ -133,6 +133,11 @@ typedef struct drivecpud_context_s {
     uint8_t *read_base_tab[1][0x101];
     uint32_t read_limit_tab[1][0x101];
 
+    /* Tables used while watchpoints are active, only the pages covered by
+       watchpoints go through the watch functions.  */
+    drive_read_func_t *read_tab_watch[0x101];
+    drive_store_func_t *store_tab_watch[0x101];
+
     int sync_factor;
 } drivecpud_context_t;
 
@@ -630,314 +630,334 @@ static inline int rotation_p64_get_delta(drive_t *dptr)
     return P64PulseSamplesPerRotation - rptr->PulseHeadPosition;
 }
 
-/* FIXME: RPM related resources "DriveXRPM" and "DriveXwobble" are ignored for p64 */
+/* Calculate delta to the next NRZI transition flux pulse in the flat pulse array */
+static inline CLOCK rotation_p64_flat_delta(rotation_t *rptr, const p64_uint32_t *Positions,
+                                            p64_uint32_t Count, p64_uint32_t Index)
+{
+    /* normal case */
+    if (Index < Count) {
+        return Positions[Index] - rptr->PulseHeadPosition;
+    }
 
-static void rotation_1541_p64(drive_t *dptr, CLOCK ref_cycles)
+    /* wrap around */
+    /* FIXME: this is incorrect, see https://sourceforge.net/p/vice-emu/bugs/1305/ */
+    return P64PulseSamplesPerRotation - rptr->PulseHeadPosition;
+}
+
+/* Read mode never changes the pulses, so it works on the flat sorted copy of
+   the pulse list instead of walking the linked list */
+static void rotation_1541_p64_read(drive_t *dptr, PP64PulseStream P64PulseStream, CLOCK ref_cycles)
 {
     rotation_t *rptr;
-    PP64PulseStream P64PulseStream;
+    const p64_uint32_t *Positions, *Strengths;
+    p64_uint32_t Index, Count;
     CLOCK DeltaPositionToNextPulse, ToDo;
 
     rptr = &rotation[dptr->diskunit->mynumber];
 
-    P64PulseStream = &dptr->p64->PulseStreams[dptr->side][dptr->current_half_track];
+    P64PulseStreamFlatUpdate(P64PulseStream);
+    Positions = P64PulseStream->FlatPositions;
+    Strengths = P64PulseStream->FlatStrengths;
+    Count = P64PulseStream->FlatCount;
 
-    /* Reset if out of head position bounds */
-    if ((P64PulseStream->UsedLast >= 0) &&
-        (P64PulseStream->Pulses[P64PulseStream->UsedLast].Position <= rptr->PulseHeadPosition)) {
-        P64PulseStream->CurrentIndex = -1;
+    /* Reset if out of head position bounds, else find the first pulse after the head */
+    if ((Count > 0) && (Positions[Count - 1] <= rptr->PulseHeadPosition)) {
+        Index = Count;
     } else {
-        if (P64PulseStream->CurrentIndex < 0) {
-            P64PulseStream->CurrentIndex = P64PulseStream->UsedFirst;
-        } else {
-            while ((P64PulseStream->CurrentIndex >= 0) &&
-                   ((P64PulseStream->CurrentIndex != P64PulseStream->UsedFirst) &&
-                    ((P64PulseStream->Pulses[P64PulseStream->CurrentIndex].Previous >= 0) &&
-                     (P64PulseStream->Pulses[P64PulseStream->Pulses[P64PulseStream->CurrentIndex].Previous].Position > rptr->PulseHeadPosition)))) {
-                P64PulseStream->CurrentIndex = P64PulseStream->Pulses[P64PulseStream->CurrentIndex].Previous;
-            }
-        }
-        while ((P64PulseStream->CurrentIndex >= 0) &&
-               (P64PulseStream->Pulses[P64PulseStream->CurrentIndex].Position <= rptr->PulseHeadPosition)) {
-            P64PulseStream->CurrentIndex = P64PulseStream->Pulses[P64PulseStream->CurrentIndex].Next;
-        }
+        Index = P64PulseStreamFlatSeek(P64PulseStream, rptr->PulseHeadPosition + 1);
     }
 
-    DeltaPositionToNextPulse = rotation_p64_get_delta(dptr);
+    DeltaPositionToNextPulse = rotation_p64_flat_delta(rptr, Positions, Count, Index);
 
-    if (dptr->read_write_mode) {
-        while (ref_cycles > 0) {
-            /****************************************************************************************************************************************/
-            {
-                /* How-Much-16MHz-Clock-Cycles-ToDo-Count logic */
+    while (ref_cycles > 0) {
+        /****************************************************************************************************************************************/
+        {
+            /* How-Much-16MHz-Clock-Cycles-ToDo-Count logic */
 
-                ToDo = DeltaPositionToNextPulse;
-                if (ToDo <= 1) {
-                    ToDo = 1;
-                } else {
-                    if (ref_cycles < (int)ToDo) {
-                        ToDo = ref_cycles;
-                    }
-                    if ((rptr->ue7_counter < 16) && ((16 - rptr->ue7_counter) < (int)ToDo)) {
-                        ToDo = 16 - rptr->ue7_counter;
-                    }
-                    if ((rptr->filter_counter < 40) && ((40 - rptr->filter_counter) < (int)ToDo)) {
-                        ToDo = 40 - rptr->filter_counter;
-                    }
-                    if ((rptr->fr_randcount > 0) && (rptr->fr_randcount < ToDo)) {
-                        ToDo = rptr->fr_randcount;
-                    }
-                    if ((rptr->so_delay > 0) && (rptr->so_delay < (int)ToDo)) {
-                        ToDo = rptr->so_delay;
-                    }
+            ToDo = DeltaPositionToNextPulse;
+            if (ToDo <= 1) {
+                ToDo = 1;
+            } else {
+                if (ref_cycles < (int)ToDo) {
+                    ToDo = ref_cycles;
+                }
+                if ((rptr->ue7_counter < 16) && ((16 - rptr->ue7_counter) < (int)ToDo)) {
+                    ToDo = 16 - rptr->ue7_counter;
+                }
+                if ((rptr->filter_counter < 40) && ((40 - rptr->filter_counter) < (int)ToDo)) {
+                    ToDo = 40 - rptr->filter_counter;
+                }
+                if ((rptr->fr_randcount > 0) && (rptr->fr_randcount < ToDo)) {
+                    ToDo = rptr->fr_randcount;
+                }
+                if ((rptr->so_delay > 0) && (rptr->so_delay < (int)ToDo)) {
+                    ToDo = rptr->so_delay;
                 }
             }
-            /****************************************************************************************************************************************/
-            {
-                /* so signal handling */
-                if (rptr->so_delay) {
-                    rptr->so_delay -= ToDo;
-                    if (!rptr->so_delay) {
-                        dptr->byte_ready_edge = 1;
-                        dptr->byte_ready_level = 1;
-                    }
+        }
+        /****************************************************************************************************************************************/
+        {
+            /* so signal handling */
+            if (rptr->so_delay) {
+                rptr->so_delay -= ToDo;
+                if (!rptr->so_delay) {
+                    dptr->byte_ready_edge = 1;
+                    dptr->byte_ready_level = 1;
                 }
             }
-            /****************************************************************************************************************************************/
-            {
-                /* Clock logic */
-
-                /* update UE7 before a possible reset of decoder to start with requested speedzone instead of todo value */
-                rptr->ue7_counter += ToDo;
-                /* 2.5 microseconds filter */
-                rptr->filter_counter += (rptr->filter_counter < 40) ? ToDo : 0;
-                if (((rptr->filter_counter >= 40) && (rptr->filter_state != rptr->filter_last_state))) {
-                    rptr->filter_last_state = rptr->filter_state;
+        }
+        /****************************************************************************************************************************************/
+        {
+            /* Clock logic */
+
+            /* update UE7 before a possible reset of decoder to start with requested speedzone instead of todo value */
+            rptr->ue7_counter += ToDo;
+            /* 2.5 microseconds filter */
+            rptr->filter_counter += (rptr->filter_counter < 40) ? ToDo : 0;
+            if (((rptr->filter_counter >= 40) && (rptr->filter_state != rptr->filter_last_state))) {
+                rptr->filter_last_state = rptr->filter_state;
+                rptr->uf4_counter = 0;
+                rptr->ue7_counter = rptr->ue7_dcba;
+                rptr->fr_randcount = ((RANDOM_nextUInt(rptr) >> 16) % 31) + 289;
+            } else {
+                rptr->fr_randcount -= ToDo;
+                if (!rptr->fr_randcount) {
                     rptr->uf4_counter = 0;
                     rptr->ue7_counter = rptr->ue7_dcba;
-                    rptr->fr_randcount = ((RANDOM_nextUInt(rptr) >> 16) % 31) + 289;
-                } else {
-                    rptr->fr_randcount -= ToDo;
-                    if (!rptr->fr_randcount) {
-                        rptr->uf4_counter = 0;
-                        rptr->ue7_counter = rptr->ue7_dcba;
-                        rptr->fr_randcount = ((RANDOM_nextUInt(rptr) >> 16) % 367) + 33;
-                    }
+                    rptr->fr_randcount = ((RANDOM_nextUInt(rptr) >> 16) % 367) + 33;
                 }
+            }
 
-                /* Increment the pulse divider clock until the speed zone pulse divider clock threshold value is reached, which is:
-                ** 16-(CurrentSpeedZone & 3), and each overflow, increment the pulse counter clock until the 4th pulse is reached
-                */
+            /* Increment the pulse divider clock until the speed zone pulse divider clock threshold value is reached, which is:
+            ** 16-(CurrentSpeedZone & 3), and each overflow, increment the pulse counter clock until the 4th pulse is reached
+            */
 
-                if (rptr->ue7_counter == 16) {
-                    rptr->ue7_counter = rptr->ue7_dcba;
+            if (rptr->ue7_counter == 16) {
+                rptr->ue7_counter = rptr->ue7_dcba;
 
-                    rptr->uf4_counter = (rptr->uf4_counter + 1) & 0xf;
-                    if ((rptr->uf4_counter & 3) == 2) {
-                        /****************************************************************************************************************************************/
-                        {
-                            /* Decoder logic */
+                rptr->uf4_counter = (rptr->uf4_counter + 1) & 0xf;
+                if ((rptr->uf4_counter & 3) == 2) {
+                    /****************************************************************************************************************************************/
+                    {
+                        /* Decoder logic */
 
-                            rptr->last_read_data = ((rptr->last_read_data << 1) & 0x3fe) | (((rptr->uf4_counter + 0x1c) >> 4) & 1);
+                        rptr->last_read_data = ((rptr->last_read_data << 1) & 0x3fe) | (((rptr->uf4_counter + 0x1c) >> 4) & 1);
 
-                            rptr->last_write_data <<= 1;
+                        rptr->last_write_data <<= 1;
 
-                            /* is sync? reset bit counter, don't move data, etc. */
-                            if (rptr->last_read_data == 0x3ff) {
+                        /* is sync? reset bit counter, don't move data, etc. */
+                        if (rptr->last_read_data == 0x3ff) {
+                            rptr->bit_counter = 0;
+                        } else {
+                            if (++rptr->bit_counter == 8) {
                                 rptr->bit_counter = 0;
-                            } else {
-                                if (++rptr->bit_counter == 8) {
-                                    rptr->bit_counter = 0;
-
-                                    dptr->GCR_read = (uint8_t) rptr->last_read_data;
-
-                                    /* tlr claims that the write register is loaded at every
-                                     * byte boundary, and since the bus is shared, it's reasonable
-                                     * to guess that it would be loaded with whatever was last read. */
-                                    rptr->last_write_data = dptr->GCR_read;
-
-                                    /* BYTE READY signal if enabled */
-                                    if ((dptr->byte_ready_active & BRA_BYTE_READY) != 0) {
-                                        rptr->so_delay = 16 - ((rptr->cycle_index + (ToDo - 1)) & 15);
-                                        if (rptr->so_delay < 10) {
-                                            rptr->so_delay += 16;
-                                        }
+
+                                dptr->GCR_read = (uint8_t) rptr->last_read_data;
+
+                                /* tlr claims that the write register is loaded at every
+                                 * byte boundary, and since the bus is shared, it's reasonable
+                                 * to guess that it would be loaded with whatever was last read. */
+                                rptr->last_write_data = dptr->GCR_read;
+
+                                /* BYTE READY signal if enabled */
+                                if ((dptr->byte_ready_active & BRA_BYTE_READY) != 0) {
+                                    rptr->so_delay = 16 - ((rptr->cycle_index + (ToDo - 1)) & 15);
+                                    if (rptr->so_delay < 10) {
+                                        rptr->so_delay += 16;
                                     }
                                 }
                             }
                         }
-                        /****************************************************************************************************************************************/
                     }
+                    /****************************************************************************************************************************************/
                 }
             }
-            /****************************************************************************************************************************************/
-            {
-                /* Head logic */
+        }
+        /****************************************************************************************************************************************/
+        {
+            /* Head logic */
 
-                DeltaPositionToNextPulse -= ToDo;
+            DeltaPositionToNextPulse -= ToDo;
 
-                /* Track wrap handling */
-                rptr->PulseHeadPosition += ToDo;
-                if (rptr->PulseHeadPosition >= P64PulseSamplesPerRotation) {
-                    rptr->PulseHeadPosition -= P64PulseSamplesPerRotation;
+            /* Track wrap handling */
+            rptr->PulseHeadPosition += ToDo;
+            if (rptr->PulseHeadPosition >= P64PulseSamplesPerRotation) {
+                rptr->PulseHeadPosition -= P64PulseSamplesPerRotation;
 
-                    P64PulseStream->CurrentIndex = P64PulseStream->UsedFirst;
-                    while ((P64PulseStream->CurrentIndex >= 0) &&
-                           (P64PulseStream->Pulses[P64PulseStream->CurrentIndex].Position < rptr->PulseHeadPosition)) {
-                        P64PulseStream->CurrentIndex = P64PulseStream->Pulses[P64PulseStream->CurrentIndex].Next;
-                    }
-                    DeltaPositionToNextPulse = rotation_p64_get_delta(dptr);
-                }
+                Index = P64PulseStreamFlatSeek(P64PulseStream, rptr->PulseHeadPosition);
+                DeltaPositionToNextPulse = rotation_p64_flat_delta(rptr, Positions, Count, Index);
+            }
 
-                /* Next NRZI transition flux pulse handling */
-                if (!DeltaPositionToNextPulse) {
-                    if ((P64PulseStream->CurrentIndex >= 0) &&
-                        (P64PulseStream->Pulses[P64PulseStream->CurrentIndex].Position == rptr->PulseHeadPosition)) {
-                        uint32_t Strength = P64PulseStream->Pulses[P64PulseStream->CurrentIndex].Strength;
-
-                        /* Forward pulse high hit to the decoder logic */
-                        if ((Strength == 0xffffffffUL) ||                                   /* Strong pulse */
-                            (((uint32_t)(RANDOM_nextInt(rptr) ^ 0x80000000UL)) < Strength)) {  /* Weak pulse */
-                            rptr->filter_state ^= 1;
-                            rptr->filter_counter = 0;
-                        }
+            /* Next NRZI transition flux pulse handling */
+            if (!DeltaPositionToNextPulse) {
+                if ((Index < Count) && (Positions[Index] == rptr->PulseHeadPosition)) {
+                    uint32_t Strength = Strengths[Index];
 
-                        P64PulseStream->CurrentIndex = P64PulseStream->Pulses[P64PulseStream->CurrentIndex].Next;
+                    /* Forward pulse high hit to the decoder logic */
+                    if ((Strength == 0xffffffffUL) ||                                   /* Strong pulse */
+                        (((uint32_t)(RANDOM_nextInt(rptr) ^ 0x80000000UL)) < Strength)) {  /* Weak pulse */
+                        rptr->filter_state ^= 1;
+                        rptr->filter_counter = 0;
                     }
-                    DeltaPositionToNextPulse = rotation_p64_get_delta(dptr);
+
+                    Index++;
                 }
+                DeltaPositionToNextPulse = rotation_p64_flat_delta(rptr, Positions, Count, Index);
             }
-            /****************************************************************************************************************************************/
-
-            rptr->cycle_index += ToDo;
-            ref_cycles -= ToDo;
         }
+        /****************************************************************************************************************************************/
+
+        rptr->cycle_index += ToDo;
+        ref_cycles -= ToDo;
+    }
+
+    P64PulseStream->FlatCursor = Index;
+}
+
+/* FIXME: RPM related resources "DriveXRPM" and "DriveXwobble" are ignored for p64 */
+
+static void rotation_1541_p64(drive_t *dptr, CLOCK ref_cycles)
+{
+    rotation_t *rptr;
+    PP64PulseStream P64PulseStream;
+    CLOCK DeltaPositionToNextPulse, ToDo;
+    int head_write = 0;
+
+    rptr = &rotation[dptr->diskunit->mynumber];
+
+    P64PulseStream = &dptr->p64->PulseStreams[dptr->side][dptr->current_half_track];
+
+    if (dptr->read_write_mode) {
+        rotation_1541_p64_read(dptr, P64PulseStream, ref_cycles);
+        return;
+    }
+
+    /* Reset if out of head position bounds */
+    if ((P64PulseStream->UsedLast >= 0) &&
+        (P64PulseStream->Pulses[P64PulseStream->UsedLast].Position <= rptr->PulseHeadPosition)) {
+        P64PulseStream->CurrentIndex = -1;
     } else {
-        int head_write;
+        if (P64PulseStream->CurrentIndex < 0) {
+            P64PulseStream->CurrentIndex = P64PulseStream->UsedFirst;
+        } else {
+            while ((P64PulseStream->CurrentIndex >= 0) &&
+                   ((P64PulseStream->CurrentIndex != P64PulseStream->UsedFirst) &&
+                    ((P64PulseStream->Pulses[P64PulseStream->CurrentIndex].Previous >= 0) &&
+                     (P64PulseStream->Pulses[P64PulseStream->Pulses[P64PulseStream->CurrentIndex].Previous].Position > rptr->PulseHeadPosition)))) {
+                P64PulseStream->CurrentIndex = P64PulseStream->Pulses[P64PulseStream->CurrentIndex].Previous;
+            }
+        }
+        while ((P64PulseStream->CurrentIndex >= 0) &&
+               (P64PulseStream->Pulses[P64PulseStream->CurrentIndex].Position <= rptr->PulseHeadPosition)) {
+            P64PulseStream->CurrentIndex = P64PulseStream->Pulses[P64PulseStream->CurrentIndex].Next;
+        }
+    }
 
-        head_write = 0;
+    DeltaPositionToNextPulse = rotation_p64_get_delta(dptr);
 
-        while (ref_cycles > 0) {
-            /****************************************************************************************************************************************/
-            {
-                /* How-Much-16MHz-Clock-Cycles-ToDo-Count logic */
+    while (ref_cycles > 0) {
+        /****************************************************************************************************************************************/
+        {
+            /* How-Much-16MHz-Clock-Cycles-ToDo-Count logic */
 
-                ToDo = DeltaPositionToNextPulse;
-                if (ToDo <= 1) {
-                    ToDo = 1;
-                } else {
-                    if ((rptr->PulseHeadPosition + ToDo) >= P64PulseSamplesPerRotation) {
-                        ToDo = P64PulseSamplesPerRotation - rptr->PulseHeadPosition;
-                    }
-                    if (ref_cycles < (int)ToDo) {
-                        ToDo = ref_cycles;
-                    }
-                    if ((rptr->ue7_counter < 16) && ((16 - rptr->ue7_counter) < (int)ToDo)) {
-                        ToDo = 16 - rptr->ue7_counter;
-                    }
-                    if ((rptr->so_delay > 0) && (rptr->so_delay < (int)ToDo)) {
-                        ToDo = rptr->so_delay;
-                    }
+            ToDo = DeltaPositionToNextPulse;
+            if (ToDo <= 1) {
+                ToDo = 1;
+            } else {
+                if ((rptr->PulseHeadPosition + ToDo) >= P64PulseSamplesPerRotation) {
+                    ToDo = P64PulseSamplesPerRotation - rptr->PulseHeadPosition;
+                }
+                if (ref_cycles < (int)ToDo) {
+                    ToDo = ref_cycles;
+                }
+                if ((rptr->ue7_counter < 16) && ((16 - rptr->ue7_counter) < (int)ToDo)) {
+                    ToDo = 16 - rptr->ue7_counter;
+                }
+                if ((rptr->so_delay > 0) && (rptr->so_delay < (int)ToDo)) {
+                    ToDo = rptr->so_delay;
                 }
             }
-            /****************************************************************************************************************************************/
-            {
-                /* so signal handling */
-                if (rptr->so_delay) {
-                    rptr->so_delay -= ToDo;
-                    if (!rptr->so_delay) {
-                        dptr->byte_ready_edge = 1;
-                        dptr->byte_ready_level = 1;
-                    }
+        }
+        /****************************************************************************************************************************************/
+        {
+            /* so signal handling */
+            if (rptr->so_delay) {
+                rptr->so_delay -= ToDo;
+                if (!rptr->so_delay) {
+                    dptr->byte_ready_edge = 1;
+                    dptr->byte_ready_level = 1;
                 }
             }
-            /****************************************************************************************************************************************/
-            {
-                /* Clock logic */
-
-                /* Increment the pulse divider clock until the speed zone pulse divider clock threshold value is reached, which is:
-                ** 16-(CurrentSpeedZone & 3), and each overflow, increment the pulse counter clock until the 4th pulse is reached
-                */
-                rptr->ue7_counter += ToDo;
-                if (rptr->ue7_counter == 16) {
-                    rptr->ue7_counter = rptr->ue7_dcba;
+        }
+        /****************************************************************************************************************************************/
+        {
+            /* Clock logic */
+
+            /* Increment the pulse divider clock until the speed zone pulse divider clock threshold value is reached, which is:
+            ** 16-(CurrentSpeedZone & 3), and each overflow, increment the pulse counter clock until the 4th pulse is reached
+            */
+            rptr->ue7_counter += ToDo;
+            if (rptr->ue7_counter == 16) {
+                rptr->ue7_counter = rptr->ue7_dcba;
 
-                    rptr->uf4_counter = (rptr->uf4_counter + 1) & 0xf;
-                    if ((rptr->uf4_counter & 3) == 2) {
-                        /****************************************************************************************************************************************/
+                rptr->uf4_counter = (rptr->uf4_counter + 1) & 0xf;
+                if ((rptr->uf4_counter & 3) == 2) {
+                    /****************************************************************************************************************************************/
 
-                        /* Encoder logic */
+                    /* Encoder logic */
 
-                        rptr->last_read_data = ((rptr->last_read_data << 1) & 0x3fe) | (((rptr->uf4_counter + 0x1c) >> 4) & 1);
+                    rptr->last_read_data = ((rptr->last_read_data << 1) & 0x3fe) | (((rptr->uf4_counter + 0x1c) >> 4) & 1);
 
-                        head_write = (rptr->last_write_data & 0x80) >> 7;
-                        rptr->last_write_data <<= 1;
+                    head_write = (rptr->last_write_data & 0x80) >> 7;
+                    rptr->last_write_data <<= 1;
 
-                        if (++rptr->bit_counter == 8) {
-                            rptr->bit_counter = 0;
+                    if (++rptr->bit_counter == 8) {
+                        rptr->bit_counter = 0;
 
-                            rptr->last_write_data = dptr->GCR_write_value;
+                        rptr->last_write_data = dptr->GCR_write_value;
 
-                            /* BYTE READY signal if enabled */
-                            if ((dptr->byte_ready_active & BRA_BYTE_READY) != 0) {
-                                rptr->so_delay = 16 - ((rptr->cycle_index + (ToDo - 1)) & 15);
-                                if (rptr->so_delay < 10) {
-                                    rptr->so_delay += 16;
-                                }
+                        /* BYTE READY signal if enabled */
+                        if ((dptr->byte_ready_active & BRA_BYTE_READY) != 0) {
+                            rptr->so_delay = 16 - ((rptr->cycle_index + (ToDo - 1)) & 15);
+                            if (rptr->so_delay < 10) {
+                                rptr->so_delay += 16;
                             }
                         }
-
-                        /****************************************************************************************************************************************/
                     }
-                }
-            }
 
-            /****************************************************************************************************************************************/
-            {
-                /* Head logic */
-
-                /* Track wrap handling */
-                rptr->PulseHeadPosition += ToDo;
-                if (rptr->PulseHeadPosition >= P64PulseSamplesPerRotation) {
-                    rptr->PulseHeadPosition -= P64PulseSamplesPerRotation;
-                    P64PulseStream->CurrentIndex = P64PulseStream->UsedFirst;
-                    while ((P64PulseStream->CurrentIndex >= 0) &&
-                           (P64PulseStream->Pulses[P64PulseStream->CurrentIndex].Position < rptr->PulseHeadPosition)) {
-                        P64PulseStream->CurrentIndex = P64PulseStream->Pulses[P64PulseStream->CurrentIndex].Next;
-                    }
+                    /****************************************************************************************************************************************/
                 }
+            }
+        }
 
-                /* Write head handling */
-                if ((!head_write) &&
-                    (P64PulseStream->CurrentIndex >= 0) &&
-                    (P64PulseStream->Pulses[P64PulseStream->CurrentIndex].Position == rptr->PulseHeadPosition)) {
-                    /* Remove pulse */
-                    P64PulseStreamFreePulse(P64PulseStream, P64PulseStream->CurrentIndex);
-                    dptr->P64_dirty = 1;
-                } else if (head_write) {
-                    /* Add a strong flux pulse */
-                    if ((P64PulseStream->CurrentIndex >= 0) &&
-                        (P64PulseStream->Pulses[P64PulseStream->CurrentIndex].Position == rptr->PulseHeadPosition)) {
-                        if (P64PulseStream->Pulses[P64PulseStream->CurrentIndex].Strength != 0xffffffffUL) {
-                            P64PulseStream->Pulses[P64PulseStream->CurrentIndex].Strength = 0xffffffffUL;
-                            dptr->P64_dirty = 1;
-                        }
-                    } else {
-                        P64PulseStreamAddPulse(P64PulseStream, rptr->PulseHeadPosition, 0xffffffffUL);
-                        dptr->P64_dirty = 1;
-                    }
+        /****************************************************************************************************************************************/
+        {
+            /* Head logic */
+
+            /* Track wrap handling */
+            rptr->PulseHeadPosition += ToDo;
+            if (rptr->PulseHeadPosition >= P64PulseSamplesPerRotation) {
+                rptr->PulseHeadPosition -= P64PulseSamplesPerRotation;
+                P64PulseStream->CurrentIndex = P64PulseStream->UsedFirst;
+                while ((P64PulseStream->CurrentIndex >= 0) &&
+                       (P64PulseStream->Pulses[P64PulseStream->CurrentIndex].Position < rptr->PulseHeadPosition)) {
                     P64PulseStream->CurrentIndex = P64PulseStream->Pulses[P64PulseStream->CurrentIndex].Next;
-                    head_write = 0;
                 }
+            }
 
-                /* Calculate new delta */
-                DeltaPositionToNextPulse = rotation_p64_get_delta(dptr);
+            /* Write head handling */
+            if (P64PulseStreamWriteHead(P64PulseStream, rptr->PulseHeadPosition, head_write)) {
+                dptr->P64_dirty = 1;
             }
-            /****************************************************************************************************************************************/
+            head_write = 0;
 
-            rptr->cycle_index += ToDo;
-            ref_cycles -= ToDo;
+            /* Calculate new delta */
+            DeltaPositionToNextPulse = rotation_p64_get_delta(dptr);
         }
+        /****************************************************************************************************************************************/
+
+        rptr->cycle_index += ToDo;
+        ref_cycles -= ToDo;
     }
 }
 
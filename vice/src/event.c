@@ -91,6 +91,11 @@ static int image_number;
 
 static alarm_t *event_alarm = NULL;
 
+/* input events kept for the reverse stepping of the monitor */
+static event_list_state_t *reverse_list = NULL;
+static event_list_t *reverse_playback = NULL;
+static alarm_t *reverse_alarm = NULL;
+
 static log_t event_log = LOG_DEFAULT;
 
 static unsigned int playback_active = 0, record_active = 0;
@@ -381,6 +386,10 @@ void event_record(unsigned int type, void *data, unsigned int size)
     if (record_active == 1) {
         event_record_in_list(event_list, type, data, size);
     }
+    /* a reset restarts the clock, the monitor drops its history instead */
+    if (reverse_list != NULL && reverse_playback == NULL && type != EVENT_RESETCPU) {
+        event_record_in_list(reverse_list, type, data, size);
+    }
 }
 
 
@@ -619,6 +628,114 @@ static void warp_end_list(void)
     memset(curr, 0, sizeof(event_list_t));
     event_list->current = curr;
 }
+/*-----------------------------------------------------------------------*/
+/* Input events for the reverse stepping of the monitor.  They are kept in
+   a separate list, independent of history recording, and are replayed with
+   their own alarm while the monitor re-executes from one of its snapshots. */
+
+static void reverse_alarm_handler(CLOCK offset, void *data)
+{
+    alarm_unset(reverse_alarm);
+
+    while (reverse_playback->type != EVENT_LIST_END
+           && reverse_playback->clk <= maincpu_clk - offset) {
+        switch (reverse_playback->type) {
+            case EVENT_KEYBOARD_MATRIX:
+                keyboard_event_playback(offset, reverse_playback->data);
+                break;
+            case EVENT_KEYBOARD_RESTORE:
+                keyboard_restore_event_playback(offset, reverse_playback->data);
+                break;
+            case EVENT_JOYSTICK_VALUE:
+                joystick_event_playback(offset, reverse_playback->data);
+                break;
+            case EVENT_DATASETTE:
+                datasette_event_playback_port1(offset, reverse_playback->data);
+                break;
+            default:
+                break;
+        }
+        reverse_playback = reverse_playback->next;
+    }
+
+    if (reverse_playback->type != EVENT_LIST_END) {
+        alarm_set(reverse_alarm, reverse_playback->clk);
+    }
+}
+
+/* start collecting input events */
+void event_reverse_start(void)
+{
+    if (reverse_list == NULL) {
+        reverse_list = lib_malloc(sizeof(event_list_state_t));
+        event_register_event_list(reverse_list);
+    }
+}
+
+/* stop collecting and forget all events */
+void event_reverse_stop(void)
+{
+    event_reverse_playback_stop();
+    if (reverse_list != NULL) {
+        event_clear_list(reverse_list);
+        lib_free(reverse_list);
+        reverse_list = NULL;
+    }
+}
+
+/* forget the events before clk */
+void event_reverse_trim(CLOCK clk)
+{
+    event_list_t *next;
+
+    if (reverse_list == NULL) {
+        return;
+    }
+    while (reverse_list->base->type != EVENT_LIST_END
+           && reverse_list->base->clk < clk
+           && reverse_list->base != reverse_playback) {
+        next = reverse_list->base->next;
+        lib_free(reverse_list->base->data);
+        lib_free(reverse_list->base);
+        reverse_list->base = next;
+    }
+}
+
+/* replay the events from clk on, while recording is suspended */
+void event_reverse_playback_start(CLOCK clk)
+{
+    if (reverse_list == NULL) {
+        return;
+    }
+    reverse_playback = reverse_list->base;
+    while (reverse_playback->type != EVENT_LIST_END && reverse_playback->clk < clk) {
+        reverse_playback = reverse_playback->next;
+    }
+    if (reverse_playback->type != EVENT_LIST_END) {
+        alarm_set(reverse_alarm, reverse_playback->clk);
+    } else {
+        alarm_unset(reverse_alarm);
+    }
+}
+
+/* stop replaying; the events not replayed yet belong to a future that no
+   longer happens and are dropped, recording continues from here */
+void event_reverse_playback_stop(void)
+{
+    if (reverse_playback == NULL) {
+        return;
+    }
+    alarm_unset(reverse_alarm);
+
+    if (reverse_playback->type != EVENT_LIST_END) {
+        cut_list(reverse_playback->next);
+        lib_free(reverse_playback->data);
+        memset(reverse_playback, 0, sizeof(event_list_t));
+    }
+    reverse_list->current = reverse_playback;
+    reverse_playback = NULL;
+}
+
 /*-----------------------------------------------------------------------*/
 /* writes or replaces version string in the initial event                */
 static void event_write_version(void)
@@ -1267,6 +1384,7 @@ void event_shutdown(void)
     lib_free(event_snapshot_path_str);
     event_snapshot_path_str = NULL;
     destroy_list();
+    event_reverse_stop();
 }
 
 /*-----------------------------------------------------------------------*/
@@ -1315,4 +1433,6 @@ void event_init(void)
 
     event_alarm = alarm_new(maincpu_alarm_context, "Event",
                             event_alarm_handler, NULL);
+    reverse_alarm = alarm_new(maincpu_alarm_context, "EventReverse",
+                              reverse_alarm_handler, NULL);
 }
@@ -82,5 +82,6 @@ unsigned int fileio_scratch(const char *file_name, const char *path,
 unsigned int fileio_get_bytes_left(fileio_info_t *info);
 unsigned int fileio_seek(fileio_info_t *info, off_t offset, int whence);
 unsigned int fileio_tell(fileio_info_t *info);
+void fileio_shutdown(void);
 
 #endif
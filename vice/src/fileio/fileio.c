@@ -229,3 +229,9 @@ unsigned int fileio_scratch(const char *file_name, const char *path,
 
     return rc;
 }
+
+/* Drop information cached about host directories.  */
+void fileio_shutdown(void)
+{
+    p00_dir_cache_invalidate();
+}
@@ -35,6 +35,7 @@
 #include <ctype.h>
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
 
 #include "archdep.h"
 #include "cbmdos.h"
@@ -158,27 +159,64 @@ static void p00_pad_a0(uint8_t *slot)
     }
 }
 
-static char *p00_file_find(const char *file_name, const char *path)
+/* Cache of the P00 headers of one host directory.
+
+   Looking up a CBM name means opening every *.P?? file in the directory and
+   reading its header, which gets very slow for large directories since the
+   fsdevice does it on every OPEN. The headers are kept here together with the
+   modification time of the directory, which changes whenever an entry is
+   added, removed or renamed. Changes made through this module drop the cache
+   right away, a directory that was modified in the current second is never
+   trusted (the mtime has only second resolution). */
+
+typedef struct p00_dir_cache_entry_s {
+    char *name;                             /* host file name */
+    uint8_t cbmname[P00_HDR_CBMNAME_LEN];   /* name from header, $a0 padded */
+} p00_dir_cache_entry_t;
+
+typedef struct p00_dir_cache_s {
+    char *path;
+    time_t mtime;
+    int valid;
+    unsigned int count;
+    unsigned int size;
+    p00_dir_cache_entry_t *entries;
+} p00_dir_cache_t;
+
+static p00_dir_cache_t p00_dir_cache = { NULL, 0, 0, 0, 0, NULL };
+
+void p00_dir_cache_invalidate(void)
+{
+    unsigned int i;
+
+    for (i = 0; i < p00_dir_cache.count; i++) {
+        lib_free(p00_dir_cache.entries[i].name);
+    }
+    lib_free(p00_dir_cache.entries);
+    lib_free(p00_dir_cache.path);
+
+    p00_dir_cache.path = NULL;
+    p00_dir_cache.entries = NULL;
+    p00_dir_cache.count = 0;
+    p00_dir_cache.size = 0;
+    p00_dir_cache.valid = 0;
+}
+
+static int p00_dir_cache_build(const char *path, time_t mtime)
 {
     archdep_dir_t *host_dir;
     struct rawfile_info_s *rawfile;
-    uint8_t p00_header_file_name[P00_HDR_CBMNAME_LEN];
+    p00_dir_cache_entry_t *entry;
     const char *name;
-    char *alloc_name = NULL;
-    int rc;
+
+    p00_dir_cache_invalidate();
 
     host_dir = archdep_opendir(path, ARCHDEP_OPENDIR_ALL_FILES);
     if (host_dir == NULL) {
-        return NULL;
+        return -1;
     }
 
-    while (1) {
-        name = archdep_readdir(host_dir);
-
-        if (name == NULL) {
-            break;
-        }
-
+    while ((name = archdep_readdir(host_dir)) != NULL) {
         if (p00_check_name(name) < 0) {
             continue;
         }
@@ -188,32 +226,61 @@ static char *p00_file_find(const char *file_name, const char *path)
             continue;
         }
 
-        rc = p00_read_header(rawfile, (uint8_t *)p00_header_file_name, NULL);
+        if (p00_dir_cache.count == p00_dir_cache.size) {
+            p00_dir_cache.size = p00_dir_cache.size ? p00_dir_cache.size * 2 : 64;
+            p00_dir_cache.entries = lib_realloc(p00_dir_cache.entries,
+                    p00_dir_cache.size * sizeof(p00_dir_cache_entry_t));
+        }
+        entry = &p00_dir_cache.entries[p00_dir_cache.count];
 
-        if (rc >= 0) {
-            uint8_t *cname;
-            unsigned int equal;
+        if (p00_read_header(rawfile, entry->cbmname, NULL) >= 0) {
+            p00_pad_a0(entry->cbmname);
+            entry->name = lib_strdup(name);
+            p00_dir_cache.count++;
+        }
 
-            p00_pad_a0(p00_header_file_name);
-            cname = cbmdos_dir_slot_create(file_name, (unsigned int)strlen(file_name));
-            equal = cbmdos_parse_wildcard_compare(cname, p00_header_file_name);
-            lib_free(cname);
+        rawfile_destroy(rawfile);
+    }
 
-            if (equal > 0) {
-                alloc_name = lib_strdup(name);
-            } else {
-                rc = -1;
-            }
+    archdep_closedir(host_dir);
+
+    p00_dir_cache.path = lib_strdup(path);
+    p00_dir_cache.mtime = mtime;
+    /* only keep the result if a later change must show up in the mtime */
+    p00_dir_cache.valid = time(NULL) > mtime + 1;
+
+    return 0;
+}
+
+static char *p00_file_find(const char *file_name, const char *path)
+{
+    uint8_t *cname;
+    char *alloc_name = NULL;
+    time_t mtime;
+    unsigned int i;
+
+    if (archdep_stat_mtime(path, &mtime) < 0) {
+        return NULL;
+    }
+
+    if (!p00_dir_cache.valid || p00_dir_cache.mtime != mtime
+        || strcmp(p00_dir_cache.path, path) != 0) {
+        if (p00_dir_cache_build(path, mtime) < 0) {
+            return NULL;
         }
+    }
 
-        rawfile_destroy(rawfile);
+    cname = cbmdos_dir_slot_create(file_name, (unsigned int)strlen(file_name));
 
-        if (rc >= 0) {
+    for (i = 0; i < p00_dir_cache.count; i++) {
+        if (cbmdos_parse_wildcard_compare(cname,
+                                          p00_dir_cache.entries[i].cbmname) > 0) {
+            alloc_name = lib_strdup(p00_dir_cache.entries[i].name);
             break;
         }
     }
 
-    archdep_closedir(host_dir);
+    lib_free(cname);
 
     return alloc_name;
 }
@@ -402,6 +469,14 @@ fileio_info_t *p00_open(const char *file_name, const char *path,
         return NULL;
     }
 
+    switch (command & FILEIO_COMMAND_MASK) {
+        case FILEIO_COMMAND_WRITE:
+        case FILEIO_COMMAND_OVERWRITE:
+        case FILEIO_COMMAND_READ_WRITE:
+            p00_dir_cache_invalidate();
+            break;
+    }
+
     type = p00_check_name(fname);
 
     rawfile = rawfile_open(fname, path, command & FILEIO_COMMAND_MASK);
@@ -529,6 +604,7 @@ unsigned int p00_rename(const char *src_name, const char *dst_name,
     }
 
     rawfile_destroy(rawfile);
+    p00_dir_cache_invalidate();
 
     p00_dst = p00_file_create(dst_name, path, type);
 
@@ -557,6 +633,7 @@ unsigned int p00_scratch(const char *file_name, const char *path)
     }
 
     rc = rawfile_remove(p00_src, path);
+    p00_dir_cache_invalidate();
 
     lib_free(p00_src);
 
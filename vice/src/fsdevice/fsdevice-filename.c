@@ -28,7 +28,9 @@
 
 #include "vice.h"
 
+#include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #include "archdep.h"
 #include "charset.h"
@@ -85,87 +87,294 @@
    invalid character in filenames on linux. */
 #define LONGNAMEMARKER '/'
 
+#define MAXDIRPOSMARK (10+26+26)
+
+static const char *dirposmark[2] = {
+    "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ",
+    "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz"};
+
 /*
-    convert real (long) name into shortened representation
+    The short name of an entry depends on all entries before it, so creating it
+    for a single name means a pass over the whole directory. Doing that for
+    every line of a directory listing, or for every entry while looking up a
+    short name, made both quadratic in the number of files.
+
+    Instead the short names of all entries of the current directory of a unit
+    are computed in one go, and kept together with the modification time of
+    the directory, which changes whenever an entry is added, removed or renamed.
+    A directory that was modified in the current second is never trusted, since
+    the mtime has only second resolution.
+
+    All tables exist twice, index 0 holds the ASCII names, index 1 the PETSCII
+    names (see "mode" below).
+*/
 
-    mode    0 - name is ASCII
-            1 - name is PETSCII
+typedef struct shortname_cache_s {
+    char *path;
+    time_t mtime;
+    int valid;
+    int count;
+    char **longname[2];     /* converted host name of each entry */
+    char **shortname[2];    /* short name of each entry, or its long name */
+    char **key[2];          /* converted ASCII short name, used to expand */
+    uint8_t *failed[2];     /* no unique short name could be created */
+    int *by_longname[2];    /* entry indices sorted by longname */
+    int *by_key[2];         /* entry indices sorted by key */
+} shortname_cache_t;
+
+static shortname_cache_t shortname_cache[FSDEVICE_DEVICE_MAX];
+
+static char **sort_names;
+
+static int sort_names_cmp(const void *a, const void *b)
+{
+    int ia = *(const int *)a;
+    int ib = *(const int *)b;
+    int rc = strcmp(sort_names[ia], sort_names[ib]);
+
+    /* keep directory order for equal names, the first one wins */
+    return rc ? rc : ia - ib;
+}
+
+static int sort_prefix_cmp(const void *a, const void *b)
+{
+    int ia = *(const int *)a;
+    int ib = *(const int *)b;
+    int rc = strncmp(sort_names[ia], sort_names[ib], 14);
+
+    return rc ? rc : ia - ib;
+}
+
+static int *sort_index(char **names, int count)
+{
+    int *index;
+    int i;
+
+    index = lib_malloc((count + 1) * sizeof(int));
+    for (i = 0; i < count; i++) {
+        index[i] = i;
+    }
+    sort_names = names;
+    qsort(index, (size_t)count, sizeof(int), sort_names_cmp);
+    sort_names = NULL;
+
+    return index;
+}
+
+/* return the first entry (in directory order) called name, or -1 */
+static int find_index(char **names, const int *index, int count, const char *name)
+{
+    int lo = 0, hi = count;
+
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+
+        if (strcmp(names[index[mid]], name) < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    if (lo < count && !strcmp(names[index[lo]], name)) {
+        return index[lo];
+    }
+    return -1;
+}
+
+static void shortname_cache_clear(shortname_cache_t *cache)
+{
+    int i, mode;
+
+    for (mode = 0; mode < 2; mode++) {
+        for (i = 0; i < cache->count; i++) {
+            lib_free(cache->longname[mode][i]);
+            lib_free(cache->shortname[mode][i]);
+            lib_free(cache->key[mode][i]);
+        }
+        lib_free(cache->longname[mode]);
+        lib_free(cache->shortname[mode]);
+        lib_free(cache->key[mode]);
+        lib_free(cache->failed[mode]);
+        lib_free(cache->by_longname[mode]);
+        lib_free(cache->by_key[mode]);
+    }
+    lib_free(cache->path);
+    memset(cache, 0, sizeof(shortname_cache_t));
+}
+
+/*
+    create the short names of all entries in one mode
+
+    - count the number of files that are the same for the first 14 chars
+      up to and including the current one (in directory order)
+    - names of up to 16 chars are left alone
 */
+static void shortname_cache_shorten(shortname_cache_t *cache, int mode)
+{
+    char **names = cache->longname[mode];
+    int *prefix;
+    int i, n = 0, group = 0, dirpos = 0;
+
+    /* entries shorter than 14 chars can not share the prefix of a long name */
+    prefix = lib_malloc((cache->count + 1) * sizeof(int));
+    for (i = 0; i < cache->count; i++) {
+        cache->shortname[mode][i] = lib_strdup(names[i]);
+        if (strlen(names[i]) >= 14) {
+            prefix[n++] = i;
+        }
+    }
 
-#define MAXDIRPOSMARK (10+26+26)
+    /* sort by 14 char prefix, directory order within the same prefix */
+    sort_names = names;
+    qsort(prefix, (size_t)n, sizeof(int), sort_prefix_cmp);
+    sort_names = NULL;
 
-static int _limit_longname(archdep_dir_t *archdep_dir, vdrive_t *vdrive, char *longname, int mode)
+    for (i = 0; i < n; i++) {
+        char *name;
+
+        if (i == 0 || strncmp(names[prefix[group]], names[prefix[i]], 14)) {
+            group = i;
+            dirpos = 0;
+        }
+        dirpos++;
+
+        name = cache->shortname[mode][prefix[i]];
+        if (strlen(name) > 16) {
+            if (dirpos >= MAXDIRPOSMARK) {
+                cache->failed[mode][prefix[i]] = 1;
+            } else {
+                name[14] = dirposmark[mode][dirpos];
+                name[15] = LONGNAMEMARKER;
+                name[16] = 0;
+            }
+        }
+    }
+
+    lib_free(prefix);
+}
+
+static shortname_cache_t *shortname_cache_get(vdrive_t *vdrive)
 {
+    shortname_cache_t *cache = &shortname_cache[vdrive->unit - 8];
+    archdep_dir_t *host_dir;
     const char *direntry;
-    char newname[ARCHDEP_PATH_MAX];
-    int longnames;
-    int dirpos = 0;
-    int tmppos;
-    char *dirposmark[2] = {
-        "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ",
-        "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz"};
+    char *prefix;
+    time_t mtime;
+    int i, mode, size = 0;
 
-    DBG(("limit_longname enter '%s' mode: %d\n", longname, mode));
-    if (resources_get_int("FSDeviceLongNames", &longnames) < 0) {
-        return -1;
+    prefix = fsdevice_get_path(vdrive->unit);
+    DBG(("shortname_cache_get path '%s'\n", prefix));
+
+    if (archdep_stat_mtime(prefix, &mtime) < 0) {
+        shortname_cache_clear(cache);
+        return NULL;
     }
 
-    if (!longnames) {
-        if (strlen(longname) > 16) {
-            tmppos = archdep_telldir(archdep_dir);
-            archdep_rewinddir(archdep_dir);
-
-            while(1) {
-                direntry = archdep_readdir(archdep_dir);
-                if (direntry == NULL) {
-                    break;
-                }
-                strcpy(newname, direntry);
-                if (mode) {
-                    charset_petconvstring((uint8_t *)newname, CONVERT_TO_PETSCII);   /* ASCII name to PETSCII */
-                }
-                if (!strncmp(newname, longname, 14)) {
-                    dirpos++;
-                    /* handle max count */
-                    if (dirpos == MAXDIRPOSMARK) {
-                        log_error(LOG_DEFAULT, "could not make a unique short name for '%s'", longname);
-                        archdep_seekdir(archdep_dir, tmppos);
-                        return -1;
-                    }
-                    DBG(("limit_longname found partial '%s'\n", longname));
-                }
-                DBG(("limit_longname>%d '%s'->'%s' (%s)\n", dirpos, direntry, newname, longname));
-                if (!strcmp(newname, longname)) {
-                    DBG(("limit_longname found full '%s'\n", longname));
-                    longname[14] = dirposmark[mode][dirpos];
-                    longname[15] = LONGNAMEMARKER;
-                    longname[16] = 0;
-                    break;
-                }
+    if (cache->valid && cache->mtime == mtime && !strcmp(cache->path, prefix)) {
+        return cache;
+    }
+
+    shortname_cache_clear(cache);
+
+    host_dir = archdep_opendir(prefix, ARCHDEP_OPENDIR_ALL_FILES);
+    if (host_dir == NULL) {
+        return NULL;
+    }
+
+    while ((direntry = archdep_readdir(host_dir)) != NULL) {
+        if (cache->count == size) {
+            size = size ? size * 2 : 64;
+            for (mode = 0; mode < 2; mode++) {
+                cache->longname[mode] = lib_realloc(cache->longname[mode],
+                                                    size * sizeof(char *));
             }
-            archdep_seekdir(archdep_dir, tmppos);
         }
+        cache->longname[0][cache->count] = lib_strdup(direntry);
+        cache->longname[1][cache->count] = lib_strdup(direntry);
+        charset_petconvstring((uint8_t *)cache->longname[1][cache->count],
+                              CONVERT_TO_PETSCII);   /* ASCII name to PETSCII */
+        cache->count++;
+    }
+    archdep_closedir(host_dir);
+
+    for (mode = 0; mode < 2; mode++) {
+        cache->shortname[mode] = lib_malloc((cache->count + 1) * sizeof(char *));
+        cache->key[mode] = lib_malloc((cache->count + 1) * sizeof(char *));
+        cache->failed[mode] = lib_calloc(cache->count + 1, 1);
+        shortname_cache_shorten(cache, mode);
+        cache->by_longname[mode] = sort_index(cache->longname[mode], cache->count);
     }
-    DBG(("limit_longname return '%s'\n", longname));
 
-    return 0;
+    /* expanding always compares against the ASCII short name */
+    for (mode = 0; mode < 2; mode++) {
+        for (i = 0; i < cache->count; i++) {
+            cache->key[mode][i] = lib_strdup(cache->shortname[0][i]);
+            if (mode) {
+                charset_petconvstring((uint8_t *)cache->key[mode][i],
+                                      CONVERT_TO_PETSCII);   /* ASCII name to PETSCII */
+            }
+        }
+        cache->by_key[mode] = sort_index(cache->key[mode], cache->count);
+    }
+
+    cache->path = lib_strdup(prefix);
+    cache->mtime = mtime;
+    /* only keep the result if a later change must show up in the mtime */
+    cache->valid = time(NULL) > mtime + 1;
+
+    return cache;
 }
 
+/*
+    convert real (long) name into shortened representation
+
+    mode    0 - name is ASCII
+            1 - name is PETSCII
+*/
 static int limit_longname(vdrive_t *vdrive, char *longname, int mode)
 {
-    archdep_dir_t *archdep_dir;
-    char *prefix;
-    int ret = -1;
+    shortname_cache_t *cache;
+    int longnames;
+    int i, dirpos;
 
-    prefix = fsdevice_get_path(vdrive->unit);
-    DBG(("limit_longname path '%s'\n", prefix));
+    DBG(("limit_longname enter '%s' mode: %d\n", longname, mode));
+    if (resources_get_int("FSDeviceLongNames", &longnames) < 0) {
+        return -1;
+    }
+
+    if (longnames || strlen(longname) <= 16) {
+        return 0;
+    }
+
+    cache = shortname_cache_get(vdrive);
+    if (cache == NULL) {
+        return -1;
+    }
 
-    archdep_dir = archdep_opendir(prefix, ARCHDEP_OPENDIR_ALL_FILES);
-    if (archdep_dir != NULL) {
-        ret = _limit_longname(archdep_dir, vdrive, longname, mode);
-        archdep_closedir(archdep_dir);
+    i = find_index(cache->longname[mode], cache->by_longname[mode],
+                   cache->count, longname);
+    if (i < 0) {
+        /* not in the directory, only the counter can overflow */
+        for (dirpos = 0, i = 0; i < cache->count; i++) {
+            if (!strncmp(cache->longname[mode][i], longname, 14)
+                && ++dirpos == MAXDIRPOSMARK) {
+                log_error(LOG_DEFAULT, "could not make a unique short name for '%s'", longname);
+                return -1;
+            }
+        }
+        return 0;
     }
-    return ret;
+
+    if (cache->failed[mode][i]) {
+        log_error(LOG_DEFAULT, "could not make a unique short name for '%s'", longname);
+        return -1;
+    }
+
+    strcpy(longname, cache->shortname[mode][i]);
+    DBG(("limit_longname return '%s'\n", longname));
+
+    return 0;
 }
 
 /*
@@ -177,11 +386,10 @@ static int limit_longname(vdrive_t *vdrive, char *longname, int mode)
 
 static char *expand_shortname(vdrive_t *vdrive, char *shortname, int mode)
 {
-    archdep_dir_t *host_dir;
-    const char *direntry;
-    char *prefix;
+    shortname_cache_t *cache;
     char *longname;
     int longnames;
+    int i;
 
     if (resources_get_int("FSDeviceLongNames", &longnames) < 0) {
         longnames = 0;
@@ -189,47 +397,39 @@ static char *expand_shortname(vdrive_t *vdrive, char *shortname, int mode)
 
     DBG(("expand_shortname shortname '%s' mode: %d\n", shortname, mode));
 
-    /* get a buffer for the new name */
-    longname = lib_malloc(ARCHDEP_PATH_MAX);
+    if (shortname == NULL) {
+        return NULL;
+    }
 
     if (!longnames) {
-        prefix = fsdevice_get_path(vdrive->unit);
-        DBG(("expand_shortname path '%s'\n", prefix));
-
-        host_dir = archdep_opendir(prefix, ARCHDEP_OPENDIR_ALL_FILES);
-        if (host_dir == NULL) {
+        cache = shortname_cache_get(vdrive);
+        if (cache == NULL) {
             return NULL;
         }
 
-        while(1) {
-            direntry = archdep_readdir(host_dir);
-            if (direntry == NULL) {
-                break;
-            }
-            /* create the short name for this entry and see if it matches */
-            strcpy(longname, direntry);
-            _limit_longname(host_dir, vdrive, longname, 0);
-            if (mode) {
-                charset_petconvstring((uint8_t *)longname, CONVERT_TO_PETSCII);   /* ASCII name to PETSCII */
-            }
-            DBG(("expand_shortname>'%s'->'%s'('%s')\n", direntry, longname, shortname));
-            if (!strcmp(longname, shortname)) {
-                strcpy(longname, direntry);
-                if (mode) {
-                    charset_petconvstring((uint8_t *)longname, CONVERT_TO_PETSCII);   /* ASCII name to PETSCII */
-                }
-                archdep_closedir(host_dir);
-                return longname;
-            }
+        i = find_index(cache->key[mode], cache->by_key[mode], cache->count,
+                       shortname);
+        if (i >= 0) {
+            DBG(("expand_shortname>'%s'->'%s'\n", shortname, cache->longname[mode][i]));
+            return lib_strdup(cache->longname[mode][i]);
         }
-        archdep_closedir(host_dir);
     }
     /* copy original string to the new name */
-    strcpy(longname, shortname);
+    longname = lib_strdup(shortname);
     DBG(("expand_shortname return '%s'\n", longname));
     return longname;
 }
 
+/* free the cached short names of all units */
+void fsdevice_filename_shutdown(void)
+{
+    int i;
+
+    for (i = 0; i < FSDEVICE_DEVICE_MAX; i++) {
+        shortname_cache_clear(&shortname_cache[i]);
+    }
+}
+
 
 /* takes a short name and returns a pointer to a long name
 
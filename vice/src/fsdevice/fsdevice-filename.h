@@ -38,4 +38,6 @@ int fsdevice_limit_namelength_ascii(vdrive_t *vdrive, char *name);
 char *fsdevice_expand_shortname(vdrive_t *vdrive, char *name);
 char *fsdevice_expand_shortname_ascii(vdrive_t *vdrive, char *name);
 
+void fsdevice_filename_shutdown(void);
+
 #endif
@@ -61,8 +61,31 @@
 # define DBG(x)
 #endif
 
+/* Get the next byte of a file opened for sequential reading. The file is read
+   in blocks, a byte at a time through all fileio layers is slow. Returns 1 at
+   EOF, -1 on error. */
+static int read_ahead(bufinfo_t *bufinfo, uint8_t *data)
+{
+    if (bufinfo->readpos >= bufinfo->readlen) {
+        bufinfo->readlen = fileio_read(bufinfo->fileio_info, bufinfo->readbuf,
+                                       FSDEVICE_READAHEAD_SIZE);
+        bufinfo->readpos = 0;
+        if (fileio_ferror(bufinfo->fileio_info)) {
+            bufinfo->readlen = 0;
+            return -1;
+        }
+        if (bufinfo->readlen == 0) {
+            return 1;
+        }
+    }
+    *data = bufinfo->readbuf[bufinfo->readpos++];
+    return 0;
+}
+
 static int command_read(bufinfo_t *bufinfo, uint8_t *data)
 {
+    int rc;
+
     if (bufinfo->tape->name) {
         if (bufinfo->buflen > 0) {
             *data = *bufinfo->bufp++;
@@ -120,19 +143,21 @@ static int command_read(bufinfo_t *bufinfo, uint8_t *data)
             }
             /* If this is our first read, read in first byte */
             if (!bufinfo->isbuffered) {
-                bufinfo->iseof = !fileio_read(bufinfo->fileio_info, &(bufinfo->buffered), 1);
+                rc = read_ahead(bufinfo, &(bufinfo->buffered));
+                bufinfo->iseof = (rc != 0);
                 /* We shouldn't get an EOF at this point */
                 /* Check for errors */
-                if (fileio_ferror(bufinfo->fileio_info)) {
+                if (rc < 0) {
                     return SERIAL_ERROR;
                 }
             }
             /* Place it in the output field */
             *data = bufinfo->buffered;
             /* Read the next buffer; if nothing read, set EOF signal */
-            bufinfo->iseof = !fileio_read(bufinfo->fileio_info, &(bufinfo->buffered), 1);
+            rc = read_ahead(bufinfo, &(bufinfo->buffered));
+            bufinfo->iseof = (rc != 0);
             /* Check for errors */
-            if (fileio_ferror(bufinfo->fileio_info)) {
+            if (rc < 0) {
                 return SERIAL_ERROR;
             }
             /* Indicate we have something in the buffer for the next read */
@@ -46,6 +46,7 @@
 #include "cbmdos.h"
 #include "fileio.h"
 #include "fsdevice-close.h"
+#include "fsdevice-filename.h"
 #include "fsdevice-flush.h"
 #include "fsdevice-open.h"
 #include "fsdevice-read.h"
@@ -224,6 +225,7 @@ void fsdevice_init(void)
             bufinfo[j].dir = lib_calloc(1, ARCHDEP_PATH_MAX);
             bufinfo[j].name = lib_calloc(1, ARCHDEP_PATH_MAX);
             bufinfo[j].dirmask = lib_calloc(1, ARCHDEP_PATH_MAX);
+            bufinfo[j].readbuf = lib_malloc(FSDEVICE_READAHEAD_SIZE);
         }
     }
 }
@@ -242,9 +244,13 @@ void fsdevice_shutdown(void)
             lib_free(bufinfo[j].dir);
             lib_free(bufinfo[j].name);
             lib_free(bufinfo[j].dirmask);
+            lib_free(bufinfo[j].readbuf);
         }
 
         lib_free(fsdevice_dev[i].errorl);
         lib_free(fsdevice_dev[i].cmdbuf);
     }
+
+    fsdevice_filename_shutdown();
+    fileio_shutdown();
 }
@@ -33,6 +33,9 @@
 #define FSDEVICE_BUFFER_MAX 16
 #define FSDEVICE_DEVICE_MAX 4
 
+/* size of the read-ahead buffer of a channel opened for reading */
+#define FSDEVICE_READAHEAD_SIZE 256
+
 #define FSDEVICE_TRACK_MAX   80
 #define FSDEVICE_SECTOR_MAX  32
 
@@ -58,6 +61,9 @@ struct bufinfo_s {
     int isbuffered; /* TRUE is a byte exists in the buffer above */
     int iseof;      /* TRUE if an EOF is detected on a buffered read */
     char *dirmask;
+    uint8_t *readbuf;           /* read-ahead of a sequential read */
+    unsigned int readlen;       /* number of bytes in readbuf */
+    unsigned int readpos;       /* next byte in readbuf */
                     /* REL file support */
     int reclen;
     int num_records;
@@ -256,6 +256,12 @@ static int cmdline_config(const char *param, void *extra_param)
     return 0;
 }
 
+static int cmdline_testrunner(const char *param, void *extra_param)
+{
+    /* like "-config", the test runner options are handled in main.c */
+    return 0;
+}
+
 static int cmdline_add_config(const char *param, void *extra_param)
 {
     return resources_load(param);
@@ -425,6 +431,15 @@ static const cmdline_option_t common_cmdline_options[] =
     { "-seed", CALL_FUNCTION, CMDLINE_ATTRIB_NEED_ARGS,
       cmdline_seed, NULL, NULL, NULL,
       "<value>", "Set random seed (for debugging)" },
+    { "-testrunner", CALL_FUNCTION, CMDLINE_ATTRIB_NEED_ARGS,
+      cmdline_testrunner, NULL, NULL, NULL,
+      "<filename>", "Run the regression tests listed in the manifest and exit" },
+    { "-testjobs", CALL_FUNCTION, CMDLINE_ATTRIB_NEED_ARGS,
+      cmdline_testrunner, NULL, NULL, NULL,
+      "<value>", "Number of tests the test runner runs at the same time (0: one per CPU)" },
+    { "-testreport", CALL_FUNCTION, CMDLINE_ATTRIB_NEED_ARGS,
+      cmdline_testrunner, NULL, NULL, NULL,
+      "<filename>", "Write the test runner results to a JSON file (JUnit XML if the name ends with .xml)" },
     { "-core", SET_RESOURCE, CMDLINE_ATTRIB_NONE,
       NULL, NULL, "DoCoreDump", (resource_value_t)1,
       NULL, "Allow production of core dumps" },
@@ -1020,6 +1020,18 @@ double lib_double_rand_unit(void)
     return 0x1.0p-32 * rand_uint32();
 }
 
+/* Get and set the exact generator state, so that a saved machine state can be
+ * re-executed with the same sequence of random numbers.  */
+uint64_t lib_rand_get_state(void)
+{
+    return rand_state;
+}
+
+void lib_rand_set_state(uint64_t state)
+{
+    rand_state = state;
+}
+
 static uint64_t initalseed;
 void lib_rand_printseed(log_t log)
 {
@@ -64,6 +64,8 @@ double lib_double_rand_unit(void);
 
 void lib_rand_seed(uint64_t seed);
 void lib_rand_printseed(log_t log);
+uint64_t lib_rand_get_state(void);
+void lib_rand_set_state(uint64_t state);
 
 char *lib_msprintf(const char *fmt, ...) VICE_ATTR_PRINTF;
 char *lib_mvsprintf(const char *fmt, va_list args);
@@ -416,6 +416,18 @@ void P64PulseStreamClear(PP64PulseStream Instance) {
     if(Instance->Pulses) {
         p64_free(Instance->Pulses);
     }
+    if(Instance->FlatPositions) {
+        p64_free(Instance->FlatPositions);
+    }
+    if(Instance->FlatStrengths) {
+        p64_free(Instance->FlatStrengths);
+    }
+    Instance->FlatPositions = 0;
+    Instance->FlatStrengths = 0;
+    Instance->FlatAllocated = 0;
+    Instance->FlatCount = 0;
+    Instance->FlatValid = 0;
+    Instance->FlatCursor = 0;
     Instance->Pulses = 0;
     Instance->PulsesAllocated = 0;
     Instance->PulsesCount = 0;
@@ -454,6 +466,7 @@ p64_int32_t P64PulseStreamAllocatePulse(PP64PulseStream Instance) {
 }
 
 void P64PulseStreamFreePulse(PP64PulseStream Instance, p64_int32_t Index) {
+    Instance->FlatValid = 0;
     if(Instance->CurrentIndex == Index) {
         Instance->CurrentIndex = Instance->Pulses[Index].Next;
     }
@@ -515,6 +528,7 @@ void P64PulseStreamAddPulse(PP64PulseStream Instance, p64_uint32_t Position, p64
     Instance->Pulses[Index].Position = Position;
     Instance->Pulses[Index].Strength = Strength;
     Instance->CurrentIndex = Index;
+    Instance->FlatValid = 0;
 }
 
 void P64PulseStreamRemovePulses(PP64PulseStream Instance, p64_uint32_t Position, p64_uint32_t Count) {
@@ -660,6 +674,110 @@ void P64PulseStreamSeek(PP64PulseStream Instance, p64_uint32_t Position) {
     Instance->CurrentIndex = Current;
 }
 
+/* Write head pass at Position, CurrentIndex must be the first pulse at or
+   after Position. Writing puts a strong pulse there and steps past it, not
+   writing erases a pulse found there. Returns 1 if the stream changed. */
+p64_uint32_t P64PulseStreamWriteHead(PP64PulseStream Instance, p64_uint32_t Position, p64_uint32_t Write) {
+    p64_int32_t Current;
+    p64_uint32_t Changed;
+    Current = Instance->CurrentIndex;
+    if(!Write) {
+        if((Current >= 0) && (Instance->Pulses[Current].Position == Position)) {
+            P64PulseStreamFreePulse(Instance, Current);
+            return 1;
+        }
+        return 0;
+    }
+    if((Current >= 0) && (Instance->Pulses[Current].Position == Position)) {
+        Changed = Instance->Pulses[Current].Strength != 0xffffffffUL;
+        if(Changed) {
+            Instance->Pulses[Current].Strength = 0xffffffffUL;
+            P64PulseStreamFlatInvalidate(Instance);
+        }
+    } else {
+        P64PulseStreamAddPulse(Instance, Position, 0xffffffffUL);
+        Changed = 1;
+    }
+    Instance->CurrentIndex = Instance->Pulses[Instance->CurrentIndex].Next;
+    return Changed;
+}
+
+void P64PulseStreamFlatInvalidate(PP64PulseStream Instance) {
+    Instance->FlatValid = 0;
+}
+
+void P64PulseStreamFlatUpdate(PP64PulseStream Instance) {
+    p64_int32_t Current;
+    p64_uint32_t Count;
+    if(Instance->FlatValid) {
+        return;
+    }
+    Count = 0;
+    Current = Instance->UsedFirst;
+    while(Current >= 0) {
+        Count++;
+        Current = Instance->Pulses[Current].Next;
+    }
+    if(Count > Instance->FlatAllocated) {
+        Instance->FlatAllocated = Count;
+        if(Instance->FlatPositions) {
+            p64_free(Instance->FlatPositions);
+        }
+        if(Instance->FlatStrengths) {
+            p64_free(Instance->FlatStrengths);
+        }
+        Instance->FlatPositions = p64_malloc(Count * sizeof(p64_uint32_t));
+        Instance->FlatStrengths = p64_malloc(Count * sizeof(p64_uint32_t));
+    }
+    Count = 0;
+    Current = Instance->UsedFirst;
+    while(Current >= 0) {
+        Instance->FlatPositions[Count] = Instance->Pulses[Current].Position;
+        Instance->FlatStrengths[Count] = Instance->Pulses[Current].Strength;
+        Count++;
+        Current = Instance->Pulses[Current].Next;
+    }
+    Instance->FlatCount = Count;
+    Instance->FlatCursor = 0;
+    Instance->FlatValid = 1;
+}
+
+/* Returns the index of the first pulse at or after Position in the flat copy,
+   or FlatCount if there is none. The last result is tried first, since the
+   head mostly moves forward by less than one pulse between queries. */
+p64_uint32_t P64PulseStreamFlatSeek(PP64PulseStream Instance, p64_uint32_t Position) {
+    p64_uint32_t Lo, Hi, Mid, Cursor;
+    const p64_uint32_t* Positions = Instance->FlatPositions;
+    if(!Instance->FlatValid) {
+        P64PulseStreamFlatUpdate(Instance);
+        Positions = Instance->FlatPositions;
+    }
+    Cursor = Instance->FlatCursor;
+    Hi = Instance->FlatCount;
+    if((Cursor <= Hi) && ((Cursor == 0) || (Positions[Cursor - 1] < Position))) {
+        if((Cursor == Hi) || (Positions[Cursor] >= Position)) {
+            return Cursor;
+        }
+        if((Cursor + 1 == Hi) || (Positions[Cursor + 1] >= Position)) {
+            Instance->FlatCursor = Cursor + 1;
+            return Cursor + 1;
+        }
+        Lo = Cursor + 2;
+    } else {
+        Lo = 0;
+    }
+    while(Lo < Hi) {
+        Mid = Lo + ((Hi - Lo) >> 1);
+        if(Positions[Mid] < Position) {
+            Lo = Mid + 1;
+        } else {
+            Hi = Mid;
+        }
+    }
+    Instance->FlatCursor = Lo;
+    return Lo;
+}
+
 void P64PulseStreamConvertFromGCR(PP64PulseStream Instance, p64_uint8_t* Bytes, p64_uint32_t Len) {
     p64_uint32_t PositionHi, PositionLo, IncrementHi, IncrementLo, BitStreamPosition;
     P64PulseStreamClear(Instance);
@@ -107,6 +107,14 @@ typedef struct {
 	p64_int32_t UsedLast;
 	p64_int32_t FreeList;
 	p64_int32_t CurrentIndex;
+	/* Flat sorted copy of the pulse list for reading, rebuilt on demand after
+	   the list has been changed */
+	p64_uint32_t* FlatPositions;
+	p64_uint32_t* FlatStrengths;
+	p64_uint32_t FlatAllocated;
+	p64_uint32_t FlatCount;
+	p64_uint32_t FlatValid;
+	p64_uint32_t FlatCursor;
 } TP64PulseStream;
 
 typedef TP64PulseStream* PP64PulseStream;
@@ -163,6 +171,10 @@ p64_uint32_t P64PulseStreamGetPulseCount(PP64PulseStream Instance);
 p64_uint32_t P64PulseStreamGetPulse(PP64PulseStream Instance, p64_uint32_t Position);
 void P64PulseStreamSetPulse(PP64PulseStream Instance, p64_uint32_t Position, p64_uint32_t Strength);
 void P64PulseStreamSeek(PP64PulseStream Instance, p64_uint32_t Position);
+p64_uint32_t P64PulseStreamWriteHead(PP64PulseStream Instance, p64_uint32_t Position, p64_uint32_t Write);
+void P64PulseStreamFlatInvalidate(PP64PulseStream Instance);
+void P64PulseStreamFlatUpdate(PP64PulseStream Instance);
+p64_uint32_t P64PulseStreamFlatSeek(PP64PulseStream Instance, p64_uint32_t Position);
 void P64PulseStreamConvertFromGCR(PP64PulseStream Instance, p64_uint8_t* Bytes, p64_uint32_t Len);
 void P64PulseStreamConvertToGCR(PP64PulseStream Instance, p64_uint8_t* Bytes, p64_uint32_t Len);
 p64_uint32_t P64PulseStreamConvertToGCRWithLogic(PP64PulseStream Instance, p64_uint8_t* Bytes, p64_uint32_t Len, p64_uint32_t SpeedZone);
@@ -0,0 +1,134 @@
+/*
+ * p64test.c - Checks for the flat pulse copy used by the 1541 P64 rotation.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/* The read side of rotation_1541_p64() works on the flat copy of the pulse
+   list, the write side on the list itself through P64PulseStreamWriteHead().
+   These checks make sure a read after a write sees what was written.  */
+
+#include "vice.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "p64.h"
+
+#define WEAK_STRENGTH   0x40000000UL
+#define STRONG_STRENGTH 0xffffffffUL
+
+/* p64 allocates through lib_malloc(); the rest of lib.c is not needed.  */
+#ifdef LIB_DEBUG_PINPOINT
+void *lib_malloc_pinpoint(size_t size, const char *name, unsigned int line)
+{
+    return malloc(size);
+}
+
+void *lib_realloc_pinpoint(void *p, size_t size, const char *name, unsigned int line)
+{
+    return realloc(p, size);
+}
+
+void lib_free_pinpoint(void *p, const char *name, unsigned int line)
+{
+    free(p);
+}
+#else
+void *lib_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+void *lib_realloc(void *p, size_t size)
+{
+    return realloc(p, size);
+}
+
+void lib_free(void *ptr)
+{
+    free(ptr);
+}
+#endif
+
+static int failed = 0;
+
+static void check(int ok, const char *what)
+{
+    printf("%s: %s\n", ok ? "pass" : "FAIL", what);
+    if (!ok) {
+        failed = 1;
+    }
+}
+
+/* Strength of the pulse at `position' as the read path sees it, or 0.  */
+static p64_uint32_t read_pulse(PP64PulseStream stream, p64_uint32_t position)
+{
+    p64_uint32_t index;
+
+    P64PulseStreamFlatUpdate(stream);
+    index = P64PulseStreamFlatSeek(stream, position);
+    if (index < stream->FlatCount && stream->FlatPositions[index] == position) {
+        return stream->FlatStrengths[index];
+    }
+    return 0;
+}
+
+/* Pass the write head over `position', writing or not.  The rotation code
+   keeps CurrentIndex at the next pulse as the disk turns, the seek does the
+   same here.  */
+static p64_uint32_t write_head(PP64PulseStream stream, p64_uint32_t position, p64_uint32_t write)
+{
+    P64PulseStreamSeek(stream, position);
+    return P64PulseStreamWriteHead(stream, position, write);
+}
+
+int main(void)
+{
+    TP64PulseStream stream;
+    p64_uint32_t position;
+
+    P64PulseStreamCreate(&stream);
+    for (position = 1000; position < 100000; position += 1000) {
+        P64PulseStreamAddPulse(&stream, position, WEAK_STRENGTH);
+    }
+
+    check(read_pulse(&stream, 5000) == WEAK_STRENGTH, "weak pulse reads back as weak");
+
+    check(write_head(&stream, 5000, 1), "write over a weak pulse changes the stream");
+    check(read_pulse(&stream, 5000) == STRONG_STRENGTH, "write over a weak pulse reads back as strong");
+    check(read_pulse(&stream, 4000) == WEAK_STRENGTH, "neighbouring pulse stays weak");
+    check(read_pulse(&stream, 6000) == WEAK_STRENGTH, "next pulse stays weak");
+
+    check(!write_head(&stream, 5000, 1), "write over a strong pulse changes nothing");
+
+    check(write_head(&stream, 5500, 1), "write between pulses changes the stream");
+    check(read_pulse(&stream, 5500) == STRONG_STRENGTH, "write between pulses reads back");
+    check(stream.FlatCount == 100, "write between pulses adds one pulse");
+
+    check(!write_head(&stream, 5200, 0), "no write where there is no pulse changes nothing");
+    check(write_head(&stream, 5000, 0), "no write over a pulse erases it");
+    check(read_pulse(&stream, 5000) == 0, "erased pulse is gone");
+    check(read_pulse(&stream, 5500) == STRONG_STRENGTH, "pulse after the erased one is kept");
+
+    P64PulseStreamDestroy(&stream);
+
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
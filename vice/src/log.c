@@ -738,7 +738,9 @@ static int log_helper(log_t log, unsigned int level, const char *format,
         return -1;
     }
 
-    if ((log_to_file) || (!log_colorize)) {
+    /* the colors are also stripped when stdout is redirected, see below */
+    if ((log_to_file) || (!log_colorize) ||
+        ((log_to_stdout) && (archdep_default_logger_is_terminal() == 0))) {
         nocolorpre = logskipcolors(pretxt);
         nocolortxt = logskipcolors(logtxt);
     }
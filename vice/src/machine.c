@@ -319,6 +319,25 @@ void machine_maincpu_shutdown(void)
     }
 }
 
+/* select the driver based on the extension of the given name, PNG if there
+   is no driver for it */
+static const char *screenshot_at_exit_driver(const char *name)
+{
+    gfxoutputdrv_t *driver;
+    const char *ext = util_get_extension(name);
+
+    if (ext != NULL) {
+        for (driver = gfxoutput_drivers_iter_init(); driver != NULL;
+             driver = gfxoutput_drivers_iter_next()) {
+            if (driver->default_extension != NULL
+                && util_strcasecmp(driver->default_extension, ext) == 0) {
+                return driver->name;
+            }
+        }
+    }
+    return "PNG";
+}
+
 static void screenshot_at_exit(void)
 {
     struct video_canvas_s *canvas;
@@ -326,15 +345,15 @@ static void screenshot_at_exit(void)
     if ((ExitScreenshotName != NULL) && (ExitScreenshotName[0] != 0)) {
         /* FIXME: this always uses the first canvas, for x128 this is the VDC */
         canvas = machine_video_canvas_get(0);
-        /* FIXME: perhaps select driver based on the extension of the given name. for now PNG is good enough :) */
-        screenshot_save("PNG", ExitScreenshotName, canvas);
+        screenshot_save(screenshot_at_exit_driver(ExitScreenshotName),
+                        ExitScreenshotName, canvas);
     }
     if (machine_class == VICE_MACHINE_C128) {
         if ((ExitScreenshotName1 != NULL) && (ExitScreenshotName1[0] != 0)) {
             /* FIXME: this always uses the second canvas, for x128 this is the VICII */
             canvas = machine_video_canvas_get(1);
-            /* FIXME: perhaps select driver based on the extension of the given name. for now PNG is good enough :) */
-            screenshot_save("PNG", ExitScreenshotName1, canvas);
+            screenshot_save(screenshot_at_exit_driver(ExitScreenshotName1),
+                            ExitScreenshotName1, canvas);
         }
     }
 }
@@ -60,6 +60,7 @@
 #include "mainlock.h"
 #include "resources.h"
 #include "sysfile.h"
+#include "testrunner.h"
 #include "types.h"
 #include "uiapi.h"
 #include "uiactions.h"
@@ -198,6 +199,9 @@ int main_program(int argc, char **argv)
 #endif
     bool loadconfig = true;
     char *datadir;
+    const char *testrunner_manifest = NULL;
+    const char *testrunner_report = NULL;
+    int testrunner_jobs = 0;
 
 #ifdef USE_VICE_THREAD
     /*
@@ -250,6 +254,9 @@ int main_program(int argc, char **argv)
        -verbose => more verbose logging
        -silent => no logging
        -seed => set the random seed
+       -testrunner => run the tests of a manifest instead of the emulator
+       -testjobs => number of tests to run at the same time
+       -testreport => write the test results to a JSON or JUnit XML file
     */
     DBG(("main:early parse cmdline(argc:%d)", argc));
     for (i = 1; i < argc; i++) {
@@ -287,6 +294,18 @@ int main_program(int argc, char **argv)
             if ((i + 1) < argc) {
                 lib_rand_seed(strtoul(argv[++i], NULL, 0));
             }
+        } else if ((!strcmp(argv[i], "-testrunner")) || (!strcmp(argv[i], "--testrunner"))) {
+            if ((i + 1) < argc) {
+                testrunner_manifest = argv[++i];
+            }
+        } else if ((!strcmp(argv[i], "-testjobs")) || (!strcmp(argv[i], "--testjobs"))) {
+            if ((i + 1) < argc) {
+                testrunner_jobs = atoi(argv[++i]);
+            }
+        } else if ((!strcmp(argv[i], "-testreport")) || (!strcmp(argv[i], "--testreport"))) {
+            if ((i + 1) < argc) {
+                testrunner_report = argv[++i];
+            }
         } else {
             break;
         }
@@ -318,6 +337,17 @@ int main_program(int argc, char **argv)
 
     DBG(("main:early init"));
     tick_init();
+
+    /* the test runner only spawns emulator processes, the remaining
+       commandline is passed on to each of them */
+    if (testrunner_manifest != NULL) {
+        i = testrunner_run(testrunner_manifest, testrunner_report,
+                           testrunner_jobs, argc, argv);
+        archdep_program_name_free();
+        archdep_program_path_free();
+        lib_free(cmdline);
+        exit(i);
+    }
     maincpu_early_init();
     machine_setup_context();
     drive_setup_context();
@@ -42,6 +42,7 @@
 #include "main65816cpu.h"
 #include "mem.h"
 #include "monitor.h"
+#include "profiler.h"
 #include "resources.h"
 #include "snapshot.h"
 #include "traps.h"
@@ -331,6 +332,7 @@ void maincpu_mainloop(void)
 #define CPU_INT_STATUS maincpu_int_status
 
 #define ALARM_CONTEXT maincpu_alarm_context
+#define PROFILER (&maincpu_profiler)
 
 #define CHECK_PENDING_ALARM() \
    (clk >= next_alarm_clk(maincpu_int_status))
@@ -65,6 +65,11 @@ static bool             vice_thread_is_running = false;
 
 static log_t mainlock_log = LOG_DEFAULT;
 
+/* Called by the vice thread before it lets the UI have the lock */
+#define MAINLOCK_YIELD_HOOKS_MAX 4
+static void (*yield_hooks[MAINLOCK_YIELD_HOOKS_MAX])(void);
+static int yield_hooks_count = 0;
+
 void mainlock_init(void)
 {
     mainlock_log = log_open("Mainlock");
@@ -161,8 +166,14 @@ void mainlock_yield(void)
  */
 void mainlock_yield_begin(void)
 {
+    int i;
+
     mainlock_assert_is_vice_thread();
 
+    for (i = 0; i < yield_hooks_count; i++) {
+        yield_hooks[i]();
+    }
+
     pthread_mutex_unlock(&main_lock);
 
     /*
@@ -182,6 +193,48 @@ void mainlock_yield_begin(void)
 }
 
 
+/** \brief Add a function to call whenever the vice thread yields the mainlock
+ *
+ * This lets emulation code with helper threads bring them to a stop before
+ * the UI gets a chance to change state they rely on.
+ *
+ * \param[in]  hook    function to call
+ *
+ * \return 0 on success, -1 if there is no room for another hook
+ */
+int mainlock_add_yield_hook(void (*hook)(void))
+{
+    if (yield_hooks_count >= MAINLOCK_YIELD_HOOKS_MAX) {
+        log_error(mainlock_log, "Too many yield hooks, at most %d are supported.",
+                  MAINLOCK_YIELD_HOOKS_MAX);
+        return -1;
+    }
+
+    yield_hooks[yield_hooks_count++] = hook;
+    return 0;
+}
+
+
+/** \brief Remove a function added with mainlock_add_yield_hook()
+ *
+ * \param[in]  hook    function to remove
+ */
+void mainlock_remove_yield_hook(void (*hook)(void))
+{
+    int i;
+
+    for (i = 0; i < yield_hooks_count; i++) {
+        if (yield_hooks[i] == hook) {
+            yield_hooks_count--;
+            for (; i < yield_hooks_count; i++) {
+                yield_hooks[i] = yield_hooks[i + 1];
+            }
+            return;
+        }
+    }
+}
+
+
 /** \brief The vice thread takes back ownership of the mainlock.
  */
 void mainlock_yield_end(void)
@@ -46,6 +46,8 @@ void mainlock_yield(void);
 void mainlock_yield_and_sleep(tick_t ticks);
 void mainlock_yield_begin(void);
 void mainlock_yield_end(void);
+int mainlock_add_yield_hook(void (*hook)(void));
+void mainlock_remove_yield_hook(void (*hook)(void));
 
 void mainlock_obtain(void);
 void mainlock_release(void);
@@ -60,6 +62,8 @@ bool mainlock_is_vice_thread(void);
 #define mainlock_yield()
 #define mainlock_yield_begin()
 #define mainlock_yield_end()
+#define mainlock_add_yield_hook(hook) 0
+#define mainlock_remove_yield_hook(hook)
 #define mainlock_yield_and_sleep(ticks) tick_sleep(ticks)
 
 #define mainlock_obtain()
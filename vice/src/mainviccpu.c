@@ -41,6 +41,7 @@
 #include "mem.h"
 #include "monitor.h"
 #include "mos6510.h"
+#include "profiler.h"
 #include "snapshot.h"
 #include "resources.h"
 #include "cmdline.h"
@@ -126,25 +127,35 @@ inline static void memmap_mem_update(unsigned int addr, int write, int dummy)
 static void memmap_mem_store(unsigned int addr, unsigned int value)
 {
     memmap_mem_update(addr, 1, 0);
+    monitor_cputrace_fix_value(value);
     (*_mem_write_tab_ptr[(addr) >> 8])((uint16_t)(addr), (uint8_t)(value));
 }
 
 static void memmap_mem_store_dummy(unsigned int addr, unsigned int value)
 {
     memmap_mem_update(addr, 1, 1);
+    monitor_cputrace_fix_value(value);
     (*_mem_write_tab_ptr_dummy[(addr) >> 8])((uint16_t)(addr), (uint8_t)(value));
 }
 
 static uint8_t memmap_mem_read(unsigned int addr)
 {
+    uint8_t value;
+
     memmap_mem_update(addr, 0, 0);
-    return (*_mem_read_tab_ptr[(addr) >> 8])((uint16_t)(addr));
+    value = (*_mem_read_tab_ptr[(addr) >> 8])((uint16_t)(addr));
+    monitor_cputrace_fix_value(value);
+    return value;
 }
 
 static uint8_t memmap_mem_read_dummy(unsigned int addr)
 {
+    uint8_t value;
+
     memmap_mem_update(addr, 0, 1);
-    return (*_mem_read_tab_ptr_dummy[(addr) >> 8])((uint16_t)(addr));
+    value = (*_mem_read_tab_ptr_dummy[(addr) >> 8])((uint16_t)(addr));
+    monitor_cputrace_fix_value(value);
+    return value;
 }
 
 #ifndef STORE
@@ -596,6 +607,8 @@ void maincpu_mainloop(void)
 
 #define ALARM_CONTEXT maincpu_alarm_context
 
+#define PROFILER (&maincpu_profiler)
+
 #define CHECK_PENDING_ALARM() (clk >= next_alarm_clk(maincpu_int_status))
 
 #define CHECK_PENDING_INTERRUPT() check_pending_interrupt(maincpu_int_status)
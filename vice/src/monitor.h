@@ -190,6 +190,8 @@ void monitor_cpu_type_set_value(int searchcpu);
 
 void monitor_watch_push_load_addr(uint16_t addr, MEMSPACE mem);
 void monitor_watch_push_store_addr(uint16_t addr, MEMSPACE mem);
+int monitor_watch_load_page(MEMSPACE mem, unsigned int page);
+int monitor_watch_store_page(MEMSPACE mem, unsigned int page);
 
 monitor_interface_t *monitor_interface_new(void);
 void monitor_interface_destroy(monitor_interface_t *monitor_interface);
@@ -248,6 +250,7 @@ void monitor_cpuhistory_store(CLOCK cycle, unsigned int addr, unsigned int op, u
                               uint8_t reg_sp, unsigned int reg_st, MEMSPACE origin);
 void monitor_cpuhistory_fix_p2(unsigned int p2);
 void monitor_memmap_store(unsigned int addr, unsigned int type);
+void monitor_cputrace_fix_value(unsigned int value);
 
 /* memmap defines */
 #define MEMMAP_UNINITIALIZED_EXEC (1 << 11)  /* was executed before written to */
@@ -54,12 +54,56 @@ struct checkpoint_list_s {
 };
 typedef struct checkpoint_list_s checkpoint_list_t;
 
+/* Interval index of the checkpoints in one of the lists below, used to find
+   all checkpoints covering an address without walking the list.
+
+   The intervals are kept in an array sorted by start address, which is used
+   as an implicit balanced binary tree (the middle element of a range is the
+   root of that range), each node storing the maximum end address of its
+   subtree. Ranges that wrap around are split into two intervals.
+*/
+typedef struct checkpoint_interval_s {
+    unsigned int start;
+    unsigned int end;
+    unsigned int max_end;
+    int order;      /* position in the list, keeps list order for equal starts */
+    mon_checkpoint_t *checkpt;
+} checkpoint_interval_t;
+
+typedef struct checkpoint_index_s {
+    checkpoint_interval_t *intervals;
+    int count;
+} checkpoint_index_t;
+
+/* Number of hits that can be handled without allocating memory */
+#define CHECKPOINT_HITS_STATIC  16
+
 static int breakpoint_count;
 static checkpoint_list_t *all_checkpoints;
 static checkpoint_list_t *breakpoints[NUM_MEMSPACES];
 static checkpoint_list_t *watchpoints_load[NUM_MEMSPACES];
 static checkpoint_list_t *watchpoints_store[NUM_MEMSPACES];
 
+static checkpoint_index_t breakpoints_index[NUM_MEMSPACES];
+static checkpoint_index_t watchpoints_load_index[NUM_MEMSPACES];
+static checkpoint_index_t watchpoints_store_index[NUM_MEMSPACES];
+
+/* incremented whenever an index is rebuilt */
+static unsigned int checkpoint_index_generation;
+
+/* pages covered by load/store watchpoints, one bit per page */
+static uint32_t watch_pages_load[NUM_MEMSPACES][256 / 32];
+static uint32_t watch_pages_store[NUM_MEMSPACES][256 / 32];
+
+/* pages whose stores are tracked for memory subscriptions, the pages written
+   to since the last mon_breakpoint_get_dirty_pages(), and the pages routed
+   through the store watch functions (watched or tracked) */
+static uint32_t track_pages_store[NUM_MEMSPACES][256 / 32];
+static uint32_t dirty_pages_store[NUM_MEMSPACES][256 / 32];
+static uint32_t route_pages_store[NUM_MEMSPACES][256 / 32];
+
+static void update_checkpoint_state(MEMSPACE mem);
+
 
 void mon_breakpoint_init(void)
 {
@@ -148,8 +192,236 @@ mon_checkpoint_t *mon_breakpoint_find_checkpoint(int brknum)
     return NULL;
 }
 
+static int compare_intervals(const void *p1, const void *p2)
+{
+    const checkpoint_interval_t *iv1 = p1;
+    const checkpoint_interval_t *iv2 = p2;
+
+    if (iv1->start != iv2->start) {
+        return (iv1->start < iv2->start) ? -1 : 1;
+    }
+    return iv1->order - iv2->order;
+}
+
+/* fill in the maximum end addresses of the subtree in [lo, hi) */
+static unsigned int checkpoint_index_build_tree(checkpoint_interval_t *intervals, int lo, int hi)
+{
+    int mid;
+    unsigned int max_end, sub_max_end;
+
+    if (lo >= hi) {
+        return 0;
+    }
+
+    mid = lo + (hi - lo) / 2;
+    max_end = intervals[mid].end;
+    sub_max_end = checkpoint_index_build_tree(intervals, lo, mid);
+    if (sub_max_end > max_end) {
+        max_end = sub_max_end;
+    }
+    sub_max_end = checkpoint_index_build_tree(intervals, mid + 1, hi);
+    if (sub_max_end > max_end) {
+        max_end = sub_max_end;
+    }
+    intervals[mid].max_end = max_end;
+
+    return max_end;
+}
+
+static void checkpoint_index_add(checkpoint_index_t *index, unsigned int start,
+                                 unsigned int end, mon_checkpoint_t *cp)
+{
+    checkpoint_interval_t *iv = &index->intervals[index->count];
+
+    iv->start = start;
+    iv->end = end;
+    iv->order = index->count++;
+    iv->checkpt = cp;
+}
+
+static void checkpoint_index_rebuild(checkpoint_index_t *index, checkpoint_list_t *head)
+{
+    checkpoint_list_t *ptr;
+    unsigned int start, end;
+    int count = 0;
+
+    for (ptr = head; ptr; ptr = ptr->next) {
+        count += 2;
+    }
+
+    lib_free(index->intervals);
+    index->intervals = count ? lib_malloc(count * sizeof(checkpoint_interval_t)) : NULL;
+    index->count = 0;
+
+    for (ptr = head; ptr; ptr = ptr->next) {
+        start = addr_location(ptr->checkpt->start_addr);
+        if (mon_is_valid_addr(ptr->checkpt->end_addr)) {
+            end = addr_location(ptr->checkpt->end_addr);
+        } else {
+            end = start;
+        }
+        if (end < start) {
+            checkpoint_index_add(index, start, addr_location(0xffffffff), ptr->checkpt);
+            checkpoint_index_add(index, 0, end, ptr->checkpt);
+        } else {
+            checkpoint_index_add(index, start, end, ptr->checkpt);
+        }
+    }
+
+    if (index->count) {
+        qsort(index->intervals, index->count, sizeof(checkpoint_interval_t), compare_intervals);
+        checkpoint_index_build_tree(index->intervals, 0, index->count);
+    }
+
+    checkpoint_index_generation++;
+}
+
+/* Collect the checkpoints of [lo, hi) covering loc in order of their start
+   address. Returns the number of hits, which may be larger than max_hits, in
+   which case only the first max_hits are stored. */
+static int checkpoint_index_query(const checkpoint_index_t *index, int lo, int hi,
+                                  unsigned int loc, mon_checkpoint_t **hits,
+                                  int num_hits, int max_hits)
+{
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        const checkpoint_interval_t *iv = &index->intervals[mid];
+
+        /* nothing in this subtree reaches up to loc */
+        if (iv->max_end < loc) {
+            break;
+        }
+        num_hits = checkpoint_index_query(index, lo, mid, loc, hits, num_hits, max_hits);
+        /* this node and its right subtree start after loc */
+        if (iv->start > loc) {
+            break;
+        }
+        if (loc <= iv->end) {
+            if (num_hits < max_hits) {
+                hits[num_hits] = iv->checkpt;
+            }
+            num_hits++;
+        }
+        lo = mid + 1;
+    }
+    return num_hits;
+}
+
+static void watch_pages_update(uint32_t *pages, const checkpoint_index_t *index)
+{
+    int i;
+    unsigned int page;
+
+    memset(pages, 0, (256 / 32) * sizeof(uint32_t));
+
+    for (i = 0; i < index->count; i++) {
+        const checkpoint_interval_t *iv = &index->intervals[i];
+
+        if ((iv->end >> 8) - (iv->start >> 8) >= 0xff) {
+            memset(pages, 0xff, (256 / 32) * sizeof(uint32_t));
+            return;
+        }
+        for (page = iv->start >> 8; page <= (iv->end >> 8); page++) {
+            pages[(page & 0xff) >> 5] |= 1U << (page & 0x1f);
+        }
+    }
+}
+
+/** \brief Check if a page is covered by load watchpoints
+ *
+ * Used by the memory code to only route watched pages through the watch
+ * functions.
+ *
+ * \param[in]  mem     memspace
+ * \param[in]  page    page number (address >> 8)
+ *
+ * \return non-zero if a load watchpoint covers any address of the page
+ */
+int monitor_watch_load_page(MEMSPACE mem, unsigned int page)
+{
+    page &= 0xff;
+    return (watch_pages_load[mem][page >> 5] >> (page & 0x1f)) & 1;
+}
+
+/** \brief Check if stores to a page must go through the watch functions
+ *
+ * \param[in]  mem     memspace
+ * \param[in]  page    page number (address >> 8)
+ *
+ * \return non-zero if a store watchpoint covers any address of the page, or
+ *         the page is tracked for a memory subscription
+ */
+int monitor_watch_store_page(MEMSPACE mem, unsigned int page)
+{
+    page &= 0xff;
+    return (route_pages_store[mem][page >> 5] >> (page & 0x1f)) & 1;
+}
+
+/** \brief Account a store for the page tracking
+ *
+ * Marks tracked pages dirty, called by monitor_watch_push_store_addr().
+ *
+ * \param[in]  mem     memspace
+ * \param[in]  page    page number (address >> 8)
+ *
+ * \return non-zero if a store watchpoint covers any address of the page
+ */
+int mon_breakpoint_store_page_hit(MEMSPACE mem, unsigned int page)
+{
+    uint32_t bit = 1U << (page & 0x1f);
+
+    page = (page & 0xff) >> 5;
+    dirty_pages_store[mem][page] |= track_pages_store[mem][page] & bit;
+    return (watch_pages_store[mem][page] & bit) != 0;
+}
+
+/** \brief Set the pages whose stores are tracked
+ *
+ * The tracked pages are routed through the store watch functions like
+ * watched ones, without making the CPU check for watchpoints.
+ *
+ * \param[in]  mem     memspace
+ * \param[in]  pages   one bit per page, NULL to stop tracking
+ */
+void mon_breakpoint_track_stores(MEMSPACE mem, const uint32_t *pages)
+{
+    if (pages != NULL) {
+        memcpy(track_pages_store[mem], pages, sizeof(track_pages_store[mem]));
+    } else {
+        memset(track_pages_store[mem], 0, sizeof(track_pages_store[mem]));
+    }
+    /* tracking starts with a full update */
+    memcpy(dirty_pages_store[mem], track_pages_store[mem], sizeof(dirty_pages_store[mem]));
+    update_checkpoint_state(mem);
+}
+
+/** \brief Get and clear the tracked pages written to
+ *
+ * \param[in]  mem     memspace
+ * \param[out] pages   one bit per page
+ */
+void mon_breakpoint_get_dirty_pages(MEMSPACE mem, uint32_t *pages)
+{
+    memcpy(pages, dirty_pages_store[mem], sizeof(dirty_pages_store[mem]));
+    memset(dirty_pages_store[mem], 0, sizeof(dirty_pages_store[mem]));
+}
+
 static void update_checkpoint_state(MEMSPACE mem)
 {
+    int i;
+    uint32_t tracked = 0;
+
+    checkpoint_index_rebuild(&breakpoints_index[mem], breakpoints[mem]);
+    checkpoint_index_rebuild(&watchpoints_load_index[mem], watchpoints_load[mem]);
+    checkpoint_index_rebuild(&watchpoints_store_index[mem], watchpoints_store[mem]);
+    watch_pages_update(watch_pages_load[mem], &watchpoints_load_index[mem]);
+    watch_pages_update(watch_pages_store[mem], &watchpoints_store_index[mem]);
+
+    for (i = 0; i < 256 / 32; i++) {
+        route_pages_store[mem][i] = watch_pages_store[mem][i] | track_pages_store[mem][i];
+        tracked |= track_pages_store[mem][i];
+    }
+
     /* calls mem_toggle_watchpoints() */
     if (watchpoints_load[mem] != NULL ||
         watchpoints_store[mem] != NULL) {
@@ -158,8 +430,9 @@ static void update_checkpoint_state(MEMSPACE mem)
             1 | (break_on_dummy_access << 1), mon_interfaces[mem]->context);
     } else {
         monitor_mask[mem] &= ~MI_WATCH;
+        /* tracked pages need the watch tables, but not the watchpoint checks */
         mon_interfaces[mem]->toggle_watchpoints_func(
-            0, mon_interfaces[mem]->context);
+            tracked ? 1 : 0, mon_interfaces[mem]->context);
     }
 
     if (breakpoints[mem] != NULL) {
@@ -185,6 +458,8 @@ void mon_update_all_checkpoint_state(void)
 
     for (i = FIRST_SPACE; i <= LAST_SPACE; i++) {
         update_checkpoint_state(i);
+        /* the snapshot did not go through the store functions */
+        memcpy(dirty_pages_store[i], track_pages_store[i], sizeof(dirty_pages_store[i]));
     }
 }
 
@@ -206,6 +481,7 @@ static void remove_checkpoint(mon_checkpoint_t *cp)
     mem = addr_memspace(cp->start_addr);
 
     mon_delete_conditional(cp->condition);
+    mon_delete_compiled_conditional(cp->condition_code);
     lib_free(cp->command);
     cp->command = NULL;
 
@@ -369,7 +645,10 @@ void mon_breakpoint_set_checkpoint_condition(int cp_num,
         if (!cp) {
             mon_out("#%d not a valid checkpoint\n", cp_num);
         } else {
+            mon_delete_conditional(cp->condition);
+            mon_delete_compiled_conditional(cp->condition_code);
             cp->condition = cnode;
+            cp->condition_code = mon_compile_conditional(cnode);
 
             mon_out("Setting checkpoint %d condition to: ", cp_num);
             mon_print_conditional(cnode);
@@ -446,9 +725,14 @@ static void mon_breakpoint_event(mon_checkpoint_t *checkpt) {
 
 bool mon_breakpoint_check_checkpoint(MEMSPACE mem, unsigned int addr, unsigned int lastpc, MEMORY_OP op)
 {
-    checkpoint_list_t *ptr;
     mon_checkpoint_t *cp;
-    checkpoint_list_t *list;
+    mon_checkpoint_t *hits_static[CHECKPOINT_HITS_STATIC];
+    mon_checkpoint_t **hits = hits_static;
+    int hit_nums_static[CHECKPOINT_HITS_STATIC];
+    int *hit_nums = hit_nums_static;
+    int num_hits, i;
+    unsigned int generation;
+    checkpoint_index_t *index;
     monitor_cpu_type_t *monitor_cpu, *searchcpu;
     bool must_stop = FALSE;
     MON_ADDR instpc, searchpc;
@@ -457,8 +741,45 @@ bool mon_breakpoint_check_checkpoint(MEMSPACE mem, unsigned int addr, unsigned i
     const char *op_str;
     const char *action_str;
     supported_cpu_type_list_t *cpulist;
-    int monbank = mon_interfaces[mem]->current_bank;
+    int monbank;
+
+    switch (op) {
+        case e_load:
+            index = &watchpoints_load_index[mem];
+            op_str = "load";
+            is_loadstore = 1;
+            break;
+
+        case e_store:
+            index = &watchpoints_store_index[mem];
+            op_str = "store";
+            is_loadstore = 1;
+            break;
+
+        default: /* e_exec */
+            index = &breakpoints_index[mem];
+            op_str = "exec";
+            break;
+    }
+
+    num_hits = checkpoint_index_query(index, 0, index->count, addr,
+                                      hits, 0, CHECKPOINT_HITS_STATIC);
+    if (num_hits == 0) {
+        return FALSE;
+    }
+    if (num_hits > CHECKPOINT_HITS_STATIC) {
+        hits = lib_malloc(num_hits * sizeof(mon_checkpoint_t *));
+        hit_nums = lib_malloc(num_hits * sizeof(int));
+        checkpoint_index_query(index, 0, index->count, addr, hits, 0, num_hits);
+    }
+    /* checkpoint commands may change the checkpoints, remember which ones
+       were hit so they can be looked up again in that case */
+    for (i = 0; i < num_hits; i++) {
+        hit_nums[i] = hits[i]->checknum;
+    }
+    generation = checkpoint_index_generation;
 
+    monbank = mon_interfaces[mem]->current_bank;
     monitor_cpu = monitor_cpu_for_memspace[mem];
     instpc = new_addr(mem, (monitor_cpu->mon_register_get_val)(mem, e_PC));
     loadstorepc = new_addr(mem, lastpc);
@@ -492,33 +813,18 @@ bool mon_breakpoint_check_checkpoint(MEMSPACE mem, unsigned int addr, unsigned i
         }
     }
 
-    switch (op) {
-        case e_load:
-            list = watchpoints_load[mem];
-            op_str = "load";
-            is_loadstore = 1;
-            break;
-
-        case e_store:
-            list = watchpoints_store[mem];
-            op_str = "store";
-            is_loadstore = 1;
-            break;
-
-        default: /* e_exec */
-            list = breakpoints[mem];
-            op_str = "exec";
-            break;
-    }
-
-    ptr = search_checkpoint_list(list, addr);
-
-    while (ptr && mon_is_in_range(ptr->checkpt->start_addr, ptr->checkpt->end_addr, addr)) {
-        cp = ptr->checkpt;
-        ptr = ptr->next;
+    for (i = 0; i < num_hits; i++) {
+        cp = hits[i];
+        if (generation != checkpoint_index_generation) {
+            cp = mon_breakpoint_find_checkpoint(hit_nums[i]);
+        }
         if (cp && cp->enabled == e_ON) {
             /* If condition test fails, skip this checkpoint */
-            if (cp->condition) {
+            if (cp->condition_code) {
+                if (!mon_evaluate_compiled_conditional(cp->condition_code)) {
+                    continue;
+                }
+            } else if (cp->condition) {
                 if (!mon_evaluate_conditional(cp->condition)) {
                     continue;
                 }
@@ -585,6 +891,51 @@ bool mon_breakpoint_check_checkpoint(MEMSPACE mem, unsigned int addr, unsigned i
         }
     }
 
+    if (hits != hits_static) {
+        lib_free(hits);
+        lib_free(hit_nums);
+    }
+
+    return must_stop;
+}
+
+/* Check if an enabled exec checkpoint at addr would stop the CPU, without
+   counting hits, printing or executing commands. Used while re-executing
+   history for reverse stepping. Ignore counts are not considered. */
+bool mon_breakpoint_would_stop(MEMSPACE mem, unsigned int addr)
+{
+    mon_checkpoint_t *hits_static[CHECKPOINT_HITS_STATIC];
+    mon_checkpoint_t **hits = hits_static;
+    checkpoint_index_t *index = &breakpoints_index[mem];
+    bool must_stop = FALSE;
+    int num_hits, i;
+
+    num_hits = checkpoint_index_query(index, 0, index->count, addr,
+                                      hits, 0, CHECKPOINT_HITS_STATIC);
+    if (num_hits > CHECKPOINT_HITS_STATIC) {
+        hits = lib_malloc(num_hits * sizeof(mon_checkpoint_t *));
+        checkpoint_index_query(index, 0, index->count, addr, hits, 0, num_hits);
+    }
+
+    for (i = 0; i < num_hits && !must_stop; i++) {
+        mon_checkpoint_t *cp = hits[i];
+
+        if (!cp->enabled || !cp->stop) {
+            continue;
+        }
+        if (cp->condition_code) {
+            must_stop = mon_evaluate_compiled_conditional(cp->condition_code);
+        } else if (cp->condition) {
+            must_stop = mon_evaluate_conditional(cp->condition);
+        } else {
+            must_stop = TRUE;
+        }
+    }
+
+    if (hits != hits_static) {
+        lib_free(hits);
+    }
+
     return must_stop;
 }
 
@@ -638,6 +989,7 @@ int breakpoint_add_checkpoint(MON_ADDR start_addr, MON_ADDR end_addr,
     new_cp->hit_count = 0;
     new_cp->ignore_count = 0;
     new_cp->condition = NULL;
+    new_cp->condition_code = NULL;
     new_cp->command = NULL;
     new_cp->check_load = memory_op & e_load;
     new_cp->check_store = memory_op & e_store;
@@ -720,6 +1072,7 @@ void mon_breakpoint_unset(MON_ADDR address)
         /* there's a breakpoint, so remove it */
         remove_checkpoint_from_list( &all_checkpoints, ptr->checkpt );
         remove_checkpoint_from_list( &breakpoints[mem], ptr->checkpt );
+        update_checkpoint_state(mem);
     }
 }
 
@@ -42,6 +42,7 @@ struct mon_checkpoint_s {
     int hit_count;
     int ignore_count;
     cond_node_t *condition;
+    cond_code_t *condition_code;    /* compiled condition, NULL if not compiled */
     char *command;
     bool stop;
     bool enabled;
@@ -62,6 +63,10 @@ void mon_breakpoint_set_checkpoint_condition(int brk_num, struct cond_node_s *cn
 void mon_breakpoint_set_checkpoint_command(int brk_num, char *cmd);
 bool mon_breakpoint_check_checkpoint(MEMSPACE mem, unsigned int addr,
                                      unsigned int lastpc, MEMORY_OP op);
+bool mon_breakpoint_would_stop(MEMSPACE mem, unsigned int addr);
+int mon_breakpoint_store_page_hit(MEMSPACE mem, unsigned int page);
+void mon_breakpoint_track_stores(MEMSPACE mem, const uint32_t *pages);
+void mon_breakpoint_get_dirty_pages(MEMSPACE mem, uint32_t *pages);
 int mon_breakpoint_add_checkpoint(MON_ADDR start_addr, MON_ADDR end_addr,
                                   bool stop, MEMORY_OP op, bool is_temp, bool do_print);
 
@@ -207,6 +207,15 @@ static const mon_cmds_t mon_cmd_array[] = {
       NO_FILENAME_ARG
     },
 
+    { "cputrace", "ctr",
+      "[record \"<filename>\" | off | decode \"<filename>\"]",
+      "Record every executed instruction with its registers and cycle, and"
+      " the memory accesses of the main CPU, to a compressed binary trace.\n"
+      "Without argument the state of the running trace is shown. `decode'"
+      " converts a trace file into a text listing called <filename>.txt.",
+      FILENAME_ARG
+    },
+
     { "registers", "r",
       "[<reg_name> = <number> [, <reg_name> = <number>]*]",
       "Assign respective registers (use FL for status flags).  With no"
@@ -248,10 +257,32 @@ static const mon_cmds_t mon_cmd_array[] = {
       NO_FILENAME_ARG
     },
 
+    { "backstep", "bz",
+      "[<count>]",
+      "Step back COUNT instructions by restoring the nearest snapshot"
+      " and re-executing up to the target.  Needs `reverse on'.",
+      NO_FILENAME_ARG
+    },
+
+    { "backcont", "bx",
+      NULL,
+      "Run backwards to the most recent instruction that hits an enabled"
+      " breakpoint.  Needs `reverse on'.",
+      NO_FILENAME_ARG
+    },
+
+    { "reverse", "rev",
+      "[on|off]",
+      "Enable or disable recording of the snapshots used by `backstep'"
+      " and `backcont'.  Without argument the recorded history is shown.",
+      NO_FILENAME_ARG
+    },
+
 
     { "profile", "prof",
-      "[on|off]|[flat [num]]|[graph [context] [depth]]|[func <function>]",
-      "Main CPU profiling functions. Commands:\n"
+      "[on|off]|[sample [cycles]]|[flat [num]]|[graph [context] [depth]]|[func <function>]|[pprof|flamegraph \"<filename>\"]",
+      "CPU profiling functions, acting on the CPU of the current memspace"
+      " (computer or drive 8-11). Commands:\n"
       "prof on - Start profiling and flush old profiling data.\n"
       "prof off - Stop profiling.\n"
       "prof flat [<num=20>] - Show flat summary of 'num' top functions sorted by self time.\n"
@@ -261,7 +292,10 @@ static const mon_cmds_t mon_cmd_array[] = {
       "prof context <ctx> - Detailed context information including "
       " per-instruction profiling for function"
       " in a call graph context.\n"
-      "prof clear <function> - Clears all profiling stats for function.\n",
+      "prof clear <function> - Clears all profiling stats for function.\n"
+      "prof sample [<cycles=1000>] - Start statistical profiling, sampling the call stack every 'cycles' cycles, and flush old profiling data.\n"
+      "prof pprof \"<filename>\" - Export profiling data in pprof protobuf format.\n"
+      "prof flamegraph \"<filename>\" - Export profiling data as collapsed stacks for flame graph tools.\n",
       NO_FILENAME_ARG
     },
 
@@ -452,6 +486,21 @@ static const mon_cmds_t mon_cmd_array[] = {
       NO_FILENAME_ARG
     },
 
+    { "memmapcount", "mmcount",
+      "[on | off | toggle | record \"<filename>\"]",
+      "Count the reads, writes and executes of every address of the main"
+      " CPU. `record' also writes the counters of each frame to a compressed"
+      " file. Without argument the state of the counters is shown.",
+      FILENAME_ARG
+    },
+
+    { "memmaphot", "mmhot",
+      "[<count>]",
+      "Show the <count> most accessed addresses since the counters were"
+      " enabled or cleared with `mmzap'.",
+      NO_FILENAME_ARG
+    },
+
     { "memmapsave", "mmsave",
       "\"<filename>\" <Format>",
       "Save the memmap as a picture. Format is:"
@@ -0,0 +1,620 @@
+/*
+ * mon_cputrace.c - The VICE built-in monitor, binary CPU trace recorder.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/* The trace recorder gets the same per-instruction and per-access events as
+   the cpuhistory and memmap features, packs them into fixed size binary
+   records and streams them through a ring buffer into a gzip compressed file.
+
+   Each CPU (memspace) collects the records of its current instruction in a
+   small staging buffer, so the value of a memory access and the late JSR
+   operand can be patched in before the record becomes visible.  The staging
+   buffer is copied to the ring when that CPU starts its next instruction.
+   With the emulation running in its own thread, a writer thread drains the
+   ring; otherwise the ring is drained whenever it fills up.  Records are never
+   dropped: if the writer falls behind, the emulation waits for it.
+
+   File layout (all values little endian):
+
+   header  16 bytes  "VICECTRC", version (16 bit), header size (16 bit), 0
+   clock   16 bytes  0x01, origin, 6 x 0, absolute cycle (64 bit)
+   instr   16 bytes  0x02, origin, pc (16 bit), op, p1, p2, a, x, y, sp, st,
+                     cycles since the previous instruction of origin (32 bit)
+   mem      8 bytes  0x03, value, memmap type (16 bit), address (32 bit)
+
+   Memory accesses are only reported by the main CPU and belong to the last
+   instruction of the computer memspace. Opcode fetches are not recorded as
+   memory accesses, the instruction record covers them.  */
+
+#include "vice.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <zlib.h>
+
+#include "archdep.h"
+#include "lib.h"
+#include "log.h"
+#include "machine.h"
+#include "mon_cputrace.h"
+#include "mon_disassemble.h"
+#include "monitor.h"
+#include "montypes.h"
+#include "types.h"
+#include "util.h"
+
+int mon_cputrace_enabled = 0;
+
+#ifdef FEATURE_CPUMEMHISTORY
+
+#ifdef USE_VICE_THREAD
+#include <pthread.h>
+#include <stdatomic.h>
+
+typedef atomic_size_t cputrace_index_t;
+#define INDEX_LOAD(x)       atomic_load_explicit(&(x), memory_order_acquire)
+#define INDEX_STORE(x, v)   atomic_store_explicit(&(x), (v), memory_order_release)
+#else
+typedef size_t cputrace_index_t;
+#define INDEX_LOAD(x)       (x)
+#define INDEX_STORE(x, v)   ((x) = (v))
+#endif
+
+#define CPUTRACE_MAGIC          "VICECTRC"
+#define CPUTRACE_VERSION        1
+#define CPUTRACE_HEADER_SIZE    16
+
+#define CPUTRACE_REC_CLOCK      0x01
+#define CPUTRACE_REC_INSTR      0x02
+#define CPUTRACE_REC_MEM        0x03
+
+#define CPUTRACE_CLOCK_SIZE     16
+#define CPUTRACE_INSTR_SIZE     16
+#define CPUTRACE_MEM_SIZE       8
+
+/* set in the type of a memory record once its value is known */
+#define CPUTRACE_MEM_VALUE      0x8000
+
+#define CPUTRACE_RING_SIZE      (16 * 1024 * 1024)  /* must be a power of 2 */
+#define CPUTRACE_STAGE_SIZE     256
+#define CPUTRACE_NONE           ((unsigned int)-1)
+
+#define CPUTRACE_IDLE_USEC      1000
+
+typedef struct cputrace_stage_s {
+    uint8_t data[CPUTRACE_STAGE_SIZE];
+    unsigned int len;
+    unsigned int instr;     /* offset of the instruction record */
+    unsigned int value;     /* offset of the memory record waiting for its value */
+    CLOCK clock;            /* cycle of the last instruction */
+    int clock_valid;
+} cputrace_stage_t;
+
+static cputrace_stage_t cputrace_stage[NUM_MEMSPACES];
+static MEMSPACE cputrace_last_origin = e_invalid_space;
+
+static uint8_t *cputrace_ring = NULL;
+static cputrace_index_t cputrace_head;  /* end of the published data */
+static cputrace_index_t cputrace_tail;  /* end of the data written to the file */
+static size_t cputrace_pos;             /* emulation side copy of cputrace_head */
+
+static gzFile cputrace_file = NULL;
+static char *cputrace_filename = NULL;
+static int cputrace_error = 0;
+static uint64_t cputrace_instructions = 0;
+static uint64_t cputrace_accesses = 0;
+
+#ifdef USE_VICE_THREAD
+static pthread_t cputrace_thread;
+static atomic_int cputrace_thread_stop;
+#endif
+
+static log_t cputrace_log = LOG_DEFAULT;
+
+/* ------------------------------------------------------------------------- */
+
+static void put_le16(uint8_t *p, unsigned int v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_le32(uint8_t *p, uint32_t v)
+{
+    put_le16(p, v & 0xffff);
+    put_le16(p + 2, v >> 16);
+}
+
+static void put_le64(uint8_t *p, uint64_t v)
+{
+    put_le32(p, (uint32_t)v);
+    put_le32(p + 4, (uint32_t)(v >> 32));
+}
+
+static unsigned int get_le16(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static uint32_t get_le32(const uint8_t *p)
+{
+    return get_le16(p) | ((uint32_t)get_le16(p + 2) << 16);
+}
+
+static uint64_t get_le64(const uint8_t *p)
+{
+    return get_le32(p) | ((uint64_t)get_le32(p + 4) << 32);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* write out the data between tail and head, called by the writer thread or,
+   without one, by the emulation when the ring is full */
+static void cputrace_drain(void)
+{
+    size_t head = INDEX_LOAD(cputrace_head);
+    size_t tail = INDEX_LOAD(cputrace_tail);
+
+    while (tail != head) {
+        size_t pos = tail & (CPUTRACE_RING_SIZE - 1);
+        size_t len = head - tail;
+
+        if (len > CPUTRACE_RING_SIZE - pos) {
+            len = CPUTRACE_RING_SIZE - pos;
+        }
+        /* keep consuming on errors, the emulation would wait forever */
+        if (!cputrace_error
+            && gzwrite(cputrace_file, cputrace_ring + pos, (unsigned int)len) != (int)len) {
+            cputrace_error = 1;
+            log_error(cputrace_log, "Error writing CPU trace to `%s'.", cputrace_filename);
+        }
+        tail += len;
+        INDEX_STORE(cputrace_tail, tail);
+    }
+}
+
+#ifdef USE_VICE_THREAD
+static void *cputrace_thread_main(void *unused)
+{
+    while (1) {
+        if (INDEX_LOAD(cputrace_head) != INDEX_LOAD(cputrace_tail)) {
+            cputrace_drain();
+        } else if (atomic_load(&cputrace_thread_stop)) {
+            break;
+        } else {
+            archdep_usleep(CPUTRACE_IDLE_USEC);
+        }
+    }
+    return NULL;
+}
+#endif
+
+static void cputrace_ring_write(const uint8_t *data, size_t len)
+{
+    size_t pos, chunk;
+
+    while (CPUTRACE_RING_SIZE - (cputrace_pos - INDEX_LOAD(cputrace_tail)) < len) {
+#ifdef USE_VICE_THREAD
+        archdep_usleep(CPUTRACE_IDLE_USEC / 10);
+#else
+        cputrace_drain();
+#endif
+    }
+
+    pos = cputrace_pos & (CPUTRACE_RING_SIZE - 1);
+    chunk = CPUTRACE_RING_SIZE - pos;
+    if (chunk > len) {
+        chunk = len;
+    }
+    memcpy(cputrace_ring + pos, data, chunk);
+    memcpy(cputrace_ring, data + chunk, len - chunk);
+
+    cputrace_pos += len;
+    INDEX_STORE(cputrace_head, cputrace_pos);
+}
+
+static void cputrace_stage_flush(cputrace_stage_t *stage)
+{
+    if (stage->len > 0) {
+        cputrace_ring_write(stage->data, stage->len);
+    }
+    stage->len = 0;
+    stage->instr = CPUTRACE_NONE;
+    stage->value = CPUTRACE_NONE;
+}
+
+static uint8_t *cputrace_stage_alloc(cputrace_stage_t *stage, unsigned int size)
+{
+    uint8_t *p;
+
+    if (stage->len + size > CPUTRACE_STAGE_SIZE) {
+        cputrace_stage_flush(stage);
+    }
+    p = stage->data + stage->len;
+    stage->len += size;
+    memset(p, 0, size);
+    return p;
+}
+
+/* ------------------------------------------------------------------------- */
+
+void mon_cputrace_store_instr(CLOCK cycle, unsigned int addr, unsigned int op,
+                              unsigned int p1, unsigned int p2,
+                              uint8_t reg_a, uint8_t reg_x, uint8_t reg_y,
+                              uint8_t reg_sp, unsigned int reg_st,
+                              MEMSPACE origin)
+{
+    cputrace_stage_t *stage;
+    uint8_t *rec;
+    CLOCK delta = 0;
+
+    if (origin >= NUM_MEMSPACES) {
+        return;
+    }
+    stage = &cputrace_stage[origin];
+    cputrace_stage_flush(stage);
+
+    if (stage->clock_valid && cycle >= stage->clock && cycle - stage->clock <= 0xffffffff) {
+        delta = cycle - stage->clock;
+    } else {
+        rec = cputrace_stage_alloc(stage, CPUTRACE_CLOCK_SIZE);
+        rec[0] = CPUTRACE_REC_CLOCK;
+        rec[1] = (uint8_t)origin;
+        put_le64(rec + 8, cycle);
+        stage->clock_valid = 1;
+    }
+    stage->clock = cycle;
+
+    stage->instr = stage->len;
+    rec = cputrace_stage_alloc(stage, CPUTRACE_INSTR_SIZE);
+    rec[0] = CPUTRACE_REC_INSTR;
+    rec[1] = (uint8_t)origin;
+    put_le16(rec + 2, addr);
+    rec[4] = (uint8_t)op;
+    rec[5] = (uint8_t)p1;
+    rec[6] = (uint8_t)p2;
+    rec[7] = reg_a;
+    rec[8] = reg_x;
+    rec[9] = reg_y;
+    rec[10] = reg_sp;
+    rec[11] = (uint8_t)reg_st;
+    put_le32(rec + 12, (uint32_t)delta);
+
+    cputrace_last_origin = origin;
+    cputrace_instructions++;
+}
+
+void mon_cputrace_fix_p2(unsigned int p2)
+{
+    cputrace_stage_t *stage;
+
+    if (cputrace_last_origin == e_invalid_space) {
+        return;
+    }
+    stage = &cputrace_stage[cputrace_last_origin];
+    if (stage->instr != CPUTRACE_NONE) {
+        stage->data[stage->instr + 6] = (uint8_t)p2;
+    }
+}
+
+void mon_cputrace_store_mem(unsigned int addr, unsigned int type)
+{
+    cputrace_stage_t *stage = &cputrace_stage[e_comp_space];
+    uint8_t *rec;
+
+    stage->value = CPUTRACE_NONE;
+
+    /* opcode fetches are part of the instruction record, and operand reads
+       without a type carry no information either */
+    if ((type & (MEMMAP_I_O_X | MEMMAP_ROM_X | MEMMAP_RAM_X)) || type == 0) {
+        return;
+    }
+
+    stage->value = stage->len;
+    rec = cputrace_stage_alloc(stage, CPUTRACE_MEM_SIZE);
+    if (stage->value != (unsigned int)(rec - stage->data)) {
+        /* the stage was flushed to make room */
+        stage->value = (unsigned int)(rec - stage->data);
+    }
+    rec[0] = CPUTRACE_REC_MEM;
+    put_le16(rec + 2, type & 0xffff);
+    put_le32(rec + 4, addr);
+
+    cputrace_accesses++;
+}
+
+void monitor_cputrace_fix_value(unsigned int value)
+{
+    cputrace_stage_t *stage = &cputrace_stage[e_comp_space];
+    uint8_t *rec;
+
+    if (!mon_cputrace_enabled || stage->value == CPUTRACE_NONE) {
+        return;
+    }
+    rec = stage->data + stage->value;
+    rec[1] = (uint8_t)value;
+    put_le16(rec + 2, get_le16(rec + 2) | CPUTRACE_MEM_VALUE);
+    stage->value = CPUTRACE_NONE;
+}
+
+/* ------------------------------------------------------------------------- */
+
+void mon_cputrace_start(const char *filename)
+{
+    uint8_t header[CPUTRACE_HEADER_SIZE];
+    int i;
+
+    if (mon_cputrace_enabled) {
+        mon_cputrace_stop();
+    }
+
+    if (cputrace_log == LOG_DEFAULT) {
+        cputrace_log = log_open("CPUTrace");
+    }
+
+    cputrace_file = gzopen(filename, "wb1");
+    if (cputrace_file == NULL) {
+        mon_out("Cannot open `%s' for writing.\n", filename);
+        return;
+    }
+
+    memset(header, 0, sizeof header);
+    memcpy(header, CPUTRACE_MAGIC, 8);
+    put_le16(header + 8, CPUTRACE_VERSION);
+    put_le16(header + 10, CPUTRACE_HEADER_SIZE);
+    if (gzwrite(cputrace_file, header, sizeof header) != (int)sizeof header) {
+        mon_out("Error writing to `%s'.\n", filename);
+        gzclose(cputrace_file);
+        cputrace_file = NULL;
+        return;
+    }
+
+    cputrace_ring = lib_malloc(CPUTRACE_RING_SIZE);
+    cputrace_pos = 0;
+    INDEX_STORE(cputrace_head, 0);
+    INDEX_STORE(cputrace_tail, 0);
+    for (i = 0; i < NUM_MEMSPACES; i++) {
+        cputrace_stage[i].len = 0;
+        cputrace_stage[i].instr = CPUTRACE_NONE;
+        cputrace_stage[i].value = CPUTRACE_NONE;
+        cputrace_stage[i].clock_valid = 0;
+    }
+    cputrace_last_origin = e_invalid_space;
+    cputrace_filename = lib_strdup(filename);
+    cputrace_error = 0;
+    cputrace_instructions = 0;
+    cputrace_accesses = 0;
+
+#ifdef USE_VICE_THREAD
+    atomic_store(&cputrace_thread_stop, 0);
+    if (pthread_create(&cputrace_thread, NULL, cputrace_thread_main, NULL) != 0) {
+        mon_out("Cannot start the CPU trace writer thread.\n");
+        gzclose(cputrace_file);
+        cputrace_file = NULL;
+        lib_free(cputrace_ring);
+        cputrace_ring = NULL;
+        lib_free(cputrace_filename);
+        cputrace_filename = NULL;
+        return;
+    }
+#endif
+
+    mon_cputrace_enabled = 1;
+    mon_out("Recording CPU trace to `%s'.\n", filename);
+}
+
+void mon_cputrace_stop(void)
+{
+    int i;
+
+    if (!mon_cputrace_enabled) {
+        return;
+    }
+    mon_cputrace_enabled = 0;
+
+    for (i = 0; i < NUM_MEMSPACES; i++) {
+        cputrace_stage_flush(&cputrace_stage[i]);
+    }
+
+#ifdef USE_VICE_THREAD
+    atomic_store(&cputrace_thread_stop, 1);
+    pthread_join(cputrace_thread, NULL);
+#endif
+    cputrace_drain();
+
+    if (gzclose(cputrace_file) != Z_OK) {
+        cputrace_error = 1;
+    }
+    cputrace_file = NULL;
+
+    log_message(cputrace_log, "%"PRIu64" instructions and %"PRIu64" memory accesses written to `%s'%s.",
+                cputrace_instructions, cputrace_accesses, cputrace_filename,
+                cputrace_error ? " with errors" : "");
+
+    lib_free(cputrace_ring);
+    cputrace_ring = NULL;
+    lib_free(cputrace_filename);
+    cputrace_filename = NULL;
+}
+
+void mon_cputrace_status(void)
+{
+    if (!mon_cputrace_enabled) {
+        mon_out("CPU trace is off.\n");
+        return;
+    }
+    mon_out("Recording CPU trace to `%s': %"PRIu64" instructions, %"PRIu64" memory accesses, %"PRIu64" bytes%s.\n",
+            cputrace_filename, cputrace_instructions, cputrace_accesses,
+            (uint64_t)cputrace_pos, cputrace_error ? " (write error)" : "");
+}
+
+void mon_cputrace_shutdown(void)
+{
+    mon_cputrace_stop();
+}
+
+/* ------------------------------------------------------------------------- */
+
+static const char *cputrace_access_string(unsigned int type)
+{
+    if (type & (MEMMAP_I_O_R | MEMMAP_I_O_W)) {
+        return (type & MEMMAP_I_O_W) ? "io   write" : "io   read ";
+    }
+    if (type & (MEMMAP_ROM_R | MEMMAP_ROM_W)) {
+        return (type & MEMMAP_ROM_W) ? "rom  write" : "rom  read ";
+    }
+    return (type & MEMMAP_RAM_W) ? "ram  write" : "ram  read ";
+}
+
+/* decode a trace into "<filename>.txt", using the disassembler of the CPU
+   currently attached to each memspace */
+void mon_cputrace_decode(const char *filename)
+{
+    gzFile in;
+    FILE *out;
+    char *outname;
+    uint8_t rec[CPUTRACE_INSTR_SIZE];
+    CLOCK clock[NUM_MEMSPACES];
+    uint64_t count = 0;
+    int last_instr_origin = e_invalid_space;
+
+    in = gzopen(filename, "rb");
+    if (in == NULL) {
+        mon_out("Cannot open `%s'.\n", filename);
+        return;
+    }
+    if (gzread(in, rec, CPUTRACE_HEADER_SIZE) != CPUTRACE_HEADER_SIZE
+        || memcmp(rec, CPUTRACE_MAGIC, 8) != 0
+        || get_le16(rec + 8) != CPUTRACE_VERSION) {
+        mon_out("`%s' is not a CPU trace file.\n", filename);
+        gzclose(in);
+        return;
+    }
+    if (get_le16(rec + 10) > CPUTRACE_HEADER_SIZE) {
+        gzseek(in, (z_off_t)get_le16(rec + 10), SEEK_SET);
+    }
+
+    outname = util_concat(filename, ".txt", NULL);
+    out = fopen(outname, "w");
+    if (out == NULL) {
+        mon_out("Cannot open `%s' for writing.\n", outname);
+        lib_free(outname);
+        gzclose(in);
+        return;
+    }
+
+    memset(clock, 0, sizeof clock);
+
+    while (gzread(in, rec, CPUTRACE_MEM_SIZE) == CPUTRACE_MEM_SIZE) {
+        MEMSPACE origin = (MEMSPACE)rec[1];
+
+        if (rec[0] == CPUTRACE_REC_MEM) {
+            unsigned int type = get_le16(rec + 2);
+            char value[4] = "??";
+
+            if (type & CPUTRACE_MEM_VALUE) {
+                sprintf(value, "%02x", rec[1]);
+            }
+            fprintf(out, "%*s%s $%04x %s %s%s\n",
+                    last_instr_origin == e_comp_space ? 11 : 2, "",
+                    cputrace_access_string(type),
+                    (unsigned int)get_le32(rec + 4),
+                    (type & (MEMMAP_I_O_W | MEMMAP_ROM_W | MEMMAP_RAM_W)) ? "<-" : "->",
+                    value,
+                    ((type & (MEMMAP_I_O_R | MEMMAP_ROM_R | MEMMAP_RAM_R))
+                     && !(type & MEMMAP_REGULAR_READ)) ? " (dummy)" : "");
+            continue;
+        }
+
+        if (gzread(in, rec + CPUTRACE_MEM_SIZE, CPUTRACE_MEM_SIZE) != CPUTRACE_MEM_SIZE
+            || origin >= NUM_MEMSPACES) {
+            break;
+        }
+
+        if (rec[0] == CPUTRACE_REC_CLOCK) {
+            clock[origin] = get_le64(rec + 8);
+        } else if (rec[0] == CPUTRACE_REC_INSTR) {
+            unsigned int st = rec[11];
+            unsigned int opc_size;
+            const char *dis_inst;
+
+            clock[origin] += get_le32(rec + 12);
+            dis_inst = mon_disassemble_to_string_ex(origin, get_le16(rec + 2),
+                                                    rec[4], rec[5], rec[6], 0, 1,
+                                                    &opc_size);
+            fprintf(out, ".%s:%04x  %-26s A:%02x X:%02x Y:%02x SP:%02x %c%c-%c%c%c%c%c %12"PRIu64"\n",
+                    mon_memspace_string[origin], get_le16(rec + 2), dis_inst,
+                    rec[7], rec[8], rec[9], rec[10],
+                    (st & (1 << 7)) ? 'N' : '.',
+                    (st & (1 << 6)) ? 'V' : '.',
+                    (st & (1 << 4)) ? 'B' : '.',
+                    (st & (1 << 3)) ? 'D' : '.',
+                    (st & (1 << 2)) ? 'I' : '.',
+                    (st & (1 << 1)) ? 'Z' : '.',
+                    (st & (1 << 0)) ? 'C' : '.',
+                    (uint64_t)clock[origin]);
+            last_instr_origin = origin;
+            count++;
+        } else {
+            mon_out("Unknown record type $%02x, stopping.\n", rec[0]);
+            break;
+        }
+    }
+
+    fclose(out);
+    gzclose(in);
+    mon_out("%"PRIu64" instructions written to `%s'.\n", count, outname);
+    lib_free(outname);
+}
+
+#else /* !FEATURE_CPUMEMHISTORY */
+
+/* stubs */
+static void mon_cputrace_stub(void)
+{
+    mon_out("Disabled. configure with --enable-cpuhistory and recompile.\n");
+}
+
+void mon_cputrace_start(const char *filename)
+{
+    mon_cputrace_stub();
+}
+
+void mon_cputrace_stop(void)
+{
+}
+
+void mon_cputrace_status(void)
+{
+    mon_cputrace_stub();
+}
+
+void mon_cputrace_decode(const char *filename)
+{
+    mon_cputrace_stub();
+}
+
+void mon_cputrace_shutdown(void)
+{
+}
+
+#endif
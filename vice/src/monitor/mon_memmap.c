@@ -30,6 +30,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <zlib.h>
 
 #ifdef HAVE_STRINGS_H
 #include <strings.h>
@@ -38,8 +39,10 @@
 #include "lib.h"
 #include "log.h"
 #include "machine.h"
+#include "mon_cputrace.h"
 #include "mon_disassemble.h"
 #include "mon_memmap.h"
+#include "mon_reverse.h"
 #include "monitor.h"
 #include "montypes.h"
 #include "screenshot.h"
@@ -159,6 +162,11 @@ void monitor_cpuhistory_store(CLOCK cycle, unsigned int addr, unsigned int op,
         return;
     }
 
+    if (mon_cputrace_enabled) {
+        mon_cputrace_store_instr(cycle, addr, op, p1, p2, reg_a, reg_x, reg_y,
+                                 reg_sp, reg_st, origin);
+    }
+
     ++cpuhistory_i;
     if (cpuhistory_i == cpuhistory_buffer_lines) {
         cpuhistory_i = 0;
@@ -179,6 +187,9 @@ void monitor_cpuhistory_store(CLOCK cycle, unsigned int addr, unsigned int op,
 void monitor_cpuhistory_fix_p2(unsigned int p2)
 {
     cpuhistory[cpuhistory_i].p2 = p2;
+    if (mon_cputrace_enabled) {
+        mon_cputrace_fix_p2(p2);
+    }
 }
 
 void mon_cpuhistory(int count, MEMSPACE filter1, MEMSPACE filter2, MEMSPACE filter3,
@@ -290,10 +301,47 @@ static int mon_memmap_picx;
 static int mon_memmap_picy;
 static unsigned int mon_memmap_mask;
 
+/* Access counters, three per address (read, write, execute). The running
+   frame is counted in count_live; at the end of a frame it is swapped with
+   count_frame, which then holds the complete frame until the next one ends,
+   and is added to count_total. Only the pages touched in a frame are
+   cleared and summed up.  */
+#define COUNT_PAGE_SIZE 0x100
+#define COUNT_PAGE_ELEMS (COUNT_PAGE_SIZE * 3)
+#define COUNT_ENTRY_SIZE 16
+
+static uint32_t *count_live = NULL;
+static uint32_t *count_frame = NULL;
+static uint32_t *count_total = NULL;
+static uint8_t *count_live_pages = NULL;
+static uint8_t *count_frame_pages = NULL;
+static uint8_t *count_total_pages = NULL;
+static unsigned int count_pages = 0;
+static uint32_t count_frames = 0;
+
+/* per-frame stream of the counters */
+static gzFile count_file = NULL;
+static uint8_t *count_buffer = NULL;
+static size_t count_buffer_size = 0;
+
+static void counters_clear(void)
+{
+    memset(count_live, 0, (size_t)mon_memmap_size * 3 * sizeof(uint32_t));
+    memset(count_frame, 0, (size_t)mon_memmap_size * 3 * sizeof(uint32_t));
+    memset(count_total, 0, (size_t)mon_memmap_size * 3 * sizeof(uint32_t));
+    memset(count_live_pages, 0, count_pages);
+    memset(count_frame_pages, 0, count_pages);
+    memset(count_total_pages, 0, count_pages);
+    count_frames = 0;
+}
+
 /* mmzap */
 void mon_memmap_zap(void)
 {
     memset(mon_memmap, 0, mon_memmap_size * sizeof(MEMMAP_ELEM));
+    if (count_live != NULL) {
+        counters_clear();
+    }
 }
 
 /* mmsh */
@@ -364,6 +412,9 @@ void monitor_memmap_store(unsigned int addr, unsigned int type)
     if (memmap_state & MEMMAP_STATE_IN_MONITOR) {
         return;
     }
+    if (mon_cputrace_enabled) {
+        mon_cputrace_store_mem(addr, type);
+    }
 #if 0 /* FIXME: why would we do this? */
     /* Ignore reg_pc+2 reads on branches & JSR
        and return address read on RTS */
@@ -384,6 +435,19 @@ void monitor_memmap_store(unsigned int addr, unsigned int type)
         }
     }
     mon_memmap[addr & mon_memmap_mask] |= type;
+
+    /* replayed history was counted already */
+    if (count_live != NULL && !mon_reverse_replaying) {
+        addr &= mon_memmap_mask;
+        if (type & (MEMMAP_RAM_X | MEMMAP_ROM_X | MEMMAP_I_O_X)) {
+            count_live[addr * 3 + 2]++;
+        } else if (type & (MEMMAP_RAM_W | MEMMAP_ROM_W | MEMMAP_I_O_W)) {
+            count_live[addr * 3 + 1]++;
+        } else if (type & (MEMMAP_RAM_R | MEMMAP_ROM_R | MEMMAP_I_O_R)) {
+            count_live[addr * 3]++;
+        }
+        count_live_pages[addr / COUNT_PAGE_SIZE] = 1;
+    }
 }
 
 void mon_memmap_save(const char *filename, int format)
@@ -433,6 +497,288 @@ void mon_memmap_save(const char *filename, int format)
     lib_free(memmap_bitmap);
 }
 
+static void put_le32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+/* Write the addresses with nonzero counters as entries of address, reads,
+   writes and executes (32 bit little endian each) to dest, if not NULL.
+   Returns the number of entries.  */
+static unsigned int counters_collect(const uint32_t *counts, const uint8_t *pages,
+                                     uint8_t *dest)
+{
+    unsigned int page, addr, n = 0;
+    const uint32_t *c;
+
+    for (page = 0; page < count_pages; page++) {
+        if (!pages[page]) {
+            continue;
+        }
+        c = &counts[page * COUNT_PAGE_ELEMS];
+        for (addr = page * COUNT_PAGE_SIZE; addr < (page + 1) * COUNT_PAGE_SIZE; addr++, c += 3) {
+            if ((c[0] | c[1] | c[2]) == 0) {
+                continue;
+            }
+            if (dest != NULL) {
+                put_le32(dest, addr);
+                put_le32(dest + 4, c[0]);
+                put_le32(dest + 8, c[1]);
+                put_le32(dest + 12, c[2]);
+                dest += COUNT_ENTRY_SIZE;
+            }
+            n++;
+        }
+    }
+    return n;
+}
+
+static void counters_record_stop(void)
+{
+    if (count_file != NULL) {
+        gzclose(count_file);
+        count_file = NULL;
+    }
+    lib_free(count_buffer);
+    count_buffer = NULL;
+    count_buffer_size = 0;
+}
+
+/* frame record: frame number, number of entries, entries */
+static void counters_write_frame(void)
+{
+    unsigned int n = counters_collect(count_frame, count_frame_pages, NULL);
+    size_t size = 8 + (size_t)n * COUNT_ENTRY_SIZE;
+
+    if (size > count_buffer_size) {
+        count_buffer = lib_realloc(count_buffer, size);
+        count_buffer_size = size;
+    }
+    put_le32(count_buffer, count_frames);
+    put_le32(count_buffer + 4, n);
+    counters_collect(count_frame, count_frame_pages, count_buffer + 8);
+
+    if (gzwrite(count_file, count_buffer, (unsigned int)size) != (int)size) {
+        log_error(LOG_DEFAULT, "memmap: writing the access counters failed.");
+        counters_record_stop();
+    }
+}
+
+int mon_memmap_counters_enabled(void)
+{
+    return count_live != NULL;
+}
+
+/* mmcount on/off */
+void mon_memmap_counters_enable(int enable)
+{
+    size_t size = (size_t)mon_memmap_size * 3 * sizeof(uint32_t);
+
+    if (enable < 0) {
+        enable = (count_live == NULL);
+    }
+
+    if (enable && count_live == NULL) {
+        count_pages = (unsigned int)mon_memmap_size / COUNT_PAGE_SIZE;
+        count_live = lib_malloc(size);
+        count_frame = lib_malloc(size);
+        count_total = lib_malloc(size);
+        count_live_pages = lib_malloc(count_pages);
+        count_frame_pages = lib_malloc(count_pages);
+        count_total_pages = lib_malloc(count_pages);
+        counters_clear();
+    } else if (!enable && count_live != NULL) {
+        counters_record_stop();
+        lib_free(count_live);
+        lib_free(count_frame);
+        lib_free(count_total);
+        lib_free(count_live_pages);
+        lib_free(count_frame_pages);
+        lib_free(count_total_pages);
+        count_live = count_frame = count_total = NULL;
+        count_live_pages = count_frame_pages = count_total_pages = NULL;
+    }
+}
+
+/* mmcount record "file"
+
+   File layout (all values 32 bit little endian):
+
+   header  16 bytes  "VICEHEAT", version (16 bit), header size (16 bit),
+                     number of addresses
+   frame    8 bytes  frame number, number of entries n
+   entries  n * 16   address, reads, writes, executes  */
+void mon_memmap_counters_record(const char *filename)
+{
+    uint8_t header[16];
+
+    counters_record_stop();
+    mon_memmap_counters_enable(1);
+
+    count_file = gzopen(filename, "wb1");
+    if (count_file == NULL) {
+        mon_out("Cannot create `%s'.\n", filename);
+        return;
+    }
+    memcpy(header, "VICEHEAT", 8);
+    header[8] = 1;
+    header[9] = 0;
+    header[10] = sizeof header;
+    header[11] = 0;
+    put_le32(header + 12, (uint32_t)mon_memmap_size);
+    if (gzwrite(count_file, header, sizeof header) != (int)sizeof header) {
+        mon_out("Cannot write to `%s'.\n", filename);
+        counters_record_stop();
+        return;
+    }
+    mon_out("Streaming the access counters of each frame to `%s'.\n", filename);
+}
+
+void mon_memmap_counters_status(void)
+{
+    if (count_live == NULL) {
+        mon_out("Access counters are off.\n");
+        return;
+    }
+    mon_out("Access counters are on, %u frames counted%s.\n", count_frames,
+            count_file != NULL ? ", streaming to file" : "");
+}
+
+/* called at the end of each frame */
+void mon_memmap_frame_done(void)
+{
+    uint32_t *counts;
+    uint8_t *pages;
+    unsigned int page, i;
+
+    if (count_live == NULL) {
+        return;
+    }
+
+    counts = count_live;
+    count_live = count_frame;
+    count_frame = counts;
+    pages = count_live_pages;
+    count_live_pages = count_frame_pages;
+    count_frame_pages = pages;
+
+    for (page = 0; page < count_pages; page++) {
+        /* the new live buffer still holds the frame before */
+        if (count_live_pages[page]) {
+            memset(&count_live[page * COUNT_PAGE_ELEMS], 0,
+                   COUNT_PAGE_ELEMS * sizeof(uint32_t));
+            count_live_pages[page] = 0;
+        }
+        if (count_frame_pages[page]) {
+            counts = &count_total[page * COUNT_PAGE_ELEMS];
+            for (i = 0; i < COUNT_PAGE_ELEMS; i++) {
+                counts[i] += count_frame[page * COUNT_PAGE_ELEMS + i];
+            }
+            count_total_pages[page] = 1;
+        }
+    }
+    count_frames++;
+
+    if (count_file != NULL) {
+        counters_write_frame();
+    }
+}
+
+uint32_t mon_memmap_counters_frames(void)
+{
+    return count_frames;
+}
+
+/* Get the counters of the last complete frame, or the totals, as entries of
+   16 bytes. *dest must be freed with lib_free().  */
+unsigned int mon_memmap_counters_get(int totals, uint8_t **dest)
+{
+    const uint32_t *counts = totals ? count_total : count_frame;
+    const uint8_t *pages = totals ? count_total_pages : count_frame_pages;
+    unsigned int n;
+
+    if (count_live == NULL) {
+        *dest = NULL;
+        return 0;
+    }
+    n = counters_collect(counts, pages, NULL);
+    *dest = lib_malloc((size_t)n * COUNT_ENTRY_SIZE + 1);
+    counters_collect(counts, pages, *dest);
+    return n;
+}
+
+typedef struct count_hot_s {
+    unsigned int addr;
+    uint32_t count[3];
+    uint64_t sum;
+} count_hot_t;
+
+static int count_hot_compare(const void *a, const void *b)
+{
+    const count_hot_t *ha = a;
+    const count_hot_t *hb = b;
+
+    if (ha->sum != hb->sum) {
+        return ha->sum < hb->sum ? 1 : -1;
+    }
+    return ha->addr < hb->addr ? -1 : 1;
+}
+
+/* mmhot, the totals include the running frame */
+void mon_memmap_hot(int count)
+{
+    count_hot_t *hot;
+    unsigned int page, addr, n = 0;
+    int i;
+
+    if (count_live == NULL) {
+        mon_out("Access counters are off, use `mmcount on' to enable them.\n");
+        return;
+    }
+    if (count <= 0) {
+        count = 20;
+    }
+
+    for (page = 0; page < count_pages; page++) {
+        if (count_total_pages[page] || count_live_pages[page]) {
+            n++;
+        }
+    }
+    hot = lib_malloc(sizeof(count_hot_t) * COUNT_PAGE_SIZE * (size_t)n + 1);
+    n = 0;
+    for (page = 0; page < count_pages; page++) {
+        if (!count_total_pages[page] && !count_live_pages[page]) {
+            continue;
+        }
+        for (addr = page * COUNT_PAGE_SIZE; addr < (page + 1) * COUNT_PAGE_SIZE; addr++) {
+            count_hot_t *h = &hot[n];
+
+            h->addr = addr;
+            h->count[0] = count_total[addr * 3] + count_live[addr * 3];
+            h->count[1] = count_total[addr * 3 + 1] + count_live[addr * 3 + 1];
+            h->count[2] = count_total[addr * 3 + 2] + count_live[addr * 3 + 2];
+            h->sum = (uint64_t)h->count[0] + h->count[1] + h->count[2];
+            if (h->sum != 0) {
+                n++;
+            }
+        }
+    }
+    qsort(hot, n, sizeof(count_hot_t), count_hot_compare);
+
+    mon_out("%s      reads     writes      execs  per frame\n",
+            machine_class == VICE_MACHINE_C64DTV ? "  addr" : "addr");
+    for (i = 0; i < count && i < (int)n; i++) {
+        mon_out(machine_class == VICE_MACHINE_C64DTV ? "%06x %10u %10u %10u %10.1f\n"
+                                                     : "%04x %10u %10u %10u %10.1f\n",
+                hot[i].addr, hot[i].count[0], hot[i].count[1], hot[i].count[2],
+                (double)hot[i].sum / (count_frames + 1));
+    }
+    lib_free(hot);
+}
+
 void mon_memmap_init(void)
 {
     mon_memmap_picx = MEMMAP_PICX;
@@ -452,6 +798,7 @@ void mon_memmap_init(void)
 
 void mon_memmap_shutdown(void)
 {
+    mon_memmap_counters_enable(0);
     lib_free(mon_memmap);
     mon_memmap = NULL;
     if (cpuhistory != NULL) {
@@ -489,6 +836,46 @@ void mon_memmap_save(const char* filename, int format)
     mon_memmap_stub();
 }
 
+int mon_memmap_counters_enabled(void)
+{
+    return 0;
+}
+
+void mon_memmap_counters_enable(int enable)
+{
+    mon_memmap_stub();
+}
+
+void mon_memmap_counters_record(const char *filename)
+{
+    mon_memmap_stub();
+}
+
+void mon_memmap_counters_status(void)
+{
+    mon_memmap_stub();
+}
+
+void mon_memmap_frame_done(void)
+{
+}
+
+uint32_t mon_memmap_counters_frames(void)
+{
+    return 0;
+}
+
+unsigned int mon_memmap_counters_get(int totals, uint8_t **dest)
+{
+    *dest = NULL;
+    return 0;
+}
+
+void mon_memmap_hot(int count)
+{
+    mon_memmap_stub();
+}
+
 void mon_memmap_init(void)
 {
 }
@@ -41,4 +41,14 @@ void mon_memmap_zap(void);
 void mon_memmap_show(int mask, MON_ADDR start_addr, MON_ADDR end_addr);
 void mon_memmap_save(const char* filename, int format);
 
+/* per address access counters of the main CPU */
+int mon_memmap_counters_enabled(void);
+void mon_memmap_counters_enable(int enable); /* -1 toggles */
+void mon_memmap_counters_record(const char *filename);
+void mon_memmap_counters_status(void);
+void mon_memmap_frame_done(void);
+uint32_t mon_memmap_counters_frames(void);
+unsigned int mon_memmap_counters_get(int totals, uint8_t **dest);
+void mon_memmap_hot(int count);
+
 #endif
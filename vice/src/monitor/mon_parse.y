@@ -68,6 +68,8 @@ char *alloca();
 #include "types.h"
 #include "uimon.h"
 #include "vsync.h"
+#include "mon_cputrace.h"
+#include "mon_reverse.h"
 #include "mon_profile.h"
 
 #define join_ints(x,y) (LO16_TO_HI16(x)|y)
@@ -152,10 +154,14 @@ void set_yydebug(int val);
 %token CMD_RESOURCE_GET CMD_RESOURCE_SET CMD_LOAD_RESOURCES CMD_SAVE_RESOURCES
 %token CMD_ATTACH CMD_DETACH CMD_MON_RESET CMD_TAPECTRL CMD_TAPEOFFS CMD_CARTFREEZE CMD_UPDB CMD_JPDB
 %token CMD_CPUHISTORY CMD_MEMMAPZAP CMD_MEMMAPSHOW CMD_MEMMAPSAVE
+%token CMD_MEMMAPCOUNT CMD_MEMMAPHOT
+%token CMD_CPUTRACE CPUTRACE_RECORD CPUTRACE_DECODE
+%token CMD_BACKSTEP CMD_BACKCONT CMD_REVERSE
 %token CMD_COMMENT CMD_LIST CMD_STOPWATCH RESET
 %token CMD_EXPORT CMD_AUTOSTART CMD_AUTOLOAD CMD_MAINCPU_TRACE
 %token CMD_WARP
 %token CMD_PROFILE FLAT GRAPH FUNC DEPTH DISASS PROFILE_CONTEXT CLEAR
+%token PROFILE_SAMPLE PROFILE_PPROF PROFILE_FLAMEGRAPH
 %token<str> CMD_LABEL_ASGN
 %token<i> L_PAREN R_PAREN ARG_IMMEDIATE REG_A REG_X REG_Y COMMA INST_SEP
 %token<i> L_BRACKET R_BRACKET LESS_THAN REG_U REG_S REG_PC REG_PCR
@@ -259,6 +265,20 @@ machine_state_rules: CMD_BANK end_cmd
                      { mon_cpuhistory($3, $5, $7, $9, $11, e_invalid_space); }
                    | CMD_CPUHISTORY opt_sep d_number opt_sep memspace opt_sep memspace opt_sep memspace opt_sep memspace opt_sep memspace end_cmd
                      { mon_cpuhistory($3, $5, $7, $9, $11, $13); }
+                   | CMD_CPUTRACE end_cmd
+                     { mon_cputrace_status(); }
+                   | CMD_CPUTRACE CPUTRACE_RECORD filename end_cmd
+                     { mon_cputrace_start($3); lib_free($3); }
+                   | CMD_CPUTRACE TOGGLE end_cmd
+                     {
+                         if ($2 == e_OFF) {
+                             mon_cputrace_stop();
+                         } else {
+                             mon_out("Use `cputrace record \"<filename>\"' to start a trace.\n");
+                         }
+                     }
+                   | CMD_CPUTRACE CPUTRACE_DECODE filename end_cmd
+                     { mon_cputrace_decode($3); lib_free($3); }
                    | CMD_RETURN end_cmd
                      { mon_instruction_return(); }
                    | CMD_DUMP filename end_cmd
@@ -269,6 +289,16 @@ machine_state_rules: CMD_BANK end_cmd
                      { mon_instructions_step(-1); }
                    | CMD_STEP opt_sep expression end_cmd
                      { mon_instructions_step($3); }
+                   | CMD_BACKSTEP end_cmd
+                     { mon_instructions_back(-1); }
+                   | CMD_BACKSTEP opt_sep expression end_cmd
+                     { mon_instructions_back($3); }
+                   | CMD_BACKCONT end_cmd
+                     { mon_instructions_back_continue(); }
+                   | CMD_REVERSE end_cmd
+                     { mon_reverse_status(); }
+                   | CMD_REVERSE TOGGLE end_cmd
+                     { mon_reverse_enable(($2 == e_TOGGLE) ? -1 : ($2 == e_ON)); }
                    | CMD_NEXT end_cmd
                      { mon_instructions_next(-1); }
                    | CMD_NEXT opt_sep expression end_cmd
@@ -393,6 +423,19 @@ memory_rules: CMD_MOVE address_range opt_sep address end_cmd
               { mon_memmap_show($3,$4[0],$4[1]); }
             | CMD_MEMMAPSAVE filename opt_sep expression end_cmd
               { mon_memmap_save($2,$4); }
+            | CMD_MEMMAPCOUNT end_cmd
+              { mon_memmap_counters_status(); }
+            | CMD_MEMMAPCOUNT TOGGLE end_cmd
+              {
+                  mon_memmap_counters_enable(($2 == e_TOGGLE) ? -1 : ($2 == e_ON));
+                  mon_memmap_counters_status();
+              }
+            | CMD_MEMMAPCOUNT CPUTRACE_RECORD filename end_cmd
+              { mon_memmap_counters_record($3); lib_free($3); }
+            | CMD_MEMMAPHOT end_cmd
+              { mon_memmap_hot(-1); }
+            | CMD_MEMMAPHOT opt_sep expression end_cmd
+              { mon_memmap_hot($3); }
             ;
 
 checkpoint_rules: CMD_BREAK opt_mem_op address_opt_range opt_if_cond_expr end_cmd
@@ -621,6 +664,12 @@ monitor_misc_rules: CMD_DISK rest_of_line end_cmd
                      { mon_profile_clear($3); }
                   | CMD_PROFILE PROFILE_CONTEXT d_number end_cmd
                      { mon_profile_disass_context($3); }
+                  | CMD_PROFILE PROFILE_SAMPLE opt_d_number end_cmd
+                     { mon_profile_sample($3); }
+                  | CMD_PROFILE PROFILE_PPROF filename end_cmd
+                     { mon_profile_export_pprof($3); lib_free($3); }
+                  | CMD_PROFILE PROFILE_FLAMEGRAPH filename end_cmd
+                     { mon_profile_export_collapsed($3); lib_free($3); }
                   ;
 
 disk_rules: CMD_LOAD filename device_num opt_address end_cmd
@@ -29,6 +29,7 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "archdep.h"
 #include "lib.h"
 #include "machine.h"
 #include "maincpu.h"
@@ -53,42 +54,83 @@ static bool is_merged(profiling_context_t *context) {
     return context->pc_src == 0 /* aggregate */ && context->id & CONTEXT_MERGED;
 }
 
+/* profiler of the CPU the monitor currently looks at */
+static profiler_cpu_t *profiler = &maincpu_profiler;
+static MEMSPACE profiler_memspace = e_comp_space;
+
+static void select_profiler(void)
+{
+    profiler_memspace = default_memspace;
+
+    switch (default_memspace) {
+        case e_disk8_space:
+        case e_disk9_space:
+        case e_disk10_space:
+        case e_disk11_space:
+            profiler = &drivecpu_profiler[default_memspace - e_disk8_space];
+            break;
+        default:
+            profiler_memspace = e_comp_space;
+            switch (monitor_cpu_for_memspace[e_comp_space]->cpu_type) {
+                case CPU_Z80:
+                    profiler = &z80_profiler;
+                    break;
+                case CPU_6809:
+                    profiler = &h6809_profiler;
+                    break;
+                default:
+                    profiler = &maincpu_profiler;
+                    break;
+            }
+            break;
+    }
+}
+
 
 void mon_profile(void)
 {
-    if (maincpu_profiling) {
-        mon_out("Profiling running.\n");
-    } else if (!root_context) {
-        mon_out("Profiling not started.\n");
+    select_profiler();
+
+    if (profiler->sampling) {
+        mon_out("%s: sampling profiler running, one sample every %u cycles.\n",
+                profiler->name, (unsigned int)profiler->sample_interval);
+    } else if (profiler->profiling) {
+        mon_out("%s: profiling running.\n", profiler->name);
+    } else if (!profiler->root_context) {
+        mon_out("%s: profiling not started.\n", profiler->name);
     } else {
-        mon_out("Profiling data available.\n");
+        mon_out("%s: profiling data available.\n", profiler->name);
     }
     mon_out("Use \"help prof\" for more information.\n");
 }
 
 void mon_profile_action(ACTION action)
 {
+    select_profiler();
+
     switch(action) {
     case e_OFF: {
-        if (maincpu_profiling) {
-            profile_stop();
-            mon_out("Profiling stopped.\n");
+        if (profiler->profiling || profiler->sampling) {
+            profile_stop(profiler);
+            mon_out("%s: profiling stopped.\n", profiler->name);
         } else {
-            mon_out("Profiling not started.\n");
+            mon_out("%s: profiling not started.\n", profiler->name);
         }
         return;
     }
     case e_ON: {
-        profile_start();
-        if (maincpu_profiling) {
-            mon_out("Profiling restarted.\n");
+        bool running = profiler->profiling || profiler->sampling;
+
+        profile_start(profiler);
+        if (running) {
+            mon_out("%s: profiling restarted.\n", profiler->name);
         } else {
-            mon_out("Profiling started.\n");
+            mon_out("%s: profiling started.\n", profiler->name);
         }
         return;
     }
     case e_TOGGLE: {
-        if (maincpu_profiling) {
+        if (profiler->profiling || profiler->sampling) {
             mon_profile_action(e_OFF);
         } else {
             mon_profile_action(e_ON);
@@ -99,12 +141,15 @@ void mon_profile_action(ACTION action)
 }
 
 static bool init_profiling_data(void) {
-    if (!root_context) {
-        mon_out("No profiling data available. Start profiling with \"prof on\".\n");
+    select_profiler();
+
+    if (!profiler->root_context) {
+        mon_out("No %s profiling data available. Start profiling with \"prof on\".\n",
+                profiler->name);
         return false;
     }
 
-    compute_aggregate_stats(root_context);
+    compute_aggregate_stats(profiler->root_context);
 
     return true;
 }
@@ -153,7 +198,7 @@ static bool are_aggregates_compatible(profiling_context_t *a,
     }
 
     int i;
-    MEMSPACE mem = e_comp_space;
+    MEMSPACE mem = profiler_memspace;
     uint16_t loc;
 
     /* loop over all memory configs within each context */
@@ -462,7 +507,7 @@ void mon_profile_flat(int num)
     all_functions.capacity = 0;
     all_functions.data = NULL;
 
-    recursively_aggregate_all_functions(root_context, &all_functions);
+    recursively_aggregate_all_functions(profiler->root_context, &all_functions);
     mark_aliases(&all_functions);
 
     /* sort based on self time */
@@ -473,7 +518,7 @@ void mon_profile_flat(int num)
 
     if (num > all_functions.size) num = all_functions.size;
     for (i = 0; i < num; i++) {
-        print_function_line(all_functions.data[i], 0 /* indent */, root_context->total_cycles);
+        print_function_line(all_functions.data[i], 0 /* indent */, profiler->root_context->total_cycles);
         free_profiling_context(all_functions.data[i]);
     }
     for (i = num; i < all_functions.size; i++) {
@@ -493,9 +538,9 @@ void mon_profile_graph(int context_id, int depth)
 
     if (!init_profiling_data()) return;
 
-    context = profile_context_by_id(context_id);
+    context = profile_context_by_id(profiler, context_id);
     if (!context) {
-        context = root_context;
+        context = profiler->root_context;
     }
 
     if (depth <= 0) depth = 4;
@@ -524,7 +569,7 @@ void mon_profile_func(MON_ADDR function)
         return;
     }
 
-    recursively_aggregate_matching_functions(root_context, addr, &func_stats);
+    recursively_aggregate_matching_functions(profiler->root_context, addr, &func_stats);
     c = func_stats;
     while(c) {
         context_array_t callers_merged = {NULL, 0, 0};
@@ -588,7 +633,7 @@ static void print_src(uint16_t src) {
 
 /* memory_config -2 will print "{*}" */
 static void print_dst(uint16_t dst, int max_width, int memory_config) {
-    char *name = mon_symbol_table_lookup_name(default_memspace, dst);
+    char *name = mon_symbol_table_lookup_name(profiler_memspace, dst);
     char buf[32];
     char *full_name = NULL;
     size_t l;
@@ -638,7 +683,7 @@ static int context_memory_config(profiling_context_t *context) {
 
 static void print_context_id(profiling_context_t *context, int max_width) {
     char idstr[16];
-    snprintf(idstr, 16, "[%d]", get_context_id(context));
+    snprintf(idstr, 16, "[%d]", get_context_id(profiler, context));
     mon_out("%*s", max_width, idstr);
 }
 
@@ -674,7 +719,7 @@ static void print_context_line(profiling_context_t *context, int indent, int max
 
 static void print_context_graph(profiling_context_t *context, int depth, int max_depth, profiling_counter_t total_cycles)
 {
-    if (context == current_context) {
+    if (context == profiler->current_context) {
         mon_out(">");
     } else {
         mon_out(" ");
@@ -691,7 +736,7 @@ static void print_context_graph(profiling_context_t *context, int depth, int max
             } while (c != context->child);
         } else {
             /* check if we are a child to the current_context */
-            profiling_context_t *c = current_context;
+            profiling_context_t *c = profiler->current_context;
             do {
                 c = c->parent;
                 if (c == context) {
@@ -713,7 +758,7 @@ static void print_context_graph(profiling_context_t *context, int depth, int max
 static void print_all_contexts(context_array_t *context_list)
 {
     for (int i = 0; i < context_list->size; i++) {
-        mon_out("[%d]", get_context_id(context_list->data[i]));
+        mon_out("[%d]", get_context_id(profiler, context_list->data[i]));
     }
 }
 
@@ -733,7 +778,7 @@ void mon_profile_disass(MON_ADDR function)
         return;
     }
 
-    recursively_aggregate_matching_functions(root_context, addr, &func_stats);
+    recursively_aggregate_matching_functions(profiler->root_context, addr, &func_stats);
 
     c = func_stats;
     while(c) {
@@ -830,16 +875,26 @@ static void merge_all_memory_configs(profiling_context_t *context) {
 static bool is_branch_instruction(uint16_t mem_config, uint16_t addr, unsigned *opc_size, uint16_t *dest_addr) {
     /* on 6502, an instruction is a conditional branch if the opcode is
      * $x0, where x is odd */
-    uint8_t opc  = mon_get_mem_val_nosfx(e_comp_space, mem_config, addr);
+    uint8_t opc;
     int8_t  offset;
 
+    switch (monitor_cpu_for_memspace[profiler_memspace]->cpu_type) {
+        case CPU_Z80:
+        case CPU_6809:
+            return false;
+        default:
+            break;
+    }
+
+    opc = mon_get_mem_val_nosfx(profiler_memspace, mem_config, addr);
+
     if ((opc & 0x1f) != 0x10) {
         return false;
     }
 
     *opc_size = 2;
 
-    offset = mon_get_mem_val_nosfx(e_comp_space, mem_config, addr+1);
+    offset = mon_get_mem_val_nosfx(profiler_memspace, mem_config, addr+1);
 
     *dest_addr = (uint16_t)(addr + *opc_size + offset);
     return true;
@@ -1050,7 +1105,7 @@ static void print_disass_context(profiling_context_t *context, bool print_contex
                             print_src(addr);
                             mon_out("\n");
                         } else {
-                            opc_size = mon_disassemble_oneline(e_comp_space, c->memory_bank_config, addr);
+                            opc_size = mon_disassemble_oneline(profiler_memspace, c->memory_bank_config, addr);
                             next_addr = addr + opc_size;
                         }
                     }
@@ -1068,7 +1123,7 @@ void mon_profile_disass_context(int context_id)
 
     if (!init_profiling_data()) return;
 
-    context = profile_context_by_id(context_id);
+    context = profile_context_by_id(profiler, context_id);
 
     if (!context) {
         mon_out("Invalid context. Use \"prof graph\" to list contexts.\n");
@@ -1136,6 +1191,416 @@ void mon_profile_clear(MON_ADDR function)
         return;
     }
 
-    clear_recursively(root_context, addr);
+    clear_recursively(profiler->root_context, addr);
+}
+
+
+/* ------------------------------------------------------------------------- */
+/* sampling mode and export to external tools */
+
+void mon_profile_sample(int interval)
+{
+    select_profiler();
+
+    if (interval <= 0) {
+        interval = 1000;
+    }
+    profile_start_sampling(profiler, (CLOCK)interval);
+    if (profiler->sampling) {
+        mon_out("%s: sampling profiler started, one sample every %d cycles.\n",
+                profiler->name, interval);
+    } else {
+        mon_out("%s: sampling is not available.\n", profiler->name);
+    }
+}
+
+static const char *interrupt_name(uint16_t src)
+{
+    switch (src) {
+        case 0xfffa: return "NMI";
+        case 0xfffc: return "RST";
+        default: return "IRQ";
+    }
+}
+
+/* function name as shown in exported profiles, always keyed by the memory
+   bank config so code swapped into the same address stays apart */
+static char *export_function_name(uint16_t dst, int memory_config)
+{
+    char *name;
+
+    if (dst == 0x0000) {
+        return lib_strdup("START");
+    }
+    name = mon_symbol_table_lookup_name(profiler_memspace, dst);
+    if (name) {
+        return lib_msprintf("%s {%d}", name, memory_config);
+    }
+    return lib_msprintf("%04x {%d}", dst, memory_config);
+}
+
+static uint32_t context_self_samples(profiling_context_t *context, profiling_counter_t *cycles)
+{
+    uint32_t samples = 0;
+    int i, j;
+
+    *cycles = 0;
+    for (i = 0; i < 256; i++) {
+        if (context->page[i]) {
+            for (j = 0; j < 256; j++) {
+                samples += context->page[i]->data[j].num_samples;
+                *cycles += context->page[i]->data[j].num_cycles;
+            }
+        }
+    }
+    return samples;
+}
+
+static void export_collapsed_context(FILE *fp, profiling_context_t *context, const char *path)
+{
+    profiling_context_t *c;
+    char *name;
+    char *frames;
+
+    name = export_function_name(context->pc_dst, context->memory_bank_config);
+    if (path == NULL) {
+        frames = name;
+    } else {
+        if (is_interrupt(context->pc_src)) {
+            frames = lib_msprintf("%s;%s;%s", path, interrupt_name(context->pc_src), name);
+        } else {
+            frames = lib_msprintf("%s;%s", path, name);
+        }
+        lib_free(name);
+    }
+
+    /* self time, one line for each bank config the function executed in */
+    for (c = context; c != NULL; c = c->next_mem_config) {
+        profiling_counter_t cycles;
+
+        context_self_samples(c, &cycles);
+        if (cycles == 0) {
+            continue;
+        }
+        if (c->memory_bank_config != context->memory_bank_config) {
+            fprintf(fp, "%s;{%d} %u\n", frames, c->memory_bank_config, cycles);
+        } else {
+            fprintf(fp, "%s %u\n", frames, cycles);
+        }
+    }
+
+    if (context->child) {
+        c = context->child;
+        do {
+            export_collapsed_context(fp, c, frames);
+            c = c->next;
+        } while (c != context->child);
+    }
+
+    lib_free(frames);
+}
+
+/* writes the profile in the collapsed stack format used by flamegraph.pl,
+   speedscope, inferno and friends, weighted by cycles */
+void mon_profile_export_collapsed(const char *filename)
+{
+    FILE *fp;
+
+    if (!init_profiling_data()) return;
+
+    fp = fopen(filename, MODE_WRITE_TEXT);
+    if (fp == NULL) {
+        mon_out("Cannot open '%s' for writing.\n", filename);
+        return;
+    }
+    export_collapsed_context(fp, profiler->root_context, NULL);
+    fclose(fp);
+
+    mon_out("Collapsed stacks written to '%s'.\n", filename);
+}
+
+/* minimal protobuf writer for the pprof profile.proto format */
+
+typedef struct pprof_buf_s {
+    uint8_t *data;
+    size_t size;
+    size_t capacity;
+} pprof_buf_t;
+
+static void pprof_put_byte(pprof_buf_t *buf, uint8_t value)
+{
+    if (buf->size == buf->capacity) {
+        buf->capacity = buf->capacity ? buf->capacity * 2 : 256;
+        buf->data = lib_realloc(buf->data, buf->capacity);
+    }
+    buf->data[buf->size++] = value;
+}
+
+static void pprof_put_varint(pprof_buf_t *buf, uint64_t value)
+{
+    while (value >= 0x80) {
+        pprof_put_byte(buf, (uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    pprof_put_byte(buf, (uint8_t)value);
+}
+
+static void pprof_put_bytes(pprof_buf_t *buf, int field, const uint8_t *data, size_t len)
+{
+    pprof_put_varint(buf, ((uint64_t)field << 3) | 2);
+    pprof_put_varint(buf, len);
+    while (len--) {
+        pprof_put_byte(buf, *data++);
+    }
+}
+
+static void pprof_put_uint(pprof_buf_t *buf, int field, uint64_t value)
+{
+    pprof_put_varint(buf, (uint64_t)field << 3);
+    pprof_put_varint(buf, value);
+}
+
+/* append a finished sub message and reset it for reuse */
+static void pprof_put_message(pprof_buf_t *buf, int field, pprof_buf_t *msg)
+{
+    pprof_put_bytes(buf, field, msg->data, msg->size);
+    msg->size = 0;
+}
+
+/* small open addressing map from function/location keys to pprof ids */
+typedef struct pprof_map_s {
+    uint64_t *keys;
+    uint64_t *ids;
+    uint64_t capacity;
+    uint64_t size;
+} pprof_map_t;
+
+static uint64_t pprof_map_slot(pprof_map_t *map, uint64_t key)
+{
+    uint64_t slot = (key * 0x9e3779b97f4a7c15ULL) >> 32;
+
+    while (1) {
+        slot &= map->capacity - 1;
+        if (map->ids[slot] == 0 || map->keys[slot] == key) {
+            return slot;
+        }
+        slot++;
+    }
+}
+
+/* returns the id for `key', `*added' tells if it was just assigned */
+static uint64_t pprof_map_get(pprof_map_t *map, uint64_t key, bool *added)
+{
+    uint64_t slot;
+
+    if ((map->size + 1) * 2 > map->capacity) {
+        pprof_map_t old = *map;
+        uint64_t i;
+
+        map->capacity = old.capacity ? old.capacity * 2 : 256;
+        map->keys = lib_calloc(map->capacity, sizeof(uint64_t));
+        map->ids = lib_calloc(map->capacity, sizeof(uint64_t));
+        for (i = 0; i < old.capacity; i++) {
+            if (old.ids[i] != 0) {
+                slot = pprof_map_slot(map, old.keys[i]);
+                map->keys[slot] = old.keys[i];
+                map->ids[slot] = old.ids[i];
+            }
+        }
+        lib_free(old.keys);
+        lib_free(old.ids);
+    }
+
+    slot = pprof_map_slot(map, key);
+    *added = (map->ids[slot] == 0);
+    if (*added) {
+        map->keys[slot] = key;
+        map->ids[slot] = ++map->size;
+    }
+    return map->ids[slot];
+}
+
+typedef struct pprof_state_s {
+    pprof_buf_t profile;
+    pprof_buf_t msg;
+    pprof_buf_t sub;
+    pprof_buf_t packed;
+    pprof_map_t functions;
+    pprof_map_t locations;
+    uint64_t num_strings;
+} pprof_state_t;
+
+static uint64_t pprof_string(pprof_state_t *state, const char *str)
+{
+    pprof_put_bytes(&state->profile, 6, (const uint8_t *)str, strlen(str));
+    return state->num_strings++;
+}
+
+static void pprof_value_type(pprof_state_t *state, int field, const char *type, const char *unit)
+{
+    uint64_t type_str = pprof_string(state, type);
+    uint64_t unit_str = pprof_string(state, unit);
+
+    pprof_put_uint(&state->msg, 1, type_str);
+    pprof_put_uint(&state->msg, 2, unit_str);
+    pprof_put_message(&state->profile, field, &state->msg);
+}
+
+/* function ids are keyed by address and bank config, interrupt
+   pseudo functions use bit 32 */
+static uint64_t pprof_function(pprof_state_t *state, uint16_t dst, int memory_config, bool interrupt)
+{
+    uint64_t key = dst | ((uint64_t)(memory_config & 0xffff) << 16) | ((uint64_t)interrupt << 32);
+    bool added;
+    uint64_t id = pprof_map_get(&state->functions, key, &added);
+
+    if (added) {
+        char *name = interrupt ? lib_strdup(interrupt_name(dst))
+                               : export_function_name(dst, memory_config);
+        uint64_t name_str = pprof_string(state, name);
+
+        lib_free(name);
+        pprof_put_uint(&state->msg, 1, id);
+        pprof_put_uint(&state->msg, 2, name_str);
+        pprof_put_uint(&state->msg, 3, name_str);
+        pprof_put_message(&state->profile, 5, &state->msg);
+    }
+    return id;
+}
+
+/* locations are instruction addresses tagged with the bank config in the
+   upper bits, so pprof -disasm style views can tell banks apart */
+static uint64_t pprof_location(pprof_state_t *state, uint16_t addr, int memory_config, uint64_t function)
+{
+    uint64_t address = addr | ((uint64_t)(memory_config & 0xffff) << 16);
+    bool added;
+    uint64_t id = pprof_map_get(&state->locations, address | (function << 32), &added);
+
+    if (added) {
+        pprof_put_uint(&state->sub, 1, function);
+        pprof_put_uint(&state->msg, 1, id);
+        pprof_put_uint(&state->msg, 3, address);
+        pprof_put_message(&state->msg, 4, &state->sub);
+        pprof_put_message(&state->profile, 4, &state->msg);
+    }
+    return id;
 }
 
+static void pprof_export_context(pprof_state_t *state, profiling_context_t *context, uint64_t bank_str)
+{
+    profiling_context_t *c;
+    uint64_t function;
+    int i, j;
+
+    function = pprof_function(state, context->pc_dst, context->memory_bank_config, false);
+
+    for (c = context; c != NULL; c = c->next_mem_config) {
+        uint64_t leaf_function = function;
+
+        if (c->memory_bank_config != context->memory_bank_config) {
+            leaf_function = pprof_function(state, context->pc_dst, c->memory_bank_config, false);
+        }
+
+        for (i = 0; i < 256; i++) {
+            if (c->page[i] == NULL) {
+                continue;
+            }
+            for (j = 0; j < 256; j++) {
+                profiling_data_t *data = &c->page[i]->data[j];
+                profiling_context_t *frame;
+                uint64_t location;
+
+                if (data->num_samples == 0) {
+                    continue;
+                }
+
+                /* call stack, leaf first: the sampled instruction followed
+                   by the JSR of each caller */
+                location = pprof_location(state, (uint16_t)((i << 8) | j), c->memory_bank_config, leaf_function);
+                pprof_put_varint(&state->packed, location);
+                for (frame = context; frame->parent != NULL; frame = frame->parent) {
+                    if (is_interrupt(frame->pc_src)) {
+                        uint64_t handler = pprof_function(state, frame->pc_src, 0, true);
+                        location = pprof_location(state, frame->pc_src, 0, handler);
+                    } else {
+                        uint64_t caller = pprof_function(state, frame->parent->pc_dst,
+                                                         frame->parent->memory_bank_config, false);
+                        location = pprof_location(state, (uint16_t)(frame->pc_src - 2),
+                                                  frame->memory_bank_config, caller);
+                    }
+                    pprof_put_varint(&state->packed, location);
+                }
+                pprof_put_message(&state->msg, 1, &state->packed);
+
+                pprof_put_varint(&state->packed, data->num_samples);
+                pprof_put_varint(&state->packed, data->num_cycles);
+                pprof_put_message(&state->msg, 2, &state->packed);
+
+                /* label the sample with the bank config it was taken in */
+                pprof_put_uint(&state->sub, 1, bank_str);
+                pprof_put_uint(&state->sub, 3, (uint64_t)c->memory_bank_config);
+                pprof_put_message(&state->msg, 3, &state->sub);
+
+                pprof_put_message(&state->profile, 2, &state->msg);
+            }
+        }
+    }
+
+    if (context->child) {
+        c = context->child;
+        do {
+            pprof_export_context(state, c, bank_str);
+            c = c->next;
+        } while (c != context->child);
+    }
+}
+
+/* writes the profile as an uncompressed pprof protobuf, which `pprof' and
+   most tools built on it accept as is */
+void mon_profile_export_pprof(const char *filename)
+{
+    pprof_state_t state;
+    uint64_t bank_str;
+    FILE *fp;
+
+    if (!init_profiling_data()) return;
+
+    fp = fopen(filename, MODE_WRITE);
+    if (fp == NULL) {
+        mon_out("Cannot open '%s' for writing.\n", filename);
+        return;
+    }
+
+    memset(&state, 0, sizeof(state));
+
+    /* string_table[0] must be the empty string */
+    pprof_string(&state, "");
+    if (profiler->data_is_sampled) {
+        pprof_value_type(&state, 1, "samples", "count");
+    } else {
+        pprof_value_type(&state, 1, "instructions", "count");
+    }
+    pprof_value_type(&state, 1, "cycles", "count");
+    bank_str = pprof_string(&state, "bank");
+
+    pprof_export_context(&state, profiler->root_context, bank_str);
+
+    pprof_value_type(&state, 11, "cycles", "count");
+    pprof_put_uint(&state.profile, 12, profiler->data_is_sampled ? profiler->sample_interval : 1);
+
+    if (fwrite(state.profile.data, 1, state.profile.size, fp) != state.profile.size) {
+        mon_out("Error writing '%s'.\n", filename);
+    } else {
+        mon_out("pprof profile written to '%s'.\n", filename);
+    }
+    fclose(fp);
+
+    lib_free(state.profile.data);
+    lib_free(state.msg.data);
+    lib_free(state.sub.data);
+    lib_free(state.packed.data);
+    lib_free(state.functions.keys);
+    lib_free(state.functions.ids);
+    lib_free(state.locations.keys);
+    lib_free(state.locations.ids);
+}
@@ -0,0 +1,542 @@
+/*
+ * mon_reverse.c - The VICE built-in monitor, reverse stepping.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/* Reverse stepping keeps compressed snapshots of the machine, taken every
+   few frames, and the input events that happened since the oldest one (see
+   event.c). Going back is done by restoring a snapshot and re-executing up to
+   the wanted instruction, in two passes:
+
+   - the scan pass runs from the snapshot up to the current position and
+     remembers the instruction boundaries (or breakpoint hits) it passes,
+   - the seek pass restores the same snapshot again and stops at the boundary
+     found by the scan.
+
+   Everything after the new position is forgotten, so continuing from there
+   records a new history.
+
+   Snapshots go through a temporary file, like the snapshots that netplay
+   sends, and are kept in memory compressed. The oldest ones are dropped when
+   the memory budget is exceeded.  */
+
+#include "vice.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <zlib.h>
+
+#include "alarm.h"
+#include "archdep.h"
+#include "interrupt.h"
+#include "lib.h"
+#include "log.h"
+#include "machine.h"
+#include "maincpu.h"
+#include "mon_breakpoint.h"
+#include "mon_reverse.h"
+#include "monitor.h"
+#include "montypes.h"
+#include "types.h"
+#include "util.h"
+#include "vice-event.h"
+#include "vsync.h"
+
+int mon_reverse_replaying = 0;
+
+typedef struct reverse_snapshot_s {
+    CLOCK clk;
+    uint64_t rand_state;
+    uint8_t *data;              /* compressed snapshot file */
+    unsigned long size;
+    unsigned long raw_size;
+} reverse_snapshot_t;
+
+enum {
+    REVERSE_SCAN,               /* collect boundaries up to scan_limit */
+    REVERSE_SEEK                /* stop at seek_target */
+};
+
+static int reverse_enabled = 0;
+static int reverse_interval = 50;       /* frames */
+static size_t reverse_budget = 64 << 20;
+
+static reverse_snapshot_t *snapshots = NULL;
+static int num_snapshots = 0;
+static int max_snapshots = 0;
+static size_t snapshots_size = 0;
+
+static char *reverse_tmpname = NULL;
+static alarm_t *reverse_alarm = NULL;
+static log_t reverse_log = LOG_DEFAULT;
+
+/* replay state */
+static int replay_mode;
+static int replay_snapshot;             /* index of the snapshot replayed */
+static CLOCK scan_limit;
+static CLOCK seek_target;
+static int replay_warp;
+
+/* back stepping: the last step_count boundaries before scan_limit */
+static int step_count;
+static CLOCK *step_ring = NULL;
+static int step_ring_pos;
+static int step_ring_used;
+
+/* reverse continue: the last breakpoint hit before scan_limit */
+static int continue_mode;
+static CLOCK continue_hit;
+static int continue_found;
+
+/* ------------------------------------------------------------------------- */
+
+static CLOCK reverse_interval_cycles(void)
+{
+    return (CLOCK)reverse_interval * (CLOCK)machine_get_cycles_per_frame();
+}
+
+static void snapshot_free(int i)
+{
+    snapshots_size -= snapshots[i].size;
+    lib_free(snapshots[i].data);
+}
+
+/* drop the oldest snapshots until the budget is met, always keep one */
+static void snapshots_trim(void)
+{
+    int drop = 0;
+
+    while (num_snapshots - drop > 1 && snapshots_size > reverse_budget) {
+        snapshot_free(drop++);
+    }
+    if (drop > 0) {
+        num_snapshots -= drop;
+        memmove(snapshots, snapshots + drop, num_snapshots * sizeof(reverse_snapshot_t));
+        event_reverse_trim(snapshots[0].clk);
+    }
+}
+
+/* forget the snapshots taken after clk */
+static void snapshots_cut(CLOCK clk)
+{
+    while (num_snapshots > 0 && snapshots[num_snapshots - 1].clk > clk) {
+        snapshot_free(--num_snapshots);
+    }
+}
+
+static void snapshots_clear(void)
+{
+    while (num_snapshots > 0) {
+        snapshot_free(--num_snapshots);
+    }
+}
+
+static int reverse_take_snapshot(void)
+{
+    reverse_snapshot_t *snap;
+    FILE *f;
+    uint8_t *raw;
+    long raw_size;
+    uLongf size;
+
+    if (machine_write_snapshot(reverse_tmpname, 0, 0, 0) < 0) {
+        log_error(reverse_log, "Cannot write snapshot `%s'.", reverse_tmpname);
+        return -1;
+    }
+
+    f = fopen(reverse_tmpname, MODE_READ);
+    if (f == NULL) {
+        log_error(reverse_log, "Cannot read snapshot `%s'.", reverse_tmpname);
+        return -1;
+    }
+    raw_size = (long)archdep_file_size(f);
+    raw = lib_malloc(raw_size);
+    if (fread(raw, 1, raw_size, f) != (size_t)raw_size) {
+        log_error(reverse_log, "Cannot read snapshot `%s'.", reverse_tmpname);
+        fclose(f);
+        lib_free(raw);
+        return -1;
+    }
+    fclose(f);
+
+    if (num_snapshots == max_snapshots) {
+        max_snapshots = max_snapshots ? max_snapshots * 2 : 64;
+        snapshots = lib_realloc(snapshots, max_snapshots * sizeof(reverse_snapshot_t));
+    }
+    snap = &snapshots[num_snapshots];
+
+    size = compressBound(raw_size);
+    snap->data = lib_malloc(size);
+    if (compress2(snap->data, &size, raw, raw_size, Z_BEST_SPEED) != Z_OK) {
+        log_error(reverse_log, "Cannot compress snapshot.");
+        lib_free(snap->data);
+        lib_free(raw);
+        return -1;
+    }
+    lib_free(raw);
+
+    snap->data = lib_realloc(snap->data, size);
+    snap->size = size;
+    snap->raw_size = raw_size;
+    snap->clk = maincpu_clk;
+    snap->rand_state = lib_rand_get_state();
+    snapshots_size += size;
+    num_snapshots++;
+
+    snapshots_trim();
+    return 0;
+}
+
+static int reverse_restore_snapshot(int i)
+{
+    reverse_snapshot_t *snap = &snapshots[i];
+    uint8_t *raw;
+    uLongf raw_size = snap->raw_size;
+    int ret;
+
+    raw = lib_malloc(raw_size);
+    if (uncompress(raw, &raw_size, snap->data, snap->size) != Z_OK
+        || util_file_save(reverse_tmpname, raw, (int)raw_size) < 0) {
+        log_error(reverse_log, "Cannot restore snapshot.");
+        lib_free(raw);
+        return -1;
+    }
+    lib_free(raw);
+
+    ret = mon_read_snapshot(reverse_tmpname, 0);
+    lib_rand_set_state(snap->rand_state);
+    /* the snapshot restores the pending interrupts of the CPUs as they were
+       when it was taken, turn the monitor traps back on */
+    mon_update_all_checkpoint_state();
+    return ret;
+}
+
+static void reverse_alarm_set(void)
+{
+    CLOCK next = maincpu_clk + 1;
+
+    if (num_snapshots > 0 && snapshots[num_snapshots - 1].clk + reverse_interval_cycles() > next) {
+        next = snapshots[num_snapshots - 1].clk + reverse_interval_cycles();
+    }
+    alarm_set(reverse_alarm, next);
+}
+
+static void reverse_snapshot_trap(uint16_t addr, void *data)
+{
+    if (reverse_enabled && !mon_reverse_replaying) {
+        reverse_take_snapshot();
+        alarm_set(reverse_alarm, maincpu_clk + reverse_interval_cycles());
+    }
+}
+
+static void reverse_alarm_handler(CLOCK offset, void *data)
+{
+    alarm_unset(reverse_alarm);
+    /* snapshots can only be taken between two instructions */
+    interrupt_maincpu_trigger_trap(reverse_snapshot_trap, NULL);
+}
+
+/* ------------------------------------------------------------------------- */
+
+static int replay_boundary(void);
+
+/* restore snapshot i and start replaying from it, returns non-zero if the
+   replay is done already */
+static int replay_from(int i)
+{
+    replay_snapshot = i;
+    if (reverse_restore_snapshot(i) < 0) {
+        /* the machine state is unknown now, give up on the history */
+        mon_out("Reverse stepping failed, history dropped.\n");
+        snapshots_clear();
+        seek_target = 0;
+        replay_mode = REVERSE_SEEK;
+        return replay_boundary();
+    }
+    event_reverse_playback_start(snapshots[i].clk);
+    step_ring_pos = 0;
+    step_ring_used = 0;
+    continue_found = 0;
+    return replay_boundary();
+}
+
+static int replay_start(int i)
+{
+    mon_reverse_replaying = 1;
+    alarm_unset(reverse_alarm);
+    replay_warp = vsync_get_warp_mode();
+    vsync_set_warp_mode(1);
+    return replay_from(i);
+}
+
+static void replay_finish(void)
+{
+    mon_reverse_replaying = 0;
+    event_reverse_playback_stop();
+    vsync_set_warp_mode(replay_warp);
+    lib_free(step_ring);
+    step_ring = NULL;
+
+    snapshots_cut(maincpu_clk);
+    if (reverse_enabled) {
+        reverse_alarm_set();
+    }
+}
+
+static int scan_done(void)
+{
+    CLOCK target;
+
+    if (continue_mode) {
+        if (continue_found) {
+            target = continue_hit;
+        } else if (replay_snapshot > 0) {
+            /* nothing in this interval, try the one before */
+            scan_limit = snapshots[replay_snapshot].clk;
+            return replay_from(replay_snapshot - 1);
+        } else {
+            mon_out("No breakpoint hit in the recorded history.\n");
+            target = snapshots[0].clk;
+        }
+    } else {
+        if (step_ring_used < step_count && replay_snapshot > 0) {
+            /* not enough instructions, scan a longer interval */
+            return replay_from(replay_snapshot - 1);
+        }
+        if (step_ring_used < step_count) {
+            mon_out("Reached the start of the recorded history.\n");
+        }
+        if (step_ring_used == 0) {
+            target = snapshots[0].clk;
+        } else if (step_ring_used < step_count) {
+            target = step_ring[(step_ring_pos + step_count - step_ring_used) % step_count];
+        } else {
+            target = step_ring[step_ring_pos];
+        }
+    }
+
+    replay_mode = REVERSE_SEEK;
+    seek_target = target;
+    return replay_from(replay_snapshot);
+}
+
+/* called at every instruction boundary of the replay */
+static int replay_boundary(void)
+{
+    if (replay_mode == REVERSE_SCAN) {
+        if (maincpu_clk >= scan_limit) {
+            return scan_done();
+        }
+        if (continue_mode) {
+            unsigned int pc = (monitor_cpu_for_memspace[e_comp_space]->mon_register_get_val)(e_comp_space, e_PC);
+
+            if (mon_breakpoint_would_stop(e_comp_space, pc)) {
+                continue_hit = maincpu_clk;
+                continue_found = 1;
+            }
+        } else {
+            step_ring[step_ring_pos] = maincpu_clk;
+            step_ring_pos = (step_ring_pos + 1) % step_count;
+            if (step_ring_used < step_count) {
+                step_ring_used++;
+            }
+        }
+        return 0;
+    }
+
+    if (maincpu_clk < seek_target) {
+        return 0;
+    }
+    if (maincpu_clk > seek_target) {
+        log_warning(reverse_log, "Replay went past the target cycle %"PRIu64" (now at %"PRIu64").",
+                    (uint64_t)seek_target, (uint64_t)maincpu_clk);
+    }
+    replay_finish();
+    return 1;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* find the last snapshot taken before clk */
+static int snapshot_before(CLOCK clk)
+{
+    int i;
+
+    for (i = num_snapshots - 1; i >= 0; i--) {
+        if (snapshots[i].clk < clk) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static int replay_prepare(void)
+{
+    int i;
+
+    if (!reverse_enabled) {
+        mon_out("Reverse stepping is off, enable it with `reverse on'.\n");
+        return -1;
+    }
+    i = snapshot_before(maincpu_clk);
+    if (i < 0) {
+        mon_out("No recorded history before the current position.\n");
+    }
+    return i;
+}
+
+int mon_reverse_step_back(int count)
+{
+    int i = replay_prepare();
+
+    if (i < 0) {
+        return -1;
+    }
+    step_count = count;
+    step_ring = lib_malloc(count * sizeof(CLOCK));
+    continue_mode = 0;
+    replay_mode = REVERSE_SCAN;
+    scan_limit = maincpu_clk;
+    return replay_start(i);
+}
+
+int mon_reverse_continue(void)
+{
+    int i = replay_prepare();
+
+    if (i < 0) {
+        return -1;
+    }
+    continue_mode = 1;
+    replay_mode = REVERSE_SCAN;
+    scan_limit = maincpu_clk;
+    return replay_start(i);
+}
+
+/* mon_reverse_step_back() and mon_reverse_continue() return -1 on error, 0
+   when the machine has to run to reach the target and 1 when the target was
+   reached already (it is the snapshot itself). */
+
+/* called by monitor_check_icount() while replaying, returns non-zero when
+   the monitor should be entered */
+int mon_reverse_check_icount(void)
+{
+    return replay_boundary();
+}
+
+/* ------------------------------------------------------------------------- */
+
+void mon_reverse_enable(int enable)
+{
+    if (enable < 0) {
+        enable = !reverse_enabled;
+    }
+    if (enable == reverse_enabled) {
+        mon_reverse_status();
+        return;
+    }
+
+    if (!enable) {
+        mon_reverse_shutdown();
+        mon_out("Reverse stepping disabled.\n");
+        return;
+    }
+
+    if (reverse_log == LOG_DEFAULT) {
+        reverse_log = log_open("Reverse");
+    }
+    if (reverse_alarm == NULL) {
+        reverse_alarm = alarm_new(maincpu_alarm_context, "MonitorReverse",
+                                  reverse_alarm_handler, NULL);
+    }
+    reverse_tmpname = archdep_tmpnam();
+    event_reverse_start();
+    reverse_enabled = 1;
+
+    if (reverse_take_snapshot() < 0) {
+        mon_out("Cannot take snapshots, reverse stepping disabled.\n");
+        mon_reverse_shutdown();
+        return;
+    }
+    alarm_set(reverse_alarm, maincpu_clk + reverse_interval_cycles());
+    mon_out("Reverse stepping enabled, snapshot every %d frames, using up to %u MiB.\n",
+            reverse_interval, (unsigned int)(reverse_budget >> 20));
+}
+
+void mon_reverse_status(void)
+{
+    if (!reverse_enabled) {
+        mon_out("Reverse stepping is off.\n");
+        return;
+    }
+    mon_out("Reverse stepping is on: %d snapshot(s) using %u KiB", num_snapshots,
+            (unsigned int)(snapshots_size >> 10));
+    if (num_snapshots > 0) {
+        mon_out(", history goes back %"PRIu64" cycles", (uint64_t)(maincpu_clk - snapshots[0].clk));
+    }
+    mon_out(".\n");
+}
+
+void mon_reverse_set_interval(int frames)
+{
+    reverse_interval = frames;
+}
+
+void mon_reverse_set_budget(int megabytes)
+{
+    reverse_budget = (size_t)megabytes << 20;
+    snapshots_trim();
+}
+
+/* the clock restarts on reset, the history before it is of no use */
+void mon_reverse_reset(void)
+{
+    if (!reverse_enabled || mon_reverse_replaying) {
+        return;
+    }
+    snapshots_clear();
+    event_reverse_stop();
+    event_reverse_start();
+    /* take a snapshot right after the reset */
+    alarm_set(reverse_alarm, maincpu_clk + 1);
+}
+
+void mon_reverse_shutdown(void)
+{
+    if (!reverse_enabled) {
+        return;
+    }
+    reverse_enabled = 0;
+    mon_reverse_replaying = 0;
+
+    alarm_unset(reverse_alarm);
+    event_reverse_stop();
+    snapshots_clear();
+    lib_free(snapshots);
+    snapshots = NULL;
+    max_snapshots = 0;
+    lib_free(step_ring);
+    step_ring = NULL;
+
+    archdep_remove(reverse_tmpname);
+    lib_free(reverse_tmpname);
+    reverse_tmpname = NULL;
+}
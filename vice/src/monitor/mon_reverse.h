@@ -0,0 +1,45 @@
+/*
+ * mon_reverse.h - The VICE built-in monitor, reverse stepping.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#ifndef VICE_MON_REVERSE_H
+#define VICE_MON_REVERSE_H
+
+#include "types.h"
+
+/* set while the machine re-executes recorded history, checkpoints must not
+   trigger during that time */
+extern int mon_reverse_replaying;
+
+void mon_reverse_enable(int enable); /* -1 toggles */
+void mon_reverse_status(void);
+void mon_reverse_set_interval(int frames);
+void mon_reverse_set_budget(int megabytes);
+
+int mon_reverse_step_back(int count);
+int mon_reverse_continue(void);
+int mon_reverse_check_icount(void);
+
+void mon_reverse_reset(void);
+void mon_reverse_shutdown(void);
+
+#endif
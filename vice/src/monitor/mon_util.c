@@ -506,7 +506,10 @@ char *uimon_in(const char *prompt)
 
         if (monitor_is_remote() || monitor_is_binary()) {
 
-            vice_network_select_multiple(sockfd);
+            /* commands that came in with an earlier one are buffered */
+            if (!monitor_binary_command_pending()) {
+                vice_network_select_multiple(sockfd);
+            }
 
             if (monitor_is_binary()) {
                 if (!monitor_binary_get_command_line()) {
@@ -63,9 +63,11 @@
 #include "machine-video.h"
 #include "mem.h"
 #include "mon_breakpoint.h"
+#include "mon_cputrace.h"
 #include "mon_disassemble.h"
 #include "mon_memmap.h"
 #include "mon_memory.h"
+#include "mon_reverse.h"
 #include "asm.h"
 
 #include "mon_parse.h"
@@ -74,7 +76,9 @@
 #include "monitor.h"
 #include "monitor_network.h"
 #include "monitor_binary.h"
+#include "mos6510.h"
 #include "montypes.h"
+#include "profiler.h"
 
 #include "userport_io_sim.h"
 #include "joyport_io_sim.h"
@@ -369,6 +373,8 @@ static bool is_machine_ready(void)
 
 void monitor_reset_hook(void)
 {
+    mon_reverse_reset();
+
     if (init_break_mode == ON_RESET) {
         init_break_mode = NONE;
 
@@ -392,9 +398,12 @@ void monitor_vsync_hook(void)
         }
     }
 
+    mon_memmap_frame_done();
+
 #ifdef HAVE_NETWORK
     /* check if someone wants to connect remotely to the monitor */
     monitor_check_remote();
+    monitor_binary_push_subscriptions();
     monitor_check_binary();
 #endif
 }
@@ -1164,12 +1173,8 @@ unsigned mon_disassemble_oneline(MEMSPACE memspace, uint16_t mem_config, uint16_
 void mon_backtrace(void)
 {
     uint16_t sp, i, pc, addr;
+    profiler_cpu_t *profiler = &maincpu_profiler;
 
-    extern uint16_t callstack_pc_dst[];
-    extern uint16_t callstack_pc_src[];
-    extern uint16_t callstack_memory_bank_config[];
-    extern uint8_t  callstack_sp[];
-    extern unsigned callstack_size;
     /* FIXME: memspace should be passed as an argument to this function */
     MEMSPACE mem = default_memspace;
     if (mem == e_default_space) {
@@ -1187,13 +1192,15 @@ void mon_backtrace(void)
     mon_out("             PC        ");
     mon_disassemble_oneline(default_memspace, mem_get_current_bank_config(), pc);
 
-    for (i = callstack_size-1; (int16_t)i >= 0; i--) {
-        uint16_t addr_src = callstack_pc_src[i];
-        uint16_t addr_dst = callstack_pc_dst[i];
+    for (i = profiler->callstack_size-1; (int16_t)i >= 0; i--) {
+        uint16_t addr_src = profiler->callstack_pc_src[i];
+        uint16_t addr_dst = profiler->callstack_pc_dst[i];
+        uint16_t bank = profiler->callstack_memory_bank_config[i];
+        uint16_t stack = profiler->callstack_sp[i];
 
         /* get current stack value */
-        addr =   mon_get_mem_val_nosfx(default_memspace, callstack_memory_bank_config[i], callstack_sp[i] + 0x100 + 1)
-               | mon_get_mem_val_nosfx(default_memspace, callstack_memory_bank_config[i], callstack_sp[i] + 0x100 + 2) << 8;
+        addr =   mon_get_mem_val_nosfx(default_memspace, bank, stack + 0x100 + 1)
+               | mon_get_mem_val_nosfx(default_memspace, bank, stack + 0x100 + 2) << 8;
 
         if (addr_src >= 0xfffa && !(addr_src & 1)) {
             switch(addr_src) {
@@ -1206,9 +1213,9 @@ void mon_backtrace(void)
             addr -= 2; /* print the JSR instruction */
         }
         mon_out(" -> %04x", addr_dst);
-        mon_out(" [SP +%3d] ", callstack_sp[i] - sp + 1);
+        mon_out(" [SP +%3d] ", stack - sp + 1);
 
-        mon_disassemble_oneline(default_memspace, callstack_memory_bank_config[i], addr);
+        mon_disassemble_oneline(default_memspace, bank, addr);
     }
 }
 
@@ -1671,6 +1678,8 @@ void monitor_shutdown(void)
         }
     }
 
+    mon_cputrace_shutdown();
+    mon_reverse_shutdown();
     mon_memmap_shutdown();
 
     while (playback_fp_stack_size) {
@@ -1782,6 +1791,28 @@ static int set_monitor_chis_lines(int val, void *param)
 }
 #endif
 
+static int monitorreverseinterval = 0;
+static int set_monitor_reverse_interval(int val, void *param)
+{
+    if (val < 1) {
+        val = 1;
+    }
+    monitorreverseinterval = val;
+    mon_reverse_set_interval(val);
+    return 0;
+}
+
+static int monitorreversebudget = 0;
+static int set_monitor_reverse_budget(int val, void *param)
+{
+    if (val < 1) {
+        val = 1;
+    }
+    monitorreversebudget = val;
+    mon_reverse_set_budget(val);
+    return 0;
+}
+
 static int monitorscrollbacklines = 0;
 static int set_monitor_scrollback_lines(int val, void *param)
 {
@@ -1814,6 +1845,10 @@ static const resource_int_t resources_int[] = {
 #endif
     { "MonitorScrollbackLines", 8192, RES_EVENT_NO, NULL,
       &monitorscrollbacklines, set_monitor_scrollback_lines, NULL },
+    { "MonitorReverseInterval", 50, RES_EVENT_NO, NULL,
+      &monitorreverseinterval, set_monitor_reverse_interval, NULL },
+    { "MonitorReverseBudget", 64, RES_EVENT_NO, NULL,
+      &monitorreversebudget, set_monitor_reverse_budget, NULL },
     RESOURCE_INT_LIST_END
 };
 
@@ -1874,6 +1909,12 @@ static const cmdline_option_t cmdline_options[] =
       NULL, NULL, "MonitorChisLines", NULL,
       "<value>", "Set number of lines to keep in the cpu history" },
 #endif
+    { "-monreverseinterval", SET_RESOURCE, CMDLINE_ATTRIB_NEED_ARGS,
+      NULL, NULL, "MonitorReverseInterval", NULL,
+      "<frames>", "Set number of frames between the snapshots used for reverse stepping" },
+    { "-monreversebudget", SET_RESOURCE, CMDLINE_ATTRIB_NEED_ARGS,
+      NULL, NULL, "MonitorReverseBudget", NULL,
+      "<MiB>", "Set memory used for the snapshots of reverse stepping" },
     CMDLINE_LIST_END
 };
 
@@ -2598,6 +2639,55 @@ void mon_instruction_return(void)
     interrupt_monitor_trap_on(mon_interfaces[default_memspace]->int_status);
 }
 
+static void reverse_leave_monitor(void)
+{
+    instruction_count = 0;
+    wait_for_return_level = 0;
+    skip_jsrs = false;
+    exit_mon = 1;
+
+    mon_console_suspend_on_leaving = 0;
+
+    /* the replay checks every instruction through monitor_check_icount() */
+    monitor_mask[e_comp_space] |= MI_STEP;
+    interrupt_monitor_trap_on(mon_interfaces[e_comp_space]->int_status);
+}
+
+static void reverse_stepped(int result)
+{
+    if (result == 0) {
+        reverse_leave_monitor();
+    } else if (result > 0) {
+        /* the target was the snapshot itself, no need to run */
+        mon_disassemble_with_regdump(e_comp_space, dot_addr[e_comp_space]);
+    }
+}
+
+void mon_instructions_back(int count)
+{
+    if (default_memspace != e_comp_space) {
+        mon_out("Reverse stepping only works on the computer.\n");
+        return;
+    }
+    if (count == 0) {
+        mon_out("Cannot step back 0 instructions.\n");
+        return;
+    }
+    if (count > 0) {
+        mon_out("Stepping back %d instruction(s).\n", count);
+    }
+    reverse_stepped(mon_reverse_step_back((count > 0) ? count : 1));
+}
+
+void mon_instructions_back_continue(void)
+{
+    if (default_memspace != e_comp_space) {
+        mon_out("Reverse stepping only works on the computer.\n");
+        return;
+    }
+    reverse_stepped(mon_reverse_continue());
+}
+
 void mon_stack_up(int count)
 {
     mon_out("Going up %d stack frame(s).\n", (count >= 0) ? count : 1);
@@ -2774,6 +2864,340 @@ void mon_delete_conditional(cond_node_t *cnode)
 }
 
 
+/* Conditions of checkpoints are compiled into a small stack based bytecode
+   when they are set, so checking them on every hit of a (possibly hot)
+   checkpoint does not need to walk the expression tree. The semantics are
+   the same as mon_evaluate_conditional(), except that the right hand side
+   of && and || is only evaluated when needed. */
+
+#define COND_STACK_SIZE 32
+
+enum cond_opcode_e {
+    COND_OP_CONST,      /* push arg */
+    COND_OP_REG,        /* push register arg (a MON_REG) */
+    COND_OP_LINE,       /* push current raster line */
+    COND_OP_CYCLE,      /* push current raster cycle */
+    COND_OP_MEM,        /* push byte at address arg of bank */
+    COND_OP_MEM_IND,    /* replace top with byte at address top of bank */
+    COND_OP_AND_JUMP,   /* if top is 0 jump to arg, else drop top */
+    COND_OP_OR_JUMP,    /* if top is not 0 set it to 1 and jump to arg, else drop top */
+    COND_OP_BOOL,       /* top = (top != 0) */
+    COND_OP_BINARY,     /* pop two values, push the result of the operation */
+    COND_OP_BINARY_CONST /* top = top <operation> arg */
+};
+
+typedef struct cond_insn_s {
+    uint8_t opcode;
+    uint8_t operation;
+    int bank;
+    int arg;
+} cond_insn_t;
+
+struct cond_code_s {
+    cond_insn_t *insns;
+    int num_insns;
+    int max_insns;
+    int depth;          /* stack depth while compiling */
+    int max_depth;      /* maximum stack depth needed to evaluate */
+};
+
+static int cond_emit(cond_code_t *code, uint8_t opcode, int bank, int arg)
+{
+    if (code->num_insns == code->max_insns) {
+        code->max_insns = code->max_insns ? code->max_insns * 2 : 16;
+        code->insns = lib_realloc(code->insns, sizeof(cond_insn_t) * code->max_insns);
+    }
+    code->insns[code->num_insns].opcode = opcode;
+    code->insns[code->num_insns].operation = e_INV;
+    code->insns[code->num_insns].bank = bank;
+    code->insns[code->num_insns].arg = arg;
+    return code->num_insns++;
+}
+
+static void cond_push(cond_code_t *code)
+{
+    if (++code->depth > code->max_depth) {
+        code->max_depth = code->depth;
+    }
+}
+
+/* Apply a binary operation, returns 0 on division by zero like the tree
+   walker does */
+static inline int cond_binary(int operation, int value_1, int value_2)
+{
+    switch (operation) {
+        case e_EQU:
+            return value_1 == value_2;
+        case e_NEQ:
+            return value_1 != value_2;
+        case e_GT:
+            return value_1 > value_2;
+        case e_LT:
+            return value_1 < value_2;
+        case e_GTE:
+            return value_1 >= value_2;
+        case e_LTE:
+            return value_1 <= value_2;
+        case e_ADD:
+            return value_1 + value_2;
+        case e_SUB:
+            return value_1 - value_2;
+        case e_MUL:
+            return value_1 * value_2;
+        case e_DIV:
+            if (value_2 == 0) {
+                log_error(LOG_DEFAULT, "Division by zero in conditional\n");
+                return 0;
+            }
+            return value_1 / value_2;
+        case e_BINARY_AND:
+            return value_1 & value_2;
+        case e_BINARY_OR:
+            return value_1 | value_2;
+        default:
+            break;
+    }
+    return 0;
+}
+
+static int cond_compile_node(cond_code_t *code, cond_node_t *cnode)
+{
+    if (cnode->operation != e_INV) {
+        int jump, first;
+
+        if (!(cnode->child1 && cnode->child2)) {
+            log_error(LOG_DEFAULT, "No conditional!");
+            return -1;
+        }
+
+        switch (cnode->operation) {
+            case e_LOGICAL_AND:
+            case e_LOGICAL_OR:
+                if (cond_compile_node(code, cnode->child1) < 0) {
+                    return -1;
+                }
+                jump = cond_emit(code,
+                                 cnode->operation == e_LOGICAL_AND ? COND_OP_AND_JUMP : COND_OP_OR_JUMP,
+                                 0, 0);
+                code->depth--;
+                if (cond_compile_node(code, cnode->child2) < 0) {
+                    return -1;
+                }
+                cond_emit(code, COND_OP_BOOL, 0, 0);
+                code->insns[jump].arg = code->num_insns;
+                return 0;
+            case e_EQU:
+            case e_NEQ:
+            case e_GT:
+            case e_LT:
+            case e_GTE:
+            case e_LTE:
+            case e_ADD:
+            case e_SUB:
+            case e_MUL:
+            case e_DIV:
+            case e_BINARY_AND:
+            case e_BINARY_OR:
+                break;
+            default:
+                log_error(LOG_DEFAULT, "Unexpected conditional operator: %d\n",
+                          cnode->operation);
+                return -1;
+        }
+
+        first = code->num_insns;
+        if (cond_compile_node(code, cnode->child1) < 0
+            || cond_compile_node(code, cnode->child2) < 0) {
+            return -1;
+        }
+        code->depth--;
+
+        if (code->insns[code->num_insns - 1].opcode == COND_OP_CONST
+            && !(cnode->operation == e_DIV && code->insns[code->num_insns - 1].arg == 0)) {
+            if (code->num_insns == first + 2
+                && code->insns[first].opcode == COND_OP_CONST) {
+                /* fold operations on two constants */
+                code->insns[first].arg = cond_binary(cnode->operation,
+                                                     code->insns[first].arg,
+                                                     code->insns[first + 1].arg);
+                code->num_insns--;
+            } else {
+                /* operate on the constant directly instead of pushing it */
+                code->insns[code->num_insns - 1].opcode = COND_OP_BINARY_CONST;
+                code->insns[code->num_insns - 1].operation = (uint8_t)cnode->operation;
+            }
+            return 0;
+        }
+        code->insns[cond_emit(code, COND_OP_BINARY, 0, 0)].operation = (uint8_t)cnode->operation;
+        return 0;
+    }
+
+    if (cnode->is_reg) {
+        if (reg_regid(cnode->reg_num) == e_Rasterline) {
+            cond_emit(code, COND_OP_LINE, 0, 0);
+        } else if (reg_regid(cnode->reg_num) == e_Cycle) {
+            cond_emit(code, COND_OP_CYCLE, 0, 0);
+        } else {
+            cond_emit(code, COND_OP_REG, 0, (int)cnode->reg_num);
+        }
+        cond_push(code);
+    } else if (cnode->banknum >= 0) {
+        if (cnode->child1 != NULL) {
+            if (cond_compile_node(code, cnode->child1) < 0) {
+                return -1;
+            }
+            cond_emit(code, COND_OP_MEM_IND, cnode->banknum, 0);
+        } else {
+            cond_emit(code, COND_OP_MEM, cnode->banknum, (int)addr_location(cnode->value));
+            cond_push(code);
+        }
+    } else {
+        cond_emit(code, COND_OP_CONST, 0, cnode->value);
+        cond_push(code);
+    }
+    return 0;
+}
+
+/* Compile a condition, returns NULL if it can not be compiled, in which case
+   the caller has to use mon_evaluate_conditional() instead */
+cond_code_t *mon_compile_conditional(cond_node_t *cnode)
+{
+    cond_code_t *code;
+
+    if (cnode == NULL) {
+        return NULL;
+    }
+
+    code = lib_calloc(1, sizeof(cond_code_t));
+    if (cond_compile_node(code, cnode) < 0 || code->max_depth > COND_STACK_SIZE) {
+        mon_delete_compiled_conditional(code);
+        return NULL;
+    }
+    return code;
+}
+
+/* Get a register value, the registers of a 6502/6510 main CPU are read
+   directly */
+static inline int cond_get_reg(MON_REG reg_num)
+{
+    MEMSPACE mem = reg_memspace(reg_num);
+    monitor_cpu_type_t *monitor_cpu = monitor_cpu_for_memspace[mem];
+    mos6510_regs_t *regs;
+
+    if (mem == e_comp_space && monitor_cpu->cpu_type == CPU_6502) {
+        regs = mon_interfaces[e_comp_space]->cpu_regs;
+        switch (reg_regid(reg_num)) {
+            case e_A:
+                return MOS6510_REGS_GET_A(regs);
+            case e_X:
+                return MOS6510_REGS_GET_X(regs);
+            case e_Y:
+                return MOS6510_REGS_GET_Y(regs);
+            case e_PC:
+                return MOS6510_REGS_GET_PC(regs);
+            case e_SP:
+                return MOS6510_REGS_GET_SP(regs);
+            default:
+                break;
+        }
+    }
+    return (monitor_cpu->mon_register_get_val)(mem, reg_regid(reg_num));
+}
+
+/* Peek a byte from the computer memspace without side effects */
+static inline uint8_t cond_peek(int bank, uint16_t addr)
+{
+    monitor_interface_t *mi = mon_interfaces[e_comp_space];
+    uint8_t value;
+    int old_sidefx;
+
+    if (mi->mem_bank_peek != NULL) {
+        return mi->mem_bank_peek(bank, addr, mi->context);
+    }
+
+    old_sidefx = sidefx;
+    sidefx = 0;
+    value = mon_get_mem_val_ex(e_comp_space, bank, addr);
+    sidefx = old_sidefx;
+    return value;
+}
+
+int mon_evaluate_compiled_conditional(cond_code_t *code)
+{
+    int stack[COND_STACK_SIZE];
+    int sp = -1;
+    int pc = 0;
+    unsigned int line, cycle;
+    int half_cycle;
+
+    while (pc < code->num_insns) {
+        const cond_insn_t *insn = &code->insns[pc++];
+
+        switch (insn->opcode) {
+            case COND_OP_CONST:
+                stack[++sp] = insn->arg;
+                break;
+            case COND_OP_REG:
+                stack[++sp] = cond_get_reg((MON_REG)insn->arg);
+                break;
+            case COND_OP_LINE:
+                mon_interfaces[e_comp_space]->get_line_cycle(&line, &cycle, &half_cycle);
+                stack[++sp] = line;
+                break;
+            case COND_OP_CYCLE:
+                mon_interfaces[e_comp_space]->get_line_cycle(&line, &cycle, &half_cycle);
+                stack[++sp] = cycle;
+                break;
+            case COND_OP_MEM:
+                stack[++sp] = cond_peek(insn->bank, (uint16_t)insn->arg);
+                break;
+            case COND_OP_MEM_IND:
+                stack[sp] = cond_peek(insn->bank, (uint16_t)stack[sp]);
+                break;
+            case COND_OP_AND_JUMP:
+                if (stack[sp] == 0) {
+                    pc = insn->arg;
+                } else {
+                    sp--;
+                }
+                break;
+            case COND_OP_OR_JUMP:
+                if (stack[sp] != 0) {
+                    stack[sp] = 1;
+                    pc = insn->arg;
+                } else {
+                    sp--;
+                }
+                break;
+            case COND_OP_BOOL:
+                stack[sp] = (stack[sp] != 0);
+                break;
+            case COND_OP_BINARY:
+                sp--;
+                stack[sp] = cond_binary(insn->operation, stack[sp], stack[sp + 1]);
+                break;
+            case COND_OP_BINARY_CONST:
+                stack[sp] = cond_binary(insn->operation, stack[sp], insn->arg);
+                break;
+            default:
+                break;
+        }
+    }
+
+    return stack[0];
+}
+
+void mon_delete_compiled_conditional(cond_code_t *code)
+{
+    if (!code) {
+        return;
+    }
+
+    lib_free(code->insns);
+    lib_free(code);
+}
+
+
 /* *** SNAPSHOTS *** */
 
 
@@ -2800,7 +3224,7 @@ int mon_read_snapshot(const char *name, int even_mode)
 
 void monitor_watch_push_load_addr(uint16_t addr, MEMSPACE mem)
 {
-    if (inside_monitor) {
+    if (inside_monitor || mon_reverse_replaying) {
         return;
     }
 
@@ -2808,6 +3232,12 @@ void monitor_watch_push_load_addr(uint16_t addr, MEMSPACE mem)
         return;
     }
 
+    /* the memory code of some machines routes all pages through the watch
+       functions, skip the ones without watchpoints */
+    if (!monitor_watch_load_page(mem, addr >> 8)) {
+        return;
+    }
+
     watch_load_occurred = true;
     watch_load_array[watch_load_count[mem]][mem] = addr;
     watch_load_count[mem]++;
@@ -2815,7 +3245,14 @@ void monitor_watch_push_load_addr(uint16_t addr, MEMSPACE mem)
 
 void monitor_watch_push_store_addr(uint16_t addr, MEMSPACE mem)
 {
-    if (inside_monitor) {
+    /* marks the pages tracked for memory subscriptions dirty. The memory code
+       of some machines routes all pages through the watch functions, skip
+       the ones without watchpoints */
+    if (!mon_breakpoint_store_page_hit(mem, addr >> 8)) {
+        return;
+    }
+
+    if (inside_monitor || mon_reverse_replaying) {
         return;
     }
 
@@ -2869,9 +3306,29 @@ static bool watchpoints_check_stores(MEMSPACE mem, unsigned int lastpc, unsigned
 
 /* *** CPU INTERFACES *** */
 
+static void monitor_step_done(void)
+{
+    if (monitor_mask[default_memspace] & MI_STEP) {
+        monitor_mask[default_memspace] &= ~MI_STEP;
+        disassemble_on_entry = 1;
+    }
+    if (!monitor_mask[default_memspace]) {
+        interrupt_monitor_trap_off(mon_interfaces[default_memspace]->int_status);
+    }
+
+    monitor_startup(e_default_space);
+}
+
 /* called by cpu core */
 void monitor_check_icount(uint16_t pc)
 {
+    if (mon_reverse_replaying) {
+        if (mon_reverse_check_icount()) {
+            monitor_step_done();
+        }
+        return;
+    }
+
     if (!instruction_count) {
         return;
     }
@@ -2907,15 +3364,7 @@ void monitor_check_icount(uint16_t pc)
         return;
     }
 
-    if (monitor_mask[default_memspace] & MI_STEP) {
-        monitor_mask[default_memspace] &= ~MI_STEP;
-        disassemble_on_entry = 1;
-    }
-    if (!monitor_mask[default_memspace]) {
-        interrupt_monitor_trap_off(mon_interfaces[default_memspace]->int_status);
-    }
-
-    monitor_startup(e_default_space);
+    monitor_step_done();
 }
 
 /* called by cpu core */
@@ -2938,6 +3387,10 @@ void monitor_check_icount_interrupt(void)
  */
 int monitor_check_breakpoints(MEMSPACE mem, uint16_t addr)
 {
+    /* re-executed history was checked the first time around */
+    if (mon_reverse_replaying) {
+        return 0;
+    }
     return mon_breakpoint_check_checkpoint(mem, addr, 0, e_exec); /* FIXME */
 }
 
@@ -33,6 +33,7 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "archdep.h"
 #include "archdep_defs.h"
 #include "cmdline.h"
 #include "drive.h"
@@ -54,6 +55,7 @@
 
 #include "mon_breakpoint.h"
 #include "mon_file.h"
+#include "mon_memmap.h"
 #include "mon_register.h"
 
 #include "version.h"
@@ -83,6 +85,11 @@ enum t_binary_command {
 
     e_MON_CMD_MEM_GET = 0x01,
     e_MON_CMD_MEM_SET = 0x02,
+    e_MON_CMD_MEM_SUBSCRIBE = 0x03,
+    e_MON_CMD_MEM_UNSUBSCRIBE = 0x04,
+    e_MON_CMD_MEM_GET_MULTI = 0x05,
+    e_MON_CMD_MEM_COUNTERS_GET = 0x07,
+    e_MON_CMD_MEM_COUNTERS_CONTROL = 0x08,
 
     e_MON_CMD_CHECKPOINT_GET = 0x11,
     e_MON_CMD_CHECKPOINT_SET = 0x12,
@@ -110,6 +117,7 @@ enum t_binary_command {
     e_MON_CMD_REGISTERS_AVAILABLE = 0x83,
     e_MON_CMD_DISPLAY_GET = 0x84,
     e_MON_CMD_VICE_INFO = 0x85,
+    e_MON_CMD_BATCH = 0x86,
 
     e_MON_CMD_PALETTE_GET = 0x91,
 
@@ -128,6 +136,12 @@ enum t_binary_response {
     e_MON_RESPONSE_INVALID = 0x00,
     e_MON_RESPONSE_MEM_GET = 0x01,
     e_MON_RESPONSE_MEM_SET = 0x02,
+    e_MON_RESPONSE_MEM_SUBSCRIBE = 0x03,
+    e_MON_RESPONSE_MEM_UNSUBSCRIBE = 0x04,
+    e_MON_RESPONSE_MEM_GET_MULTI = 0x05,
+    e_MON_RESPONSE_MEM_CHANGED = 0x06,
+    e_MON_RESPONSE_MEM_COUNTERS = 0x07,
+    e_MON_RESPONSE_MEM_COUNTERS_CONTROL = 0x08,
 
     e_MON_RESPONSE_CHECKPOINT_INFO = 0x11,
 
@@ -158,6 +172,7 @@ enum t_binary_response {
     e_MON_RESPONSE_REGISTERS_AVAILABLE = 0x83,
     e_MON_RESPONSE_DISPLAY_GET = 0x84,
     e_MON_RESPONSE_VICE_INFO = 0x85,
+    e_MON_RESPONSE_BATCH = 0x86,
 
     e_MON_RESPONSE_PALETTE_GET = 0x91,
 
@@ -204,6 +219,54 @@ struct binary_command_s {
 };
 typedef struct binary_command_s binary_command_t;
 
+/* number of memory subscriptions a client can have */
+#define MON_MAX_SUBSCRIPTIONS 16
+
+/* changes closer than this are sent as one run */
+#define MON_SUBSCRIPTION_GAP 8
+
+/* number of memspaces the binary monitor knows about */
+#define MON_BINARY_MEMSPACES 5
+
+struct mem_subscription_s {
+    uint32_t id;                /* 0 if unused */
+    MEMSPACE memspace;
+    int banknum;
+    uint16_t start;
+    uint16_t end;
+    unsigned int interval;      /* frames between two updates */
+    unsigned int countdown;
+    bool shadow_valid;
+    uint32_t dirty[256 / 32];   /* pages written to since the last update */
+    uint8_t *shadow;            /* the memory as last sent to the client */
+};
+typedef struct mem_subscription_s mem_subscription_t;
+
+static mem_subscription_t subscriptions[MON_MAX_SUBSCRIPTIONS];
+static int num_subscriptions = 0;
+static uint32_t next_subscription_id = 1;
+static bool memspace_tracked[MON_BINARY_MEMSPACES];
+
+/* send the access counters at the end of each frame */
+static bool counters_streamed = false;
+
+/* data received from the client, the commands from receive_buffer_pos up to
+   receive_buffer_used are not processed yet */
+static unsigned char *receive_buffer = NULL;
+static size_t receive_buffer_size = 0;
+static size_t receive_buffer_pos = 0;
+static size_t receive_buffer_used = 0;
+
+/* while the received commands are processed, the responses are collected and
+   sent in one go when no more commands are pending */
+static unsigned char *transmit_buffer = NULL;
+static size_t transmit_buffer_size = 0;
+static size_t transmit_buffer_used = 0;
+static bool transmit_collect = false;
+
+static void monitor_binary_subscriptions_clear(void);
+static size_t monitor_binary_pending_command(void);
+
 int monitor_binary_transmit(const unsigned char *buffer, size_t buffer_length)
 {
     int error = 0;
@@ -225,6 +288,21 @@ static void monitor_binary_quit(void)
 {
     vice_network_socket_close(connected_socket);
     connected_socket = NULL;
+    monitor_binary_subscriptions_clear();
+    counters_streamed = false;
+
+    receive_buffer_pos = 0;
+    receive_buffer_used = 0;
+    transmit_buffer_used = 0;
+}
+
+/*! \internal \brief Send the collected responses */
+static void monitor_binary_flush(void)
+{
+    if (transmit_buffer_used > 0) {
+        monitor_binary_transmit(transmit_buffer, transmit_buffer_used);
+        transmit_buffer_used = 0;
+    }
 }
 
 ssize_t monitor_binary_receive(unsigned char *buffer, size_t buffer_length)
@@ -277,7 +355,8 @@ static int monitor_binary_data_available(void)
 
 void monitor_check_binary(void)
 {
-    if (monitor_binary_data_available()) {
+    /* commands after an exit command are still buffered */
+    if (monitor_binary_pending_command() > 0 || monitor_binary_data_available()) {
         monitor_startup_trap();
     }
 }
@@ -326,7 +405,15 @@ static uint16_t little_endian_to_uint16(unsigned char *input) {
 
 static void monitor_binary_response(uint32_t length, BINARY_RESPONSE response_type, BINARY_ERROR errorcode, uint32_t request_id, unsigned char *body)
 {
-    unsigned char response[12];
+    unsigned char *response;
+    size_t response_size = 12 + (body != NULL ? length : 0);
+
+    if (transmit_buffer_size < transmit_buffer_used + response_size) {
+        transmit_buffer_size = transmit_buffer_used + response_size + 4096;
+        transmit_buffer = lib_realloc(transmit_buffer, transmit_buffer_size);
+    }
+    response = &transmit_buffer[transmit_buffer_used];
+    transmit_buffer_used += response_size;
 
     response[0] = ASC_STX;
     response[1] = MON_BINARY_API_VERSION;
@@ -335,10 +422,13 @@ static void monitor_binary_response(uint32_t length, BINARY_RESPONSE response_ty
     response[7] = (uint8_t)errorcode;
     write_uint32(request_id, &response[8]);
 
-    monitor_binary_transmit(response, sizeof response);
-
     if (body != NULL) {
-        monitor_binary_transmit(body, length);
+        memcpy(&response[12], body, length);
+    }
+
+    /* header and body go out in one packet */
+    if (!transmit_collect) {
+        monitor_binary_flush();
     }
 }
 
@@ -416,18 +506,26 @@ static uint8_t memspace_to_uint8_t(MEMSPACE mem) {
     }
 }
 
-static void monitor_binary_response_register_info(uint32_t request_id, MEMSPACE memspace)
+/*! \internal \brief Size of the register info written by write_register_info() */
+static uint32_t register_info_size(mon_reg_list_t *regs)
 {
-    mon_reg_list_t *regs;
-    mon_reg_list_t *regs_cursor;
-    unsigned char *response;
-    unsigned char *response_cursor;
-    uint32_t response_size = 2;
     uint16_t count = 0;
-    uint8_t item_size = 3;
 
-    regs = mon_register_list_get(memspace);
-    regs_cursor = regs;
+    for( ; regs->name ; regs++) {
+        if (!ignore_fake_register(regs)) {
+            ++count;
+        }
+    }
+
+    return 2 + count * (3 + 1);
+}
+
+/*! \internal \brief Write the register info and return pointer to byte after */
+static unsigned char *write_register_info(mon_reg_list_t *regs, unsigned char *output)
+{
+    mon_reg_list_t *regs_cursor = regs;
+    uint16_t count = 0;
+    uint8_t item_size = 3;
 
     for( ; regs_cursor->name ; regs_cursor++) {
         if (!ignore_fake_register(regs_cursor)) {
@@ -435,28 +533,38 @@ static void monitor_binary_response_register_info(uint32_t request_id, MEMSPACE
         }
     }
 
-    response_size += count * (item_size + 1);
-    response = lib_malloc(response_size);
-    response_cursor = response;
-
-    regs_cursor = regs;
+    output = write_uint16(count, output);
 
-    response_cursor = write_uint16(count, response_cursor);
-
-    for( ; regs_cursor->name ; regs_cursor++) {
+    for(regs_cursor = regs ; regs_cursor->name ; regs_cursor++) {
         if (ignore_fake_register(regs_cursor)) {
             continue;
         }
 
-        *response_cursor = item_size;
-        ++response_cursor;
+        *output = item_size;
+        ++output;
 
-        *response_cursor = regs_cursor->id;
-        ++response_cursor;
+        *output = regs_cursor->id;
+        ++output;
 
-        response_cursor = write_uint16((uint16_t)regs_cursor->val, response_cursor);
+        output = write_uint16((uint16_t)regs_cursor->val, output);
     }
 
+    return output;
+}
+
+static void monitor_binary_response_register_info(uint32_t request_id, MEMSPACE memspace)
+{
+    mon_reg_list_t *regs;
+    unsigned char *response;
+    uint32_t response_size;
+
+    regs = mon_register_list_get(memspace);
+
+    response_size = register_info_size(regs);
+    response = lib_malloc(response_size);
+
+    write_register_info(regs, response);
+
     monitor_binary_response(response_size, e_MON_RESPONSE_REGISTER_INFO, e_MON_ERR_OK, request_id, response);
 
     lib_free(response);
@@ -1542,6 +1650,461 @@ static void monitor_binary_process_mem_set(binary_command_t *command)
     monitor_binary_response(0, e_MON_RESPONSE_MEM_SET, e_MON_ERR_OK, command->request_id, NULL);
 }
 
+/*! \internal \brief Track the stores to the pages of all subscriptions */
+static void monitor_binary_subscriptions_track(void)
+{
+    uint32_t pages[MON_BINARY_MEMSPACES][256 / 32];
+    bool used[MON_BINARY_MEMSPACES];
+    unsigned int i, page;
+
+    memset(pages, 0, sizeof(pages));
+    memset(used, 0, sizeof(used));
+
+    for (i = 0; i < MON_MAX_SUBSCRIPTIONS; i++) {
+        mem_subscription_t *sub = &subscriptions[i];
+        uint8_t index;
+
+        if (sub->id == 0) {
+            continue;
+        }
+        index = memspace_to_uint8_t(sub->memspace);
+        used[index] = true;
+        for (page = sub->start >> 8; page <= (unsigned int)(sub->end >> 8); page++) {
+            pages[index][page >> 5] |= 1U << (page & 0x1f);
+        }
+    }
+
+    for (i = 0; i < MON_BINARY_MEMSPACES; i++) {
+        if (used[i] || memspace_tracked[i]) {
+            mon_breakpoint_track_stores(get_requested_memspace(i), used[i] ? pages[i] : NULL);
+        }
+        memspace_tracked[i] = used[i];
+    }
+}
+
+static void monitor_binary_subscriptions_clear(void)
+{
+    unsigned int i;
+
+    if (num_subscriptions == 0) {
+        return;
+    }
+
+    for (i = 0; i < MON_MAX_SUBSCRIPTIONS; i++) {
+        if (subscriptions[i].id != 0) {
+            lib_free(subscriptions[i].shadow);
+            subscriptions[i].id = 0;
+        }
+    }
+    num_subscriptions = 0;
+
+    monitor_binary_subscriptions_track();
+}
+
+/*! \internal \brief Write a run of a memory subscription and return pointer to byte after */
+static unsigned char *write_subscription_run(mem_subscription_t *sub, unsigned int from, unsigned int to, unsigned char *output)
+{
+    output = write_uint16((uint16_t)(sub->start + from), output);
+    output = write_uint16((uint16_t)(sub->start + to), output);
+    memcpy(output, &sub->shadow[from], to - from + 1);
+
+    return output + (to - from + 1);
+}
+
+/*! \internal \brief Send the bytes of the dirty pages that differ from what the client has */
+static void monitor_binary_subscription_update(mem_subscription_t *sub)
+{
+    unsigned int length = (sub->end + 1) - sub->start;
+    unsigned int page, offset, from, to;
+    unsigned int run_from = 0, run_to = 0;
+    bool in_run = false;
+    uint16_t runs = 0;
+    unsigned char *response;
+    unsigned char *response_cursor;
+
+    /* the runs are separated by more than MON_SUBSCRIPTION_GAP bytes */
+    response = lib_malloc(6 + length + 4 * (length / (MON_SUBSCRIPTION_GAP + 1) + 1));
+    response_cursor = response + 6;
+
+    for (page = sub->start >> 8; page <= (unsigned int)(sub->end >> 8); page++) {
+        if (!(sub->dirty[page >> 5] & (1U << (page & 0x1f)))) {
+            continue;
+        }
+
+        from = (page << 8) > sub->start ? (page << 8) - sub->start : 0;
+        to = ((page << 8) | 0xff) < sub->end ? ((page << 8) | 0xff) - sub->start : sub->end - sub->start;
+
+        for (offset = from; offset <= to; offset++) {
+            uint8_t value = mon_get_mem_val_ex_nosfx(sub->memspace, sub->banknum, (uint16_t)(sub->start + offset));
+
+            if (sub->shadow_valid && sub->shadow[offset] == value) {
+                continue;
+            }
+            sub->shadow[offset] = value;
+
+            if (in_run && offset - run_to <= MON_SUBSCRIPTION_GAP) {
+                run_to = offset;
+                continue;
+            }
+            if (in_run) {
+                response_cursor = write_subscription_run(sub, run_from, run_to, response_cursor);
+                runs++;
+            }
+            run_from = run_to = offset;
+            in_run = true;
+        }
+    }
+
+    if (in_run) {
+        response_cursor = write_subscription_run(sub, run_from, run_to, response_cursor);
+        runs++;
+    }
+
+    memset(sub->dirty, 0, sizeof(sub->dirty));
+    sub->shadow_valid = true;
+
+    if (runs > 0) {
+        write_uint32(sub->id, response);
+        write_uint16(runs, response + 4);
+
+        monitor_binary_response((uint32_t)(response_cursor - response), e_MON_RESPONSE_MEM_CHANGED, e_MON_ERR_OK, MON_EVENT_ID, response);
+    }
+
+    lib_free(response);
+}
+
+/*! \internal \brief Send the access counters of the last frame or the totals */
+static void monitor_binary_counters_response(int totals, uint32_t request_id)
+{
+    unsigned char *response;
+    unsigned char *entries;
+    unsigned int count;
+
+    count = mon_memmap_counters_get(totals, &entries);
+    response = lib_malloc(8 + (size_t)count * 16);
+    write_uint32(mon_memmap_counters_frames(), response);
+    write_uint32(count, &response[4]);
+    memcpy(&response[8], entries, (size_t)count * 16);
+    lib_free(entries);
+
+    monitor_binary_response(8 + count * 16, e_MON_RESPONSE_MEM_COUNTERS, e_MON_ERR_OK, request_id, response);
+
+    lib_free(response);
+}
+
+/*! \brief Push the changes of the subscribed memory, called once per frame */
+void monitor_binary_push_subscriptions(void)
+{
+    uint32_t dirty[256 / 32];
+    unsigned int i, j, m;
+
+    if (counters_streamed && connected_socket != NULL && mon_memmap_counters_enabled()) {
+        monitor_binary_counters_response(0, MON_EVENT_ID);
+    }
+
+    if (num_subscriptions == 0 || connected_socket == NULL) {
+        return;
+    }
+
+    for (m = 0; m < MON_BINARY_MEMSPACES; m++) {
+        if (!memspace_tracked[m]) {
+            continue;
+        }
+        if (m > 0) {
+            /* let the drives catch up with the main CPU */
+            drive_cpu_execute_all(maincpu_clk);
+        }
+        mon_breakpoint_get_dirty_pages(get_requested_memspace(m), dirty);
+        for (i = 0; i < MON_MAX_SUBSCRIPTIONS; i++) {
+            if (subscriptions[i].id != 0 && memspace_to_uint8_t(subscriptions[i].memspace) == m) {
+                for (j = 0; j < 256 / 32; j++) {
+                    subscriptions[i].dirty[j] |= dirty[j];
+                }
+            }
+        }
+    }
+
+    for (i = 0; i < MON_MAX_SUBSCRIPTIONS; i++) {
+        mem_subscription_t *sub = &subscriptions[i];
+
+        if (sub->id == 0 || --sub->countdown > 0) {
+            continue;
+        }
+        sub->countdown = sub->interval;
+        monitor_binary_subscription_update(sub);
+    }
+}
+
+static void monitor_binary_process_mem_subscribe(binary_command_t *command)
+{
+    unsigned int i, page;
+    unsigned char response[4];
+    mem_subscription_t *sub = NULL;
+    MEMSPACE memspace;
+
+    unsigned char *body = command->body;
+
+    uint16_t startaddress = little_endian_to_uint16(&body[0]);
+    uint16_t endaddress = little_endian_to_uint16(&body[2]);
+
+    uint8_t requested_memspace = body[4];
+    uint16_t requested_banknum = little_endian_to_uint16(&body[5]);
+
+    uint8_t interval = body[7];
+
+    if (command->length < 8) {
+        monitor_binary_error(e_MON_ERR_CMD_INVALID_LENGTH, command->request_id);
+        return;
+    }
+
+    if (startaddress > endaddress) {
+        monitor_binary_error(e_MON_ERR_INVALID_PARAMETER, command->request_id);
+        log_message(LOG_DEFAULT, "monitor binary memsubscribe: wrong start and/or end address %04x - %04x",
+                    startaddress, endaddress);
+        return;
+    }
+
+    memspace = get_requested_memspace(requested_memspace);
+
+    if(memspace == e_invalid_space) {
+        monitor_binary_error(e_MON_ERR_INVALID_MEMSPACE, command->request_id);
+        log_message(LOG_DEFAULT, "monitor binary memsubscribe: Unknown memspace %u", requested_memspace);
+        return;
+    }
+
+    if (mon_banknum_validate(memspace, requested_banknum) == 0) {
+        monitor_binary_error(e_MON_ERR_INVALID_PARAMETER, command->request_id);
+        log_message(LOG_DEFAULT, "monitor binary memsubscribe: Unknown bank %u", requested_banknum);
+        return;
+    }
+
+    for (i = 0; i < MON_MAX_SUBSCRIPTIONS; i++) {
+        if (subscriptions[i].id == 0) {
+            sub = &subscriptions[i];
+            break;
+        }
+    }
+
+    if (sub == NULL) {
+        monitor_binary_error(e_MON_ERR_CMD_FAILURE, command->request_id);
+        return;
+    }
+
+    sub->id = next_subscription_id++;
+    if (next_subscription_id == 0 || next_subscription_id == MON_EVENT_ID) {
+        next_subscription_id = 1;
+    }
+    sub->memspace = memspace;
+    sub->banknum = requested_banknum;
+    sub->start = startaddress;
+    sub->end = endaddress;
+    sub->interval = interval ? interval : 1;
+    sub->countdown = 1;
+    sub->shadow_valid = false;
+    sub->shadow = lib_malloc((endaddress + 1) - startaddress);
+
+    /* the first update sends the whole range */
+    memset(sub->dirty, 0, sizeof(sub->dirty));
+    for (page = startaddress >> 8; page <= (unsigned int)(endaddress >> 8); page++) {
+        sub->dirty[page >> 5] |= 1U << (page & 0x1f);
+    }
+
+    num_subscriptions++;
+    monitor_binary_subscriptions_track();
+
+    write_uint32(sub->id, response);
+
+    monitor_binary_response(sizeof response, e_MON_RESPONSE_MEM_SUBSCRIBE, e_MON_ERR_OK, command->request_id, response);
+}
+
+static void monitor_binary_process_mem_unsubscribe(binary_command_t *command)
+{
+    unsigned int i;
+    uint32_t id = little_endian_to_uint32(command->body);
+
+    if (command->length < 4) {
+        monitor_binary_error(e_MON_ERR_CMD_INVALID_LENGTH, command->request_id);
+        return;
+    }
+
+    for (i = 0; i < MON_MAX_SUBSCRIPTIONS; i++) {
+        if (subscriptions[i].id != 0 && subscriptions[i].id == id) {
+            break;
+        }
+    }
+
+    if (i == MON_MAX_SUBSCRIPTIONS) {
+        monitor_binary_error(e_MON_ERR_OBJECT_MISSING, command->request_id);
+        return;
+    }
+
+    lib_free(subscriptions[i].shadow);
+    subscriptions[i].id = 0;
+    num_subscriptions--;
+    monitor_binary_subscriptions_track();
+
+    monitor_binary_response(0, e_MON_RESPONSE_MEM_UNSUBSCRIBE, e_MON_ERR_OK, command->request_id, NULL);
+}
+
+static void monitor_binary_process_mem_counters_get(binary_command_t *command)
+{
+    if (command->length < 1) {
+        monitor_binary_error(e_MON_ERR_CMD_INVALID_LENGTH, command->request_id);
+        return;
+    }
+    if (!mon_memmap_counters_enabled()) {
+        monitor_binary_error(e_MON_ERR_OBJECT_MISSING, command->request_id);
+        return;
+    }
+
+    monitor_binary_counters_response(command->body[0] != 0, command->request_id);
+}
+
+static void monitor_binary_process_mem_counters_control(binary_command_t *command)
+{
+    if (command->length < 2) {
+        monitor_binary_error(e_MON_ERR_CMD_INVALID_LENGTH, command->request_id);
+        return;
+    }
+
+    mon_memmap_counters_enable(command->body[0] != 0);
+    counters_streamed = command->body[0] != 0 && command->body[1] != 0;
+
+    monitor_binary_response(0, e_MON_RESPONSE_MEM_COUNTERS_CONTROL, e_MON_ERR_OK, command->request_id, NULL);
+}
+
+static void monitor_binary_process_mem_get_multi(binary_command_t *command)
+{
+    unsigned int i;
+    unsigned char *response;
+    unsigned char *response_cursor;
+    unsigned char *ranges;
+    mon_reg_list_t *regs = NULL;
+    uint32_t response_size = 2 + 2;
+    int old_sidefx = sidefx;
+    MEMSPACE memspace;
+
+    const int header_size = 7;
+    unsigned char *body = command->body;
+
+    uint8_t new_sidefx = body[0];
+    uint8_t requested_memspace = body[1];
+    uint16_t requested_banknum = little_endian_to_uint16(&body[2]);
+    uint8_t with_registers = body[4];
+    uint16_t count = little_endian_to_uint16(&body[5]);
+
+    if (command->length < header_size
+        || command->length < header_size + count * 4) {
+        monitor_binary_error(e_MON_ERR_CMD_INVALID_LENGTH, command->request_id);
+        return;
+    }
+
+    memspace = get_requested_memspace(requested_memspace);
+
+    if(memspace == e_invalid_space) {
+        monitor_binary_error(e_MON_ERR_INVALID_MEMSPACE, command->request_id);
+        log_message(LOG_DEFAULT, "monitor binary memgetmulti: Unknown memspace %u", requested_memspace);
+        return;
+    }
+
+    if (mon_banknum_validate(memspace, requested_banknum) == 0) {
+        monitor_binary_error(e_MON_ERR_INVALID_PARAMETER, command->request_id);
+        log_message(LOG_DEFAULT, "monitor binary memgetmulti: Unknown bank %u", requested_banknum);
+        return;
+    }
+
+    ranges = &body[header_size];
+
+    for (i = 0; i < count; i++) {
+        uint16_t startaddress = little_endian_to_uint16(&ranges[i * 4]);
+        uint16_t endaddress = little_endian_to_uint16(&ranges[i * 4 + 2]);
+
+        if (startaddress > endaddress) {
+            monitor_binary_error(e_MON_ERR_INVALID_PARAMETER, command->request_id);
+            log_message(LOG_DEFAULT, "monitor binary memgetmulti: wrong start and/or end address %04x - %04x",
+                        startaddress, endaddress);
+            return;
+        }
+        response_size += 4 + (endaddress + 1) - startaddress;
+    }
+
+    if (with_registers) {
+        regs = mon_register_list_get(memspace);
+        response_size += register_info_size(regs);
+    }
+
+    response = lib_malloc(response_size);
+    response_cursor = response;
+
+    /* registers and memory are taken while the machine is stopped */
+    if (regs != NULL) {
+        response_cursor = write_register_info(regs, response_cursor);
+    } else {
+        response_cursor = write_uint16(0, response_cursor);
+    }
+
+    response_cursor = write_uint16(count, response_cursor);
+
+    sidefx = !!new_sidefx;
+    for (i = 0; i < count; i++) {
+        uint16_t startaddress = little_endian_to_uint16(&ranges[i * 4]);
+        uint16_t endaddress = little_endian_to_uint16(&ranges[i * 4 + 2]);
+
+        response_cursor = write_uint16(startaddress, response_cursor);
+        response_cursor = write_uint16(endaddress, response_cursor);
+
+        mon_get_mem_block_ex(memspace, requested_banknum, startaddress, endaddress - startaddress, response_cursor);
+        response_cursor += (endaddress + 1) - startaddress;
+    }
+    sidefx = old_sidefx;
+
+    monitor_binary_response(response_size, e_MON_RESPONSE_MEM_GET_MULTI, e_MON_ERR_OK, command->request_id, response);
+
+    lib_free(response);
+}
+
+
+static void monitor_binary_process_command_at(unsigned char *pbuffer, size_t size);
+
+static void monitor_binary_process_batch(binary_command_t *command)
+{
+    unsigned char *cursor = command->body;
+    uint32_t remaining = command->length;
+    uint32_t count = 0;
+    unsigned char response[4];
+
+    /* the commands are processed like they were sent one by one, until one
+       of them resumes the machine */
+    while (remaining > 0 && !exit_mon) {
+        uint32_t body_length;
+
+        if (remaining < 11) {
+            monitor_binary_error(e_MON_ERR_CMD_INVALID_LENGTH, command->request_id);
+            return;
+        }
+
+        body_length = little_endian_to_uint32(&cursor[2]);
+
+        if (cursor[0] != ASC_STX || body_length > remaining - 11) {
+            monitor_binary_error(e_MON_ERR_CMD_INVALID_LENGTH, command->request_id);
+            return;
+        }
+        if (cursor[10] == e_MON_CMD_BATCH) {
+            monitor_binary_error(e_MON_ERR_INVALID_PARAMETER, command->request_id);
+            return;
+        }
+
+        monitor_binary_process_command_at(cursor, 11 + body_length);
+
+        cursor += 11 + body_length;
+        remaining -= 11 + body_length;
+        count++;
+    }
+
+    write_uint32(count, response);
+
+    monitor_binary_response(sizeof response, e_MON_RESPONSE_BATCH, e_MON_ERR_OK, command->request_id, response);
+}
 
 static void monitor_binary_process_command(unsigned char * pbuffer)
 {
@@ -1574,6 +2137,16 @@ static void monitor_binary_process_command(unsigned char * pbuffer)
         monitor_binary_process_mem_get(&command);
     } else if (command_type == e_MON_CMD_MEM_SET) {
         monitor_binary_process_mem_set(&command);
+    } else if (command_type == e_MON_CMD_MEM_SUBSCRIBE) {
+        monitor_binary_process_mem_subscribe(&command);
+    } else if (command_type == e_MON_CMD_MEM_UNSUBSCRIBE) {
+        monitor_binary_process_mem_unsubscribe(&command);
+    } else if (command_type == e_MON_CMD_MEM_GET_MULTI) {
+        monitor_binary_process_mem_get_multi(&command);
+    } else if (command_type == e_MON_CMD_MEM_COUNTERS_GET) {
+        monitor_binary_process_mem_counters_get(&command);
+    } else if (command_type == e_MON_CMD_MEM_COUNTERS_CONTROL) {
+        monitor_binary_process_mem_counters_control(&command);
 
     } else if (command_type == e_MON_CMD_CHECKPOINT_GET) {
         monitor_binary_process_checkpoint_get(&command);
@@ -1628,6 +2201,8 @@ static void monitor_binary_process_command(unsigned char * pbuffer)
         monitor_binary_process_display_get(&command);
     } else if (command_type == e_MON_CMD_VICE_INFO) {
         monitor_binary_process_vice_info(&command);
+    } else if (command_type == e_MON_CMD_BATCH) {
+        monitor_binary_process_batch(&command);
 
     } else if (command_type == e_MON_CMD_EXIT) {
         monitor_binary_process_exit(&command);
@@ -1681,83 +2256,130 @@ static int monitor_binary_activate(void)
     return error;
 }
 
-int monitor_binary_get_command_line(void)
+/*! \internal \brief Process the command at pbuffer, size bytes long */
+static void monitor_binary_process_command_at(unsigned char *pbuffer, size_t size)
 {
-    static size_t buffer_size = 0;
-    static unsigned char *buffer;
+    /* some commands terminate strings in place, right after the body, that
+       is where the next command starts */
+    unsigned char next = pbuffer[size];
+
+    monitor_binary_process_command(pbuffer);
 
-    while (monitor_binary_data_available()) {
+    pbuffer[size] = next;
+}
+
+/*! \internal \brief Size of the complete command waiting in the receive
+    buffer, 0 if there is none */
+static size_t monitor_binary_pending_command(void)
+{
+    while (receive_buffer_pos < receive_buffer_used) {
+        unsigned char *command = &receive_buffer[receive_buffer_pos];
+        size_t available = receive_buffer_used - receive_buffer_pos;
         uint32_t body_length;
-        uint8_t api_version;
-        unsigned int remaining_header_size = 5;
-        unsigned int command_size;
-        ssize_t n;
-
-        if (!buffer) {
-            buffer = lib_malloc(300);
-            buffer_size = 300;
+
+        if (command[0] != ASC_STX) {
+            receive_buffer_pos++;
+            continue;
         }
 
-        n = monitor_binary_receive(buffer, 1);
-        if (n == 0) {
-            monitor_binary_quit();
-            return 0;
-        } else if (n < 0) {
-            monitor_binary_quit();
+        if (available < 11) {
             return 0;
         }
 
-        if (buffer[0] != ASC_STX) {
+        if (command[1] < 0x01 || command[1] > 0x02) {
+            /* unknown api version, look for the next command */
+            receive_buffer_pos++;
             continue;
         }
 
-        n = 0;
+        body_length = little_endian_to_uint32(&command[2]);
+        if (body_length > available - 11) {
+            return 0;
+        }
 
-        while (n < sizeof(api_version) + sizeof(body_length)) {
-            ssize_t o = monitor_binary_receive(&buffer[1 + n], (sizeof(api_version) + sizeof(body_length)) - n);
-            if (o <= 0) {
-                monitor_binary_quit();
-                return 0;
-            }
+        return 11 + body_length;
+    }
 
-            n += o;
-        }
+    return 0;
+}
 
-        api_version = buffer[1];
-        body_length = little_endian_to_uint32(&buffer[2]);
+/*! \internal \brief Receive what the client has sent so far
 
-        if (api_version >= 0x01 && api_version <= 0x02) {
-            remaining_header_size = 5;
-        } else {
-            continue;
-        }
+ \return
+   0 on success, -1 if the connection was closed
+*/
+static int monitor_binary_receive_available(void)
+{
+    ssize_t n;
 
-        command_size = sizeof(api_version) + sizeof(body_length) + remaining_header_size + body_length + 1;
-        if (!buffer || buffer_size < command_size + 1) {
-            buffer = lib_realloc(buffer, command_size + 1);
-            buffer_size = command_size + 1;
-        }
+    /* move the incomplete command to the start */
+    if (receive_buffer_pos > 0) {
+        memmove(receive_buffer, &receive_buffer[receive_buffer_pos], receive_buffer_used - receive_buffer_pos);
+        receive_buffer_used -= receive_buffer_pos;
+        receive_buffer_pos = 0;
+    }
 
-        n = 0;
+    if (receive_buffer_size - receive_buffer_used < 4096) {
+        receive_buffer_size = receive_buffer_size * 2 + 4096;
+        /* one more byte for monitor_binary_process_command_at() */
+        receive_buffer = lib_realloc(receive_buffer, receive_buffer_size + 1);
+    }
 
-        while (n < remaining_header_size + body_length) {
-            ssize_t o = monitor_binary_receive(&buffer[6 + n], remaining_header_size + body_length - n);
-            if (o <= 0) {
-                monitor_binary_quit();
-                return 0;
-            }
+    n = vice_network_receive(connected_socket, &receive_buffer[receive_buffer_used],
+                             receive_buffer_size - receive_buffer_used, 0);
+    if (n <= 0) {
+        log_message(LOG_DEFAULT,
+                    "monitor_binary_receive_available(): vice_network_receive() returned %"PRI_SSIZE_T", breaking connection",
+                    n);
+        monitor_binary_quit();
+        return -1;
+    }
+
+    receive_buffer_used += n;
+
+    return 0;
+}
+
+/*! \brief Check if a complete command is waiting in the receive buffer */
+int monitor_binary_command_pending(void)
+{
+    return monitor_binary_pending_command() > 0;
+}
 
-            n += o;
+int monitor_binary_get_command_line(void)
+{
+    int result = 1;
+
+    /* all commands sent so far are processed before the responses go out */
+    transmit_collect = true;
+
+    while (connected_socket != NULL || monitor_binary_pending_command() > 0) {
+        size_t command_size = monitor_binary_pending_command();
+
+        if (command_size == 0) {
+            if (!monitor_binary_data_available()) {
+                break;
+            }
+            if (monitor_binary_receive_available() < 0) {
+                result = 0;
+                break;
+            }
+            continue;
         }
 
-        monitor_binary_process_command(buffer);
+        monitor_binary_process_command_at(&receive_buffer[receive_buffer_pos], command_size);
+        receive_buffer_pos += command_size;
 
         if (exit_mon) {
-            return 0;
+            result = 0;
+            break;
         }
     }
 
-    return 1;
+    transmit_collect = false;
+    monitor_binary_flush();
+
+    return result;
 }
 
 static int monitor_binary_deactivate(void)
@@ -1765,6 +2387,12 @@ static int monitor_binary_deactivate(void)
     if (listen_socket) {
         vice_network_socket_close(listen_socket);
         listen_socket = NULL;
+
+        /* a unix domain socket leaves its file behind */
+        if (monitor_binary_server_address != NULL
+            && strncmp(monitor_binary_server_address, "unix://", sizeof "unix://" - 1) == 0) {
+            archdep_remove(&monitor_binary_server_address[sizeof "unix://" - 1]);
+        }
     }
 
     return 0;
@@ -1933,6 +2561,10 @@ void monitor_check_binary(void)
 {
 }
 
+void monitor_binary_push_subscriptions(void)
+{
+}
+
 int monitor_binary_transmit(const unsigned char *buffer, size_t buffer_length)
 {
     return 0;
@@ -1943,6 +2575,11 @@ int monitor_binary_get_command_line(void)
     return 0;
 }
 
+int monitor_binary_command_pending(void)
+{
+    return 0;
+}
+
 int monitor_is_binary(void)
 {
     return 0;
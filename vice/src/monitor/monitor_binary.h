@@ -43,10 +43,12 @@ void monitor_binary_event_opened(void);
 void monitor_binary_event_closed(void);
 
 void monitor_check_binary(void);
+void monitor_binary_push_subscriptions(void);
 
 ssize_t monitor_binary_receive(unsigned char *buffer, size_t buffer_length);
 int monitor_binary_transmit(const unsigned char *buffer, size_t buffer_length);
 int monitor_binary_get_command_line(void);
+int monitor_binary_command_pending(void);
 
 int monitor_is_binary(void);
 vice_network_socket_t *monitor_binary_get_connected_socket(void);
@@ -176,6 +176,10 @@ struct cond_node_s {
 };
 typedef struct cond_node_s cond_node_t;
 
+/* Conditional expression compiled to bytecode, see mon_compile_conditional() */
+struct cond_code_s;
+typedef struct cond_code_s cond_code_t;
+
 typedef void monitor_toggle_func_t(int value);
 
 /* Defines */
@@ -275,6 +279,8 @@ void mon_display_screen(long addr);
 void mon_instructions_step(int count);
 void mon_instructions_next(int count);
 void mon_instruction_return(void);
+void mon_instructions_back(int count);
+void mon_instructions_back_continue(void);
 void mon_stack_up(int count);
 void mon_stack_down(int count);
 void mon_print_convert(int val);
@@ -299,6 +305,9 @@ bool check_drive_emu_level_ok(int drive_num);
 void mon_print_conditional(cond_node_t *cnode);
 void mon_delete_conditional(cond_node_t *cnode);
 int mon_evaluate_conditional(cond_node_t *cnode);
+cond_code_t *mon_compile_conditional(cond_node_t *cnode);
+int mon_evaluate_compiled_conditional(cond_code_t *code);
+void mon_delete_compiled_conditional(cond_code_t *code);
 int mon_write_snapshot(const char* name, int save_roms, int save_disks, int even_mode);
 int mon_read_snapshot(const char* name, int even_mode);
 bool mon_is_valid_addr(MON_ADDR a);
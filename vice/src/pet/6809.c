@@ -23,13 +23,18 @@
 #include "vice.h"
 
 #include <stdarg.h>
+#include <stdlib.h>
 
 #include "6809.h"
 #include "alarm.h"
+#include "archdep_exit.h"
 #include "h6809regs.h"
 #include "interrupt.h"
+#include "log.h"
+#include "maincpu.h"
 #include "monitor.h"
 #include "petmem.h"
+#include "profiler.h"
 #include "snapshot.h"
 #include "machine.h"
 
@@ -39,6 +44,7 @@ static void req_irq(unsigned int source);
 #define CLK maincpu_clk
 #define CPU_INT_STATUS maincpu_int_status
 #define ALARM_CONTEXT maincpu_alarm_context
+#define PROFILER (&h6809_profiler)
 
 /* ------------------------------------------------------------------------- */
 /* Hook for additional delay.  */
@@ -274,6 +280,40 @@ static void sim_error(const char *format, ...)
     va_end(ap);
 }
 
+static inline uint8_t h6809_read8(uint16_t addr)
+{
+    uint8_t *p = mem6809_direct_read_tab[addr >> 8];
+
+    if (p != NULL) {
+        petmem_last_access = p[addr & 0xff];
+        return petmem_last_access;
+    }
+    return mem6809_read(addr);
+}
+
+static inline void h6809_write8(uint16_t addr, uint8_t value)
+{
+    uint8_t *p = mem6809_direct_write_tab[addr >> 8];
+
+    if (p != NULL) {
+        p[addr & 0xff] = value;
+        petmem_last_access = value;
+    } else {
+        mem6809_store(addr, value);
+    }
+}
+
+static inline uint16_t h6809_read16(uint16_t addr)
+{
+    uint8_t *p = mem6809_direct_read_tab[addr >> 8];
+
+    if (p != NULL && (addr & 0xff) != 0xff) {
+        petmem_last_access = p[(addr & 0xff) + 1];
+        return (p[addr & 0xff] << 8) | petmem_last_access;
+    }
+    return (h6809_read8(addr) << 8) | h6809_read8((uint16_t)(addr + 1));
+}
+
 static inline uint8_t imm_byte(void)
 {
     uint8_t val = read8(PC);
@@ -1546,6 +1586,7 @@ static void jsr(void)
 {
     S -= 2;
     write_stack16(S, PC);
+    profile_jsr(PROFILER, ea, (uint16_t)(iPC + 2), S);
     PC = ea;
 
     CLK_ADD(3, 2);
@@ -1553,6 +1594,7 @@ static void jsr(void)
 
 static void rti(void)
 {
+    profile_rtx(PROFILER, S);
     CLK += 3;
     set_cc(read_stack(S));
     S++;
@@ -1580,6 +1622,7 @@ static void rti(void)
 
 static void rts(void)
 {
+    profile_rtx(PROFILER, S);
     CLK_ADD(2, 1);
 
     PC = read_stack16(S);
@@ -1610,6 +1653,7 @@ void nmi(void)
     EFI |= I_FLAG;
 
     PC = read16(0xfffc);
+    profile_jsr(PROFILER, PC, 0xfffa /* NMI */, S);
 }
 
 void irq(void)
@@ -1636,6 +1680,7 @@ void irq(void)
     EFI |= I_FLAG;
 
     PC = read16(0xfff8);
+    profile_jsr(PROFILER, PC, 0xfffe /* IRQ */, S);
     irqs_pending = 0;
 }
 
@@ -1666,6 +1711,7 @@ void firq(void)
     EFI |= (I_FLAG | F_FLAG);
 
     PC = read16(0xfff6);
+    profile_jsr(PROFILER, PC, 0xfffe /* IRQ */, S);
     firqs_pending = 0;
 }
 
@@ -1694,6 +1740,7 @@ static void swi(void)
     EFI |= (I_FLAG | F_FLAG);
 
     PC = read16(0xfffa);
+    profile_jsr(PROFILER, PC, 0xfffe /* IRQ */, S);
 }
 
 static void swi2(void)
@@ -1720,6 +1767,7 @@ static void swi2(void)
     write_stack(S, get_cc());
 
     PC = read16(0xfff4);
+    profile_jsr(PROFILER, PC, 0xfffe /* IRQ */, S);
 }
 
 static void swi3(void)
@@ -1746,6 +1794,7 @@ static void swi3(void)
     write_stack(S, get_cc());
 
     PC = read16(0xfff2);
+    profile_jsr(PROFILER, PC, 0xfffe /* IRQ */, S);
 }
 
 #ifdef H6309
@@ -1800,7 +1849,7 @@ void div0_trap(void)
 }
 #endif
 
-static void cwai(struct interrupt_cpu_status_s *maincpu_intstatus, alarm_context_t *maincpu_alarm_context)
+static void cwai(struct interrupt_cpu_status_s *maincpu_intstatus, alarm_context_t *alarm_context)
 {
     uint8_t tmp = imm_byte();
     int taken;
@@ -1829,11 +1878,11 @@ static void cwai(struct interrupt_cpu_status_s *maincpu_intstatus, alarm_context
         if (pending) {
             break;
         } else {
-            CLOCK newclock = alarm_context_next_pending_clk(maincpu_alarm_context) - TIME;
+            CLOCK newclock = alarm_context_next_pending_clk(alarm_context) - TIME;
             if (newclock > CLK) {
                 CLK = newclock;
             }
-            alarm_context_dispatch(maincpu_alarm_context, CLK);
+            alarm_context_dispatch(alarm_context, CLK);
             taken = irqs_pending /*| firqs_pending*/;
         }
     }
@@ -1841,7 +1890,7 @@ static void cwai(struct interrupt_cpu_status_s *maincpu_intstatus, alarm_context
 #undef TIME
 
 /* FIXME: cycle count */
-static void sync(void)
+static void sync_op(void)
 {
     CLK += 4;
     /*
@@ -1930,6 +1979,7 @@ static void long_bsr(void)
     ea = PC + tmp;
     S -= 2;
     write_stack16(S, PC);
+    profile_jsr(PROFILER, ea, (uint16_t)(iPC + 2), S);
     PC = ea;
 
     CLK_ADD(4, 1);
@@ -1942,6 +1992,7 @@ static void bsr(void)
     ea = PC + tmp;
     S -= 2;
     write_stack16(S, PC);
+    profile_jsr(PROFILER, ea, (uint16_t)(iPC + 2), S);
     CLK_ADD(3, 2);
     PC = ea;
 }
@@ -2739,10 +2790,11 @@ static void st32(uint32_t arg, int CLK6809, int CLK6309)
 #endif
 
 /* Execute 6809 code for a certain number of cycles. */
-void h6809_mainloop (struct interrupt_cpu_status_s *maincpu_intstatus, alarm_context_t *maincpu_alarm_context)
+void h6809_mainloop (struct interrupt_cpu_status_s *maincpu_intstatus, alarm_context_t *alarm_context)
 {
     uint16_t opcode;
     uint8_t fetch;
+    CLOCK profiling_clock_start;
 #ifdef H6309
     uint8_t post_byte;
 #endif
@@ -2782,6 +2834,11 @@ void h6809_mainloop (struct interrupt_cpu_status_s *maincpu_intstatus, alarm_con
             }
         }
 
+        profiling_clock_start = CLK;
+        if (PROFILER->profiling) {
+            profile_sample_start(PROFILER, PC);
+        }
+
         SET_LAST_ADDR(PC);
         fetch = imm_byte();
 
@@ -3996,7 +4053,7 @@ void h6809_mainloop (struct interrupt_cpu_status_s *maincpu_intstatus, alarm_con
             case 0x103c:        /* CWAI (UNDOC) */
             case 0x113c:        /* CWAI (UNDOC) */
 #endif
-                cwai(maincpu_intstatus, maincpu_alarm_context);
+                cwai(maincpu_intstatus, alarm_context);
                 break;
 
             case 0x0019:        /* DAA */
@@ -5813,7 +5870,7 @@ void h6809_mainloop (struct interrupt_cpu_status_s *maincpu_intstatus, alarm_con
             case 0x1013:        /* SYNC (UNDOC) */
             case 0x1113:        /* SYNC (UNDOC) */
 #endif
-                sync();
+                sync_op();
                 break;
 
 #ifdef H6309
@@ -5937,6 +5994,15 @@ void h6809_mainloop (struct interrupt_cpu_status_s *maincpu_intstatus, alarm_con
         if (cc_changed) {
             cc_modified();
         }
+
+        if (PROFILER->profiling) {
+            profile_sample_finish(PROFILER, CLK - profiling_clock_start, 0 /* stolen_cycles */);
+        }
+
+        if (maincpu_clk_limit && (maincpu_clk > maincpu_clk_limit)) {
+            log_error(LOG_DEFAULT, "cycle limit reached.");
+            archdep_vice_exit(EXIT_FAILURE);
+        }
     } while (1);
 
 /* cpu_exit: */
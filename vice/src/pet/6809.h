@@ -72,13 +72,14 @@ typedef unsigned int absolute_address_t;
 #define V_FLAG 0x02
 #define C_FLAG 0x01
 
-/* Primitive read/write macros */
-#define read8(addr)      mem6809_read((addr))
-#define write8(addr, val) mem6809_store((addr), (val))
+/* Primitive read/write macros, these access plain RAM and ROM directly (see
+   6809.c) and use mem6809_read()/mem6809_store() for everything else */
+#define read8(addr)      h6809_read8((addr))
+#define write8(addr, val) h6809_write8((addr), (val))
 
 
 /* 16-bit versions */
-#define read16(addr)       mem6809_read16((addr))
+#define read16(addr)       h6809_read16((addr))
 #define write16(addr, val)                   \
     do {                                     \
         write8((addr) + 1, (val) & 0xFF);    \
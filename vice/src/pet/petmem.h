@@ -85,10 +85,16 @@ extern struct dongle6702_s dongle6702;
 extern uint8_t petmem_map_reg;
 extern uint8_t petmem_ramON;
 extern uint8_t petmem_2001_buf_ef[];
+extern uint8_t petmem_last_access;
 
 extern read_func_t mem6809_read;
 extern store_func_t mem6809_store;
 
+/* Direct access tables for plain RAM/ROM pages, NULL if a handler is needed.
+   Users must update petmem_last_access like the handlers do.  */
+extern uint8_t *mem6809_direct_read_tab[];
+extern uint8_t *mem6809_direct_write_tab[];
+
 void mem6809_store16(uint16_t addr, uint16_t value);
 uint16_t mem6809_read16(uint16_t addr);
 
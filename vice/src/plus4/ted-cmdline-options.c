@@ -66,7 +66,8 @@ static const cmdline_option_t cmdline_options[] =
 
 int ted_cmdline_options_init(void)
 {
-    if (raster_cmdline_options_chip_init("TED", ted.video_chip_cap) < 0) {
+    if (raster_cmdline_options_chip_init("TED", ted.video_chip_cap) < 0
+        || raster_cmdline_options_chip_async_init("TED") < 0) {
         return -1;
     }
 
@@ -30,12 +30,14 @@
 
 #include <string.h>
 
+#include "raster-async.h"
 #include "raster-cache-fill.h"
 #include "raster-cache-fill-1fff.h"
 #include "raster-cache-nibbles.h"
 #include "raster-cache-text-ext.h"
 #include "raster-cache-text-std.h"
 #include "raster-cache.h"
+#include "raster-changes.h"
 #include "raster-modes.h"
 #include "ted-draw.h"
 #include "ted.h"
@@ -43,6 +45,96 @@
 #include "types.h"
 
 
+/* The drawing code reads the TED state through this pointer, so the raster
+   lines can be drawn from a copy of it on a separate thread.  The character
+   and bitmap data a line uses are captured with the line and put into
+   buffers of their own, at the same offsets the drawing code reads them
+   from.  */
+static ted_t *ted_draw_state = &ted;
+
+typedef struct ted_draw_async_data_s {
+    unsigned int first_mask;    /* first entry of async_char_mask[] used */
+    uint8_t chars[3][TED_SCREEN_TEXTCOLS];
+    uint8_t bitmap[TED_SCREEN_TEXTCOLS];
+} ted_draw_async_data_t;
+
+/* The character numbers used are `vbuf' masked with these.  */
+static const uint8_t async_char_mask[3] = { 0xff, 0x7f, 0x3f };
+
+static uint8_t async_chargen[0x800];
+static uint8_t async_bitmap[0x2000];
+
+static int ted_draw_async_capture(void *data, int blank)
+{
+    ted_draw_async_data_t *async = data;
+    uint8_t *char_ptr;
+    unsigned int i, j, m;
+
+    if (blank) {
+        async->first_mask = 3;
+        return 0;
+    }
+
+    /* All 256 characters are only used in reverse mode and by the
+       multicolor text foreground.  */
+    if (ted.reverse_mode || ted.raster.changes->have_on_this_line) {
+        async->first_mask = 0;
+    } else {
+        async->first_mask = 1;
+    }
+    char_ptr = ted.chargen_ptr + ted.raster.ycounter;
+    for (m = async->first_mask; m < 3; m++) {
+        for (i = 0; i < TED_SCREEN_TEXTCOLS; i++) {
+            async->chars[m][i] = char_ptr[(ted.vbuf[i] & async_char_mask[m]) * 8];
+        }
+    }
+    for (j = ((ted.memptr << 3) + ted.raster.ycounter) & 0x1fff, i = 0;
+         i < TED_SCREEN_TEXTCOLS; i++, j = (j + 8) & 0x1fff) {
+        async->bitmap[i] = ted.bitmap_ptr[j];
+    }
+
+    /* draw_hires_bitmap() sets the overscan color in the state it draws
+       from.  The copy is thrown away after the line, so a line that changes
+       the color is drawn from the live state instead.  */
+    if (!ted.raster.changes->have_on_this_line && !ted.raster.draw_idle_state
+        && ted.raster.video_mode == TED_HIRES_BITMAP_MODE
+        && ted.raster.idle_background_color != (ted.vbuf[TED_SCREEN_TEXTCOLS - 1] & 0x7f)) {
+        return -1;
+    }
+    return 0;
+}
+
+static void ted_draw_async_prepare(void *state, const void *data)
+{
+    ted_t *view = state;
+    const ted_draw_async_data_t *async = data;
+    unsigned int i, j, m;
+
+    if (async->first_mask == 3) {
+        return;
+    }
+
+    for (m = async->first_mask; m < 3; m++) {
+        for (i = 0; i < TED_SCREEN_TEXTCOLS; i++) {
+            async_chargen[(view->vbuf[i] & async_char_mask[m]) * 8 + view->raster.ycounter]
+                = async->chars[m][i];
+        }
+    }
+    for (j = ((view->memptr << 3) + view->raster.ycounter) & 0x1fff, i = 0;
+         i < TED_SCREEN_TEXTCOLS; i++, j = (j + 8) & 0x1fff) {
+        async_bitmap[j] = async->bitmap[i];
+    }
+    view->chargen_ptr = async_chargen;
+    view->bitmap_ptr = async_bitmap;
+}
+
+const raster_async_chip_t ted_draw_async_chip = {
+    &ted, sizeof(ted_t), (void **)&ted_draw_state, sizeof(ted_draw_async_data_t),
+    ted_draw_async_capture, ted_draw_async_prepare
+};
+
+#define ted (*ted_draw_state)
+
 /* The following tables are used to speed up the drawing.  We do not use
    multi-dimensional arrays as we can optimize better this way...  */
 
@@ -28,6 +28,10 @@
 #ifndef VICE_TED_DRAW_H
 #define VICE_TED_DRAW_H
 
+struct raster_async_chip_s;
+
+extern const struct raster_async_chip_s ted_draw_async_chip;
+
 void ted_draw_init(void);
 
 #endif
@@ -34,6 +34,7 @@
 #include "machine.h"
 #include "raster-resources.h"
 #include "resources.h"
+#include "ted-draw.h"
 #include "ted-resources.h"
 #include "ted.h"
 #include "tedtypes.h"
@@ -100,7 +101,8 @@ int ted_resources_init(void)
 
     ted.video_chip_cap = &video_chip_cap;
 
-    if (raster_resources_chip_init("TED", &ted.raster, &video_chip_cap) < 0) {
+    if (raster_resources_chip_init("TED", &ted.raster, &video_chip_cap) < 0
+        || raster_resources_chip_async_init("TED", &ted.raster, &ted_draw_async_chip) < 0) {
         return -1;
     }
 
@@ -31,93 +31,102 @@
 #include <stddef.h>
 #include <string.h>
 
+#include "alarm.h"
 #include "lib.h"
+#include "maincpu.h"
 #include "mem.h"
 #include "profiler.h"
 #include "profiler_data.h"
 
 
-#define MAX_CALLSTACK_SIZE 129
+/* the Z80 and 6809 take over the bus from the main CPU, so they run on the
+   main CPU clock and alarm context */
+profiler_cpu_t maincpu_profiler = {
+    .name = "Main CPU",
+    .clk_ptr = &maincpu_clk,
+    .alarm_context = &maincpu_alarm_context,
+    .get_bank_config = mem_get_current_bank_config,
+    .context_dirty = true
+};
+
+profiler_cpu_t z80_profiler = {
+    .name = "Z80",
+    .clk_ptr = &maincpu_clk,
+    .alarm_context = &maincpu_alarm_context,
+    .get_bank_config = mem_get_current_bank_config,
+    .context_dirty = true
+};
+
+profiler_cpu_t h6809_profiler = {
+    .name = "6809",
+    .clk_ptr = &maincpu_clk,
+    .alarm_context = &maincpu_alarm_context,
+    .get_bank_config = mem_get_current_bank_config,
+    .context_dirty = true
+};
+
+/* hooked up by the drive code */
+profiler_cpu_t drivecpu_profiler[PROFILER_NUM_DRIVES] = {
+    { .name = "Drive 8 CPU", .context_dirty = true },
+    { .name = "Drive 9 CPU", .context_dirty = true },
+    { .name = "Drive 10 CPU", .context_dirty = true },
+    { .name = "Drive 11 CPU", .context_dirty = true }
+};
+
+static int get_bank_config(profiler_cpu_t *profiler)
+{
+    return profiler->get_bank_config ? profiler->get_bank_config() : 0;
+}
 
-/* Store the PC address for JSR calls and the SP where PC is stored
- * this allows us to differentiate between fake RTS/RTI-calls used as indirect
- * JMPs
- *
- * for interrupts, we use "magic" PC_SRC values corresponding to the 6502
- * interrupt vectors */
-
-uint16_t callstack_pc_dst[MAX_CALLSTACK_SIZE];
-uint16_t callstack_pc_src[MAX_CALLSTACK_SIZE];
-uint8_t  callstack_sp[MAX_CALLSTACK_SIZE];
-uint16_t callstack_memory_bank_config[MAX_CALLSTACK_SIZE];
-unsigned callstack_size = 0;
-bool     context_dirty = true;
-bool     maincpu_profiling = false;
-
-/* (fragile) flags if the current command is a JSR/INT or RTS/RTI */
-bool     entered_context = false;
-bool     exited_context = false;
-
-profiling_context_t  *root_context = NULL;
-profiling_context_t  *current_context = NULL;
-uint16_t              current_pc;
-int                   num_context_ids = 0;
-int                   context_id_capacity = 0;
-profiling_context_t **id_to_context = NULL;
-
-profiling_context_t  *profile_context_by_id(int id) {
-    if (id > 0 && id <= num_context_ids) {
-        return id_to_context[id-1];
+profiling_context_t *profile_context_by_id(profiler_cpu_t *profiler, int id) {
+    if (id > 0 && id <= profiler->num_context_ids) {
+        return profiler->id_to_context[id-1];
     }
     return NULL;
 }
 
-int get_context_id(profiling_context_t *context) {
+int get_context_id(profiler_cpu_t *profiler, profiling_context_t *context) {
     if (context->id == 0) {
-        context->id = num_context_ids + 1;
-        num_context_ids++;
-
-        if (context->id > context_id_capacity) {
-            context_id_capacity *= 2;
-            if (context_id_capacity < 100) context_id_capacity = 100;
-            id_to_context = lib_realloc(id_to_context,
-                                        context_id_capacity
-                                            * sizeof(*id_to_context));
+        context->id = profiler->num_context_ids + 1;
+        profiler->num_context_ids++;
+
+        if (context->id > profiler->context_id_capacity) {
+            profiler->context_id_capacity *= 2;
+            if (profiler->context_id_capacity < 100) profiler->context_id_capacity = 100;
+            profiler->id_to_context = lib_realloc(profiler->id_to_context,
+                                                  profiler->context_id_capacity
+                                                      * sizeof(*profiler->id_to_context));
         }
-        id_to_context[context->id - 1] = context;
+        profiler->id_to_context[context->id - 1] = context;
     }
     return context->id;
 }
 
-#if 0 /* unused */
-static void callstack_reset(void) {
-    callstack_size = 0;
-    context_dirty = true;
-}
-#endif
-
 /* push pc to callstack (triggered by interrupt or JSR) */
-static void callstack_push(uint16_t pc_dst, uint16_t pc_src, uint8_t sp) {
-    if (callstack_size >= MAX_CALLSTACK_SIZE) {
+static void callstack_push(profiler_cpu_t *profiler, uint16_t pc_dst, uint16_t pc_src, uint16_t sp) {
+    unsigned int size = profiler->callstack_size;
+
+    if (size >= PROFILER_MAX_CALLSTACK_SIZE) {
         /* stack overflow; do nothing */
         return;
     }
-    callstack_pc_dst[callstack_size] = pc_dst;
-    callstack_pc_src[callstack_size] = pc_src;
-    callstack_sp[callstack_size] = sp;
-    callstack_memory_bank_config[callstack_size] = mem_get_current_bank_config(); /* TODO: move out to interface? */
-    callstack_size++;
-    context_dirty = true;
+    profiler->callstack_pc_dst[size] = pc_dst;
+    profiler->callstack_pc_src[size] = pc_src;
+    profiler->callstack_sp[size] = sp;
+    profiler->callstack_memory_bank_config[size] = get_bank_config(profiler);
+    profiler->callstack_size++;
+    profiler->context_dirty = true;
 }
 
 /* check if we should pop the callstack */
-static void callstack_pop_check(uint8_t sp) {
-    while (callstack_size != 0 && sp >= callstack_sp[callstack_size-1]
-           && callstack_sp[callstack_size-1] > 0x01) {
-        callstack_size--;
+static void callstack_pop_check(profiler_cpu_t *profiler, uint16_t sp) {
+    while (profiler->callstack_size != 0
+           && sp >= profiler->callstack_sp[profiler->callstack_size-1]
+           && profiler->callstack_sp[profiler->callstack_size-1] > 0x01) {
+        profiler->callstack_size--;
     }
 
-    context_dirty = true;
+    profiler->context_dirty = true;
 }
 
 static profiling_page_t *alloc_profiling_page(void) {
@@ -215,73 +224,113 @@ static profiling_context_t *get_child_context(profiling_context_t *parent,
 }
 
 /* store profiling samples */
-static void initialize_context(void) {
+static void initialize_context(profiler_cpu_t *profiler) {
     int callstack_head;
 
     /* find head of context (>0 if interrupt) */
-    for (callstack_head = callstack_size-1;
+    for (callstack_head = profiler->callstack_size-1;
          callstack_head > 0;
          callstack_head--) {
-        if (callstack_pc_src[callstack_head] >= 0xfffa) break;
+        if (profiler->callstack_pc_src[callstack_head] >= 0xfffa) break;
     }
 
-    current_context = root_context;
-    while (callstack_head < callstack_size) {
-        current_context = get_child_context(current_context,
-                                            callstack_pc_dst[callstack_head],
-                                            callstack_pc_src[callstack_head],
-                                            callstack_memory_bank_config[callstack_head]);
+    profiler->current_context = profiler->root_context;
+    while (callstack_head < (int)profiler->callstack_size) {
+        profiler->current_context = get_child_context(profiler->current_context,
+                                                      profiler->callstack_pc_dst[callstack_head],
+                                                      profiler->callstack_pc_src[callstack_head],
+                                                      profiler->callstack_memory_bank_config[callstack_head]);
         callstack_head++;
     }
 
-    current_context = get_mem_config_context(current_context, mem_get_current_bank_config());
+    profiler->current_context = get_mem_config_context(profiler->current_context,
+                                                       get_bank_config(profiler));
+}
+
+static void update_context(profiler_cpu_t *profiler)
+{
+    if (profiler->context_dirty
+        || get_bank_config(profiler) != profiler->current_context->memory_bank_config) {
+        initialize_context(profiler);
+        profiler->context_dirty = false;
+    }
+}
+
+/* record one sample for the current call stack at `pc', weighted with the
+   sample interval so the cycle based views stay meaningful */
+static void profile_sample_take(profiler_cpu_t *profiler, uint16_t pc)
+{
+    profiling_data_t *data;
+
+    /* enters and exits are not tracked between samples */
+    profiler->entered_context = false;
+    profiler->exited_context = false;
+
+    update_context(profiler);
+    profiler->current_pc = pc;
+
+    data = &profiling_get_page(profiler->current_context, pc >> 8)->data[pc & 0xff];
+    data->num_cycles += profiler->sample_interval;
+    data->num_samples++;
+
+    profiler->profiling = false;
 }
 
-void profile_sample_start(uint16_t pc)
+void profile_sample_start(profiler_cpu_t *profiler, uint16_t pc)
 {
-    if (exited_context) {
-        current_context->num_exits++;
-        exited_context = false;
+    if (profiler->sampling) {
+        profile_sample_take(profiler, pc);
+        return;
     }
 
-    if (context_dirty || mem_get_current_bank_config() != current_context->memory_bank_config) {
-        initialize_context();
-        context_dirty = false;
+    if (profiler->exited_context) {
+        profiler->current_context->num_exits++;
+        profiler->exited_context = false;
     }
-    current_pc = pc;
 
-    if (entered_context) {
-        current_context->num_enters++;
-        entered_context = false;
+    update_context(profiler);
+    profiler->current_pc = pc;
+
+    if (profiler->entered_context) {
+        profiler->current_context->num_enters++;
+        profiler->entered_context = false;
     }
 }
 
-void profile_sample_finish(uint16_t cycle_time, uint16_t stolen_cycles)
+void profile_sample_finish(profiler_cpu_t *profiler, uint16_t cycle_time, uint16_t stolen_cycles)
 {
-    profiling_data_t * data = &profiling_get_page(current_context,
-                                                 current_pc >> 8)
-                                  ->data[current_pc & 0xff];
+    profiling_data_t *data;
+
+    if (profiler->sampling) {
+        /* the sample alarm went off during this instruction, the sample
+           is taken at the start of the next one */
+        return;
+    }
+
+    data = &profiling_get_page(profiler->current_context, profiler->current_pc >> 8)
+                ->data[profiler->current_pc & 0xff];
     data->num_cycles += cycle_time;
     data->num_samples++;
-    current_context->total_stolen_cycles_self   += stolen_cycles;
+    profiler->current_context->total_stolen_cycles_self += stolen_cycles;
 }
 
-void profile_jsr(uint16_t pc_dst, uint16_t pc_src, uint8_t sp)
+void profile_jsr(profiler_cpu_t *profiler, uint16_t pc_dst, uint16_t pc_src, uint16_t sp)
 {
-    callstack_push(pc_dst, pc_src, sp);
-    entered_context = true;
+    callstack_push(profiler, pc_dst, pc_src, sp);
+    profiler->entered_context = true;
 }
 
-void profile_int(uint16_t pc_dst,
+void profile_int(profiler_cpu_t *profiler,
+                 uint16_t pc_dst,
                  uint16_t handler,
-                 uint8_t sp,
+                 uint16_t sp,
                  uint16_t cycle_time)
 {
-    callstack_push(pc_dst, handler, sp);
-    entered_context = true;
-    if (maincpu_profiling) {
-        profile_sample_start(handler);
-        profile_sample_finish(cycle_time, 0 /* stolen_cycles */);
+    callstack_push(profiler, pc_dst, handler, sp);
+    profiler->entered_context = true;
+    if (profiler->profiling) {
+        profile_sample_start(profiler, handler);
+        profile_sample_finish(profiler, cycle_time, 0 /* stolen_cycles */);
     }
 }
 
@@ -290,22 +339,48 @@ void profile_int(uint16_t pc_dst,
  * actually returning and clearing the return address on the stack.
  * For the purpose of call stack tracking, we simply ignore rts/rti if sp is
  * not at (or below) the stored earlier call stack value */
-void profile_rtx(uint8_t sp)
+void profile_rtx(profiler_cpu_t *profiler, uint16_t sp)
+{
+    callstack_pop_check(profiler, sp);
+    profiler->exited_context = true;
+}
+
+void profile_cpu_setup(profiler_cpu_t *profiler, CLOCK *clk_ptr,
+                       alarm_context_t **alarm_context)
+{
+    profiler->clk_ptr = clk_ptr;
+    profiler->alarm_context = alarm_context;
+}
+
+static void profile_sample_alarm_handler(CLOCK offset, void *data)
+{
+    profiler_cpu_t *profiler = data;
+
+    profiler->profiling = true;
+    alarm_set(profiler->sample_alarm,
+              *profiler->clk_ptr - offset + profiler->sample_interval);
+}
+
+static void profile_sample_alarm_stop(profiler_cpu_t *profiler)
 {
-    callstack_pop_check(sp);
-    exited_context = true;
+    if (profiler->sample_alarm != NULL) {
+        alarm_unset(profiler->sample_alarm);
+    }
+    profiler->sampling = false;
 }
 
-void profile_start(void)
+void profile_start(profiler_cpu_t *profiler)
 {
-    if (root_context) free_profiling_context(root_context);
-    root_context    = alloc_profiling_context();
-    num_context_ids = 0;
-    current_context = root_context;
-    maincpu_profiling = true;
-    entered_context = false;
-    exited_context  = false;
-    context_dirty   = true;
+    profile_sample_alarm_stop(profiler);
+    if (profiler->root_context) free_profiling_context(profiler->root_context);
+    profiler->root_context    = alloc_profiling_context();
+    profiler->num_context_ids = 0;
+    profiler->current_context = profiler->root_context;
+    profiler->profiling       = true;
+    profiler->entered_context = false;
+    profiler->exited_context  = false;
+    profiler->context_dirty   = true;
+    profiler->data_is_sampled = false;
 }
 
 void compute_aggregate_stats(profiling_context_t *context) {
@@ -355,24 +430,55 @@ void compute_aggregate_stats(profiling_context_t *context) {
     context->total_stolen_cycles = context->total_stolen_cycles_self + total_stolen_child_cycles;
 }
 
+void profile_start_sampling(profiler_cpu_t *profiler, CLOCK interval)
+{
+    profile_start(profiler);
+    /* the flag is raised by the alarm only */
+    profiler->profiling = false;
 
-void profile_stop(void)
+    if (profiler->alarm_context == NULL || *profiler->alarm_context == NULL) {
+        return;
+    }
+    if (profiler->sample_alarm == NULL) {
+        profiler->sample_alarm = alarm_new(*profiler->alarm_context, "Profiler",
+                                           profile_sample_alarm_handler, profiler);
+    }
+    profiler->sample_interval = interval;
+    profiler->sampling = true;
+    profiler->data_is_sampled = true;
+    alarm_set(profiler->sample_alarm, *profiler->clk_ptr + interval);
+}
+
+void profile_stop(profiler_cpu_t *profiler)
 {
-    maincpu_profiling = false;
+    profile_sample_alarm_stop(profiler);
+    profiler->profiling = false;
 }
 
-static void profile_reset(void) {
-    free_profiling_context(root_context);
-    root_context = NULL;
-    current_context = NULL;
-    lib_free(id_to_context);
-    id_to_context = NULL;
-    num_context_ids = 0;
-    context_id_capacity = 0;
+static void profile_reset(profiler_cpu_t *profiler) {
+    free_profiling_context(profiler->root_context);
+    profiler->root_context = NULL;
+    profiler->current_context = NULL;
+    lib_free(profiler->id_to_context);
+    profiler->id_to_context = NULL;
+    profiler->num_context_ids = 0;
+    profiler->context_id_capacity = 0;
+    profiler->profiling = false;
+    profiler->sampling = false;
+    profiler->data_is_sampled = false;
+    /* the alarm is freed along with the CPU alarm context */
+    profiler->sample_alarm = NULL;
 }
 
 
 void profile_shutdown(void)
 {
-    profile_reset();
+    int i;
+
+    profile_reset(&maincpu_profiler);
+    profile_reset(&z80_profiler);
+    profile_reset(&h6809_profiler);
+    for (i = 0; i < PROFILER_NUM_DRIVES; i++) {
+        profile_reset(&drivecpu_profiler[i]);
+    }
 }
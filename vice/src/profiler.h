@@ -29,31 +29,107 @@
 
 #include "types.h"
 
-extern bool maincpu_profiling;
+#define PROFILER_MAX_CALLSTACK_SIZE 129
+#define PROFILER_NUM_DRIVES         4
+
+struct alarm_s;
+struct alarm_context_s;
+struct profiling_context_s;
+
+/* Profiler state of one CPU. The main CPU, the C128 Z80, the SuperPET 6809
+ * and each drive CPU have their own, so they can be profiled side by side.
+ *
+ * The CPU core only looks at `profiling', the other members belong to the
+ * profiler and its monitor interface. */
+typedef struct profiler_cpu_s {
+    /* checked by the CPU core for each instruction */
+    bool profiling;
+
+    const char *name;
+
+    /* clock and alarm context of the CPU, needed for sampling */
+    CLOCK *clk_ptr;
+    struct alarm_context_s **alarm_context;
+
+    /* returns the current memory bank config, NULL if there is only one */
+    int (*get_bank_config)(void);
+
+    /* Store the PC address for JSR calls and the SP where PC is stored
+     * this allows us to differentiate between fake RTS/RTI-calls used as
+     * indirect JMPs
+     *
+     * for interrupts, we use "magic" PC_SRC values corresponding to the 6502
+     * interrupt vectors */
+    uint16_t callstack_pc_dst[PROFILER_MAX_CALLSTACK_SIZE];
+    uint16_t callstack_pc_src[PROFILER_MAX_CALLSTACK_SIZE];
+    uint16_t callstack_sp[PROFILER_MAX_CALLSTACK_SIZE];
+    uint16_t callstack_memory_bank_config[PROFILER_MAX_CALLSTACK_SIZE];
+    unsigned int callstack_size;
+    bool context_dirty;
+
+    /* (fragile) flags if the current command is a JSR/INT or RTS/RTI */
+    bool entered_context;
+    bool exited_context;
+
+    struct profiling_context_s  *root_context;
+    struct profiling_context_s  *current_context;
+    uint16_t                     current_pc;
+    int                          num_context_ids;
+    int                          context_id_capacity;
+    struct profiling_context_s **id_to_context;
+
+    /* statistical mode: an alarm raises `profiling' every `sample_interval'
+     * cycles, the next instruction start records one sample for the current
+     * call stack and clears the flag again */
+    bool            sampling;
+    CLOCK           sample_interval;
+    struct alarm_s *sample_alarm;
+
+    /* the collected data comes from statistical mode, kept after `sampling'
+     * is cleared by stopping the profiler so the data can still be exported */
+    bool            data_is_sampled;
+} profiler_cpu_t;
+
+extern profiler_cpu_t maincpu_profiler;
+extern profiler_cpu_t z80_profiler;
+extern profiler_cpu_t h6809_profiler;
+extern profiler_cpu_t drivecpu_profiler[PROFILER_NUM_DRIVES];
+
+/* hooks up the clock and alarm context of a CPU, drives do this on init */
+void profile_cpu_setup(profiler_cpu_t *profiler, CLOCK *clk_ptr,
+                       struct alarm_context_s **alarm_context);
 
 /* resets sample statistics and starts profiling sample collection */
-void profile_start(void);
+void profile_start(profiler_cpu_t *profiler);
+
+/* resets sample statistics and starts statistical profiling, taking one
+ * call stack sample every `interval' cycles */
+void profile_start_sampling(profiler_cpu_t *profiler, CLOCK interval);
 
-/* stops profiling and writes profiling log to disk */
-void profile_stop(void);
+/* stops profiling */
+void profile_stop(profiler_cpu_t *profiler);
 
 /* called by the CPU for each instruction */
-void profile_sample_start(uint16_t pc);
-void profile_sample_finish(uint16_t cycle_time, uint16_t stolen_cycles);
+void profile_sample_start(profiler_cpu_t *profiler, uint16_t pc);
+void profile_sample_finish(profiler_cpu_t *profiler, uint16_t cycle_time, uint16_t stolen_cycles);
 
-/* called whenever a JSR is encountered */
-void profile_jsr(uint16_t pc_dst, uint16_t pc_src, uint8_t sp);
+/* called whenever a JSR is encountered. `pc_src' is the address of the
+ * call instruction plus two, `sp' the stack pointer after pushing the
+ * return address */
+void profile_jsr(profiler_cpu_t *profiler, uint16_t pc_dst, uint16_t pc_src, uint16_t sp);
 
 /* interrupts are handled like JSRs with PC as one of the
  * interrupt handler addresses (0xfffa-0xffff)
  * for interrupts sp = sp+1 to accommodate the pushed status register */
-void profile_int(uint16_t pc_dst,
+void profile_int(profiler_cpu_t *profiler,
+                 uint16_t pc_dst,
                  uint16_t handler,
-                 uint8_t sp,
+                 uint16_t sp,
                  uint16_t cycle_time);
 
-/* called whenever an RTS/RI is called */
-void profile_rtx(uint8_t sp);
+/* called whenever an RTS/RTI is called, with the stack pointer before
+ * pulling the return address */
+void profile_rtx(profiler_cpu_t *profiler, uint16_t sp);
 
 void profile_shutdown(void);
 
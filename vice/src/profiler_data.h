@@ -28,6 +28,7 @@
 #define VICE_PROFILER_DATA_H
 
 #include "types.h"
+#include "profiler.h"
 
 enum CallstackMagic {
     NMI   = 0xfffa,
@@ -69,11 +70,8 @@ typedef struct profiling_context_s {
     int id;
 } profiling_context_t;
 
-extern profiling_context_t  *root_context;
-extern profiling_context_t  *current_context;
-
-profiling_context_t *profile_context_by_id(int id);
-int                  get_context_id(profiling_context_t *context);
+profiling_context_t *profile_context_by_id(profiler_cpu_t *profiler, int id);
+int                  get_context_id(profiler_cpu_t *profiler, profiling_context_t *context);
 void                 compute_aggregate_stats(profiling_context_t *context);
 profiling_page_t    *profiling_get_page(profiling_context_t *ctx, uint8_t page);
 profiling_context_t *alloc_profiling_context(void);
@@ -0,0 +1,401 @@
+/*
+ * raster-async.c - Drawing raster lines on a separate thread.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/* When a raster is drawn asynchronously, raster_line_emulate() does not draw
+   the line itself.  It copies the chip state (which contains the raster_t),
+   the geometry and the changes of the line into a ring of line slots, lets
+   the chip capture the video memory its drawing code reads, updates the
+   live state as drawing the line would have done and moves on.  The render
+   thread draws the queued lines from their slots; the chip drawing code
+   reads the chip state through a pointer (raster_async_chip_t.draw_state)
+   that is set to the slot being drawn.
+
+   Lines the slots cannot describe (changes that do not point into the chip
+   state, too many changes, or whatever the chip refuses to capture) are
+   drawn by the emulation thread after the queue has been drained, so the
+   output is always the same as with inline drawing.
+
+   While lines are queued the render thread owns the frame buffer, the
+   update area and the line cache.  Everything else that touches them calls
+   raster_async_sync() first, which waits until the queue is empty.  The
+   vice thread does the same before it yields the mainlock to the UI.  */
+
+#include "vice.h"
+
+#include <string.h>
+
+#include "lib.h"
+#include "log.h"
+#include "mainlock.h"
+#include "raster-async.h"
+#include "raster-changes.h"
+#include "raster-line.h"
+#include "raster.h"
+#include "types.h"
+#include "viewport.h"
+
+#ifdef USE_VICE_THREAD
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+#define RASTER_ASYNC_LINES      64      /* must be a power of 2 */
+#define RASTER_ASYNC_BATCH      8       /* lines to queue before waking the thread */
+#define RASTER_ASYNC_CHANGES    64      /* lines with more changes are drawn inline */
+
+#define SLOT_ALIGN(size)        (((size) + 15) & ~(size_t)15)
+
+/* Start of a line slot, the copy of the chip state and the data captured by
+   the chip follow.  */
+typedef struct raster_async_line_s {
+    geometry_t geometry;
+    int have_changes;
+    unsigned int num_changes[4];    /* background, foreground, border, sprites */
+    raster_changes_action_t changes[RASTER_ASYNC_CHANGES];
+} raster_async_line_t;
+
+struct raster_async_s {
+    raster_t *raster;
+    const raster_async_chip_t *chip;
+    size_t raster_offset;           /* of the raster_t in the chip state */
+    size_t state_offset;            /* of the chip state in a slot */
+    size_t data_offset;             /* of the chip data in a slot */
+    size_t slot_size;
+    uint8_t *slots;
+
+    size_t line_pos;                /* emulation side copy of line_head */
+    atomic_size_t line_head;        /* end of the queued lines */
+    atomic_size_t line_tail;        /* end of the drawn lines */
+
+    /* The changes of the line being drawn by the render thread.  */
+    raster_changes_t change_lists[4];
+    raster_changes_all_t changes;
+
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t work_cond;
+    pthread_cond_t idle_cond;
+    atomic_int waiting;
+    int stop;
+
+    struct raster_async_s *next;
+};
+typedef struct raster_async_s raster_async_t;
+
+/* The rasters drawn asynchronously.  */
+static raster_async_t *async_list = NULL;
+
+/* ------------------------------------------------------------------------- */
+
+static uint8_t *line_slot(raster_async_t *async, size_t pos)
+{
+    return async->slots + (pos & (RASTER_ASYNC_LINES - 1)) * async->slot_size;
+}
+
+static void draw_slot(raster_async_t *async, uint8_t *slot)
+{
+    raster_async_line_t *line = (raster_async_line_t *)slot;
+    const raster_async_chip_t *chip = async->chip;
+    uint8_t *state = slot + async->state_offset;
+    raster_t *raster = (raster_t *)(state + async->raster_offset);
+    const raster_changes_action_t *action = line->changes;
+    unsigned int i;
+
+    for (i = 0; i < 4; i++) {
+        raster_changes_t *list = &async->change_lists[i];
+
+        list->count = line->num_changes[i];
+        memcpy(list->actions, action, sizeof(raster_changes_action_t) * list->count);
+        action += list->count;
+    }
+    async->changes.have_on_this_line = line->have_changes;
+
+    raster->changes = &async->changes;
+    raster->geometry = &line->geometry;
+    *chip->draw_state = state;
+    if (chip->prepare != NULL) {
+        chip->prepare(state, slot + async->data_offset);
+    }
+    raster_line_draw(raster);
+}
+
+static void *render_thread_main(void *param)
+{
+    raster_async_t *async = param;
+    size_t tail = atomic_load(&async->line_tail);
+
+    while (1) {
+        if (tail != atomic_load_explicit(&async->line_head, memory_order_acquire)) {
+            draw_slot(async, line_slot(async, tail));
+            tail++;
+            atomic_store_explicit(&async->line_tail, tail, memory_order_release);
+            continue;
+        }
+
+        pthread_mutex_lock(&async->lock);
+        pthread_cond_broadcast(&async->idle_cond);
+        atomic_store(&async->waiting, 1);
+        while (tail == atomic_load(&async->line_head) && !async->stop) {
+            pthread_cond_wait(&async->work_cond, &async->lock);
+        }
+        atomic_store(&async->waiting, 0);
+        if (tail == atomic_load(&async->line_head) && async->stop) {
+            pthread_mutex_unlock(&async->lock);
+            break;
+        }
+        pthread_mutex_unlock(&async->lock);
+    }
+    return NULL;
+}
+
+static void wake_render_thread(raster_async_t *async)
+{
+    pthread_mutex_lock(&async->lock);
+    pthread_cond_signal(&async->work_cond);
+    pthread_mutex_unlock(&async->lock);
+}
+
+/* Copy the changes of the current line into `line', pointing them at the
+   copy of the chip state at `state'.  */
+static int copy_changes(raster_async_t *async, raster_async_line_t *line, uint8_t *state)
+{
+    raster_changes_all_t *changes = async->raster->changes;
+    raster_changes_t *lists[4];
+    raster_changes_action_t *action = line->changes;
+    uintptr_t chip_state = (uintptr_t)async->chip->state;
+    unsigned int i, j, num = 0;
+
+    lists[0] = changes->background;
+    lists[1] = changes->foreground;
+    lists[2] = changes->border;
+    lists[3] = changes->sprites;
+
+    for (i = 0; i < 4; i++) {
+        if (num + lists[i]->count > RASTER_ASYNC_CHANGES) {
+            return -1;
+        }
+        for (j = 0; j < lists[i]->count; j++, action++) {
+            *action = lists[i]->actions[j];
+
+            if (action->type != RASTER_CHANGES_TYPE_INT
+                || (uintptr_t)action->value.integer.oldp < chip_state
+                || (uintptr_t)action->value.integer.oldp - chip_state
+                   > async->chip->state_size - sizeof(int)) {
+                return -1;
+            }
+            action->value.integer.oldp = (int *)(state + ((uintptr_t)action->value.integer.oldp - chip_state));
+        }
+        line->num_changes[i] = lists[i]->count;
+        num += lists[i]->count;
+    }
+    return 0;
+}
+
+static void draw_inline(raster_async_t *async)
+{
+    raster_async_sync(async->raster);
+    *async->chip->draw_state = async->chip->state;
+    raster_line_draw(async->raster);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Queue the current line for the render thread, see raster_line_emulate().  */
+void raster_async_line(raster_t *raster)
+{
+    raster_async_t *async = raster->async;
+    const raster_async_chip_t *chip = async->chip;
+    raster_async_line_t *line;
+    uint8_t *slot;
+
+    if (raster->sprite_status != NULL || raster->cache_enabled) {
+        draw_inline(async);
+        return;
+    }
+
+    if (async->line_pos - atomic_load_explicit(&async->line_tail, memory_order_acquire) == RASTER_ASYNC_LINES) {
+        raster_async_sync(raster);
+    }
+    slot = line_slot(async, async->line_pos);
+    line = (raster_async_line_t *)slot;
+
+    line->have_changes = raster->changes->have_on_this_line;
+    if (line->have_changes) {
+        if (copy_changes(async, line, slot + async->state_offset) < 0) {
+            draw_inline(async);
+            return;
+        }
+    } else {
+        memset(line->num_changes, 0, sizeof(line->num_changes));
+    }
+    memcpy(slot + async->state_offset, chip->state, chip->state_size);
+    line->geometry = *raster->geometry;
+
+    if (chip->capture != NULL
+        && chip->capture(slot + async->data_offset, raster_line_is_blank(raster)) < 0) {
+        draw_inline(async);
+        return;
+    }
+
+    async->line_pos++;
+    atomic_store_explicit(&async->line_head, async->line_pos, memory_order_release);
+
+    if (atomic_load(&async->waiting)
+        && async->line_pos - atomic_load_explicit(&async->line_tail, memory_order_acquire) >= RASTER_ASYNC_BATCH) {
+        wake_render_thread(async);
+    }
+
+    raster_line_update_state(raster);
+}
+
+/* Wait until the render thread has drawn all queued lines.  */
+void raster_async_sync(raster_t *raster)
+{
+    raster_async_t *async = raster->async;
+
+    if (async == NULL
+        || atomic_load_explicit(&async->line_tail, memory_order_acquire) == async->line_pos) {
+        return;
+    }
+
+    pthread_mutex_lock(&async->lock);
+    pthread_cond_signal(&async->work_cond);
+    while (atomic_load(&async->line_tail) != async->line_pos) {
+        pthread_cond_wait(&async->idle_cond, &async->lock);
+    }
+    pthread_mutex_unlock(&async->lock);
+}
+
+static void raster_async_sync_all(void)
+{
+    raster_async_t *async;
+
+    for (async = async_list; async != NULL; async = async->next) {
+        raster_async_sync(async->raster);
+    }
+}
+
+int raster_async_enable(raster_t *raster, const raster_async_chip_t *chip, int enable)
+{
+    raster_async_t *async = raster->async;
+    raster_async_t **prev;
+
+    if (enable == (async != NULL)) {
+        return 0;
+    }
+
+    if (enable) {
+        if (async_list == NULL && mainlock_add_yield_hook(raster_async_sync_all) < 0) {
+            return -1;
+        }
+
+        async = lib_calloc(1, sizeof(raster_async_t));
+        async->raster = raster;
+        async->chip = chip;
+        async->raster_offset = (size_t)((uint8_t *)raster - (uint8_t *)chip->state);
+        async->state_offset = SLOT_ALIGN(sizeof(raster_async_line_t));
+        async->data_offset = async->state_offset + SLOT_ALIGN(chip->state_size);
+        async->slot_size = async->data_offset + SLOT_ALIGN(chip->data_size);
+        async->slots = lib_malloc(async->slot_size * RASTER_ASYNC_LINES);
+
+        async->changes.background = &async->change_lists[0];
+        async->changes.foreground = &async->change_lists[1];
+        async->changes.border = &async->change_lists[2];
+        async->changes.sprites = &async->change_lists[3];
+        async->changes.next_line = NULL;    /* not used for drawing */
+
+        atomic_init(&async->line_head, 0);
+        atomic_init(&async->line_tail, 0);
+        atomic_init(&async->waiting, 0);
+        pthread_mutex_init(&async->lock, NULL);
+        pthread_cond_init(&async->work_cond, NULL);
+        pthread_cond_init(&async->idle_cond, NULL);
+
+        if (pthread_create(&async->thread, NULL, render_thread_main, async) != 0) {
+            log_error(LOG_DEFAULT, "Raster: cannot create the render thread.");
+            if (async_list == NULL) {
+                mainlock_remove_yield_hook(raster_async_sync_all);
+            }
+            pthread_mutex_destroy(&async->lock);
+            pthread_cond_destroy(&async->work_cond);
+            pthread_cond_destroy(&async->idle_cond);
+            lib_free(async->slots);
+            lib_free(async);
+            return -1;
+        }
+
+        async->next = async_list;
+        async_list = async;
+        raster->async = async;
+    } else {
+        raster_async_sync(raster);
+
+        pthread_mutex_lock(&async->lock);
+        async->stop = 1;
+        pthread_cond_signal(&async->work_cond);
+        pthread_mutex_unlock(&async->lock);
+        pthread_join(async->thread, NULL);
+
+        for (prev = &async_list; *prev != async; prev = &(*prev)->next) {
+        }
+        *prev = async->next;
+        if (async_list == NULL) {
+            mainlock_remove_yield_hook(raster_async_sync_all);
+        }
+
+        *async->chip->draw_state = async->chip->state;
+        raster->async = NULL;
+
+        pthread_mutex_destroy(&async->lock);
+        pthread_cond_destroy(&async->work_cond);
+        pthread_cond_destroy(&async->idle_cond);
+        lib_free(async->slots);
+        lib_free(async);
+    }
+    return 0;
+}
+
+#else
+
+/* Without a separate emulation thread the UI may change the raster state at
+   any time, so the lines are always drawn inline.  */
+
+int raster_async_enable(raster_t *raster, const raster_async_chip_t *chip, int enable)
+{
+    if (enable) {
+        log_error(LOG_DEFAULT, "Raster: drawing on a separate thread is not available.");
+        return -1;
+    }
+    return 0;
+}
+
+void raster_async_line(raster_t *raster)
+{
+    raster_line_draw(raster);
+}
+
+void raster_async_sync(raster_t *raster)
+{
+}
+
+#endif
@@ -0,0 +1,61 @@
+/*
+ * raster-async.h - Drawing raster lines on a separate thread.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#ifndef VICE_RASTER_ASYNC_H
+#define VICE_RASTER_ASYNC_H
+
+#include <stddef.h>
+
+struct raster_s;
+
+/* A video chip whose drawing code can work on a copy of the chip state.  */
+struct raster_async_chip_s {
+    /* The chip state, which contains the raster_t.  */
+    void *state;
+    size_t state_size;
+
+    /* Pointer the drawing code reads the chip state through.  */
+    void **draw_state;
+
+    /* Size of the data captured with each line.  */
+    size_t data_size;
+
+    /* If not NULL, called for each line before it is queued, with the chip
+       state as the drawing code will see it.  Store whatever the drawing
+       code reads outside of the chip state (e.g. video memory) in `data' and
+       return 0, or return -1 to have the line drawn right away.  `blank' is
+       set if the line is drawn as a blank (border only) line.  */
+    int (*capture)(void *data, int blank);
+
+    /* If not NULL, called on the render thread before the line is drawn
+       from `state', the copy of the chip state, with the data captured for
+       it.  */
+    void (*prepare)(void *state, const void *data);
+};
+typedef struct raster_async_chip_s raster_async_chip_t;
+
+int raster_async_enable(struct raster_s *raster, const raster_async_chip_t *chip, int enable);
+void raster_async_line(struct raster_s *raster);
+void raster_async_sync(struct raster_s *raster);
+
+#endif
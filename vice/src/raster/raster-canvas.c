@@ -33,6 +33,7 @@
 
 #include "lib.h"
 #include "machine.h"
+#include "raster-async.h"
 #include "raster-canvas.h"
 #include "raster.h"
 #include "video.h"
@@ -119,6 +120,8 @@ void raster_canvas_handle_end_of_frame(raster_t *raster)
         return;
     }
 
+    raster_async_sync(raster);
+
     if (raster->dont_cache) {
         video_canvas_refresh_all(raster->canvas);
     } else {
@@ -53,6 +53,17 @@ static cmdline_option_t cmdline_options_chip[] =
     CMDLINE_LIST_END
 };
 
+static cmdline_option_t cmdline_options_chip_async[] =
+{
+    { NULL, SET_RESOURCE, CMDLINE_ATTRIB_NONE,
+      NULL, NULL, NULL, (void *)1,
+      NULL, "Draw the screen on a separate thread" },
+    { NULL, SET_RESOURCE, CMDLINE_ATTRIB_NONE,
+      NULL, NULL, NULL, (void *)0,
+      NULL, "Draw the screen on the emulation thread" },
+    CMDLINE_LIST_END
+};
+
 int raster_cmdline_options_chip_init(const char *chipname,
                                      struct video_chip_cap_s *video_chip_cap)
 {
@@ -78,3 +89,31 @@ int raster_cmdline_options_chip_init(const char *chipname,
 
     return video_cmdline_options_chip_init(chipname, video_chip_cap);
 }
+
+/* Register the options for the <chipname>AsyncDraw resource, see
+   raster_resources_chip_async_init().  */
+int raster_cmdline_options_chip_async_init(const char *chipname)
+{
+    unsigned int i;
+    int result;
+
+    if (machine_class == VICE_MACHINE_VSID) {
+        return 0;
+    }
+
+    for (i = 0; i < 2; i++) {
+        cmdline_options_chip_async[i].name = util_concat(i == 0 ? "-" : "+",
+                                                         chipname, "asyncdraw", NULL);
+        cmdline_options_chip_async[i].resource_name = util_concat(chipname,
+                                                                  "AsyncDraw", NULL);
+    }
+
+    result = cmdline_register_options(cmdline_options_chip_async);
+
+    for (i = 0; i < 2; i++) {
+        lib_free(cmdline_options_chip_async[i].name);
+        lib_free(cmdline_options_chip_async[i].resource_name);
+    }
+
+    return result;
+}
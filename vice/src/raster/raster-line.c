@@ -33,6 +33,7 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "raster-async.h"
 #include "raster-cache.h"
 #include "raster-canvas.h"
 #include "raster-changes.h"
@@ -648,6 +649,68 @@ inline static void handle_visible_line(raster_t *raster)
     }
 }
 
+/* Return nonzero if the current line is drawn as a blank (border only)
+   line.  */
+int raster_line_is_blank(raster_t *raster)
+{
+    /* handle lines with no border or with changes that may affect
+       the border as visible lines */
+    if (raster->can_disable_border && (raster->border_disable || raster->changes->have_on_this_line)) {
+        return 0;
+    }
+    return (raster->blank_this_line || raster->blank_enabled) && !raster->open_left_border;
+}
+
+/* Draw the current line, which must be in the displayed area.  */
+void raster_line_draw(raster_t *raster)
+{
+    if (raster_line_is_blank(raster)) {
+        handle_blank_line(raster);
+    } else {
+        handle_visible_line(raster);
+    }
+}
+
+/* Update the raster state the same way raster_line_draw() does, without
+   drawing anything.  This is used when the line is drawn from a copy of the
+   state (see raster-async.c), which is only done for rasters without
+   sprites and without the video cache.  */
+void raster_line_update_state(raster_t *raster)
+{
+    raster_changes_all_t *changes = raster->changes;
+
+    if (raster_line_is_blank(raster)) {
+        if (changes->have_on_this_line) {
+            raster_changes_apply_all(changes->background);
+            raster_changes_apply_all(changes->foreground);
+            raster_changes_apply_all(changes->sprites);
+            raster_changes_apply_all(changes->border);
+            changes->have_on_this_line = 0;
+        }
+        return;
+    }
+
+    if (changes->have_on_this_line) {
+        int old_draw_idle_state, old_video_mode;
+
+        /* See handle_visible_line_with_changes().  */
+        old_draw_idle_state = raster->draw_idle_state;
+        old_video_mode = raster->video_mode;
+        raster_changes_apply_all(changes->background);
+        raster->draw_idle_state = old_draw_idle_state;
+        raster->video_mode = old_video_mode;
+        raster_changes_apply_all(changes->foreground);
+        raster->xsmooth_shift_left = 0;
+        raster_changes_apply_all(changes->sprites);
+        raster_changes_apply_all(changes->border);
+        changes->have_on_this_line = 0;
+    }
+
+    if (raster->draw_idle_state) {
+        raster->xsmooth_color = raster->idle_background_color;
+    }
+}
+
 void raster_line_emulate(raster_t *raster)
 {
     raster_draw_buffer_ptr_update(raster);
@@ -666,17 +729,10 @@ void raster_line_emulate(raster_t *raster)
         || (raster->current_line <= raster->geometry->last_displayed_line - raster->geometry->screen_size.height
             && raster->geometry->screen_size.height <= raster->geometry->last_displayed_line)
         ) {
-        /* handle lines with no border or with changes that may affect
-           the border as visible lines */
-        if (raster->can_disable_border && (raster->border_disable || raster->changes->have_on_this_line)) {
-            handle_visible_line(raster);
+        if (raster->async != NULL) {
+            raster_async_line(raster);
         } else {
-            if ((raster->blank_this_line || raster->blank_enabled)
-                && !raster->open_left_border) {
-                handle_blank_line(raster);
-            } else {
-                handle_visible_line(raster);
-            }
+            raster_line_draw(raster);
         }
 
         if (++raster->num_cached_lines == (1
@@ -33,6 +33,9 @@ unsigned int raster_line_get_real_mode(struct raster_s *raster);
 void raster_line_draw_borders(struct raster_s *raster);
 void raster_line_fill_xsmooth_region(struct raster_s *raster);
 void raster_line_draw_blank(struct raster_s *raster, unsigned int start, unsigned int end);
+int raster_line_is_blank(struct raster_s *raster);
+void raster_line_draw(struct raster_s *raster);
+void raster_line_update_state(struct raster_s *raster);
 void raster_line_emulate(struct raster_s *raster);
 
 #endif
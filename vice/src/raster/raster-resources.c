@@ -31,6 +31,7 @@
 #include "lib.h"
 #include "machine.h"
 #include "raster.h"
+#include "raster-async.h"
 #include "raster-resources.h"
 #include "resources.h"
 #include "types.h"
@@ -42,6 +43,8 @@
 struct raster_resource_chip_s {
     raster_t *raster;
     int video_cache_enabled;
+    const raster_async_chip_t *async_chip;
+    int async_draw;
 };
 typedef struct raster_resource_chip_s raster_resource_chip_t;
 
@@ -91,6 +94,29 @@ static resource_int_t resources_chip[] =
     RESOURCE_INT_LIST_END
 };
 
+static int set_async_draw(int val, void *param)
+{
+    raster_resource_chip_t *raster_resource_chip;
+
+    raster_resource_chip = (raster_resource_chip_t *)param;
+    val = val ? 1 : 0;
+
+    if (raster_async_enable(raster_resource_chip->raster,
+                            raster_resource_chip->async_chip, val) < 0) {
+        return -1;
+    }
+    raster_resource_chip->async_draw = val;
+
+    return 0;
+}
+
+static resource_int_t resources_chip_async[] =
+{
+    { NULL, 0, RES_EVENT_NO, NULL,
+      NULL, set_async_draw, NULL },
+    RESOURCE_INT_LIST_END
+};
+
 int raster_resources_chip_init(const char *chipname, raster_t *raster,
                                struct video_chip_cap_s *video_chip_cap)
 {
@@ -128,6 +154,32 @@ int raster_resources_chip_init(const char *chipname, raster_t *raster,
     return video_resources_chip_init(chipname, &raster->canvas, video_chip_cap);
 }
 
+/* Register the <chipname>AsyncDraw resource for a chip that can be drawn on
+   a separate thread.  Must be called after raster_resources_chip_init().  */
+int raster_resources_chip_async_init(const char *chipname, raster_t *raster,
+                                     const raster_async_chip_t *async_chip)
+{
+    raster_resource_chip_t *raster_resource_chip;
+    int result;
+
+    if (machine_class == VICE_MACHINE_VSID) {
+        return 0;
+    }
+
+    raster_resource_chip = raster->raster_resource_chip;
+    raster_resource_chip->async_chip = async_chip;
+
+    resources_chip_async[0].name = util_concat(chipname, "AsyncDraw", NULL);
+    resources_chip_async[0].value_ptr = &(raster_resource_chip->async_draw);
+    resources_chip_async[0].param = (void *)raster_resource_chip;
+
+    result = resources_register_int(resources_chip_async);
+
+    lib_free(resources_chip_async[0].name);
+
+    return result;
+}
+
 void raster_resources_chip_shutdown(raster_t *raster)
 {
     video_resources_chip_shutdown(raster->canvas);
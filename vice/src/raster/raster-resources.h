@@ -27,10 +27,12 @@
 #ifndef VICE_RASTER_RESOURCES_H
 #define VICE_RASTER_RESOURCES_H
 
+struct raster_async_chip_s;
 struct raster_s;
 struct video_chip_cap_s;
 
 int raster_resources_chip_init(const char *chipname, struct raster_s *raster, struct video_chip_cap_s *video_chip_cap);
+int raster_resources_chip_async_init(const char *chipname, struct raster_s *raster, const struct raster_async_chip_s *async_chip);
 void raster_resources_chip_shutdown(struct raster_s *raster);
 void raster_resources_shutdown(void);
 
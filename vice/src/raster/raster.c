@@ -40,6 +40,7 @@
 #include "lib.h"
 #include "log.h"
 #include "machine.h"
+#include "raster-async.h"
 #include "raster-cache.h"
 #include "raster-canvas.h"
 #include "raster-changes.h"
@@ -140,6 +141,7 @@ static int raster_realize_frame_buffer(raster_t *raster)
 {
     unsigned int fb_width, fb_height, fb_pitch;
 
+    raster_async_sync(raster);
     raster_draw_buffer_free(raster->canvas);
 
     fb_width = raster_calc_frame_buffer_width(raster);
@@ -210,6 +212,8 @@ static int realize_canvas(raster_t *raster)
 
 static int perform_mode_change(raster_t *raster)
 {
+    raster_async_sync(raster);
+
     if (!video_disabled_mode
         && raster->canvas && raster->canvas->palette != NULL) {
         if (video_canvas_set_palette(raster->canvas, raster->canvas->palette) < 0) {
@@ -395,6 +399,8 @@ void raster_set_geometry(raster_t *raster,
 {
     geometry_t *geometry;
 
+    raster_async_sync(raster);
+
     geometry = raster->geometry;
     if (screen_height != geometry->screen_size.height
         || raster->cache == NULL) {
@@ -521,6 +527,8 @@ void raster_set_canvas_refresh(raster_t *raster, int enable)
 
 void raster_screenshot(raster_t *raster, screenshot_t *screenshot)
 {
+    raster_async_sync(raster);
+
     screenshot->palette = raster->canvas->palette;
     screenshot->max_width = raster->geometry->screen_size.width;
     screenshot->max_height = raster->geometry->screen_size.height;
@@ -550,6 +558,8 @@ void raster_screenshot(raster_t *raster, screenshot_t *screenshot)
 
 void raster_async_refresh(raster_t *raster, struct canvas_refresh_s *ref)
 {
+    raster_async_sync(raster);
+
     ref->draw_buffer = raster->canvas->draw_buffer->draw_buffer;
     ref->draw_buffer_line_size
         = raster->canvas->draw_buffer->draw_buffer_width;
@@ -563,6 +573,8 @@ void raster_async_refresh(raster_t *raster, struct canvas_refresh_s *ref)
 
 void raster_shutdown(raster_t *raster)
 {
+    raster_async_enable(raster, NULL, 0);
+
     if (raster->canvas) {
         raster_draw_buffer_free(raster->canvas);
     }
@@ -54,6 +54,7 @@ struct canvas_refresh_s;
 
 struct video_canvas_s;
 
+struct raster_async_s;
 struct raster_cache_s;
 struct raster_canvas_area_s;
 struct raster_changes_all_s;
@@ -179,6 +180,10 @@ struct raster_s {
     int (*fill_sprite_cache)(struct raster_s *, struct raster_cache_s *,
                              unsigned int *, unsigned int *);
 
+    /* If not NULL, the lines are drawn on a separate thread (see
+       raster-async.c).  */
+    struct raster_async_s *async;
+
     int intialized;
 };
 typedef struct raster_s raster_t;
@@ -28,8 +28,12 @@
 #include <cmath>
 #include <cassert>
 
+#include <cstdio>
+#include <cstring>
+#include <ctime>
 #include <iostream>
 #include <fstream>
+#include <sys/stat.h>
 using namespace std;
 
 #ifndef round
@@ -64,6 +68,7 @@ SID::SID()
   // Initialize pointers.
   sample = 0;
   fir = 0;
+  fir_table = 0;
   fir_N = 0;
   fir_RES = 0;
   fir_beta = 0;
@@ -95,7 +100,7 @@ SID::SID()
 SID::~SID()
 {
   delete[] sample;
-  delete[] fir;
+  fir_release(fir_table);
 }
 
 
@@ -627,9 +632,10 @@ bool SID::set_sampling_parameters(double clock_freq, sampling_method method,
   if (method != SAMPLE_RESAMPLE && method != SAMPLE_RESAMPLE_FASTMEM)
   {
     delete[] sample;
-    delete[] fir;
+    fir_release(fir_table);
     sample = 0;
     fir = 0;
+    fir_table = 0;
     return true;
   }
 
@@ -649,14 +655,10 @@ bool SID::set_sampling_parameters(double clock_freq, sampling_method method,
   const double A = -20*log10(1.0/(1 << 16));
   // A fraction of the bandwidth is allocated to the transition band,
   double dw = (1 - 2*pass_freq/sample_freq)*pi*2;
-  // The cutoff frequency is midway through the transition band (nyquist)
-  double wc = pi;
-
   // For calculation of beta and N see the reference for the kaiserord
   // function in the MATLAB Signal Processing Toolbox:
   // http://www.mathworks.com/access/helpdesk/help/toolbox/signal/kaiserord.html
   const double beta = 0.1102*(A - 8.7);
-  const double I0beta = I0(beta);
 
   // The filter order will maximally be 124 with the current constraints.
   // N >= (96.33 - 7.95)/(2.285*0.1*pi) -> N >= 123
@@ -695,9 +697,133 @@ bool SID::set_sampling_parameters(double clock_freq, sampling_method method,
   fir_f_cycles_per_sample = f_cycles_per_sample;
   fir_filter_scale = filter_scale;
 
-  // Allocate memory for FIR tables.
-  delete[] fir;
-  fir = new short[fir_N*fir_RES];
+  // Share the FIR tables with other SID instances, or load them from the
+  // cache directory, before calculating them.
+  FIRTable* table = fir_get(fir_N, fir_RES, beta, f_cycles_per_sample,
+                            f_samples_per_cycle, filter_scale);
+  fir_release(fir_table);
+  fir_table = table;
+  fir = table->fir;
+
+  return true;
+}
+
+
+// ----------------------------------------------------------------------------
+// Shared FIR tables.
+//
+// The FIR tables only depend on the sampling parameters, so all SID
+// instances using the same parameters share one copy. Tables which are no
+// longer used are kept until a table with other parameters is needed, or
+// until fir_cache_shutdown().
+// If a cache directory is set the tables are also stored there, calculating
+// the large SAMPLE_RESAMPLE_FASTMEM tables takes a noticeable time. The
+// directory holds at most fir_cache_slots tables, a new table replaces the
+// oldest one.
+// SID instances are expected to be configured from a single thread.
+// ----------------------------------------------------------------------------
+SID::FIRTable* SID::fir_tables = 0;
+char* SID::fir_cache_dir = 0;
+
+static const int fir_cache_slots = 4;
+
+void SID::set_fir_cache_dir(const char* dir)
+{
+  delete[] fir_cache_dir;
+  fir_cache_dir = 0;
+
+  if (dir) {
+    fir_cache_dir = new char[strlen(dir) + 1];
+    strcpy(fir_cache_dir, dir);
+  }
+}
+
+void SID::fir_cache_shutdown()
+{
+  // Tables still used by a SID instance stay, the cache directory is only
+  // needed while there are tables.
+  fir_free_unused();
+  if (!fir_tables) {
+    set_fir_cache_dir(0);
+  }
+}
+
+SID::FIRTable* SID::fir_get(int N, int RES, double beta,
+                            double f_cycles_per_sample,
+                            double f_samples_per_cycle, double filter_scale)
+{
+  FIRTable* table;
+
+  for (table = fir_tables; table; table = table->next) {
+    if (table->N == N && table->RES == RES && table->beta == beta &&
+        table->f_cycles_per_sample == f_cycles_per_sample &&
+        table->f_samples_per_cycle == f_samples_per_cycle &&
+        table->filter_scale == filter_scale)
+    {
+      table->refcount++;
+      return table;
+    }
+  }
+
+  fir_free_unused();
+
+  table = new FIRTable;
+  table->N = N;
+  table->RES = RES;
+  table->beta = beta;
+  table->f_cycles_per_sample = f_cycles_per_sample;
+  table->f_samples_per_cycle = f_samples_per_cycle;
+  table->filter_scale = filter_scale;
+  table->fir = new short[N*RES];
+  table->refcount = 1;
+
+  if (!fir_load(table)) {
+    fir_compute(table);
+    fir_save(table);
+  }
+
+  table->next = fir_tables;
+  fir_tables = table;
+  return table;
+}
+
+void SID::fir_release(FIRTable* table)
+{
+  if (table) {
+    table->refcount--;
+  }
+}
+
+void SID::fir_free_unused()
+{
+  FIRTable** link = &fir_tables;
+  while (*link) {
+    if ((*link)->refcount == 0) {
+      FIRTable* table = *link;
+      *link = table->next;
+      delete[] table->fir;
+      delete table;
+    } else {
+      link = &(*link)->next;
+    }
+  }
+}
+
+void SID::fir_compute(FIRTable* table)
+{
+  const double pi = 3.1415926535897932385;
+
+  // The cutoff frequency is midway through the transition band (nyquist)
+  double wc = pi;
+
+  const int fir_N = table->N;
+  const int fir_RES = table->RES;
+  const double beta = table->beta;
+  const double I0beta = I0(beta);
+  const double f_cycles_per_sample = table->f_cycles_per_sample;
+  const double f_samples_per_cycle = table->f_samples_per_cycle;
+  const double filter_scale = table->filter_scale;
+  short* fir = table->fir;
 
   // Calculate fir_RES FIR tables for linear interpolation.
   for (int i = 0; i < fir_RES; i++) {
@@ -715,8 +841,119 @@ bool SID::set_sampling_parameters(double clock_freq, sampling_method method,
       fir[fir_offset + j] = (short)round(val);
     }
   }
+}
 
-  return true;
+// Cache file header, the parameters are compared bit for bit on loading.
+static const char fir_magic[8] = { 'r', 'e', 'S', 'I', 'D', 'F', 'I', 'R' };
+
+char* SID::fir_cache_file(int slot)
+{
+  char* name = new char[strlen(fir_cache_dir) + 32];
+  sprintf(name, "%s/resid-fir-%d.bin", fir_cache_dir, slot);
+  return name;
+}
+
+static void fir_write_header(ostream& file, const int* size, const double* key)
+{
+  file.write(fir_magic, sizeof(fir_magic));
+  file.write(reinterpret_cast<const char*>(size), 2*sizeof(int));
+  file.write(reinterpret_cast<const char*>(key), 4*sizeof(double));
+}
+
+bool SID::fir_load(FIRTable* table)
+{
+  if (!fir_cache_dir) {
+    return false;
+  }
+
+  const int size[2] = { table->N, table->RES };
+  const double key[4] = {
+    table->beta, table->f_cycles_per_sample,
+    table->f_samples_per_cycle, table->filter_scale
+  };
+
+  // The slot a table is in is not known, look for the header matching it.
+  for (int slot = 0; slot < fir_cache_slots; slot++) {
+    char* name = fir_cache_file(slot);
+    ifstream file(name, ios::in | ios::binary);
+    delete[] name;
+    if (!file) {
+      continue;
+    }
+
+    char magic[sizeof(fir_magic)];
+    int file_size[2];
+    double file_key[4];
+
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char*>(file_size), sizeof(file_size));
+    file.read(reinterpret_cast<char*>(file_key), sizeof(file_key));
+    if (!file ||
+        memcmp(magic, fir_magic, sizeof(magic)) != 0 ||
+        memcmp(file_size, size, sizeof(size)) != 0 ||
+        memcmp(file_key, key, sizeof(key)) != 0)
+    {
+      continue;
+    }
+
+    file.read(reinterpret_cast<char*>(table->fir), sizeof(short)*table->N*table->RES);
+    return file.gcount() == (streamsize)(sizeof(short)*table->N*table->RES);
+  }
+  return false;
+}
+
+void SID::fir_save(const FIRTable* table)
+{
+  if (!fir_cache_dir) {
+    return;
+  }
+
+  const int size[2] = { table->N, table->RES };
+  const double key[4] = {
+    table->beta, table->f_cycles_per_sample,
+    table->f_samples_per_cycle, table->filter_scale
+  };
+
+  // Use a free slot, or replace the table written longest ago.
+  int slot = 0;
+  time_t oldest = 0;
+  for (int i = 0; i < fir_cache_slots; i++) {
+    char* slot_name = fir_cache_file(i);
+    struct stat st;
+    int found = stat(slot_name, &st) == 0;
+    delete[] slot_name;
+    if (!found) {
+      slot = i;
+      break;
+    }
+    if (i == 0 || st.st_mtime < oldest) {
+      slot = i;
+      oldest = st.st_mtime;
+    }
+  }
+
+  char* name = fir_cache_file(slot);
+  char* temp_name = new char[strlen(name) + 5];
+  sprintf(temp_name, "%s.tmp", name);
+
+  // Write to a temporary file first, so an interrupted write or another
+  // emulator instance never leaves a truncated table behind.
+  ofstream file(temp_name, ios::out | ios::binary | ios::trunc);
+  if (file) {
+    fir_write_header(file, size, key);
+    file.write(reinterpret_cast<const char*>(table->fir), sizeof(short)*table->N*table->RES);
+    file.close();
+    // rename() does not replace an existing file everywhere.
+    if (file) {
+      remove(name);
+    }
+    if (!file || rename(temp_name, name) != 0) {
+      remove(temp_name);
+    }
+  }
+
+  delete[] temp_name;
+  delete[] name;
 }
 
 
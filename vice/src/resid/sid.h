@@ -52,6 +52,12 @@ public:
   void adjust_sampling_frequency(double sample_freq);
   void enable_raw_debug_output(bool enable);
 
+  // Directory to keep computed FIR tables in across runs, 0 to disable.
+  static void set_fir_cache_dir(const char* dir);
+  // Free the FIR tables no SID instance uses, and the cache directory once
+  // no tables are left.
+  static void fir_cache_shutdown();
+
   void clock();
   void clock(cycle_count delta_t);
   int clock(cycle_count& delta_t, short* buf, int n, int interleave = 1);
@@ -104,6 +110,33 @@ public:
   void debugoutput(void);
 
  protected:
+  // FIR tables are shared by all SID instances with the same parameters.
+  struct FIRTable
+  {
+    int N;
+    int RES;
+    double beta;
+    double f_cycles_per_sample;
+    double f_samples_per_cycle;
+    double filter_scale;
+    short* fir;
+    int refcount;
+    FIRTable* next;
+  };
+
+  static FIRTable* fir_get(int N, int RES, double beta,
+                           double f_cycles_per_sample,
+                           double f_samples_per_cycle, double filter_scale);
+  static void fir_release(FIRTable* table);
+  static void fir_free_unused();
+  static void fir_compute(FIRTable* table);
+  static bool fir_load(FIRTable* table);
+  static void fir_save(const FIRTable* table);
+  static char* fir_cache_file(int slot);
+
+  static FIRTable* fir_tables;
+  static char* fir_cache_dir;
+
   static double I0(double x);
   int clock_fast(cycle_count& delta_t, short* buf, int n, int interleave);
   int clock_interpolate(cycle_count& delta_t, short* buf, int n, int interleave);
@@ -171,6 +204,7 @@ public:
 
   // FIR_RES filter tables (FIR_N*FIR_RES).
   short* fir;
+  FIRTable* fir_table;
 
   bool raw_debug_output; // FIXME: should be private?
 };
@@ -334,29 +334,71 @@ void scpu64_clock_read_ioram(void) /* scpu64 v1 $d200-$d3ff one extra 20 Mhz cyc
 /* SCPU64 needs external reg_pc */
 #define NEED_REG_PC
 
-#define STORE(addr, value) \
-    do { \
-        uint32_t tmpx1 = (addr); \
-        uint8_t tmpx2 = (value); \
-        if (tmpx1 & ~0xffff) { \
-            mem_store2(tmpx1, tmpx2); \
-        } else { \
-            (*_mem_write_tab_ptr[tmpx1 >> 8])((uint16_t)tmpx1, tmpx2); \
-        } \
-    } while (0)
-
-#define LOAD(addr) \
-    (((addr) & ~0xffff)?mem_read2(addr):(*_mem_read_tab_ptr[(addr) >> 8])((uint16_t)(addr)))
+/* Plain SRAM and SIMM accesses are done directly through the page and bank
+   pointers, the wait states follow from the region: bank 0 SRAM has to wait
+   for BA, bank 1 SRAM is never delayed and the SIMM has the row/cell
+   timing. Everything else goes through the memory handlers.  */
+static inline void store_direct(uint32_t addr, uint8_t value)
+{
+    uint8_t *p;
+
+    if (addr < 0x20000) {
+        p = mem_direct_write_tab[addr >> 8];
+        if (p != NULL) {
+            if (addr < 0x10000 && !scpu64_fastmode && !scpu64_emulation_mode && maincpu_ba_low_flags) {
+                maincpu_steal_cycles();
+            }
+            p[addr & 0xff] = value;
+        } else if (addr & ~0xffff) {
+            mem_store2(addr, value);
+        } else {
+            (*_mem_write_tab_ptr[addr >> 8])((uint16_t)addr, value);
+        }
+    } else {
+        p = mem_direct_write_bank_tab[(addr >> 16) & 0xff];
+        if (p != NULL && addr < 0x1000000) {
+            p[addr & 0xffff] = value;
+            scpu64_clock_write_stretch_simm(addr);
+        } else {
+            mem_store2(addr, value);
+        }
+    }
+}
+
+static inline uint8_t load_direct(uint32_t addr)
+{
+    uint8_t *p;
+
+    if (addr < 0x20000) {
+        p = mem_direct_read_tab[addr >> 8];
+        if (p != NULL) {
+            if (addr < 0x10000) {
+                check_ba();
+            }
+            return p[addr & 0xff];
+        }
+        if (addr & ~0xffff) {
+            return mem_read2(addr);
+        }
+        return (*_mem_read_tab_ptr[addr >> 8])((uint16_t)addr);
+    }
+    p = mem_direct_read_bank_tab[(addr >> 16) & 0xff];
+    if (p != NULL && addr < 0x1000000) {
+        scpu64_clock_read_stretch_simm(addr);
+        return p[addr & 0xffff];
+    }
+    return mem_read2(addr);
+}
+
+#define STORE(addr, value) store_direct((uint32_t)(addr), (uint8_t)(value))
+
+#define LOAD(addr) load_direct((uint32_t)(addr))
 
 #define STORE_LONG(addr, value) store_long((uint32_t)(addr), (uint8_t)(value))
 
 static inline void store_long(uint32_t addr, uint8_t value)
 {
-    if (addr & ~0xffff) {
-        mem_store2(addr, value);
-    } else {
-        (*_mem_write_tab_ptr[addr >> 8])((uint16_t)addr, value);
-    }
+    store_direct(addr, value);
     scpu64_clock_inc(1);
 }
 
@@ -366,11 +408,7 @@ static inline uint8_t load_long(uint32_t addr)
 {
     uint8_t tmp;
 
-    if ((addr) & ~0xffff) {
-        tmp = mem_read2(addr);
-    } else {
-        tmp = (*_mem_read_tab_ptr[(addr) >> 8])((uint16_t)addr);
-    }
+    tmp = load_direct(addr);
     scpu64_clock_inc(0);
     return tmp;
 }
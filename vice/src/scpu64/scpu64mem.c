@@ -121,6 +121,15 @@ static uint32_t mem_read_limit_tab[NUM_CONFIGS][0x101];
 static store_func_ptr_t mem_write_tab_watch[0x101];
 static read_func_ptr_t mem_read_tab_watch[0x101];
 
+/* Direct access tables for the CPU. Pages of bank 0 and 1 which are plain
+   SRAM point to the start of the page, SIMM banks to the start of the bank.
+   NULL means the access has to go through the handlers (I/O, ROM, mirrored
+   to the C64 RAM, watchpoints, traps).  */
+uint8_t *mem_direct_read_tab[0x200];
+uint8_t *mem_direct_write_tab[0x200];
+uint8_t *mem_direct_read_bank_tab[0x100];
+uint8_t *mem_direct_write_bank_tab[0x100];
+
 /* Current mirror config */
 static int mirror;
 
@@ -145,6 +154,8 @@ int mem_pport;                  /* processor "port" */
 
 static int dma_in_progress = 0;
 
+static void mem_direct_update(void);
+
 /* ------------------------------------------------------------------------- */
 
 inline static void check_ba_read(void)
@@ -198,6 +209,7 @@ void mem_toggle_watchpoints(int flag, void *context)
         _mem_write_tab_ptr = mem_write_tab[mirror][mem_config];
     }
     watchpoints_active = flag;
+    mem_direct_update();
 }
 
 /* ------------------------------------------------------------------------- */
@@ -223,6 +235,7 @@ void mem_pla_config_changed(void)
 
     _mem_read_base_tab_ptr = mem_read_base_tab[mem_config];
     mem_read_limit_tab_ptr = mem_read_limit_tab[mem_config];
+    mem_direct_update();
 
     maincpu_resync_limits();
 }
@@ -1285,6 +1298,55 @@ void mem_read_base_set(unsigned int base, unsigned int index, uint8_t *mem_ptr)
     mem_read_base_tab[base][index] = mem_ptr;
 }
 
+/* Rebuild the bank 0 part of the direct access tables, called whenever the
+   memory configuration, the mirroring or the watchpoint state changes.  */
+static void mem_direct_update(void)
+{
+    read_func_ptr_t *read_tab = mem_read_tab[mem_config];
+    store_func_ptr_t *write_tab = mem_write_tab[mirror][mem_config];
+    uint8_t *p;
+    int i;
+
+    for (i = 0; i <= 0xff; i++) {
+        p = NULL;
+        if (!watchpoints_active) {
+            if (read_tab[i] == ram_read) {
+                p = mem_sram + (i << 8);
+            } else if (read_tab[i] == scpu64_kernalshadow_read) {
+                p = mem_sram + 0x8000 + (i << 8);
+            } else if (read_tab[i] == ram1_read) {
+                p = mem_sram + 0x10000 + (i << 8);
+            }
+        }
+        mem_direct_read_tab[i] = p;
+        /* only the unmirrored pages, zeropage and $ffxx have side effects */
+        mem_direct_write_tab[i] = (!watchpoints_active && write_tab[i] == ram_store) ? mem_sram + (i << 8) : NULL;
+    }
+}
+
+/* Rebuild the SIMM part of the direct access tables, only possible if the
+   SIMM page size matches the configured one, as otherwise every access has to
+   be remapped.  */
+static void mem_direct_update_simm(void)
+{
+    uint8_t *p;
+    int i;
+
+    for (i = 0; i <= 0xff; i++) {
+        p = NULL;
+        if (mem_simm_ram_mask && mem_simm_page_size == mem_conf_page_size) {
+            if (i == 0xf6 || i == 0xf7) {
+                p = mem_simm_ram + ((i & 1) << 16);
+            } else if (i >= 0x02 && i < 0xf6 && (i << 16) < mem_conf_size) {
+                p = mem_simm_ram + ((i << 16) & mem_simm_ram_mask);
+            }
+        }
+        mem_direct_read_bank_tab[i] = p;
+        /* $f60000-$f7ffff writes depend on the hardware registers */
+        mem_direct_write_bank_tab[i] = (i < 0xf6) ? p : NULL;
+    }
+}
+
 void mem_initialize_memory(void)
 {
     int i, j, l;
@@ -1348,6 +1410,14 @@ void mem_initialize_memory(void)
 
     scpu64meminit();
 
+    /* bank 1 is plain SRAM, except for $0000/$0001 and the kernal traps */
+    for (i = 0x100; i < 0x200; i++) {
+        uint8_t *p = (i == 0x100 && scpu64_version_v2) ? NULL : mem_sram + (i << 8);
+
+        mem_direct_read_tab[i] = p;
+        mem_direct_write_tab[i] = (i >= 0x1e0) ? NULL : p;
+    }
+
     for (i = 0; i < NUM_CONFIGS; i++) {
         mem_read_tab[i][0x100] = mem_read_tab[i][0];
             for (l = 0; l < NUM_MIRRORS; l++) {
@@ -1471,6 +1541,7 @@ void mem_set_mirroring(int new_mirroring)
     if (_mem_write_tab_ptr != mem_write_tab_watch) {
         _mem_write_tab_ptr = mem_write_tab[mirror][mem_config];
     }
+    mem_direct_update();
 }
 
 void mem_set_simm(int config)
@@ -1498,6 +1569,7 @@ void mem_set_simm(int config)
         break;
     }
     scpu64_set_simm_row_size(mem_conf_page_size);
+    mem_direct_update_simm();
 }
 
 void scpu64_hardware_reset(void)
@@ -2150,6 +2222,7 @@ void mem_set_simm_size(int val)
             mem_simm_page_size = 11 + 2;  /* 4,3 */
             break;
     }
+    mem_direct_update_simm();
     maincpu_resync_limits();
 }
 
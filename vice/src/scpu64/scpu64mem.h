@@ -54,6 +54,11 @@ extern int mem_pport;                  /* processor "port" */
 
 extern unsigned int mem_simm_ram_mask;
 
+extern uint8_t *mem_direct_read_tab[];
+extern uint8_t *mem_direct_write_tab[];
+extern uint8_t *mem_direct_read_bank_tab[];
+extern uint8_t *mem_direct_write_bank_tab[];
+
 int c64_mem_init_resources(void);
 int c64_mem_init_cmdline_options(void);
 
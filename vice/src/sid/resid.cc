@@ -38,6 +38,7 @@ extern "C" {
 #include <string.h>
 
 #include "sid/sid.h" /* sid_engine_t */
+#include "archdep_user_cache_path.h"
 #include "lib.h"
 #include "log.h"
 #include "resid.h"
@@ -219,6 +220,9 @@ static int resid_init(sound_t *psid, int speed, int cycles_per_sec, int factor)
         break;
     }
 
+    /* the resampling FIR tables are kept in the cache dir across runs */
+    SID::set_fir_cache_dir(archdep_user_cache_path());
+
     if (!psid->sid->set_sampling_parameters(cycles_per_sec, method,
                                             speed, passband, gain)) {
         log_warning(sound_log,
@@ -242,6 +246,8 @@ static void resid_close(sound_t *psid)
     delete psid->sid;
     delete psid;
 
+    SID::fir_cache_shutdown();
+
     if (buf) {
         lib_free(buf);
         buf = NULL;
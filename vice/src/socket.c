@@ -54,6 +54,10 @@
 #include <strings.h>
 #endif
 
+#ifdef HAVE_UNIX_DOMAIN_SOCKETS
+#include <sys/stat.h>
+#endif
+
 #include "socketimpl.h"
 
 /* Fix Windows' definition of 'INVALID_SOCKET (SOCKET)(~0)', which breaks the
@@ -446,6 +450,17 @@ vice_network_socket_t *vice_network_server(
 #endif
         }
 
+#ifdef HAVE_UNIX_DOMAIN_SOCKETS
+        if (server_address->domain == PF_UNIX) {
+            struct stat st;
+
+            /* remove the socket file left by an earlier run */
+            if (stat(server_address->address.local.sun_path, &st) == 0 && S_ISSOCK(st.st_mode)) {
+                unlink(server_address->address.local.sun_path);
+            }
+        }
+#endif
+
         if (bind(sockfd, &server_address->address.generic, server_address->len) < 0) {
             err = errno;
             log_error(LOG_DEFAULT,
@@ -753,7 +768,6 @@ static int vice_network_address_generate_ipv6(vice_network_socket_address_t * so
 #endif /* #ifdef HAVE_IPV6 */
 }
 
-#if 0
 /*! \internal \brief Generate a unix domain socket address
 
   Initialises a socket address with a unix domain socket address
@@ -812,7 +826,6 @@ static int vice_network_address_generate_local(vice_network_socket_address_t * s
     return -1;
 #endif /* #ifdef HAVE_UNIX_DOMAIN_SOCKETS */
 }
-#endif
 
 /*! \brief Generate a socket address
 
@@ -835,8 +848,8 @@ static int vice_network_address_generate_local(vice_network_socket_address_t * s
      NULL in case of an error.
 
   \remark
-     If address_string starts with a pipe ('|'), then the
-     address_string is treated as a unix domain socket.
+     If address_string starts with unix://, then the rest of
+     address_string is the path of a unix domain socket.
      Otherwise, address_string can be prepended with ip6://
      or ip4://, in which case address_string is treated
      exactly as an IPv6 or IPv4 address, respectively.
@@ -855,15 +868,13 @@ vice_network_socket_address_t * vice_network_address_generate(const char * addre
         if (socket_address == NULL) {
             break;
         }
-#if 0 /* FIXME: "|" as first character indicates that we want to pipe through an external process - if we
-                want to support unix domain socket, this has to use another syntax! */
-        if (address_string && address_string[0] == '|') {
-            if (vice_network_address_generate_local(socket_address, &address_string[1])) {
+        /* "|" as first character indicates that we want to pipe through an
+           external process, unix domain sockets use their own prefix */
+        if (address_string && strncmp("unix://", address_string, sizeof "unix://" - 1) == 0) {
+            if (vice_network_address_generate_local(socket_address, &address_string[sizeof "unix://" - 1])) {
                 break;
             }
-        } else
-#endif
-        if (address_string && strncmp("ip6://", address_string, sizeof "ip6://" - 1) == 0) {
+        } else if (address_string && strncmp("ip6://", address_string, sizeof "ip6://" - 1) == 0) {
             if (vice_network_address_generate_ipv6(socket_address, &address_string[sizeof "ip6://" - 1], port)) {
                 break;
             }
@@ -40,6 +40,12 @@
 #include <strings.h>
 #endif
 
+#include <stdatomic.h>
+
+#ifdef USE_VICE_THREAD
+#include <pthread.h>
+#endif
+
 #include "archdep.h"
 #include "cmdline.h"
 #include "debug.h"
@@ -532,6 +538,7 @@ static int amp;
 static int fragment_size;
 static int output_option;
 static int sound_emulation_enabled_on_warp;
+static int sync_method;
 
 /* divisors for fragment size calculation */
 static const int fragment_divisor[] = {
@@ -578,6 +585,23 @@ static int set_output_option(int val, void *param)
     return 0;
 }
 
+static int set_sync_method(int val, void *param)
+{
+    switch (val) {
+        case SOUND_SYNC_PUSH:
+        case SOUND_SYNC_RING:
+            break;
+        default:
+            return -1;
+    }
+
+    if (sync_method != val) {
+        sync_method = val;
+        sound_state_changed = TRUE;
+    }
+    return 0;
+}
+
 static int set_sound_emulation_enabled_on_warp(int value, void *param)
 {
     int val = value ? 1 : 0;
@@ -718,6 +742,8 @@ static const resource_int_t resources_int[] = {
       (void *)&output_option, set_output_option, NULL },
     { "SoundEmulateOnWarp", 1, RES_EVENT_NO, NULL,
       (void *)&sound_emulation_enabled_on_warp, set_sound_emulation_enabled_on_warp, NULL },
+    { "SoundSyncMethod", SOUND_SYNC_PUSH, RES_EVENT_NO, NULL,
+      (void *)&sync_method, set_sync_method, NULL },
     RESOURCE_INT_LIST_END
 };
 
@@ -776,6 +802,9 @@ static const cmdline_option_t cmdline_options[] =
     { "-soundwarpmode", SET_RESOURCE, CMDLINE_ATTRIB_NEED_ARGS,
       NULL, NULL, "SoundEmulateOnWarp", NULL,
       "<mode>", "Specify how to handle sound emulation in warp mode: (0: do not emulate the sound chips, 1: keep emulating the sound chips)" },
+    { "-soundsync", SET_RESOURCE, CMDLINE_ATTRIB_NEED_ARGS,
+      NULL, NULL, "SoundSyncMethod", NULL,
+      "<method>", "Specify the sound sync method: (0: push against the sound device, 1: ring buffer with adaptive resampling)" },
     CMDLINE_LIST_END
 };
 
@@ -1013,6 +1042,301 @@ static void fill_buffer(int size, int rise)
 }
 
 
+/* ------------------------------------------------------------------------- */
+
+/* Ring buffer sync (SoundSyncMethod = SOUND_SYNC_RING).
+
+   The emulation does not wait for the sound device, the host clock keeps
+   the emulation speed like with the non realtime devices. sound_flush()
+   resamples the generated samples by a ratio close to 1 into a single
+   producer, single consumer ring buffer, which is drained on the audio
+   side: from the audio callback for the devices calling sound_ring_attach()
+   from their init routine, by a feeder thread calling the blocking write
+   routine for the others.
+
+   Every flush the ratio is adjusted by the deviation of the (smoothed) fill
+   level of the ring from the target latency, half of the sound buffer size.
+   This makes up for the drift between the host clock and the clock of the
+   sound device without ever blocking the emulation thread.  */
+
+#define RING_RATIO_MAX_ADJUST   0.005   /* at most 0.5% pitch change */
+#define RING_FILL_SMOOTHING     16      /* flushes to average the fill level over */
+
+static int16_t *ring_buffer = NULL;
+static size_t ring_size;                /* in samples, power of 2 */
+static atomic_size_t ring_head;         /* samples written */
+static atomic_size_t ring_tail;         /* samples read */
+static int ring_channels;
+static atomic_int ring_active;          /* set once the ring is set up */
+static int ring_callback = 0;           /* drained by the device callback */
+
+/* producer side */
+static double ring_target;              /* fill level to keep, in samples */
+static double ring_fill;                /* smoothed fill level */
+static double ring_ratio;               /* input frames per output frame */
+static double ring_pos;                 /* resampler position in the input */
+static int16_t ring_prev[SOUND_OUTPUT_CHANNELS_MAX];
+static unsigned int ring_overruns;
+
+/* consumer side */
+static int16_t ring_last[SOUND_OUTPUT_CHANNELS_MAX];
+static atomic_uint ring_underruns;
+static atomic_int ring_suspended;       /* not fed, don't count underruns */
+
+#ifdef USE_VICE_THREAD
+static pthread_t ring_thread;
+static atomic_int ring_thread_stop;
+static int ring_thread_running = 0;
+static int16_t *ring_thread_buffer = NULL;
+#endif
+
+/* Called from the init routine of a device which reads the samples with
+   sound_ring_read() from its audio callback. Returns 0 if the ring buffer
+   sync is used, -1 if the samples are passed to the write routine.  */
+int sound_ring_attach(void)
+{
+    if (sync_method != SOUND_SYNC_RING) {
+        return -1;
+    }
+    ring_callback = 1;
+    return 0;
+}
+
+/* Read nr samples from the ring, called on the audio side. Missing samples
+   are filled up by repeating the last frame. Returns the number of samples
+   which were actually available.  */
+size_t sound_ring_read(int16_t *pbuf, size_t nr)
+{
+    size_t tail = atomic_load_explicit(&ring_tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&ring_head, memory_order_acquire);
+    size_t avail = head - tail;
+    size_t pos, n, i;
+    int c;
+
+    /* The callback may already run before sound_open() has set up the ring.  */
+    if (!atomic_load_explicit(&ring_active, memory_order_acquire)) {
+        memset(pbuf, 0, nr * sizeof(int16_t));
+        return 0;
+    }
+
+    if (avail > nr) {
+        avail = nr;
+    }
+    avail -= avail % ring_channels;
+
+    pos = tail & (ring_size - 1);
+    n = ring_size - pos;
+    if (n > avail) {
+        n = avail;
+    }
+    memcpy(pbuf, ring_buffer + pos, n * sizeof(int16_t));
+    memcpy(pbuf + n, ring_buffer, (avail - n) * sizeof(int16_t));
+    atomic_store_explicit(&ring_tail, tail + avail, memory_order_release);
+
+    if (avail > 0) {
+        for (c = 0; c < ring_channels; c++) {
+            ring_last[c] = pbuf[avail - ring_channels + c];
+        }
+    }
+    if (avail < nr) {
+        if (!atomic_load_explicit(&ring_suspended, memory_order_relaxed)) {
+            atomic_fetch_add(&ring_underruns, 1);
+        }
+        for (i = avail; i < nr; i++) {
+            pbuf[i] = ring_last[i % ring_channels];
+        }
+    }
+    return avail;
+}
+
+/* Resample nr frames into the ring.  */
+static void sound_ring_write(const int16_t *pbuf, int nr)
+{
+    size_t head = atomic_load_explicit(&ring_head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&ring_tail, memory_order_acquire);
+    size_t space = ring_size - (head - tail);
+    double adjust;
+    int i, c, overrun = 0;
+
+    if (nr <= 0) {
+        return;
+    }
+
+    ring_fill += ((double)(head - tail) - ring_fill) / RING_FILL_SMOOTHING;
+    adjust = (ring_fill - ring_target) / ring_target * RING_RATIO_MAX_ADJUST;
+    if (adjust > RING_RATIO_MAX_ADJUST) {
+        adjust = RING_RATIO_MAX_ADJUST;
+    } else if (adjust < -RING_RATIO_MAX_ADJUST) {
+        adjust = -RING_RATIO_MAX_ADJUST;
+    }
+    ring_ratio = 1.0 + adjust;
+
+    /* Linear interpolation, ring_prev holds the frame before pbuf[0].  */
+    while (ring_pos < nr) {
+        double f;
+
+        i = (int)ring_pos;
+        f = ring_pos - i;
+        if (space < (size_t)ring_channels) {
+            overrun = 1;
+        } else {
+            for (c = 0; c < ring_channels; c++) {
+                int s0 = i ? pbuf[(i - 1) * ring_channels + c] : ring_prev[c];
+                int s1 = pbuf[i * ring_channels + c];
+
+                ring_buffer[head & (ring_size - 1)] = (int16_t)(s0 + (s1 - s0) * f);
+                head++;
+            }
+            space -= ring_channels;
+        }
+        ring_pos += ring_ratio;
+    }
+    ring_pos -= nr;
+
+    for (c = 0; c < ring_channels; c++) {
+        ring_prev[c] = pbuf[(nr - 1) * ring_channels + c];
+    }
+    atomic_store_explicit(&ring_head, head, memory_order_release);
+
+    ring_overruns += overrun;
+}
+
+#ifdef USE_VICE_THREAD
+/* Feeds the ring to the blocking write routine of the device.  */
+static void *sound_ring_thread(void *unused)
+{
+    size_t chunk = (size_t)(snddata.fragsize * ring_channels);
+
+    while (!atomic_load(&ring_thread_stop)) {
+        size_t avail = atomic_load_explicit(&ring_head, memory_order_acquire)
+                       - atomic_load_explicit(&ring_tail, memory_order_relaxed);
+
+        if (avail < chunk) {
+            tick_sleep(tick_per_second() / 1000);
+            continue;
+        }
+        sound_ring_read(ring_thread_buffer, chunk);
+        if (snddata.playdev->write(ring_thread_buffer, chunk)) {
+            log_error(sound_log, "write to sound device failed.");
+            break;
+        }
+    }
+    return NULL;
+}
+
+static int sound_ring_thread_start(void)
+{
+    if (ring_thread_running) {
+        return 0;
+    }
+    atomic_store(&ring_thread_stop, 0);
+    if (pthread_create(&ring_thread, NULL, sound_ring_thread, NULL) != 0) {
+        return -1;
+    }
+    ring_thread_running = 1;
+    return 0;
+}
+
+static void sound_ring_thread_stop(void)
+{
+    if (ring_thread_running) {
+        atomic_store(&ring_thread_stop, 1);
+        pthread_join(ring_thread, NULL);
+        ring_thread_running = 0;
+    }
+}
+#endif
+
+/* Set up the ring for the device just opened. Returns -1 if the device
+   cannot be fed from a ring, the push method is used then.  */
+static int sound_ring_open(void)
+{
+    size_t size;
+    int c;
+
+    ring_channels = snddata.sound_output_channels;
+    for (size = 1; size < (size_t)(snddata.bufsize * ring_channels * 2); size <<= 1) {
+    }
+    ring_size = size;
+    ring_buffer = lib_calloc(ring_size, sizeof(int16_t));
+
+    /* Start off at the target latency.  */
+    ring_target = (double)(snddata.bufsize / 2 * ring_channels);
+    ring_fill = ring_target;
+    ring_ratio = 1.0;
+    ring_pos = 0.0;
+    ring_overruns = 0;
+    atomic_store(&ring_underruns, 0);
+    atomic_store(&ring_suspended, 0);
+    atomic_store(&ring_tail, 0);
+    atomic_store(&ring_head, (size_t)ring_target);
+    for (c = 0; c < SOUND_OUTPUT_CHANNELS_MAX; c++) {
+        ring_prev[c] = 0;
+        ring_last[c] = 0;
+    }
+
+    if (!ring_callback) {
+#ifdef USE_VICE_THREAD
+        ring_thread_buffer = lib_malloc(snddata.fragsize * ring_channels * sizeof(int16_t));
+        if (sound_ring_thread_start() < 0) {
+            log_error(sound_log, "Cannot create the sound feeder thread.");
+            lib_free(ring_thread_buffer);
+            ring_thread_buffer = NULL;
+            lib_free(ring_buffer);
+            ring_buffer = NULL;
+            return -1;
+        }
+#else
+        log_warning(sound_log, "Device `%s' cannot be fed from a ring buffer, using the push sync method.",
+                    snddata.playdev->name);
+        lib_free(ring_buffer);
+        ring_buffer = NULL;
+        return -1;
+#endif
+    }
+
+    atomic_store_explicit(&ring_active, 1, memory_order_release);
+    log_message(sound_log, "Using the ring buffer sync method, latency %.2fms.",
+                1000.0 * snddata.bufsize / 2 / sample_rate);
+    return 0;
+}
+
+/* Stop feeding the device, before it is closed.  */
+static void sound_ring_stop(void)
+{
+    atomic_store(&ring_suspended, 1);
+#ifdef USE_VICE_THREAD
+    sound_ring_thread_stop();
+#endif
+}
+
+/* Start feeding the device again after sound_ring_stop().  */
+static void sound_ring_resume(void)
+{
+    atomic_store(&ring_suspended, 0);
+#ifdef USE_VICE_THREAD
+    if (!ring_callback && sound_ring_thread_start() < 0) {
+        log_error(sound_log, "Cannot create the sound feeder thread.");
+    }
+#endif
+}
+
+static void sound_ring_close(void)
+{
+    if (atomic_load(&ring_active)) {
+        log_message(sound_log, "Ring buffer: %u underruns, %u overruns.",
+                    atomic_load(&ring_underruns), ring_overruns);
+    }
+#ifdef USE_VICE_THREAD
+    lib_free(ring_thread_buffer);
+    ring_thread_buffer = NULL;
+#endif
+    lib_free(ring_buffer);
+    ring_buffer = NULL;
+    atomic_store(&ring_active, 0);
+    ring_callback = 0;
+}
+
 /* open SID engine */
 static int sid_open(void)
 {
@@ -1239,8 +1563,12 @@ int sound_open(void)
         sound_is_timing_source = pdev->is_timing_source ? TRUE : FALSE;
         sid_state_changed = FALSE;
 
-        /* Fill up the sound hardware buffer. */
-        if (pdev->bufferspace) {
+        if (sync_method == SOUND_SYNC_RING && sound_ring_open() == 0) {
+            /* The ring starts filled up to the target latency, and the host
+               clock has to keep the emulation speed.  */
+            sound_is_timing_source = FALSE;
+        } else if (pdev->bufferspace) {
+            /* Fill up the sound hardware buffer. */
             /* Fill to bufsize - fragsize. */
             j = pdev->bufferspace() - snddata.fragsize;
             if (j > 0) {
@@ -1320,8 +1648,10 @@ static void sounddev_close(const sound_device_t **dev)
 /* close sid */
 void sound_close(void)
 {
+    sound_ring_stop();
     sounddev_close(&snddata.playdev);
     sounddev_close(&snddata.recdev);
+    sound_ring_close();
     sid_close();
 
     sdev_open = FALSE;
@@ -1516,7 +1846,9 @@ bool sound_flush(void)
     }
     sound_resume();
 
-    if (snddata.playdev->flush) {
+    /* The ring is drained on the audio side, the device is not flushed
+       from here.  */
+    if (snddata.playdev->flush && !atomic_load_explicit(&ring_active, memory_order_relaxed)) {
         state = sound_machine_dump_state(snddata.psid[0]);
         i = snddata.playdev->flush(state);
         lib_free(state);
@@ -1526,6 +1858,24 @@ bool sound_flush(void)
         }
     }
 
+    if (atomic_load_explicit(&ring_active, memory_order_relaxed)) {
+        /* Never block, everything generated goes to the ring.  */
+        sound_ring_write(snddata.buffer, snddata.bufptr);
+        if (snddata.recdev && snddata.bufptr > 0) {
+            if (snddata.recdev->write(snddata.buffer, snddata.bufptr * snddata.sound_output_channels)) {
+                sound_error("write to sound device failed.");
+                goto done;
+            }
+        }
+        if (snddata.bufptr > 0) {
+            for (c = 0; c < snddata.sound_output_channels; c++) {
+                snddata.lastsample[c] = snddata.buffer[(snddata.bufptr - 1) * snddata.sound_output_channels + c];
+            }
+        }
+        snddata.bufptr = 0;
+        goto done;
+    }
+
     /* Calculate the number of samples to flush - whole fragments. */
     nr = snddata.bufptr - snddata.bufptr % snddata.fragsize;
     if (!nr) {
@@ -1614,7 +1964,10 @@ void sound_suspend(void)
         return;
     }
 
-    if (snddata.playdev->write && !snddata.issuspended
+    if (atomic_load(&ring_active) && !snddata.issuspended) {
+        /* The device plays the ring, just stop feeding it.  */
+        sound_ring_stop();
+    } else if (snddata.playdev->write && !snddata.issuspended
         && snddata.playdev->need_attenuation) {
         /* fill buffer, but avoid overwriting */
         if (!snddata.playdev->bufferspace
@@ -1651,7 +2004,11 @@ void sound_resume(void)
             snddata.issuspended = 0;
         }
 
-        if (snddata.playdev->write && !snddata.issuspended
+        if (atomic_load(&ring_active)) {
+            if (!snddata.issuspended) {
+                sound_ring_resume();
+            }
+        } else if (snddata.playdev->write && !snddata.issuspended
             && snddata.playdev->need_attenuation) {
             fill_buffer(snddata.fragsize, 1);
         }
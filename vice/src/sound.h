@@ -110,6 +110,12 @@ enum {
 #define SOUND_FRAGMENT_SIZE SOUND_FRAGMENT_MEDIUM
 #endif
 
+/* Sound sync methods */
+enum {
+    SOUND_SYNC_PUSH = 0,    /* block until the device takes the samples */
+    SOUND_SYNC_RING         /* ring buffer with adaptive resampling */
+};
+
 #define SOUND_OUTPUT_CHANNELS_MAX 2
 
 #define SOUND_CHIP_CHANNELS_MAX 8
@@ -222,25 +228,19 @@ typedef struct sound_desc_s {
 } sound_desc_t;
 
 #ifndef SOUND_SYSTEM_FLOAT
+/* Mix two samples. Samples of opposite sign are added, samples of the same
+   sign are pulled back towards zero by |ch1 * ch2| / 32768 so they do not
+   clip as soon.
+
+   This is written without branches so the loops mixing whole buffers can
+   be vectorized: ch1 * ch2 is only positive when both samples have the same
+   sign, and for a positive product / 32768 and >> 15 are the same.  */
 static inline int16_t sound_audio_mix(int ch1, int ch2)
 {
-    if (ch1 == 0) {
-        return (int16_t)ch2;
-    }
+    int prod = ch1 * ch2;
+    int corr = (prod > 0 ? prod : 0) >> 15;
 
-    if (ch2 == 0) {
-        return (int16_t)ch1;
-    }
-
-    if ((ch1 > 0 && ch2 < 0) || (ch1 < 0 && ch2 > 0)) {
-        return (int16_t)(ch1 + ch2);
-    }
-
-    if (ch1 > 0) {
-        return (int16_t)((ch1 + ch2) - (ch1 * ch2 / 32768));
-    }
-
-    return (int16_t)-((-(ch1) + -(ch2)) - (-(ch1) * -(ch2) / 32768));
+    return (int16_t)(ch1 + ch2 + (ch1 > 0 ? -corr : corr));
 }
 #endif
 
@@ -290,6 +290,10 @@ int sound_init_pulse_device(void);
 /* internal function for sound device registration */
 int sound_register_device(const sound_device_t *pdevice);
 
+/* used by devices which play the samples from their audio callback */
+int sound_ring_attach(void);
+size_t sound_ring_read(int16_t *pbuf, size_t nr);
+
 /* other internal functions used around sound -code */
 int sound_read(uint16_t addr, int chipno);
 void sound_store(uint16_t addr, uint8_t val, int chipno);
@@ -300,6 +300,11 @@ void tapeport_trigger_flux_change(unsigned int on, int port)
     machine_trigger_flux_change(port, on);
 }
 
+int tapeport_flux_observed(int port)
+{
+    return machine_tape_flux_observed(port);
+}
+
 void tapeport_set_tape_sense(int sense, int port)
 {
     machine_set_tape_sense(port, sense);
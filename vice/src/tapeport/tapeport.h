@@ -130,6 +130,7 @@ void tapeport_powerup(void);
 int tapeport_valid_port(int port);
 
 void tapeport_trigger_flux_change(unsigned int on, int port);
+int tapeport_flux_observed(int port);
 void tapeport_set_tape_sense(int sense, int port);
 void tapeport_set_write_in(int val, int port);
 void tapeport_set_motor_in(int val, int port);
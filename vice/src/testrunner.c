@@ -0,0 +1,703 @@
+/*
+ * testrunner.c - Parallel headless regression test runner.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/* The runner starts one emulator process per test, using the same binary it
+   was started from, with the debug cartridge enabled and -limitcycles as the
+   timeout. The result of a test is the exit code the program wrote to the
+   debug cartridge; the cycle count is taken from the message the cartridge
+   prints when it terminates the emulator.
+
+   Manifest format, one test per line, '#' starts a comment:
+
+   <name> <program> [key=value ...] [Resource=Value ...] [-- options ...]
+
+   program          file to autostart, relative to the manifest, "-" for none
+   timeout=<n>      cycles before the test is aborted (default 100000000)
+   expect=<n>       expected debug cartridge exit code (default 0)
+   frame[=<crc>]    hash the final frame (BMP screenshot), optionally compare it with <crc>
+   Resource=Value   resources set for this test only
+   -- options       everything after "--" is passed on the commandline
+
+   Arguments can be quoted with '"'. On Unix the tests are run in parallel,
+   elsewhere one after the other.  */
+
+#include "vice.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#ifdef UNIX_COMPILE
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#endif
+
+#include "archdep.h"
+#include "crc32.h"
+#include "lib.h"
+#include "log.h"
+#include "machine.h"
+#include "testrunner.h"
+#include "types.h"
+#include "util.h"
+
+#define TESTRUNNER_DEFAULT_TIMEOUT  100000000
+#define TESTRUNNER_LINE_MAX         4096
+#define TESTRUNNER_OUTPUT_MAX       4096
+
+enum {
+    TESTRUNNER_PASS = 0,
+    TESTRUNNER_FAIL,
+    TESTRUNNER_TIMEOUT,
+    TESTRUNNER_ERROR
+};
+
+static const char * const result_names[] = {
+    "pass", "fail", "timeout", "error"
+};
+
+typedef struct testrunner_test_s {
+    char *name;
+    char *program;      /* NULL if nothing is autostarted */
+    char *resources;    /* "Resource=Value\n" lines, NULL if none */
+    char **options;     /* passed on the commandline */
+    int options_count;
+    uint64_t timeout;
+    int expect;
+    int frame;          /* hash the final frame */
+    int frame_check;    /* compare the hash with frame_expect */
+    uint32_t frame_expect;
+
+    char *output_name;
+    char *config_name;
+    char *frame_name;
+#ifdef UNIX_COMPILE
+    pid_t pid;
+#endif
+    tick_t started;
+
+    int result;
+    int exitcode;
+    uint64_t cycles;
+    uint32_t framehash;
+    uint32_t millis;
+    char *output;       /* tail of the emulator output, for failed tests */
+} testrunner_test_t;
+
+static log_t testrunner_log = LOG_DEFAULT;
+
+static testrunner_test_t *tests = NULL;
+static int tests_count = 0;
+static int tests_size = 0;
+
+/* ------------------------------------------------------------------------- */
+
+/* Split the next (optionally quoted) argument off *line.  */
+static char *next_token(char **line)
+{
+    char *p = *line;
+    char *token;
+
+    while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') {
+        p++;
+    }
+    if (*p == 0 || *p == '#') {
+        *line = p;
+        return NULL;
+    }
+    if (*p == '"') {
+        token = ++p;
+        while (*p != 0 && *p != '"') {
+            p++;
+        }
+    } else {
+        token = p;
+        while (*p != 0 && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') {
+            p++;
+        }
+    }
+    if (*p != 0) {
+        *p++ = 0;
+    }
+    *line = p;
+    return token;
+}
+
+static int parse_test(char *line, const char *basedir, int lineno)
+{
+    testrunner_test_t *test;
+    char *name, *program, *token;
+
+    name = next_token(&line);
+    if (name == NULL) {
+        return 0;
+    }
+    program = next_token(&line);
+    if (program == NULL) {
+        log_error(testrunner_log, "line %d: test '%s' has no program.", lineno, name);
+        return -1;
+    }
+
+    if (tests_count == tests_size) {
+        tests_size = tests_size ? tests_size * 2 : 64;
+        tests = lib_realloc(tests, sizeof(testrunner_test_t) * tests_size);
+    }
+    test = &tests[tests_count++];
+    memset(test, 0, sizeof(testrunner_test_t));
+    test->name = lib_strdup(name);
+    test->timeout = TESTRUNNER_DEFAULT_TIMEOUT;
+    test->options = lib_calloc(1, sizeof(char *));
+
+    if (strcmp(program, "-") != 0) {
+        if (archdep_path_is_relative(program) && strcmp(basedir, ".") != 0) {
+            test->program = util_join_paths(basedir, program, NULL);
+        } else {
+            test->program = lib_strdup(program);
+        }
+    }
+
+    while ((token = next_token(&line)) != NULL) {
+        char *value;
+
+        if (strcmp(token, "--") == 0) {
+            while ((token = next_token(&line)) != NULL) {
+                test->options = lib_realloc(test->options,
+                                            sizeof(char *) * (test->options_count + 2));
+                test->options[test->options_count++] = lib_strdup(token);
+                test->options[test->options_count] = NULL;
+            }
+            break;
+        }
+        if (strcmp(token, "frame") == 0) {
+            test->frame = 1;
+            continue;
+        }
+        value = strchr(token, '=');
+        if (value == NULL) {
+            log_error(testrunner_log, "line %d: unknown argument '%s'.", lineno, token);
+            return -1;
+        }
+        *value++ = 0;
+        if (strcmp(token, "timeout") == 0) {
+            test->timeout = strtoull(value, NULL, 0);
+        } else if (strcmp(token, "expect") == 0) {
+            test->expect = (int)strtol(value, NULL, 0);
+        } else if (strcmp(token, "frame") == 0) {
+            test->frame = 1;
+            test->frame_check = 1;
+            test->frame_expect = (uint32_t)strtoul(value, NULL, 16);
+        } else {
+            char *p = test->resources;
+
+            test->resources = util_concat(p ? p : "", token, "=", value, "\n", NULL);
+            lib_free(p);
+        }
+    }
+    return 0;
+}
+
+static int load_manifest(const char *filename)
+{
+    FILE *f;
+    char *line;
+    char *basedir;
+    int lineno = 0;
+    int result = 0;
+
+    f = fopen(filename, "r");
+    if (f == NULL) {
+        log_error(testrunner_log, "Cannot open manifest '%s'.", filename);
+        return -1;
+    }
+    util_fname_split(filename, &basedir, NULL);
+    line = lib_malloc(TESTRUNNER_LINE_MAX);
+    while (fgets(line, TESTRUNNER_LINE_MAX, f) != NULL) {
+        if (parse_test(line, basedir, ++lineno) < 0) {
+            result = -1;
+            break;
+        }
+    }
+    lib_free(line);
+    lib_free(basedir);
+    fclose(f);
+    return result;
+}
+
+static void free_tests(void)
+{
+    int i, n;
+
+    for (i = 0; i < tests_count; i++) {
+        testrunner_test_t *test = &tests[i];
+
+        for (n = 0; n < test->options_count; n++) {
+            lib_free(test->options[n]);
+        }
+        lib_free(test->options);
+        lib_free(test->name);
+        lib_free(test->program);
+        lib_free(test->resources);
+        lib_free(test->output);
+    }
+    lib_free(tests);
+    tests = NULL;
+    tests_count = tests_size = 0;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Build the commandline of a test. The early options must come first, they
+   are only recognized at the start of the commandline.  */
+static char **make_argv(testrunner_test_t *test, int argc, char **argv,
+                        char *timeout)
+{
+    char **args;
+    int n = 0, i;
+
+    args = lib_malloc(sizeof(char *) * (argc + test->options_count + 20));
+    args[n++] = (char *)archdep_program_path();
+    args[n++] = "-console";
+    /* a fixed seed makes the cycle counts and frames reproducible */
+    args[n++] = "-seed";
+    args[n++] = "1";
+    if (test->config_name != NULL) {
+        args[n++] = "-config";
+        args[n++] = test->config_name;
+    } else {
+        args[n++] = "-default";
+    }
+    args[n++] = "-sounddev";
+    args[n++] = "dummy";
+    args[n++] = "-warp";
+    args[n++] = "-debugcart";
+    /* the default autostart disk image would be shared by all tests */
+    args[n++] = "-autostartprgmode";
+    args[n++] = "1";
+    args[n++] = "-limitcycles";
+    args[n++] = timeout;
+    if (test->frame_name != NULL) {
+        args[n++] = "-exitscreenshot";
+        args[n++] = test->frame_name;
+    }
+    for (i = 1; i < argc; i++) {
+        args[n++] = argv[i];
+    }
+    for (i = 0; i < test->options_count; i++) {
+        args[n++] = test->options[i];
+    }
+    if (test->program != NULL) {
+        args[n++] = test->program;
+    }
+    args[n] = NULL;
+    return args;
+}
+
+static int write_config(testrunner_test_t *test)
+{
+    FILE *f;
+
+    test->config_name = archdep_tmpnam();
+    f = fopen(test->config_name, "w");
+    if (f == NULL) {
+        log_error(testrunner_log, "Cannot create '%s'.", test->config_name);
+        return -1;
+    }
+    fprintf(f, "[%s]\n%s", machine_get_name(), test->resources);
+    fclose(f);
+    return 0;
+}
+
+/* Start the emulator for a test. On Unix the process runs in the
+   background, elsewhere this waits for it and returns its exit code.  */
+static int start_test(testrunner_test_t *test, int argc, char **argv)
+{
+    char **args;
+    char timeout[32];
+    int result = 0;
+
+    test->output_name = archdep_tmpnam();
+    if (test->resources != NULL && write_config(test) < 0) {
+        return -1;
+    }
+    if (test->frame) {
+        /* BMP is always available and not compressed, so the hash only
+           depends on the frame */
+        test->frame_name = util_concat(test->output_name, ".bmp", NULL);
+    }
+    snprintf(timeout, sizeof(timeout), "%"PRIu64, test->timeout);
+    args = make_argv(test, argc, argv, timeout);
+
+    test->started = tick_now();
+#ifdef UNIX_COMPILE
+    fflush(stdout);
+    fflush(stderr);
+    test->pid = fork();
+    if (test->pid < 0) {
+        log_error(testrunner_log, "fork() failed: %s.", strerror(errno));
+        result = -1;
+    } else if (test->pid == 0) {
+        /* child - CAUTION: log system does not work here */
+        if (freopen(test->output_name, "w", stdout) == NULL) {
+            _exit(-1);
+        }
+        dup2(fileno(stdout), fileno(stderr));
+        execvp(args[0], args);
+        _exit(-1);
+    }
+#else
+    result = archdep_spawn(args[0], args, &test->output_name, NULL);
+#endif
+    lib_free(args);
+    return result;
+}
+
+/* Keep the last part of the emulator output, it usually tells why a test
+   did not pass.  */
+static void keep_output(testrunner_test_t *test, FILE *f)
+{
+    long size;
+    size_t len;
+
+    fseek(f, 0, SEEK_END);
+    size = ftell(f);
+    if (size > TESTRUNNER_OUTPUT_MAX) {
+        fseek(f, size - TESTRUNNER_OUTPUT_MAX, SEEK_SET);
+    } else {
+        fseek(f, 0, SEEK_SET);
+    }
+    test->output = lib_malloc(TESTRUNNER_OUTPUT_MAX + 1);
+    len = fread(test->output, 1, TESTRUNNER_OUTPUT_MAX, f);
+    test->output[len] = 0;
+}
+
+static void finish_test(testrunner_test_t *test, int status)
+{
+    FILE *f;
+    char *line;
+    int dbgcart = 0, limit = 0;
+
+    test->millis = TICK_TO_MILLI(tick_now_delta(test->started));
+    test->exitcode = status;
+    test->result = TESTRUNNER_ERROR;
+
+    f = fopen(test->output_name, "r");
+    if (f != NULL) {
+        line = lib_malloc(TESTRUNNER_LINE_MAX);
+        while (fgets(line, TESTRUNNER_LINE_MAX, f) != NULL) {
+            int exitcode;
+            char *p;
+
+            if (sscanf(line, "DBGCART: exit(%d)", &exitcode) == 1) {
+                p = strstr(line, "cycles elapsed:");
+                test->exitcode = exitcode;
+                test->cycles = p ? strtoull(p + 15, NULL, 10) : 0;
+                dbgcart = 1;
+            } else if (strstr(line, "cycle limit reached.") != NULL) {
+                limit = 1;
+            }
+        }
+        lib_free(line);
+
+        if (dbgcart) {
+            test->result = test->exitcode == test->expect ? TESTRUNNER_PASS : TESTRUNNER_FAIL;
+        } else if (limit) {
+            test->result = TESTRUNNER_TIMEOUT;
+            test->cycles = test->timeout;
+        }
+        if (test->frame && util_file_exists(test->frame_name)) {
+            test->framehash = crc32_file(test->frame_name);
+            if (test->frame_check && test->framehash != test->frame_expect
+                && test->result == TESTRUNNER_PASS) {
+                test->result = TESTRUNNER_FAIL;
+            }
+        } else if (test->frame && test->result == TESTRUNNER_PASS) {
+            test->result = TESTRUNNER_ERROR;
+        }
+        if (test->result != TESTRUNNER_PASS) {
+            keep_output(test, f);
+        }
+        fclose(f);
+    }
+
+    log_message(testrunner_log, "%-32s %-7s exit %3d  cycles %12"PRIu64"  %6u ms",
+                test->name, result_names[test->result], test->exitcode,
+                test->cycles, test->millis);
+
+    archdep_remove(test->output_name);
+    lib_free(test->output_name);
+    test->output_name = NULL;
+    if (test->config_name != NULL) {
+        archdep_remove(test->config_name);
+        lib_free(test->config_name);
+        test->config_name = NULL;
+    }
+    if (test->frame_name != NULL) {
+        archdep_remove(test->frame_name);
+        lib_free(test->frame_name);
+        test->frame_name = NULL;
+    }
+}
+
+/* ------------------------------------------------------------------------- */
+
+static void write_escaped(FILE *f, const char *s, int xml)
+{
+    for (; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+
+        if (xml) {
+            switch (c) {
+                case '<': fputs("&lt;", f); continue;
+                case '>': fputs("&gt;", f); continue;
+                case '&': fputs("&amp;", f); continue;
+                case '"': fputs("&quot;", f); continue;
+                case '\n': case '\t': fputc(c, f); continue;
+                default: break;
+            }
+        } else {
+            switch (c) {
+                case '"': fputs("\\\"", f); continue;
+                case '\\': fputs("\\\\", f); continue;
+                case '\n': fputs("\\n", f); continue;
+                case '\t': fputs("\\t", f); continue;
+                default: break;
+            }
+        }
+        if (c < 0x20 || c == 0x7f) {
+            /* control characters (log colors) are not allowed in XML 1.0 */
+            continue;
+        }
+        fputc(c, f);
+    }
+}
+
+static void write_json(FILE *f, int *totals, uint32_t millis)
+{
+    int i;
+
+    fprintf(f, "{\n  \"machine\": \"%s\",\n", machine_get_name());
+    fprintf(f, "  \"tests\": %d, \"passed\": %d, \"failed\": %d, \"timeouts\": %d, \"errors\": %d,\n",
+            tests_count, totals[TESTRUNNER_PASS], totals[TESTRUNNER_FAIL],
+            totals[TESTRUNNER_TIMEOUT], totals[TESTRUNNER_ERROR]);
+    fprintf(f, "  \"time\": %.3f,\n  \"results\": [", millis / 1000.0);
+    for (i = 0; i < tests_count; i++) {
+        testrunner_test_t *test = &tests[i];
+
+        fputs(i ? ",\n    {" : "\n    {", f);
+        fputs("\"name\": \"", f);
+        write_escaped(f, test->name, 0);
+        fputs("\", \"program\": ", f);
+        if (test->program != NULL) {
+            fputc('"', f);
+            write_escaped(f, test->program, 0);
+            fputc('"', f);
+        } else {
+            fputs("null", f);
+        }
+        fprintf(f, ", \"result\": \"%s\", \"exitcode\": %d, \"expect\": %d, \"cycles\": %"PRIu64", \"time\": %.3f",
+                result_names[test->result], test->exitcode, test->expect,
+                test->cycles, test->millis / 1000.0);
+        if (test->frame) {
+            fprintf(f, ", \"framehash\": \"%08x\"", test->framehash);
+        }
+        if (test->output != NULL) {
+            fputs(", \"output\": \"", f);
+            write_escaped(f, test->output, 0);
+            fputc('"', f);
+        }
+        fputc('}', f);
+    }
+    fputs("\n  ]\n}\n", f);
+}
+
+static void write_junit(FILE *f, int *totals, uint32_t millis)
+{
+    int i;
+
+    fputs("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n", f);
+    fprintf(f, "<testsuite name=\"%s\" tests=\"%d\" failures=\"%d\" errors=\"%d\" time=\"%.3f\">\n",
+            machine_get_name(), tests_count,
+            totals[TESTRUNNER_FAIL] + totals[TESTRUNNER_TIMEOUT],
+            totals[TESTRUNNER_ERROR], millis / 1000.0);
+    for (i = 0; i < tests_count; i++) {
+        testrunner_test_t *test = &tests[i];
+
+        fputs("  <testcase classname=\"", f);
+        write_escaped(f, machine_get_name(), 1);
+        fputs("\" name=\"", f);
+        write_escaped(f, test->name, 1);
+        fprintf(f, "\" time=\"%.3f\">\n", test->millis / 1000.0);
+        fprintf(f, "    <properties><property name=\"cycles\" value=\"%"PRIu64"\"/>",
+                test->cycles);
+        if (test->frame) {
+            fprintf(f, "<property name=\"framehash\" value=\"%08x\"/>", test->framehash);
+        }
+        fputs("</properties>\n", f);
+        switch (test->result) {
+            case TESTRUNNER_FAIL:
+                fprintf(f, "    <failure message=\"exit code %d, expected %d\"/>\n",
+                        test->exitcode, test->expect);
+                break;
+            case TESTRUNNER_TIMEOUT:
+                fprintf(f, "    <failure message=\"timeout after %"PRIu64" cycles\"/>\n",
+                        test->timeout);
+                break;
+            case TESTRUNNER_ERROR:
+                fprintf(f, "    <error message=\"emulator exited with %d\"/>\n",
+                        test->exitcode);
+                break;
+            default:
+                break;
+        }
+        if (test->output != NULL) {
+            fputs("    <system-out>", f);
+            write_escaped(f, test->output, 1);
+            fputs("</system-out>\n", f);
+        }
+        fputs("  </testcase>\n", f);
+    }
+    fputs("</testsuite>\n", f);
+}
+
+static int write_report(const char *filename, uint32_t millis)
+{
+    FILE *f;
+    int totals[4] = { 0, 0, 0, 0 };
+    size_t len;
+    int i;
+
+    for (i = 0; i < tests_count; i++) {
+        totals[tests[i].result]++;
+    }
+    log_message(testrunner_log, "%d tests: %d passed, %d failed, %d timeouts, %d errors (%.1f s).",
+                tests_count, totals[TESTRUNNER_PASS], totals[TESTRUNNER_FAIL],
+                totals[TESTRUNNER_TIMEOUT], totals[TESTRUNNER_ERROR],
+                millis / 1000.0);
+
+    if (filename == NULL) {
+        return 0;
+    }
+    f = fopen(filename, "w");
+    if (f == NULL) {
+        log_error(testrunner_log, "Cannot create report '%s'.", filename);
+        return -1;
+    }
+    len = strlen(filename);
+    if (len > 4 && util_strcasecmp(filename + len - 4, ".xml") == 0) {
+        write_junit(f, totals, millis);
+    } else {
+        write_json(f, totals, millis);
+    }
+    fclose(f);
+    return 0;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static int default_jobs(void)
+{
+#if defined(UNIX_COMPILE) && defined(_SC_NPROCESSORS_ONLN)
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+
+    if (n > 0) {
+        return (int)n;
+    }
+#endif
+    return 1;
+}
+
+int testrunner_run(const char *manifest, const char *report, int jobs,
+                   int argc, char **argv)
+{
+    int next = 0, running = 0;
+    int i, result = EXIT_SUCCESS;
+    uint32_t millis = 0;
+    tick_t started;
+
+    testrunner_log = log_open("Testrunner");
+
+    if (load_manifest(manifest) < 0) {
+        free_tests();
+        return EXIT_FAILURE;
+    }
+    if (jobs <= 0) {
+        jobs = default_jobs();
+    }
+    log_message(testrunner_log, "Running %d tests from '%s' with %d jobs.",
+                tests_count, manifest, jobs);
+
+    started = tick_now();
+    while (next < tests_count || running > 0) {
+        while (running < jobs && next < tests_count) {
+            testrunner_test_t *test = &tests[next++];
+            int status = start_test(test, argc, argv);
+#ifdef UNIX_COMPILE
+            if (status == 0) {
+                running++;
+                continue;
+            }
+#endif
+            finish_test(test, status);
+        }
+#ifdef UNIX_COMPILE
+        if (running > 0) {
+            int status;
+            pid_t pid = waitpid(-1, &status, 0);
+
+            if (pid < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                log_error(testrunner_log, "waitpid() failed: %s.", strerror(errno));
+                break;
+            }
+            for (i = 0; i < tests_count; i++) {
+                if (tests[i].output_name != NULL && tests[i].pid == pid) {
+                    finish_test(&tests[i],
+                                WIFEXITED(status) ? WEXITSTATUS(status) : -1);
+                    running--;
+                    break;
+                }
+            }
+        }
+#endif
+        /* the tick counter wraps after a bit more than an hour, so sum up
+           the time in small steps */
+        millis += TICK_TO_MILLI(tick_now_delta(started));
+        started = tick_now();
+    }
+
+    for (i = 0; i < tests_count; i++) {
+        if (tests[i].result != TESTRUNNER_PASS) {
+            result = EXIT_FAILURE;
+        }
+    }
+    if (write_report(report, millis) < 0) {
+        result = EXIT_FAILURE;
+    }
+    free_tests();
+    log_close(testrunner_log);
+    return result;
+}
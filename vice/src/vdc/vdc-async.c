@@ -0,0 +1,295 @@
+/*
+ * vdc-async.c - Drawing the MOS 8563 (VDC) raster lines on a separate thread.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/* With VDCAsyncDraw enabled the raster alarm handler does not draw the line
+   itself, it records the line state (see vdc_line_state_t) in a ring of line
+   slots and the render thread draws from there. The VDC RAM writes are logged
+   in a second ring and applied to a shadow copy of the VDC RAM by the render
+   thread before it draws the line they precede, so it sees exactly what the
+   inline drawing would have seen.
+
+   While lines are queued the render thread owns vdc.raster and the canvas.
+   Everything else that touches them calls vdc_async_sync() first, which waits
+   until the queue is empty. The vice thread does the same before it yields
+   the mainlock to the UI.  */
+
+#include "vice.h"
+
+#include <string.h>
+
+#include "lib.h"
+#include "log.h"
+#include "mainlock.h"
+#include "types.h"
+#include "vdc-async.h"
+#include "vdc-draw.h"
+#include "vdctypes.h"
+
+int vdc_async_draw_active = 0;
+
+#ifdef USE_VICE_THREAD
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+#define VDC_ASYNC_LINES     64          /* must be a power of 2 */
+#define VDC_ASYNC_BATCH     8           /* lines to queue before waking the thread */
+#define VDC_ASYNC_RAM_LOG   0x10000     /* must be a power of 2 */
+
+typedef struct vdc_async_line_s {
+    vdc_line_state_t state;
+    size_t ram_log_end;     /* RAM writes to apply before drawing the line */
+} vdc_async_line_t;
+
+static vdc_async_line_t *lines = NULL;
+static size_t line_pos;             /* emulation side copy of line_head */
+static atomic_size_t line_head;     /* end of the queued lines */
+static atomic_size_t line_tail;     /* end of the drawn lines */
+
+static uint32_t *ram_log = NULL;    /* (index << 8) | value */
+static size_t ram_log_pos;          /* end of the logged RAM writes */
+static atomic_size_t ram_log_tail;  /* end of the RAM writes applied */
+static uint8_t *shadow_ram = NULL;
+
+static pthread_t render_thread;
+static pthread_mutex_t render_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t work_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t idle_cond = PTHREAD_COND_INITIALIZER;
+static atomic_int render_waiting;
+static int render_stop;
+
+/* ------------------------------------------------------------------------- */
+
+static void apply_ram_log(size_t end)
+{
+    size_t pos = atomic_load_explicit(&ram_log_tail, memory_order_relaxed);
+
+    while (pos != end) {
+        uint32_t entry = ram_log[pos & (VDC_ASYNC_RAM_LOG - 1)];
+
+        shadow_ram[entry >> 8] = (uint8_t)entry;
+        pos++;
+    }
+    atomic_store_explicit(&ram_log_tail, pos, memory_order_release);
+}
+
+static void *render_thread_main(void *unused)
+{
+    size_t tail = atomic_load(&line_tail);
+
+    while (1) {
+        if (tail != atomic_load_explicit(&line_head, memory_order_acquire)) {
+            vdc_async_line_t *line = &lines[tail & (VDC_ASYNC_LINES - 1)];
+
+            apply_ram_log(line->ram_log_end);
+            vdc_draw_line(&line->state);
+            tail++;
+            atomic_store_explicit(&line_tail, tail, memory_order_release);
+            continue;
+        }
+
+        pthread_mutex_lock(&render_lock);
+        pthread_cond_broadcast(&idle_cond);
+        atomic_store(&render_waiting, 1);
+        while (tail == atomic_load(&line_head) && !render_stop) {
+            pthread_cond_wait(&work_cond, &render_lock);
+        }
+        atomic_store(&render_waiting, 0);
+        if (tail == atomic_load(&line_head) && render_stop) {
+            pthread_mutex_unlock(&render_lock);
+            break;
+        }
+        pthread_mutex_unlock(&render_lock);
+    }
+    return NULL;
+}
+
+static void wake_render_thread(void)
+{
+    pthread_mutex_lock(&render_lock);
+    pthread_cond_signal(&work_cond);
+    pthread_mutex_unlock(&render_lock);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Wait until the render thread has drawn all queued lines.  */
+void vdc_async_sync(void)
+{
+    if (!vdc_async_draw_active
+        || atomic_load_explicit(&line_tail, memory_order_acquire) == line_pos) {
+        return;
+    }
+
+    pthread_mutex_lock(&render_lock);
+    pthread_cond_signal(&work_cond);
+    while (atomic_load(&line_tail) != line_pos) {
+        pthread_cond_wait(&idle_cond, &render_lock);
+    }
+    pthread_mutex_unlock(&render_lock);
+}
+
+/* Return the slot to record the state of the current line in.  */
+vdc_line_state_t *vdc_async_line_begin(void)
+{
+    if (line_pos - atomic_load_explicit(&line_tail, memory_order_acquire) == VDC_ASYNC_LINES) {
+        vdc_async_sync();
+    }
+    return &lines[line_pos & (VDC_ASYNC_LINES - 1)].state;
+}
+
+/* Queue the line recorded since vdc_async_line_begin().  */
+void vdc_async_line_end(void)
+{
+    vdc_async_line_t *line = &lines[line_pos & (VDC_ASYNC_LINES - 1)];
+
+    line->state.ram = shadow_ram;
+    line->ram_log_end = ram_log_pos;
+    line_pos++;
+    atomic_store_explicit(&line_head, line_pos, memory_order_release);
+
+    if (atomic_load(&render_waiting)
+        && line_pos - atomic_load_explicit(&line_tail, memory_order_acquire) >= VDC_ASYNC_BATCH) {
+        wake_render_thread();
+    }
+}
+
+/* Log a write to vdc.ram[index] for the render thread.  */
+void vdc_async_ram_store(unsigned int index, uint8_t value)
+{
+    if (ram_log_pos - atomic_load_explicit(&ram_log_tail, memory_order_acquire) == VDC_ASYNC_RAM_LOG) {
+        /* Let the render thread catch up, the writes left over do not
+           belong to a queued line and can be applied right here.  */
+        vdc_async_sync();
+        apply_ram_log(ram_log_pos);
+    }
+    ram_log[ram_log_pos & (VDC_ASYNC_RAM_LOG - 1)] = (uint32_t)(index << 8) | value;
+    ram_log_pos++;
+}
+
+/* Copy the whole VDC RAM after it has been changed without vdc_ram_store().  */
+void vdc_async_ram_reload(void)
+{
+    if (!vdc_async_draw_active) {
+        return;
+    }
+
+    vdc_async_sync();
+    memcpy(shadow_ram, vdc.ram, sizeof(vdc.ram));
+    atomic_store(&ram_log_tail, ram_log_pos);
+}
+
+int vdc_async_draw_enable(int enable)
+{
+    if (enable == vdc_async_draw_active) {
+        return 0;
+    }
+
+    if (enable) {
+        if (mainlock_add_yield_hook(vdc_async_sync) < 0) {
+            return -1;
+        }
+
+        lines = lib_malloc(sizeof(vdc_async_line_t) * VDC_ASYNC_LINES);
+        ram_log = lib_malloc(sizeof(uint32_t) * VDC_ASYNC_RAM_LOG);
+        shadow_ram = lib_malloc(sizeof(vdc.ram));
+        memcpy(shadow_ram, vdc.ram, sizeof(vdc.ram));
+
+        line_pos = 0;
+        atomic_store(&line_head, 0);
+        atomic_store(&line_tail, 0);
+        ram_log_pos = 0;
+        atomic_store(&ram_log_tail, 0);
+        atomic_store(&render_waiting, 0);
+        render_stop = 0;
+
+        if (pthread_create(&render_thread, NULL, render_thread_main, NULL) != 0) {
+            log_error(vdc.log, "Cannot create the render thread.");
+            mainlock_remove_yield_hook(vdc_async_sync);
+            lib_free(lines);
+            lib_free(ram_log);
+            lib_free(shadow_ram);
+            lines = NULL;
+            ram_log = NULL;
+            shadow_ram = NULL;
+            return -1;
+        }
+        vdc_async_draw_active = 1;
+    } else {
+        mainlock_remove_yield_hook(vdc_async_sync);
+        vdc_async_sync();
+
+        pthread_mutex_lock(&render_lock);
+        render_stop = 1;
+        pthread_cond_signal(&work_cond);
+        pthread_mutex_unlock(&render_lock);
+        pthread_join(render_thread, NULL);
+
+        /* Writes logged after the last line are already in vdc.ram.  */
+        vdc_async_draw_active = 0;
+        lib_free(lines);
+        lib_free(ram_log);
+        lib_free(shadow_ram);
+        lines = NULL;
+        ram_log = NULL;
+        shadow_ram = NULL;
+    }
+    return 0;
+}
+
+#else
+
+/* Without a separate emulation thread the UI may change the raster state at
+   any time, so the lines are always drawn inline.  */
+
+int vdc_async_draw_enable(int enable)
+{
+    if (enable) {
+        log_error(LOG_DEFAULT, "VDC: drawing on a separate thread is not available.");
+        return -1;
+    }
+    return 0;
+}
+
+vdc_line_state_t *vdc_async_line_begin(void)
+{
+    return NULL;
+}
+
+void vdc_async_line_end(void)
+{
+}
+
+void vdc_async_ram_store(unsigned int index, uint8_t value)
+{
+}
+
+void vdc_async_ram_reload(void)
+{
+}
+
+void vdc_async_sync(void)
+{
+}
+
+#endif
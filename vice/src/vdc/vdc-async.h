@@ -0,0 +1,42 @@
+/*
+ * vdc-async.h - Drawing the MOS 8563 (VDC) raster lines on a separate thread.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#ifndef VICE_VDC_ASYNC_H
+#define VICE_VDC_ASYNC_H
+
+#include "types.h"
+
+struct vdc_line_state_s;
+
+/* Flag: are raster lines drawn by the render thread?  */
+extern int vdc_async_draw_active;
+
+int vdc_async_draw_enable(int enable);
+
+struct vdc_line_state_s *vdc_async_line_begin(void);
+void vdc_async_line_end(void);
+void vdc_async_ram_store(unsigned int index, uint8_t value);
+void vdc_async_ram_reload(void);
+void vdc_async_sync(void);
+
+#endif
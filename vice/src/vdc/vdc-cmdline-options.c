@@ -45,6 +45,12 @@ static const cmdline_option_t cmdline_options[] =
     { "+VDCstretchvertical", SET_RESOURCE, CMDLINE_ATTRIB_NONE,
       NULL, NULL, "VDCStretchVertical", (resource_value_t)0,
       NULL, "Disable additional vertical stretching." },
+    { "-VDCasyncdraw", SET_RESOURCE, CMDLINE_ATTRIB_NONE,
+      NULL, NULL, "VDCAsyncDraw", (resource_value_t)1,
+      NULL, "Draw the VDC screen on a separate thread" },
+    { "+VDCasyncdraw", SET_RESOURCE, CMDLINE_ATTRIB_NONE,
+      NULL, NULL, "VDCAsyncDraw", (resource_value_t)0,
+      NULL, "Draw the VDC screen on the emulation thread" },
     { "-VDC16KB", SET_RESOURCE, CMDLINE_ATTRIB_NONE,
       NULL, NULL, "VDC64KB", (resource_value_t)0,
       NULL, "Set the VDC memory size to 16KiB" },
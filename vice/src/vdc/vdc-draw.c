@@ -34,6 +34,7 @@
 #include "raster-cache-const.h"
 #include "raster-cache-fill.h"
 #include "raster-cache.h"
+#include "raster-line.h"
 #include "raster-modes.h"
 #include "types.h"
 #include "vdc-draw.h"
@@ -122,6 +123,9 @@ static unsigned int semi_gfx_test;   /* a combo flag & bitmask, if 0 there is no
 static unsigned int semi_gfx_mask;   /* used to mask 'on' the remainder of the character, e.g. for semi_gfx_test 0x08, semi_gfx_mask= 0x07 to mask on bits 0-2 inclusive */
 static unsigned int semi_gfx_type;   /* 0 = semi-graphics does not extend through intercharacter gap, 0xFF = it does */
 
+/* The state of the line being drawn, see vdc_draw_line() */
+static const vdc_line_state_t *vdc_line;
+
 
 /* These functions draw the background from `start_pixel' to `end_pixel'.  */
 /*
@@ -191,12 +195,12 @@ static void calculate_draw_masks(void)
     unsigned int i;
     int displayedpixels;
 
-    if (vdc.regs[25] & 0x10) { /* double pixel / 40 column mode */
+    if (vdc_line->regs[25] & 0x10) { /* double pixel / 40 column mode */
         /* half the values for 40column mode are 0x10 further down, so compensate the table lookup */
-        if (!(vdc.regs[22] & 0x08) && (vdc.regs[22] >= 0x10)) {
-            i = vdc.regs[22] - 0x10;
+        if (!(vdc_line->regs[22] & 0x08) && (vdc_line->regs[22] >= 0x10)) {
+            i = vdc_line->regs[22] - 0x10;
         } else {
-            i = vdc.regs[22];
+            i = vdc_line->regs[22];
         }
         displayedpixels = displayedwidth[i];
         if (displayedpixels < 0) {  /* invalid, i.e displays nothing but black. we don't support this quite yet so just set the displayed width to 0 */
@@ -204,10 +208,10 @@ static void calculate_draw_masks(void)
             dmask = 0x00;   /* show no pixels */
             semi_gfx_test = 0;  /* always fail, so don't extend through any gap */
         } else {
-            if ((vdc.regs[25] & 0x20 )  /* Semi-graphics mode */
-             || (((vdc.regs[22] >> 4) & 0x0F) == (vdc.regs[22] & 0x0F))) { /* extra weirdness - in 40col mode if displayed width = total width, semigfx is enabled either way */
-                if (((vdc.regs[22] >> 4) & 0x0F) == (vdc.regs[22] & 0x0F)) { /* in extra weirdness the width is always at least 1 */
-                    if ((vdc.regs[22] & 0x0F) <= 8 ) {
+            if ((vdc_line->regs[25] & 0x20 )  /* Semi-graphics mode */
+             || (((vdc_line->regs[22] >> 4) & 0x0F) == (vdc_line->regs[22] & 0x0F))) { /* extra weirdness - in 40col mode if displayed width = total width, semigfx is enabled either way */
+                if (((vdc_line->regs[22] >> 4) & 0x0F) == (vdc_line->regs[22] & 0x0F)) { /* in extra weirdness the width is always at least 1 */
+                    if ((vdc_line->regs[22] & 0x0F) <= 8 ) {
                         displayedpixels = 1;
                     }
                 } else if (displayedpixels == 0) {
@@ -220,31 +224,31 @@ static void calculate_draw_masks(void)
             }
             dmask = displayedpixmask[displayedpixels];
         }
-        if ((vdc.regs[22] >> 4) > 8) { /* if there is inter-char gap then...    */
-            d2mask = displayedpixmask[(vdc.regs[22] >> 4) - 6];  /* ..calculate the mask to apply to display the correct # of pixels but no more */
+        if ((vdc_line->regs[22] >> 4) > 8) { /* if there is inter-char gap then...    */
+            d2mask = displayedpixmask[(vdc_line->regs[22] >> 4) - 6];  /* ..calculate the mask to apply to display the correct # of pixels but no more */
         } else {
             d2mask = 0x00;  /* this shouldn't matter as it shouldn't try to render the interchar gap because there isn't one, but setting it to be thorough */
         }
     } else {    /* normal / 80 column mode */
-        displayedpixels = displayedwidth[vdc.regs[22]];
+        displayedpixels = displayedwidth[vdc_line->regs[22]];
         if (displayedpixels < 0) {  /* invalid, i.e displays nothing but black. we don't support this quite yet so just set the displayed width to 0 */
             displayedpixels = 0;
             dmask = 0x00;   /* show no pixels */
             semi_gfx_test = 0;  /* always fail, so don't extend through any gap */
         } else {
-            if (vdc.regs[25] & 0x20) {  /* Semi-graphics mode */
+            if (vdc_line->regs[25] & 0x20) {  /* Semi-graphics mode */
                 if (displayedpixels == 0) {
                     displayedpixels = 8;    /* there is no width 0 in semigfx mode, so override it if it happens, e.g. R22:0-3 = 7 */
                 }
                 semi_gfx_test = semigfxtest[displayedpixels - 1];   /* .. set it as a mask to check the appropriate bit */
-                semi_gfx_type = semigfxtype[vdc.regs[22]];  /* 0 if semigfx mode is active but doesn't extend through intercharacter gap. 0xFF otherwise, doubles as a mask */
+                semi_gfx_type = semigfxtype[vdc_line->regs[22]];  /* 0 if semigfx mode is active but doesn't extend through intercharacter gap. 0xFF otherwise, doubles as a mask */
             } else {    /* regular text mode */
                 semi_gfx_test = 0;  /* always fail, so don't extend through any gap */
             }
             dmask = displayedpixmask[displayedpixels];
         }
-        if ((vdc.regs[22] >> 4) >= 8) { /* if there is inter-char gap then... */
-            d2mask = displayedpixmask[(vdc.regs[22] >> 4) - 6];  /* ..calculate the mask to apply to display the correct # of pixels but no more */
+        if ((vdc_line->regs[22] >> 4) >= 8) { /* if there is inter-char gap then... */
+            d2mask = displayedpixmask[(vdc_line->regs[22] >> 4) - 6];  /* ..calculate the mask to apply to display the correct # of pixels but no more */
         } else {
             d2mask = 0x00;  /* this shouldn't matter as it shouldn't try to render the interchar gap because there isn't one, but setting it to be thorough */
         }
@@ -268,31 +272,31 @@ index = where in the screen memory we are, to check against the cursor */
     uint8_t data;
     if (a & VDC_ALTCHARSET_ATTR) {
         /* swich to alternate charset if appropriate attribute bit set */
-        char_mem += 0x100 * vdc.bytes_per_char; /* 0x1000 or 0x2000, depending on character height */
+        char_mem += 0x100 * vdc_line->bytes_per_char; /* 0x1000 or 0x2000, depending on character height */
     }
 
-    if (l > (signed)vdc.regs[23]) {
+    if (l > (signed)vdc_line->regs[23]) {
         /* Return nothing if > Vertical Character Size */
         data = 0x00;
     } else {
         /* mask against r[22] - pixels per char mask */
-        data = char_mem[(c * bytes_per_char) + l] & mask[vdc.regs[22] & 0x0F];
+        data = char_mem[(c * bytes_per_char) + l] & mask[vdc_line->regs[22] & 0x0F];
     }
 
     /* Pixels per char does not apply to the underline but the underline does blink, reverse and extend through inter-character spacing */
-    if ((l == (signed)vdc.regs[29]) && (a & VDC_UNDERLINE_ATTR)) {
+    if ((l == (signed)vdc_line->regs[29]) && (a & VDC_UNDERLINE_ATTR)) {
         data = 0xFF;
     }
 
-    if ((a & VDC_FLASH_ATTR) && (vdc.attribute_blink)) {
+    if ((a & VDC_FLASH_ATTR) && (vdc_line->attribute_blink)) {
         data = 0x00;
     }
 
-    if (vdc.regs[25] & 0x20) {
+    if (vdc_line->regs[25] & 0x20) {
         /* Semi-graphics mode */
-        if (data & semigfxtest[vdc.regs[22] & 0x0F]) {
+        if (data & semigfxtest[vdc_line->regs[22] & 0x0F]) {
             /* if the far right pixel is on.. */
-            data |= semigfxmask[vdc.regs[22] & 0x0F];
+            data |= semigfxmask[vdc_line->regs[22] & 0x0F];
             /* .. mask the rest of the right hand side on */
         }
     }
@@ -302,7 +306,7 @@ index = where in the screen memory we are, to check against the cursor */
         data ^= 0xFF;
     }
 
-    if (vdc.regs[24] & 0x40) {
+    if (vdc_line->regs[24] & 0x40) {
         /* Reverse screen bit */
         data ^= 0xFF;
     }
@@ -310,12 +314,12 @@ index = where in the screen memory we are, to check against the cursor */
     /* on a 80x25 text screen (2000 characters) this is only true for 1 character. */
     if (curpos == index) {
         /* invert anything at all? */
-        if ((vdc.frame_counter | 1) & crsrblink[(vdc.regs[10] >> 5) & 3]) {
+        if ((vdc_line->frame_counter | 1) & crsrblink[(vdc_line->regs[10] >> 5) & 3]) {
             /* invert current byte of the character? */
             if (
-            ((l >= (vdc.regs[10] & 0x1F)) && (l < (vdc.regs[11] & 0x1F)))
-            || ((l == (vdc.regs[10] & 0x1F)) && (l == (vdc.regs[11] & 0x1F)))
-            || (((vdc.regs[10] & 0x1F) > (vdc.regs[11] & 0x1F)) && ((l >= (vdc.regs[10] & 0x1F)) || (l < (vdc.regs[11] & 0x1F))))
+            ((l >= (vdc_line->regs[10] & 0x1F)) && (l < (vdc_line->regs[11] & 0x1F)))
+            || ((l == (vdc_line->regs[10] & 0x1F)) && (l == (vdc_line->regs[11] & 0x1F)))
+            || (((vdc_line->regs[10] & 0x1F) > (vdc_line->regs[11] & 0x1F)) && ((l >= (vdc_line->regs[10] & 0x1F)) || (l < (vdc_line->regs[11] & 0x1F))))
             ) {
                 /* The VDC cursor reverses the char */
                 data ^= 0xFF;
@@ -512,17 +516,17 @@ static int get_std_text(raster_cache_t *cache, unsigned int *xs, unsigned int *x
     /* r=return value, cursor_pos=the cursor position in screen memory so that it can be drawn correctly */
     int r, cursor_pos;
 
-    cursor_pos = ( vdc.crsrpos & vdc.vdc_address_mask ) - vdc.screen_adr - vdc.mem_counter;
+    cursor_pos = ( vdc_line->crsrpos & vdc_line->vdc_address_mask ) - vdc_line->screen_adr - vdc_line->mem_counter;
 
-    if (vdc.regs[25] & 0x40) {
+    if (vdc_line->regs[25] & 0x40) {
         /* attribute mode */
         /* get the character definition data, with any attributes applied from attribute memory, into the raster cache foreground_data */
         r = cache_data_fill_attr_text(cache->foreground_data,
-                                      vdc.ram + vdc.screen_adr + vdc.mem_counter,
-                                      vdc.ram + vdc.attribute_adr + vdc.mem_counter,
-                                      vdc.ram + (vdc.chargen_adr & vdc.vdc_address_mask),
-                                      vdc.bytes_per_char,
-                                      vdc.screen_text_cols,
+                                      vdc_line->ram + vdc_line->screen_adr + vdc_line->mem_counter,
+                                      vdc_line->ram + vdc_line->attribute_adr + vdc_line->mem_counter,
+                                      vdc_line->ram + (vdc_line->chargen_adr & vdc_line->vdc_address_mask),
+                                      vdc_line->bytes_per_char,
+                                      vdc_line->screen_text_cols,
                                       vdc.raster.ycounter,
                                       xs, xe,
                                       rr,
@@ -531,19 +535,19 @@ static int get_std_text(raster_cache_t *cache, unsigned int *xs, unsigned int *x
                                       cursor_pos);
         /* fill the raster cache color_data_1 with the attributes from vdc memory */
         r |= raster_cache_data_fill(cache->color_data_1,
-                                    vdc.ram + vdc.attribute_adr + vdc.mem_counter,
-                                    vdc.screen_text_cols,
+                                    vdc_line->ram + vdc_line->attribute_adr + vdc_line->mem_counter,
+                                    vdc_line->screen_text_cols,
                                     xs, xe,
                                     rr);
     } else {
         /* monochrome mode - attributes from register 26 */
         /* get the character definition data, fixed attributes (only background colour, which doesn't actually do anything to these functions!) */
         r = cache_data_fill_attr_text_const(cache->foreground_data,
-                                            vdc.ram + vdc.screen_adr + vdc.mem_counter,
-                                            (uint8_t)(vdc.regs[26] & 0x0f),
-                                            vdc.ram + (vdc.chargen_adr & vdc.vdc_address_mask),
-                                            vdc.bytes_per_char,
-                                            (int)vdc.screen_text_cols,
+                                            vdc_line->ram + vdc_line->screen_adr + vdc_line->mem_counter,
+                                            (uint8_t)(vdc_line->regs[26] & 0x0f),
+                                            vdc_line->ram + (vdc_line->chargen_adr & vdc_line->vdc_address_mask),
+                                            vdc_line->bytes_per_char,
+                                            (int)vdc_line->screen_text_cols,
                                             vdc.raster.ycounter,
                                             xs, xe,
                                             rr,
@@ -552,8 +556,8 @@ static int get_std_text(raster_cache_t *cache, unsigned int *xs, unsigned int *x
                                             cursor_pos);
         /* fill the raster cache color_data_1 with the foreground colour from vdc reg 26 */
         r |= raster_cache_data_fill_const(cache->color_data_1,
-                                          (uint8_t)(vdc.regs[26] >> 4),
-                                          (int)vdc.screen_text_cols,
+                                          (uint8_t)(vdc_line->regs[26] >> 4),
+                                          (int)vdc_line->screen_text_cols,
                                           xs, xe,
                                           rr);
     }
@@ -571,27 +575,27 @@ static void draw_std_text_cached(raster_cache_t *cache, unsigned int xs,
     unsigned int i;
     int icsi = -1;  /* Inter Character Spacing Index - used as a combo flag/index as to whether there is any intercharacter gap to render */
 
-    if (vdc.regs[25] & 0x10) { /* double pixel a.k.a 40column mode */
-        if (vdc.charwidth > 16) {   /* Is there inter character spacing to render? */
-            icsi = vdc.charwidth / 2 - 8;
+    if (vdc_line->regs[25] & 0x10) { /* double pixel a.k.a 40column mode */
+        if (vdc_line->charwidth > 16) {   /* Is there inter character spacing to render? */
+            icsi = vdc_line->charwidth / 2 - 8;
         }
     } else { /* 80 column mode */
-        if (vdc.charwidth > 8) {    /* Is there inter character spacing to render? */
-            icsi = vdc.charwidth - 8;
+        if (vdc_line->charwidth > 8) {    /* Is there inter character spacing to render? */
+            icsi = vdc_line->charwidth - 8;
         }
     }
     p = vdc.raster.draw_buffer_ptr
-        + vdc.border_width
-        + ((vdc.regs[25] & 0x10) ? 2 : 0)
-        + vdc.xsmooth * ((vdc.regs[25] & 0x10) ? 2 : 1)
-        - (vdc.regs[22] >> 4) * ((vdc.regs[25] & 0x10) ? 2 : 1)
-        + xs * vdc.charwidth;
-    table_ptr = hr_table + ((vdc.regs[26] & 0x0f) << 4);
-    pdl_ptr = pdl_table + ((vdc.regs[26] & 0x0f) << 4);
-    pdh_ptr = pdh_table + ((vdc.regs[26] & 0x0f) << 4);
-
-    if (vdc.regs[25] & 0x10) { /* double pixel mode */
-        for (i = xs; i <= (unsigned int)xe; i++, p += vdc.charwidth) {
+        + vdc_line->border_width
+        + ((vdc_line->regs[25] & 0x10) ? 2 : 0)
+        + vdc_line->xsmooth * ((vdc_line->regs[25] & 0x10) ? 2 : 1)
+        - (vdc_line->regs[22] >> 4) * ((vdc_line->regs[25] & 0x10) ? 2 : 1)
+        + xs * vdc_line->charwidth;
+    table_ptr = hr_table + ((vdc_line->regs[26] & 0x0f) << 4);
+    pdl_ptr = pdl_table + ((vdc_line->regs[26] & 0x0f) << 4);
+    pdh_ptr = pdh_table + ((vdc_line->regs[26] & 0x0f) << 4);
+
+    if (vdc_line->regs[25] & 0x10) { /* double pixel mode */
+        for (i = xs; i <= (unsigned int)xe; i++, p += vdc_line->charwidth) {
             uint32_t *pdwl = pdl_ptr + ((cache->color_data_1[i] & 0x0f) << 8);
             uint32_t *pdwh = pdh_ptr + ((cache->color_data_1[i] & 0x0f) << 8);
             int d = cache->foreground_data[i];
@@ -601,7 +605,7 @@ static void draw_std_text_cached(raster_cache_t *cache, unsigned int xs,
             *((uint32_t *)p + 3) = *(pdwl + (d & 0x0f));
             if (icsi >= 0) {    /* if there's inter character spacing, then render it */
                 q = p + 16;
-                if ((vdc.regs[25] & 0x20) && (d & semigfxtest[vdc.regs[22] & 0x0F])) { /* If semi-graphics mode and the rightmost active bit is set */
+                if ((vdc_line->regs[25] & 0x20) && (d & semigfxtest[vdc_line->regs[22] & 0x0F])) { /* If semi-graphics mode and the rightmost active bit is set */
                     d = mask[icsi];   /* .. figure out how big it is based on the width of the gap */
                 } else { /* otherwise just draw the background */
                     d = 0;
@@ -609,7 +613,7 @@ static void draw_std_text_cached(raster_cache_t *cache, unsigned int xs,
                 if (cache->color_data_1[i] & VDC_REVERSE_ATTR) { /* reverse if the reverse attribute is set for this char */
                     d ^= 0xff;
                 }
-                if (vdc.regs[24] & VDC_REVERSE_ATTR) {  /* whole screen reverse */
+                if (vdc_line->regs[24] & VDC_REVERSE_ATTR) {  /* whole screen reverse */
                     d ^= 0xff;
                 }
                 *((uint32_t *)q) = *(pdwh + (d >> 4));
@@ -619,14 +623,14 @@ static void draw_std_text_cached(raster_cache_t *cache, unsigned int xs,
             }
         }
     } else { /* normal text size */
-        for (i = xs; i <= (unsigned int)xe; i++, p += vdc.charwidth) {
+        for (i = xs; i <= (unsigned int)xe; i++, p += vdc_line->charwidth) {
             uint32_t *ptr = table_ptr + ((cache->color_data_1[i] & 0x0f) << 8);
             int d = cache->foreground_data[i];
             *((uint32_t *)p) = *(ptr + (d >> 4));
             *((uint32_t *)p + 1) = *(ptr + (d & 0x0f));
             if (icsi >= 0) {    /* if there's inter character spacing, then render it */
                 q = p + 8;
-                if ((vdc.regs[25] & 0x20) && (d & semigfxtest[vdc.regs[22] & 0x0F])) { /* If semi-graphics mode and the rightmost active bit is set */
+                if ((vdc_line->regs[25] & 0x20) && (d & semigfxtest[vdc_line->regs[22] & 0x0F])) { /* If semi-graphics mode and the rightmost active bit is set */
                     d = mask[icsi];   /* .. figure out how big it is based on the width of the gap */
                 } else { /* otherwise just draw the background */
                     d = 0;
@@ -634,7 +638,7 @@ static void draw_std_text_cached(raster_cache_t *cache, unsigned int xs,
                 if (cache->color_data_1[i] & VDC_REVERSE_ATTR) { /* reverse if the reverse attribute is set for this char */
                     d ^= 0xff;
                 }
-                if (vdc.regs[24] & VDC_REVERSE_ATTR) {  /* whole screen reverse */
+                if (vdc_line->regs[24] & VDC_REVERSE_ATTR) {  /* whole screen reverse */
                     d ^= 0xff;
                 }
                 *((uint32_t *)q) = *(ptr + (d >> 4));
@@ -644,9 +648,9 @@ static void draw_std_text_cached(raster_cache_t *cache, unsigned int xs,
     }
 
     /* fill the last few pixels of the display with bg colour if smooth scroll != 0 - if needed */
-    if (i == vdc.screen_text_cols) {
-        for (i = vdc.xsmooth; i < (unsigned)(vdc.regs[22] >> 4); i++, p++) {
-            *p = (vdc.regs[26] & 0x0f);
+    if (i == vdc_line->screen_text_cols) {
+        for (i = vdc_line->xsmooth; i < (unsigned)(vdc_line->regs[22] >> 4); i++, p++) {
+            *p = (vdc_line->regs[26] & 0x0f);
         }
     }
 }
@@ -659,64 +663,64 @@ static void draw_std_text(void)
 {
     uint8_t *p, *q;
     uint32_t *table_ptr, *pdl_ptr, *pdh_ptr, char_index;
-    uint8_t *attr_ptr, *screen_ptr;
+    const uint8_t *attr_ptr, *screen_ptr;
 
     unsigned int i, d, d2;
     unsigned int cpos = 0xFFFF;
     int icsi = -1;  /* Inter Character Spacing Index - used as a combo flag/index as to whether there is any intercharacter gap to render */
 
-    cpos = ( vdc.crsrpos & vdc.vdc_address_mask ) - vdc.screen_adr - vdc.mem_counter;
+    cpos = ( vdc_line->crsrpos & vdc_line->vdc_address_mask ) - vdc_line->screen_adr - vdc_line->mem_counter;
 
-    if(vdc.regs[25] & 0x10) { /* double pixel a.k.a 40column mode */
-        if (vdc.charwidth > 16) {   /* Is there inter character spacing to render? */
-            icsi = vdc.charwidth / 2 - 8;
+    if(vdc_line->regs[25] & 0x10) { /* double pixel a.k.a 40column mode */
+        if (vdc_line->charwidth > 16) {   /* Is there inter character spacing to render? */
+            icsi = vdc_line->charwidth / 2 - 8;
         }
     } else { /* 80 column mode */
-        if (vdc.charwidth > 8) {    /* Is there inter character spacing to render? */
-            icsi = vdc.charwidth - 8;
+        if (vdc_line->charwidth > 8) {    /* Is there inter character spacing to render? */
+            icsi = vdc_line->charwidth - 8;
         }
     }
 
     p = vdc.raster.draw_buffer_ptr
-        + vdc.border_width
-        + ((vdc.regs[25] & 0x10) ? 2 : 0)
-        + vdc.xsmooth * ((vdc.regs[25] & 0x10) ? 2 : 1)
-        - (vdc.regs[22] >> 4) * ((vdc.regs[25] & 0x10) ? 2 : 1);
+        + vdc_line->border_width
+        + ((vdc_line->regs[25] & 0x10) ? 2 : 0)
+        + vdc_line->xsmooth * ((vdc_line->regs[25] & 0x10) ? 2 : 1)
+        - (vdc_line->regs[22] >> 4) * ((vdc_line->regs[25] & 0x10) ? 2 : 1);
 
-    /* attr_ptr = vdc.ram + ((vdc.attribute_adr + vdc.mem_counter) & vdc.vdc_address_mask);*/    /* keep pre-buffer pointer set-up for testing */
-    attr_ptr = &vdc.attrbuf[vdc.attrbufdraw];
-    /* screen_ptr = vdc.ram + ((vdc.screen_adr + vdc.mem_counter) & vdc.vdc_address_mask);*/ /* as above */
-    screen_ptr = &vdc.scrnbuf[vdc.attrbufdraw];
-    char_index = (vdc.chargen_adr & vdc.vdc_address_mask) + vdc.raster.ycounter;
+    /* attr_ptr = vdc_line->ram + ((vdc_line->attribute_adr + vdc_line->mem_counter) & vdc_line->vdc_address_mask);*/    /* keep pre-buffer pointer set-up for testing */
+    attr_ptr = &vdc_line->attrbuf[vdc_line->attrbufdraw];
+    /* screen_ptr = vdc_line->ram + ((vdc_line->screen_adr + vdc_line->mem_counter) & vdc_line->vdc_address_mask);*/ /* as above */
+    screen_ptr = &vdc_line->scrnbuf[vdc_line->attrbufdraw];
+    char_index = (vdc_line->chargen_adr & vdc_line->vdc_address_mask) + vdc.raster.ycounter;
 
     calculate_draw_masks();
 
     /* Now actually render everything */
-    if (vdc.regs[25] & 0x40) {  /* Attribute mode - background colour from regs[26] but foreground from attribute ram */
-        table_ptr = hr_table + ((vdc.regs[26] & 0x0F) << 4);    /* regs[26] & 0xF is the background colour */
-        pdl_ptr = pdl_table + ((vdc.regs[26] & 0x0F) << 4);
-        pdh_ptr = pdh_table + ((vdc.regs[26] & 0x0F) << 4);
-        for (i = 0; i < vdc.screen_text_cols; i++, p += vdc.charwidth) {
-            if (vdc.raster.ycounter > (signed)vdc.regs[23]) {
+    if (vdc_line->regs[25] & 0x40) {  /* Attribute mode - background colour from regs[26] but foreground from attribute ram */
+        table_ptr = hr_table + ((vdc_line->regs[26] & 0x0F) << 4);    /* regs[26] & 0xF is the background colour */
+        pdl_ptr = pdl_table + ((vdc_line->regs[26] & 0x0F) << 4);
+        pdh_ptr = pdh_table + ((vdc_line->regs[26] & 0x0F) << 4);
+        for (i = 0; i < vdc_line->screen_text_cols; i++, p += vdc_line->charwidth) {
+            if (vdc.raster.ycounter > (signed)vdc_line->regs[23]) {
                 /* Return nothing if > Vertical Character Size */
                 d = 0x00;
             } else {
                 d = vdc_ram_read(char_index
-                  + ((*(attr_ptr + i) & VDC_ALTCHARSET_ATTR) ? 0x100 * vdc.bytes_per_char : 0) /* the offset to the alternate character set is either 0x1000 or 0x2000, depending on the character size (16 or 32) */
-                  + (*(screen_ptr + i) * vdc.bytes_per_char));
+                  + ((*(attr_ptr + i) & VDC_ALTCHARSET_ATTR) ? 0x100 * vdc_line->bytes_per_char : 0) /* the offset to the alternate character set is either 0x1000 or 0x2000, depending on the character size (16 or 32) */
+                  + (*(screen_ptr + i) * vdc_line->bytes_per_char));
             }
             d &= dmask; /* mask off to active pixels only */
             d2 = 0x00;
 
             /* set underline if the underline attrib is set for this char */
             /* Pixels per char does not apply to the underline but the underline does blink, reverse and extend through inter-character spacing */
-            if ((vdc.raster.ycounter == vdc.regs[29]) && (*(attr_ptr + i) & VDC_UNDERLINE_ATTR)) {
+            if ((vdc.raster.ycounter == vdc_line->regs[29]) && (*(attr_ptr + i) & VDC_UNDERLINE_ATTR)) {
                 d = 0xFF;
                 d2 = 0xFF;
             }
 
             /* blink if the blink attribute is set for this char */
-            if (vdc.attribute_blink && (*(attr_ptr + i) & VDC_FLASH_ATTR)) {
+            if (vdc_line->attribute_blink && (*(attr_ptr + i) & VDC_FLASH_ATTR)) {
                 d = 0x00;
                 d2 = 0x00;
             }
@@ -734,12 +738,12 @@ static void draw_std_text(void)
             }
 
             if (cpos == i) { /* handle cursor if this is the cursor */
-                if ((vdc.frame_counter | 1) & crsrblink[(vdc.regs[10] >> 5) & 3]) {
+                if ((vdc_line->frame_counter | 1) & crsrblink[(vdc_line->regs[10] >> 5) & 3]) {
                     /* invert current byte of the character if we are within the cursor area */
                     if (
-                    ((vdc.raster.ycounter >= (vdc.regs[10] & 0x1F)) && (vdc.raster.ycounter < (vdc.regs[11] & 0x1F)))
-                    || ((vdc.raster.ycounter == (vdc.regs[10] & 0x1F)) && (vdc.raster.ycounter == (vdc.regs[11] & 0x1F)))
-                    || (((vdc.regs[10] & 0x1F) > (vdc.regs[11] & 0x1F)) && ((vdc.raster.ycounter >= (vdc.regs[10] & 0x1F)) || (vdc.raster.ycounter < (vdc.regs[11] & 0x1F))))
+                    ((vdc.raster.ycounter >= (vdc_line->regs[10] & 0x1F)) && (vdc.raster.ycounter < (vdc_line->regs[11] & 0x1F)))
+                    || ((vdc.raster.ycounter == (vdc_line->regs[10] & 0x1F)) && (vdc.raster.ycounter == (vdc_line->regs[11] & 0x1F)))
+                    || (((vdc_line->regs[10] & 0x1F) > (vdc_line->regs[11] & 0x1F)) && ((vdc.raster.ycounter >= (vdc_line->regs[10] & 0x1F)) || (vdc.raster.ycounter < (vdc_line->regs[11] & 0x1F))))
                     ) {
                         /* The VDC cursor reverses the char */
                         d ^= 0xFF;
@@ -748,7 +752,7 @@ static void draw_std_text(void)
                 }
             }
 
-            if (vdc.regs[24] & VDC_REVERSE_ATTR) { /* whole screen reverse */
+            if (vdc_line->regs[24] & VDC_REVERSE_ATTR) { /* whole screen reverse */
                 d ^= 0xFF;
                 d2 ^= 0xFF;
             }
@@ -756,7 +760,7 @@ static void draw_std_text(void)
             d2 &= d2mask;   /* Mask off any extra "on" pixels from the inter-character gap */
 
             /* actually render the byte into 8 bytes of colour pixels using the lookup tables */
-            if (vdc.regs[25] & 0x10) { /* double pixel mode */
+            if (vdc_line->regs[25] & 0x10) { /* double pixel mode */
                 uint32_t *pdwl = pdl_ptr + ((*(attr_ptr + i) & 0x0F) << 8);
                 uint32_t *pdwh = pdh_ptr + ((*(attr_ptr + i) & 0x0F) << 8);
                 *((uint32_t *)p) = *(pdwh + (d >> 4));
@@ -782,16 +786,16 @@ static void draw_std_text(void)
             }
         }
     } else {    /* Monochrome mode - foreground & background colours both from register 26 */
-        uint32_t *ptr = hr_table + (vdc.regs[26] << 4);
-        uint32_t *pdwl = pdl_table + (vdc.regs[26] << 4);  /* Pointers into the lookup tables */
-        uint32_t *pdwh = pdh_table + (vdc.regs[26] << 4);
-        for (i = 0; i < vdc.screen_text_cols; i++, p += vdc.charwidth) {
-            if (vdc.raster.ycounter > (signed)vdc.regs[23]) {
+        uint32_t *ptr = hr_table + (vdc_line->regs[26] << 4);
+        uint32_t *pdwl = pdl_table + (vdc_line->regs[26] << 4);  /* Pointers into the lookup tables */
+        uint32_t *pdwh = pdh_table + (vdc_line->regs[26] << 4);
+        for (i = 0; i < vdc_line->screen_text_cols; i++, p += vdc_line->charwidth) {
+            if (vdc.raster.ycounter > (signed)vdc_line->regs[23]) {
                 /* Return nothing if > Vertical Character Size */
                 d = 0x00;
             } else {
                 d = vdc_ram_read(char_index
-                  + (*(screen_ptr + i) * vdc.bytes_per_char));
+                  + (*(screen_ptr + i) * vdc_line->bytes_per_char));
             }
             d &= dmask; /* mask off to active pixels only */
             d2 = 0x00;
@@ -803,12 +807,12 @@ static void draw_std_text(void)
             }
 
             if (cpos == i) { /* handle cursor if this is the cursor */
-                if ((vdc.frame_counter | 1) & crsrblink[(vdc.regs[10] >> 5) & 3]) {
+                if ((vdc_line->frame_counter | 1) & crsrblink[(vdc_line->regs[10] >> 5) & 3]) {
                     /* invert current byte of the character if we are within the cursor area */
                     if (
-                    ((vdc.raster.ycounter >= (vdc.regs[10] & 0x1F)) && (vdc.raster.ycounter < (vdc.regs[11] & 0x1F)))
-                    || ((vdc.raster.ycounter == (vdc.regs[10] & 0x1F)) && (vdc.raster.ycounter == (vdc.regs[11] & 0x1F)))
-                    || (((vdc.regs[10] & 0x1F) > (vdc.regs[11] & 0x1F)) && ((vdc.raster.ycounter >= (vdc.regs[10] & 0x1F)) || (vdc.raster.ycounter < (vdc.regs[11] & 0x1F))))
+                    ((vdc.raster.ycounter >= (vdc_line->regs[10] & 0x1F)) && (vdc.raster.ycounter < (vdc_line->regs[11] & 0x1F)))
+                    || ((vdc.raster.ycounter == (vdc_line->regs[10] & 0x1F)) && (vdc.raster.ycounter == (vdc_line->regs[11] & 0x1F)))
+                    || (((vdc_line->regs[10] & 0x1F) > (vdc_line->regs[11] & 0x1F)) && ((vdc.raster.ycounter >= (vdc_line->regs[10] & 0x1F)) || (vdc.raster.ycounter < (vdc_line->regs[11] & 0x1F))))
                     ) {
                         /* The VDC cursor reverses the char */
                         d ^= 0xFF;
@@ -817,7 +821,7 @@ static void draw_std_text(void)
                 }
             }
 
-            if (vdc.regs[24] & VDC_REVERSE_ATTR) { /* whole screen reverse */
+            if (vdc_line->regs[24] & VDC_REVERSE_ATTR) { /* whole screen reverse */
                 d ^= 0xFF;
                 d2 ^= 0xFF;
             }
@@ -825,7 +829,7 @@ static void draw_std_text(void)
             d2 &= d2mask;   /* Mask off any extra "on" pixels from the inter-character gap */
 
             /* actually render the byte into 8 bytes of colour pixels using the lookup tables */
-            if (vdc.regs[25] & 0x10) { /* double pixel mode */
+            if (vdc_line->regs[25] & 0x10) { /* double pixel mode */
                 *((uint32_t *)p) = *(pdwh + (d >> 4));
                 *((uint32_t *)p + 1) = *(pdwl + (d >> 4));
                 *((uint32_t *)p + 2) = *(pdwh + (d & 0x0F));
@@ -849,8 +853,8 @@ static void draw_std_text(void)
         }
     }
     /* fill the last few pixels of the display with bg colour if smooth scroll != 0 */
-    for (i = vdc.xsmooth; i < (unsigned)(vdc.regs[22] >> 4); i++, p++) {
-        *p = (vdc.regs[26] & 0x0F);
+    for (i = vdc_line->xsmooth; i < (unsigned)(vdc_line->regs[22] >> 4); i++, p++) {
+        *p = (vdc_line->regs[26] & 0x0F);
     }
 }
 
@@ -863,26 +867,26 @@ static int get_std_bitmap(raster_cache_t *cache, unsigned int *xs,
     int r;
 
     r = cache_data_fill(cache->foreground_data,
-                        vdc.ram + vdc.screen_adr + vdc.bitmap_counter,
-                        vdc.screen_text_cols + 1,
+                        vdc_line->ram + vdc_line->screen_adr + vdc_line->bitmap_counter,
+                        vdc_line->screen_text_cols + 1,
                         1,
                         xs, xe,
                         rr,
-                        (vdc.regs[24] & VDC_REVERSE_ATTR) ? 0xff : 0x0);
+                        (vdc_line->regs[24] & VDC_REVERSE_ATTR) ? 0xff : 0x0);
 
-    if (vdc.regs[25] & 0x40) {
+    if (vdc_line->regs[25] & 0x40) {
         /* attribute mode */
         r |= raster_cache_data_fill(cache->color_data_1,
-                                    vdc.ram + vdc.attribute_adr
-                                    + vdc.mem_counter,
-                                    vdc.screen_text_cols + 1,
+                                    vdc_line->ram + vdc_line->attribute_adr
+                                    + vdc_line->mem_counter,
+                                    vdc_line->screen_text_cols + 1,
                                     xs, xe,
                                     rr);
     } else {
         /* monochrome mode - attributes from register 26 */
         r |= raster_cache_data_fill_const(cache->color_data_1,
-                                          (uint8_t)(vdc.regs[26] >> 4),
-                                          (int)vdc.screen_text_cols + 1,
+                                          (uint8_t)(vdc_line->regs[26] >> 4),
+                                          (int)vdc_line->screen_text_cols + 1,
                                           xs, xe,
                                           rr);
     }
@@ -899,17 +903,17 @@ static void draw_std_bitmap_cached(raster_cache_t *cache, unsigned int xs,
 
     unsigned int i, d, j, fg, bg;
     p = vdc.raster.draw_buffer_ptr
-        + vdc.border_width
-        + ((vdc.regs[25] & 0x10) ? 2 : 0)
-        + vdc.xsmooth * ((vdc.regs[25] & 0x10) ? 2 : 1)
-        - (vdc.regs[22] >> 4) * ((vdc.regs[25] & 0x10) ? 2 : 1)
-        + xs * vdc.charwidth;
+        + vdc_line->border_width
+        + ((vdc_line->regs[25] & 0x10) ? 2 : 0)
+        + vdc_line->xsmooth * ((vdc_line->regs[25] & 0x10) ? 2 : 1)
+        - (vdc_line->regs[22] >> 4) * ((vdc_line->regs[25] & 0x10) ? 2 : 1)
+        + xs * vdc_line->charwidth;
 
     /* TODO: See if we even need to split these renderers between attr/mono, because the attr data is filled either way. draw_std_text_cached mode() doesn't differentiate */
-    if (vdc.regs[25] & 0x40) {
+    if (vdc_line->regs[25] & 0x40) {
         /* attribute mode */
-        if (vdc.regs[25] & 0x10) { /* double pixel mode */
-            for (i = xs; i <= (unsigned int)xe; i++, p += vdc.charwidth) {
+        if (vdc_line->regs[25] & 0x10) { /* double pixel mode */
+            for (i = xs; i <= (unsigned int)xe; i++, p += vdc_line->charwidth) {
                 d = cache->foreground_data[i];
                 pdwl = pdl_table + ((cache->color_data_1[i] & 0x0f) << 8) + (cache->color_data_1[i] & 0xf0);
                 pdwh = pdh_table + ((cache->color_data_1[i] & 0x0f) << 8) + (cache->color_data_1[i] & 0xf0);
@@ -919,7 +923,7 @@ static void draw_std_bitmap_cached(raster_cache_t *cache, unsigned int xs,
                 *((uint32_t *)p + 3) = *(pdwl + (d & 0x0f));
             }
         } else { /* normal text size */
-            for (i = xs; i <= (unsigned int)xe; i++, p += vdc.charwidth) {
+            for (i = xs; i <= (unsigned int)xe; i++, p += vdc_line->charwidth) {
                 d = cache->foreground_data[i];
 
                 table_ptr = hr_table + (cache->color_data_1[i] & 0xf0);
@@ -931,11 +935,11 @@ static void draw_std_bitmap_cached(raster_cache_t *cache, unsigned int xs,
         }
     } else {
         /* monochrome mode - attributes from register 26 */
-        if (vdc.regs[25] & 0x10) { /* double pixel mode */
-            pdl_ptr = pdl_table + ((vdc.regs[26] & 0x0f) << 4);
-            pdh_ptr = pdh_table + ((vdc.regs[26] & 0x0f) << 4);
+        if (vdc_line->regs[25] & 0x10) { /* double pixel mode */
+            pdl_ptr = pdl_table + ((vdc_line->regs[26] & 0x0f) << 4);
+            pdh_ptr = pdh_table + ((vdc_line->regs[26] & 0x0f) << 4);
 
-            for (i = xs; i <= (unsigned int)xe; i++, p += vdc.charwidth) {
+            for (i = xs; i <= (unsigned int)xe; i++, p += vdc_line->charwidth) {
                 d = cache->foreground_data[i];
                 pdwl = pdl_ptr + ((cache->color_data_1[i] & 0x0f) << 8);
                 pdwh = pdh_ptr + ((cache->color_data_1[i] & 0x0f) << 8);
@@ -945,9 +949,9 @@ static void draw_std_bitmap_cached(raster_cache_t *cache, unsigned int xs,
                 *((uint32_t *)p + 3) = *(pdwl + (d & 0x0f));
             }
         } else { /* normal text size */
-            table_ptr = hr_table + ((vdc.regs[26] & 0x0f) << 4);
+            table_ptr = hr_table + ((vdc_line->regs[26] & 0x0f) << 4);
 
-            for (i = xs; i <= (unsigned int)xe; i++, p += vdc.charwidth) {
+            for (i = xs; i <= (unsigned int)xe; i++, p += vdc_line->charwidth) {
                 d = cache->foreground_data[i];
 
                 ptr = table_ptr + ((cache->color_data_1[i] & 0x0f) << 8);
@@ -960,20 +964,20 @@ static void draw_std_bitmap_cached(raster_cache_t *cache, unsigned int xs,
 
     /* fill the last few pixels of the display with bg colour if xsmooth scroll != maximum  */
     d = cache->foreground_data[i];
-    if (vdc.regs[24] & VDC_REVERSE_ATTR) {
+    if (vdc_line->regs[24] & VDC_REVERSE_ATTR) {
         /* reverse screen bit */
         d ^= 0xff;
     }
-    if (vdc.regs[25] & 0x40) {
+    if (vdc_line->regs[25] & 0x40) {
         /* attribute mode */
         fg = cache->color_data_1[i] >> 4;
         bg = cache->color_data_1[i] & 0x0F;
     } else {
         /* monochrome mode - attributes from register 26 */
-        bg = vdc.regs[26] & 0x0F;
-        fg = vdc.regs[26] >> 4;
+        bg = vdc_line->regs[26] & 0x0F;
+        fg = vdc_line->regs[26] >> 4;
     }
-    for (i = vdc.xsmooth, j = 0x80; i < (unsigned)(vdc.regs[22] >> 4); i++, p++, j >>= 1) {
+    for (i = vdc_line->xsmooth, j = 0x80; i < (unsigned)(vdc_line->regs[22] >> 4); i++, p++, j >>= 1) {
         if (d & j) {
             /* foreground */
             *p = fg;
@@ -989,49 +993,49 @@ static void draw_std_bitmap(void)
    See draw_std_text(), this is for bitmap mode. */
 {
     uint8_t *p, *q;
-    uint8_t *attr_ptr;
+    const uint8_t *attr_ptr;
 
     unsigned int i, d, d2, j, fg, bg, bitmap_index;
     int icsi = -1;  /* Inter Character Spacing Index - used as a combo flag/index as to whether there is any intercharacter gap to render */
 
-    if(vdc.regs[25] & 0x10) { /* double pixel a.k.a 40column mode */
-        if (vdc.charwidth > 16) {   /* Is there inter character spacing to render? */
-            icsi = vdc.charwidth / 2 - 8;
+    if(vdc_line->regs[25] & 0x10) { /* double pixel a.k.a 40column mode */
+        if (vdc_line->charwidth > 16) {   /* Is there inter character spacing to render? */
+            icsi = vdc_line->charwidth / 2 - 8;
         }
     } else { /* 80 column mode */
-        if (vdc.charwidth > 8) {    /* Is there inter character spacing to render? */
-            icsi = vdc.charwidth - 8;
+        if (vdc_line->charwidth > 8) {    /* Is there inter character spacing to render? */
+            icsi = vdc_line->charwidth - 8;
         }
     }
 
     p = vdc.raster.draw_buffer_ptr
-        + vdc.border_width
-        + ((vdc.regs[25] & 0x10) ? 2 : 0)
-        + vdc.xsmooth * ((vdc.regs[25] & 0x10) ? 2 : 1)
-        - (vdc.regs[22] >> 4) * ((vdc.regs[25] & 0x10) ? 2 : 1);
+        + vdc_line->border_width
+        + ((vdc_line->regs[25] & 0x10) ? 2 : 0)
+        + vdc_line->xsmooth * ((vdc_line->regs[25] & 0x10) ? 2 : 1)
+        - (vdc_line->regs[22] >> 4) * ((vdc_line->regs[25] & 0x10) ? 2 : 1);
 
-    /*attr_ptr = vdc.ram + ((vdc.attribute_adr + vdc.mem_counter) & vdc.vdc_address_mask);*/    /* keep pre-buffer pointer set-up for testing */
-    attr_ptr = &vdc.attrbuf[vdc.attrbufdraw];
-    bitmap_index = vdc.screen_adr + vdc.bitmap_counter;
+    /*attr_ptr = vdc_line->ram + ((vdc_line->attribute_adr + vdc_line->mem_counter) & vdc_line->vdc_address_mask);*/    /* keep pre-buffer pointer set-up for testing */
+    attr_ptr = &vdc_line->attrbuf[vdc_line->attrbufdraw];
+    bitmap_index = vdc_line->screen_adr + vdc_line->bitmap_counter;
 
     calculate_draw_masks();
 
-    for (i = 0; i < vdc.mem_counter_inc; i++, p += vdc.charwidth) {
+    for (i = 0; i < vdc_line->mem_counter_inc; i++, p += vdc_line->charwidth) {
         uint32_t *ptr, *pdwl, *pdwh;
 
-        if (vdc.regs[25] & 0x40) {
+        if (vdc_line->regs[25] & 0x40) {
             /* attribute mode */
             ptr = hr_table + (*(attr_ptr + i) & 0xf0) + ((*(attr_ptr + i) & 0x0f) << 8);
             pdwl = pdl_table + (*(attr_ptr + i) & 0xf0) + ((*(attr_ptr + i) & 0x0f) << 8);
             pdwh = pdh_table + (*(attr_ptr + i) & 0xf0) + ((*(attr_ptr + i) & 0x0f) << 8);
         } else {
             /* monochrome mode - attributes from register 26 */
-            ptr = hr_table + (vdc.regs[26] << 4);
-            pdwl = pdl_table + (vdc.regs[26] << 4);  /* Pointers into the lookup tables */
-            pdwh = pdh_table + (vdc.regs[26] << 4);
+            ptr = hr_table + (vdc_line->regs[26] << 4);
+            pdwl = pdl_table + (vdc_line->regs[26] << 4);  /* Pointers into the lookup tables */
+            pdwh = pdh_table + (vdc_line->regs[26] << 4);
         }
 
-        if (vdc.raster.ycounter > (signed)vdc.regs[23]) {
+        if (vdc.raster.ycounter > (signed)vdc_line->regs[23]) {
             /* Return nothing if > Vertical Character Size */
             d = 0x00;
         } else {
@@ -1046,7 +1050,7 @@ static void draw_std_bitmap(void)
             d2 = semi_gfx_type;  /* this will get masked off later on, so we just set all (or none) inter-char pixels on for now */
         }
 
-        if (vdc.regs[24] & VDC_REVERSE_ATTR) { /* whole screen reverse */
+        if (vdc_line->regs[24] & VDC_REVERSE_ATTR) { /* whole screen reverse */
             d ^= 0xff;
             d2 ^= 0xFF;
         }
@@ -1054,7 +1058,7 @@ static void draw_std_bitmap(void)
         d2 &= d2mask;   /* Mask off any extra "on" pixels from the inter-character gap */
 
         /* actually render the byte into 8 bytes of colour pixels using the lookup tables */
-        if (vdc.regs[25] & 0x10) { /* double pixel mode */
+        if (vdc_line->regs[25] & 0x10) { /* double pixel mode */
             *((uint32_t *)p) = *(pdwh + (d >> 4));
             *((uint32_t *)p + 1) = *(pdwl + (d >> 4));
             *((uint32_t *)p + 2) = *(pdwh + (d & 0x0f));
@@ -1079,19 +1083,19 @@ static void draw_std_bitmap(void)
 
     /* fill the last few pixels of the display with bg colour if xsmooth scroll != maximum  */
     d = vdc_ram_read(bitmap_index + i); /* grab the data byte from the bitmap */
-    if (vdc.regs[24] & VDC_REVERSE_ATTR) { /* reverse screen bit */
+    if (vdc_line->regs[24] & VDC_REVERSE_ATTR) { /* reverse screen bit */
         d ^= 0xff;
     }
-    if (vdc.regs[25] & 0x40) {
+    if (vdc_line->regs[25] & 0x40) {
         /* attribute mode */
         fg = *(attr_ptr + i) >> 4;
         bg = *(attr_ptr + i) & 0x0F;
     } else {
         /* monochrome mode - attributes from register 26 */
-        fg = vdc.regs[26] >> 4;
-        bg = vdc.regs[26] & 0x0F;
+        fg = vdc_line->regs[26] >> 4;
+        bg = vdc_line->regs[26] & 0x0F;
     }
-    for (i = vdc.xsmooth, j = 0x80; i < (unsigned)(vdc.regs[22] >> 4); i++, p++, j >>= 1) {
+    for (i = vdc_line->xsmooth, j = 0x80; i < (unsigned)(vdc_line->regs[22] >> 4); i++, p++, j >>= 1) {
         if (d & j) {
             /* foreground */
             *p = fg;
@@ -1106,10 +1110,10 @@ static int get_idle(raster_cache_t *cache, unsigned int *xs, unsigned int *xe,
                     int rr)
 /* aka raster_modes_fill_cache() in raster */
 {
-    if (rr || (vdc.regs[26] >> 4) != cache->color_data_1[0]) {
+    if (rr || (vdc_line->regs[26] >> 4) != cache->color_data_1[0]) {
         *xs = 0;
-        *xe = vdc.screen_text_cols;
-        cache->color_data_1[0] = vdc.regs[26] >> 4;
+        *xe = vdc_line->screen_text_cols;
+        cache->color_data_1[0] = vdc_line->regs[26] >> 4;
         return 1;
     }
 
@@ -1125,7 +1129,7 @@ static void draw_idle_cached(raster_cache_t *cache, unsigned int xs,
 
     unsigned int i;
 
-    p = vdc.raster.draw_buffer_ptr + vdc.border_width
+    p = vdc.raster.draw_buffer_ptr + vdc_line->border_width
         + vdc.raster.xsmooth + xs * 8;
 
     idleval = *(hr_table + ((cache->color_data_1[0] & 0x0f) << 8));
@@ -1144,16 +1148,16 @@ static void draw_idle(void)
 
     unsigned int i;
 
-    p = vdc.raster.draw_buffer_ptr + vdc.border_width
+    p = vdc.raster.draw_buffer_ptr + vdc_line->border_width
         + vdc.raster.xsmooth;
 
     /* border colour is just the screen background colour from reg 26 bits 0-3 */
-    idleval = *(hr_table + ((vdc.regs[26] & 0x0f) << 4));
+    idleval = *(hr_table + ((vdc_line->regs[26] & 0x0f) << 4));
 
-    for (i = 0; i < vdc.mem_counter_inc; i++, p += ((vdc.regs[25] & 0x10) ? 16 : 8)) {
+    for (i = 0; i < vdc_line->mem_counter_inc; i++, p += ((vdc_line->regs[25] & 0x10) ? 16 : 8)) {
         *((uint32_t *)p) = idleval;
         *((uint32_t *)p + 1) = idleval;
-        if (vdc.regs[25] & 0x10) { /* double pixel mode */
+        if (vdc_line->regs[25] & 0x10) { /* double pixel mode */
             *((uint32_t *)p + 2) = idleval;
             *((uint32_t *)p + 3) = idleval;
         }
@@ -1191,3 +1195,25 @@ void vdc_draw_init(void)
 
     setup_modes();
 }
+
+/* Draw a raster line from the state recorded when it ended. This is called
+   either by the raster alarm handler or by the render thread.  */
+void vdc_draw_line(const vdc_line_state_t *state)
+{
+    vdc_line = state;
+
+    vdc.raster.video_mode = state->video_mode;
+    vdc.raster.ycounter = state->ycounter;
+    if (state->blank_this_line) {
+        vdc.raster.blank_this_line = 1;
+    }
+    if (state->border_color >= 0) {
+        vdc.raster.border_color = (unsigned int)state->border_color;
+    }
+    if (state->xsmooth_reset) {
+        vdc.raster.xsmooth = 0;
+    }
+    vdc.raster.xsmooth_color += (int)state->xsmooth_color_inc;
+
+    raster_line_emulate(&vdc.raster);
+}
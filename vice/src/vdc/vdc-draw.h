@@ -29,6 +29,9 @@
 #ifndef VICE_VDC_DRAW_H
 #define VICE_VDC_DRAW_H
 
+struct vdc_line_state_s;
+
 void vdc_draw_init(void);
+void vdc_draw_line(const struct vdc_line_state_s *state);
 
 #endif
@@ -39,6 +39,7 @@
 #include "maincpu.h"
 #include "monitor.h"
 #include "types.h"
+#include "vdc-async.h"
 #include "vdc-mem.h"
 #include "vdc.h"
 #include "vdctypes.h"
@@ -160,6 +161,8 @@ void vdc_store(uint16_t addr, uint8_t value)
     vdc.regs[vdc.update_reg] = value;
 
 #ifdef REG_DEBUG
+    /* the dump reads the raster line, which the render thread may be using */
+    vdc_async_sync();
     switch (vdc.update_reg) {
         case 10:
         case 11:
@@ -268,6 +271,7 @@ void vdc_store(uint16_t addr, uint8_t value)
             break;
 
         case 8:                 /* R08  Interlace and Skew */
+            vdc_async_sync();
             if ((vdc.regs[8] & 0x03) == 3)  {   /* interlace sync and video */
                 vdc.interlaced = 1;
                 vdc.raster.canvas->videoconfig->interlaced = 1;
@@ -391,13 +395,13 @@ void vdc_store(uint16_t addr, uint8_t value)
                     /* v1/2 VDC, incrementing HSS moves screen to the right */
                     vdc.xsmooth = (vdc.regs[25] & 0x0F);
                 }
-                vdc.raster.xsmooth = 0;
+                vdc.pending_xsmooth_reset = 1;
                 /* Hack to get the line redrawn because we are not actually using the xsmooth in raster
                 (so the xsmooth color is irrelevant, but changing it still forces a repaint of the line) */
-                vdc.raster.xsmooth_color++;
+                vdc.pending_xsmooth_color_inc++;
 #else
                 vdc.xsmooth = (vdc.regs[22] >> 4) - ((vdc.regs[25] & 0x10) ? 1 : 0);
-                vdc.raster.xsmooth = 0;
+                vdc.pending_xsmooth_reset = 1;
 #endif
             }
             if ((vdc.regs[25] & 0x10u) != (oldval & 0x10u)) {
@@ -444,7 +448,7 @@ void vdc_store(uint16_t addr, uint8_t value)
                      vdc.raster.xsmooth_color = vdc.regs[26] & 0x0F; */
                 /* Set the xsmooth area too for the 0-7pixel gap between border & foreground */
 
-                vdc.raster.border_color = (vdc.regs[26] & 0x0F);
+                vdc.pending_border_color = (vdc.regs[26] & 0x0F);
             }
 #ifdef REG_DEBUG
             log_message(vdc.log, "Color register %x.", vdc.regs[26]);
@@ -454,7 +458,7 @@ void vdc_store(uint16_t addr, uint8_t value)
         case 27:                /* R27  Row/Adrs. Increment */
             /* We need to redraw the current line if this changes,
             as cache will be wrong. Uses xsmooth_color hack (see reg 25) */
-            vdc.raster.xsmooth_color++;
+            vdc.pending_xsmooth_color_inc++;
             vdc.skip_after_line = vdc.regs[27];
             /* emulate quirk of v0, where 0 means 0 and all other values mean one more! */
             if ((vdc.revision == VDC_REVISION_0) && (vdc.regs[27])) {
@@ -648,23 +652,31 @@ uint8_t vdc_ram_read(uint16_t addr)
 
 void vdc_ram_store(uint16_t addr, uint8_t value)
 {   /* as above but for storing to VDC ram with appropriate address translation*/
+    unsigned int index;
+
     if (vdc.regs[28] & 0x10) {
         if (vdc_resources.vdc_64kb_expansion) {
             /* 64KB addressing, 4464 chips 64KB */
-            vdc.ram[addr] = value;
+            index = addr;
         } else {
             /* 64KB addressing, 4416 chips 16KB */
-            vdc.ram[vdc_64k_to_16k_map(addr)] = value;
+            index = vdc_64k_to_16k_map(addr);
         }
     } else {
         if (vdc_resources.vdc_64kb_expansion) {
             /* 16KB addressing, 4464 chips 64KB */
-            vdc.ram[vdc_16k_to_64k_map(addr)] = value;
+            index = vdc_16k_to_64k_map(addr);
         } else {
             /* 16KB addressing, 4416 chips 16KB */
-            vdc.ram[addr & 0x3fff] = value;
+            index = addr & 0x3fff;
         }
     }
+    vdc.ram[index] = value;
+
+    /* the render thread draws from its own copy */
+    if (vdc_async_draw_active) {
+        vdc_async_ram_store(index, value);
+    }
 }
 
 
@@ -672,6 +684,8 @@ int vdc_dump(void)
 {
     unsigned int r, c, regnum=0, location, size;
 
+    vdc_async_sync();
+
     /* Dump the internal VDC registers */
     mon_out("VDC Internal Registers:\n");
     for (r = 0; r < 3; r++) {
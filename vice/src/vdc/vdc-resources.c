@@ -42,6 +42,7 @@
 #include "raster-resources.h"
 #include "resources.h"
 #include "vdc.h"
+#include "vdc-async.h"
 #include "vdc-resources.h"
 #include "vdctypes.h"
 #include "video.h"
@@ -105,6 +106,17 @@ static int set_stretch(int val, void *param)
     return 0;
 }
 
+static int set_async_draw(int val, void *param)
+{
+    val = val ? 1 : 0;
+
+    if (vdc_async_draw_enable(val) < 0) {
+        return -1;
+    }
+    vdc_resources.async_draw = val;
+    return 0;
+}
+
 static const resource_int_t resources_int[] =
 {
     { "VDC64KB", 1, RES_EVENT_SAME, NULL,
@@ -113,6 +125,8 @@ static const resource_int_t resources_int[] =
       (int *)&vdc.revision, set_vdc_revision, NULL },
     { "VDCStretchVertical", 1, RES_EVENT_SAME, NULL,
       &vdc_resources.stretchy, set_stretch, NULL },
+    { "VDCAsyncDraw", 0, RES_EVENT_NO, NULL,
+      &vdc_resources.async_draw, set_async_draw, NULL },
     RESOURCE_INT_LIST_END
 };
 
@@ -31,6 +31,7 @@
 struct vdc_resources_s {
     int vdc_64kb_expansion; /* Flag: VDC memory size.  */
     int stretchy;           /* additional doubling of y size */
+    int async_draw;         /* draw the raster lines on a separate thread */
 };
 typedef struct vdc_resources_s vdc_resources_t;
 
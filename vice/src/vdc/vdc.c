@@ -46,6 +46,7 @@
 #include "screenshot.h"
 #include "snapshot.h"
 #include "types.h"
+#include "vdc-async.h"
 #include "vdc-cmdline-options.h"
 #include "vdc-color.h"
 #include "vdc-draw.h"
@@ -316,6 +317,8 @@ static void vdc_update_geometry(void)
 void vdc_reset(void)
 {
     int video;
+
+    vdc_async_sync();
     if (vdc.initialized) {
         raster_reset(&vdc.raster);
     }
@@ -368,9 +371,13 @@ void vdc_powerup(void)
         vdc.ram[i] = v;
         v ^= 0xff;
     }
+    vdc_async_ram_reload();
     memset(vdc.regs, 0, sizeof(vdc.regs));
     vdc.mem_counter = 0;
     vdc.mem_counter_inc = 0;
+    vdc.pending_border_color = -1;
+    vdc.pending_xsmooth_reset = 0;
+    vdc.pending_xsmooth_color_inc = 0;
 
     vdc.screen_xpix = VDC_SCREEN_XPIX;
     vdc.first_displayed_line = VDC_FIRST_DISPLAYED_LINE;
@@ -451,14 +458,44 @@ static void vdc_increment_memory_pointer_interlace_bitmap(void)
 }
 #endif
 
-static void vdc_set_video_mode(void)
+static int vdc_get_video_mode(void)
 {
-    vdc.raster.video_mode = (vdc.regs[25] & 0x80)
-                            ? VDC_BITMAP_MODE : VDC_TEXT_MODE;
-
     if (vdc.draw_counter_y > (unsigned int)(vdc.regs[9] & 0x1f)) {
-        vdc.raster.video_mode = VDC_IDLE_MODE;
+        return VDC_IDLE_MODE;
     }
+    return (vdc.regs[25] & 0x80) ? VDC_BITMAP_MODE : VDC_TEXT_MODE;
+}
+
+/* Record what the drawing code needs to know about the current line.  */
+static void vdc_fill_line_state(vdc_line_state_t *state)
+{
+    memcpy(state->regs, vdc.regs, sizeof(state->regs));
+    state->ram = vdc.ram;
+    state->screen_text_cols = vdc.screen_text_cols;
+    state->screen_adr = vdc.screen_adr;
+    state->attribute_adr = vdc.attribute_adr;
+    state->chargen_adr = vdc.chargen_adr;
+    state->mem_counter = vdc.mem_counter;
+    state->mem_counter_inc = vdc.mem_counter_inc;
+    state->bitmap_counter = vdc.bitmap_counter;
+    state->bytes_per_char = vdc.bytes_per_char;
+    state->charwidth = vdc.charwidth;
+    state->border_width = vdc.border_width;
+    state->xsmooth = vdc.xsmooth;
+    state->vdc_address_mask = vdc.vdc_address_mask;
+    state->frame_counter = vdc.frame_counter;
+    state->attribute_blink = vdc.attribute_blink;
+    state->crsrpos = vdc.crsrpos;
+    state->attrbufdraw = vdc.attrbufdraw;
+    memcpy(state->scrnbuf, vdc.scrnbuf, sizeof(state->scrnbuf));
+    memcpy(state->attrbuf, vdc.attrbuf, sizeof(state->attrbuf));
+
+    state->border_color = vdc.pending_border_color;
+    state->xsmooth_reset = vdc.pending_xsmooth_reset;
+    state->xsmooth_color_inc = vdc.pending_xsmooth_color_inc;
+    vdc.pending_border_color = -1;
+    vdc.pending_xsmooth_reset = 0;
+    vdc.pending_xsmooth_color_inc = 0;
 }
 
 
@@ -472,6 +509,9 @@ static void vdc_set_video_mode(void)
 static void vdc_raster_draw_alarm_handler(CLOCK offset, void *data)
 {
     unsigned int i, j;
+    int video_mode, blank_this_line = 0;
+    vdc_line_state_t *state;
+    static vdc_line_state_t line_state;
     static unsigned int vdc_row_counter_latch = 0;
     static unsigned int vdc_draw_counter_latch = 0;
     static unsigned int vdc_vert_fine_adj = 0;
@@ -558,6 +598,7 @@ static void vdc_raster_draw_alarm_handler(CLOCK offset, void *data)
 
         /* check if we've hit the vsync position and should start vsync */
         if (vdc.row_counter == vdc.regs[7]) {
+            vdc_async_sync();
             vdc.vsync = 1;
             vdc.vsync_counter = 0;
 /*
@@ -618,6 +659,7 @@ static void vdc_raster_draw_alarm_handler(CLOCK offset, void *data)
         vdc.vsync_counter++;
         /* Check if we are now out of the pulse == at first visible raster line, and reset the raster to the top of the screen if so */
         if (vdc.vsync_counter > vdc.vsync_height) { /* 25 for PAL, 21 for NTSC seems to be about right # of raster lines the vsync consumes on a C= monitor, and is official PAL spec */
+            vdc_async_sync();
             vdc.vsync = 0;
             /* printf("vdc.raster.current_line: %03u vdc.canvas_height_old: %03u ", vdc.raster.current_line, vdc.canvas_height_old); */
 
@@ -793,36 +835,35 @@ static void vdc_raster_draw_alarm_handler(CLOCK offset, void *data)
            Implied: vdc.prime_draw == 0 && vdc.draw_active == 0 */
         vdc_draw_counter_latch = 0;
     }
-    vdc.raster.ycounter = vdc.draw_counter_y;   /* FIXME quick hack. maybe just use ycounter in the first place? Check side effects with memory inc functions */
     /*  END drawing section ----------------------------------------------------------------------------------------------------------------*/
 
 
     /* Decide if the current raster line is visible or not and set draw mode appropriately */
     if (vdc.vsync) {    /* no, we're in vsync */
         /*FIXME change this to always black or some other mode so it works more obviously that you're in vsync vs in the border and make sure it restarts drawing past the pulse */
-        vdc.raster.video_mode = VDC_IDLE_MODE;
+        video_mode = VDC_IDLE_MODE;
     } else if ( ((vdc.regs[25] & 0x0F) > ((vdc.regs[22] >> 4) & 0x0F)) ||    /* smooth scroll is > char with */
                 ((vdc.regs[25] & 0x10) && ((vdc.regs[25] & 0x0F) == ((vdc.regs[22] >> 4) & 0x0F))) ) { /* or double-pixel/40-column mode and smooth scroll = char width */
         /*FIXME technically this should be black in the foreground area (border remains normal), not just border colour all the way across */
-        vdc.raster.video_mode = VDC_IDLE_MODE;
+        video_mode = VDC_IDLE_MODE;
     } else if ( ((vdc.regs[34] > vdc.regs[0]) && (vdc.regs[35] <= vdc.regs[0])) ||      /* if #34> #0  and #35 <= #0, blank line, always */
                 ((vdc.regs[34] == vdc.regs[35]) && (vdc.regs[35] <= vdc.regs[0])) ) {   /* if #34==#35 and both <= #0, blank line always */
                 /* || ((vdc.regs[34] <= vdc.regs[35]) && (vdc.regs[35] <= vdc.regs[0])) ) {*/ /* FIXME if #34<=#35 and both <= #0, blank line sometimes, depends on values relative to display area */
         /*FIXME technically this should be black across the entire screen, not just border colour */
-        vdc.raster.video_mode = VDC_IDLE_MODE;
+        video_mode = VDC_IDLE_MODE;
     } else if ( vdc.charwidth < 8 ) {   /* can't do less than 8pixels wide in 80col or 4 pixels wide in 40col mode, both of which this covers */
-        vdc.raster.video_mode = VDC_IDLE_MODE;
+        video_mode = VDC_IDLE_MODE;
     } else if (vdc.draw_active && vdc.display_enable) {
-        vdc_set_video_mode();   /* show stuff */
+        video_mode = vdc_get_video_mode();   /* show stuff */
     } else {
-        vdc.raster.video_mode = VDC_IDLE_MODE;  /* fall through for remaining combinations */
+        video_mode = VDC_IDLE_MODE;  /* fall through for remaining combinations */
     }
 
 
     /* FIXME this is a hack to get the "background" between the "left and right" top & bottom border areas actually drawn when the cache is on.
         Strongly suspect raster code is broken at this point, or at least confused, as it always draws black even though the colours are set.. */
     if (vdc.raster.cache_enabled && !vdc.display_enable) {
-        vdc.raster.blank_this_line = 1;
+        blank_this_line = 1;
     }
 
     /* fill the non-draw buffers for the next character row during the start of the current one */
@@ -841,8 +882,17 @@ static void vdc_raster_draw_alarm_handler(CLOCK offset, void *data)
         vdc.draw_counter, vdc.draw_counter_y, vdc.raster.current_line, vdc.draw_active, vdc.vsync, vdc.mem_counter, vdc.bitmap_counter,
         (vdc.attribute_adr + vdc.mem_counter) & vdc.vdc_address_mask, (vdc.screen_adr + vdc.bitmap_counter) & vdc.vdc_address_mask, vdc.frame_counter); */
 
-    /* actually draw the current raster line */
-    raster_line_emulate(&vdc.raster);
+    /* actually draw the current raster line, or have the render thread do it */
+    state = vdc_async_draw_active ? vdc_async_line_begin() : &line_state;
+    vdc_fill_line_state(state);
+    state->video_mode = video_mode;
+    state->ycounter = vdc.draw_counter_y;   /* FIXME quick hack. maybe just use ycounter in the first place? Check side effects with memory inc functions */
+    state->blank_this_line = blank_this_line;
+    if (vdc_async_draw_active) {
+        vdc_async_line_end();
+    } else {
+        vdc_draw_line(state);
+    }
 
 
     vdc_set_next_alarm(offset);
@@ -863,6 +913,7 @@ void vdc_calculate_xsync(void)
 
 void vdc_set_canvas_refresh(int enable)
 {
+    vdc_async_sync();
     raster_set_canvas_refresh(&vdc.raster, enable);
 }
 
@@ -878,6 +929,7 @@ int vdc_read_snapshot_module(snapshot_t *s)
 
 void vdc_screenshot(screenshot_t *screenshot)
 {
+    vdc_async_sync();
     raster_screenshot(&vdc.raster, screenshot);
     screenshot->chipid = "VDC";
     screenshot->video_regs = vdc.regs;
@@ -891,10 +943,12 @@ void vdc_screenshot(screenshot_t *screenshot)
 
 void vdc_async_refresh(struct canvas_refresh_s *refresh)
 {
+    vdc_async_sync();
     raster_async_refresh(&vdc.raster, refresh);
 }
 
 void vdc_shutdown(void)
 {
+    vdc_async_draw_enable(0);
     raster_shutdown(&vdc.raster);
 }
@@ -85,6 +85,40 @@ struct vdc_light_pen_s {
 };
 typedef struct vdc_light_pen_s vdc_light_pen_t;
 
+/* Everything the drawing code needs to know about a raster line, recorded
+   when the line ends.  */
+struct vdc_line_state_s {
+    uint8_t regs[64];
+    uint8_t *ram;
+    unsigned int screen_text_cols;
+    unsigned int screen_adr;
+    unsigned int attribute_adr;
+    unsigned int chargen_adr;
+    unsigned int mem_counter;
+    unsigned int mem_counter_inc;
+    unsigned int bitmap_counter;
+    unsigned int bytes_per_char;
+    unsigned int charwidth;
+    unsigned int border_width;
+    unsigned int xsmooth;
+    int vdc_address_mask;
+    int frame_counter;
+    int attribute_blink;
+    int crsrpos;
+    unsigned int attrbufdraw;
+    uint8_t scrnbuf[0x200];
+    uint8_t attrbuf[0x200];
+
+    /* Raster state for the line.  */
+    int video_mode;
+    unsigned int ycounter;
+    int blank_this_line;
+    int border_color;               /* -1 if unchanged */
+    int xsmooth_reset;
+    unsigned int xsmooth_color_inc;
+};
+typedef struct vdc_line_state_s vdc_line_state_t;
+
 struct alarm_s;
 struct video_chip_cap_s;
 
@@ -255,6 +289,11 @@ struct vdc_s {
     unsigned int scrnbufdraw;
     uint8_t attrbuf[0x200];
     unsigned int attrbufdraw;
+
+    /* Raster changes from register writes, applied when the line is drawn */
+    int pending_border_color;       /* -1 if unchanged */
+    int pending_xsmooth_reset;
+    unsigned int pending_xsmooth_color_inc;
 };
 typedef struct vdc_s vdc_t;
 
@@ -215,6 +215,156 @@ static int vdrive_bam_get_interleave(vdrive_t *vdrive)
     }
 }
 
+/* ------------------------------------------------------------------------- */
+
+/*
+ * Free sector mirror.
+ *
+ * The allocation routines below used to try every sector through the BAM
+ * bytes, which gets quadratic when filling up large images. The mirror keeps
+ * the free sectors of each track as native bitmap words plus a count, so full
+ * tracks are skipped at once and the next free sector is found word by word.
+ * It is built per track on first use, updated by vdrive_bam_allocate_sector()
+ * and vdrive_bam_free_sector() and invalidated whenever the BAM is replaced.
+ */
+
+static unsigned int vdrive_bam_first_bit(uint32_t w)
+{
+#if defined(__GNUC__)
+    return (unsigned int)__builtin_ctz(w);
+#else
+    unsigned int n = 0;
+
+    while (!(w & 1)) {
+        w >>= 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+void vdrive_bam_free_map_invalidate(vdrive_t *vdrive)
+{
+    memset(vdrive->bam_free_valid, 0, sizeof(vdrive->bam_free_valid));
+}
+
+/* returns the number of free sectors on a track or -1 if the track can not
+   be mirrored */
+static int vdrive_bam_free_map_track(vdrive_t *vdrive, unsigned int track)
+{
+    uint32_t *map;
+    unsigned int s, count;
+    int max_sector;
+
+    if (track >= VDRIVE_BAM_MAP_TRACKS) {
+        return -1;
+    }
+    if (vdrive->bam_free_valid[track]) {
+        return (int)vdrive->bam_free_count[track];
+    }
+
+    max_sector = vdrive_get_max_sectors(vdrive, track);
+    if (max_sector < 0 || max_sector > VDRIVE_BAM_MAP_WORDS * 32) {
+        return -1;
+    }
+
+    map = vdrive->bam_free_map[track];
+    memset(map, 0, VDRIVE_BAM_MAP_WORDS * sizeof(uint32_t));
+    count = 0;
+    for (s = 0; s < (unsigned int)max_sector; s++) {
+        if (vdrive_bam_is_sector_allocated(vdrive, track, s) == 0) {
+            map[s >> 5] |= 1U << (s & 31);
+            count++;
+        }
+    }
+    vdrive->bam_free_count[track] = count;
+    vdrive->bam_free_valid[track] = 1;
+
+    return (int)count;
+}
+
+static void vdrive_bam_free_map_update(vdrive_t *vdrive, unsigned int track,
+                                       unsigned int sector, int isfree)
+{
+    uint32_t *w;
+    uint32_t bit;
+
+    if (track >= VDRIVE_BAM_MAP_TRACKS || !vdrive->bam_free_valid[track]) {
+        return;
+    }
+
+    w = &vdrive->bam_free_map[track][sector >> 5];
+    bit = 1U << (sector & 31);
+    if (isfree && !(*w & bit)) {
+        *w |= bit;
+        vdrive->bam_free_count[track]++;
+    } else if (!isfree && (*w & bit)) {
+        *w &= ~bit;
+        vdrive->bam_free_count[track]--;
+    }
+}
+
+/* returns the first free sector in [from, to) of an already mirrored track,
+   or -1 */
+static int vdrive_bam_free_map_find(vdrive_t *vdrive, unsigned int track,
+                                    unsigned int from, unsigned int to)
+{
+    const uint32_t *map = vdrive->bam_free_map[track];
+    unsigned int i;
+    uint32_t w;
+
+    if (from >= to) {
+        return -1;
+    }
+
+    i = from >> 5;
+    w = map[i] & (0xffffffffU << (from & 31));
+    for (;;) {
+        if (w) {
+            unsigned int s = (i << 5) + vdrive_bam_first_bit(w);
+
+            return (s < to) ? (int)s : -1;
+        }
+        if (++i >= VDRIVE_BAM_MAP_WORDS || (i << 5) >= to) {
+            return -1;
+        }
+        w = map[i];
+    }
+}
+
+/* allocate the first free sector found cyclically in [first, first + count)
+   starting at start; returns 0 if done, -1 if the track has nothing there
+   and -2 if the mirror can not be used */
+static int vdrive_bam_free_map_alloc(vdrive_t *vdrive, unsigned int track,
+                                     unsigned int first, unsigned int count,
+                                     unsigned int *sector)
+{
+    int s, free;
+
+    free = vdrive_bam_free_map_track(vdrive, track);
+    if (free < 0) {
+        return -2;
+    }
+    if (free == 0) {
+        return -1;
+    }
+
+    s = vdrive_bam_free_map_find(vdrive, track, *sector, first + count);
+    if (s < 0) {
+        s = vdrive_bam_free_map_find(vdrive, track, first, *sector);
+    }
+    if (s < 0) {
+        return -1;
+    }
+    if (!vdrive_bam_allocate_sector(vdrive, track, (unsigned int)s)) {
+        /* out of sync, let the caller do it the slow way */
+        vdrive_bam_free_map_invalidate(vdrive);
+        return -2;
+    }
+    *sector = (unsigned int)s;
+    return 0;
+}
+
 /*
 This function is used by the next 3 to find an available sector in
 a single track. Typically this would be a simple loop, but the D9090/60
@@ -225,7 +375,8 @@ returns -1 if nothing found.
 static int vdrive_bam_alloc_worker(vdrive_t *vdrive,
                                    unsigned int track, unsigned int *sector)
 {
-    unsigned int max_sector, max_sector_all, s, h, s2, h2;
+    unsigned int max_sector, max_sector_all, s, h, s2, h2, found;
+    int rc;
 
     max_sector = vdrive_get_max_sectors_per_head(vdrive, track);
     max_sector_all = vdrive_get_max_sectors(vdrive, track);
@@ -234,8 +385,15 @@ static int vdrive_bam_alloc_worker(vdrive_t *vdrive,
     h = (*sector / max_sector) * max_sector;
     /* go through all groups, 1 round for most CBM drives */
     for (h2 = 0; h2 < max_sector_all; h2 += max_sector) {
+        /* try the free sector mirror first */
+        found = s + h;
+        rc = vdrive_bam_free_map_alloc(vdrive, track, h, max_sector, &found);
+        if (rc == 0) {
+            *sector = found;
+            return 0;
+        }
         /* scan sectors in group */
-        for (s2 = 0; s2 < max_sector; s2++) {
+        for (s2 = 0; rc < -1 && s2 < max_sector; s2++) {
             if (vdrive_bam_allocate_sector(vdrive, track, s + h)) {
                 *sector = s + h;
                 return 0;
@@ -435,6 +593,39 @@ static int vdrive_bam_alloc_next_free_sector_reset(vdrive_t *vdrive,
     return h;
 }
 
+/* the DNP search of vdrive_bam_alloc_next_free_sector_interleave() done
+   through the free sector mirror; returns 0 when a sector is found, -1 if
+   the partition is full and -2 if the mirror can not be used */
+static int vdrive_bam_alloc_np_mirror(vdrive_t *vdrive,
+                                      unsigned int *track, unsigned int *sector,
+                                      unsigned int max_sector)
+{
+    unsigned int t = *track, from = *sector + 1, lo, s, i;
+    int rc;
+
+    for (i = 0; i <= vdrive->num_tracks; i++) {
+        /* skip the first 64 sectors of track 1 */
+        lo = (t == DIR_TRACK_NP) ? 64 : 0;
+        s = (from < lo) ? lo : from;
+        if (s < max_sector) {
+            rc = vdrive_bam_free_map_alloc(vdrive, t, s, max_sector - s, &s);
+            if (rc == 0) {
+                *track = t;
+                *sector = s;
+                return 0;
+            } else if (rc < -1) {
+                return rc;
+            }
+        }
+        from = 0;
+        t++;
+        if (t > vdrive->num_tracks) {
+            t = 1;
+        }
+    }
+    return -1;
+}
+
 /*
 This function find the next suitable sector based on the one passed.
 function reworked to use smaller functions above and to behave like DOS
@@ -469,6 +660,19 @@ int vdrive_bam_alloc_next_free_sector_interleave(vdrive_t *vdrive,
         sector by sector, and when it hits the maximum, it goes back to track 1. */
     if (vdrive->image_format == VDRIVE_IMAGE_FORMAT_NP) {
         unsigned int max_sector = vdrive_get_max_sectors_per_head(vdrive, *track);
+
+        /* same search through the free sector mirror */
+        switch (vdrive_bam_alloc_np_mirror(vdrive, track, sector, max_sector)) {
+            case 0:
+                return 0;
+            case -1:
+                *track = origt;
+                *sector = origs;
+                return -1;
+            default:
+                break;
+        }
+
         /* use counter to check all sectors in partition*/
         s = max_sector * vdrive->num_tracks;
         while (s) {
@@ -829,6 +1033,7 @@ int vdrive_bam_allocate_sector(vdrive_t *vdrive,
                                unsigned int track, unsigned int sector)
 {
     uint8_t *bamp;
+    unsigned int logical = sector;
 
     /* Tracks > 70 don't go into the (regular) BAM on 1571 */
     if ((track > NUM_TRACKS_1571) && (vdrive->image_format == VDRIVE_IMAGE_FORMAT_1571)) {
@@ -846,6 +1051,7 @@ int vdrive_bam_allocate_sector(vdrive_t *vdrive,
     if (bamp && vdrive_bam_isset(vdrive, bamp, sector)) {
         vdrive_bam_clr(vdrive, bamp, sector); /* clear bit */
         vdrive_bam_sector_free(vdrive, bamp, track, -1); /* update count */
+        vdrive_bam_free_map_update(vdrive, track, logical, 0);
         return 1;
     }
 
@@ -858,6 +1064,7 @@ int vdrive_bam_free_sector(vdrive_t *vdrive, unsigned int track,
                            unsigned int sector)
 {
     uint8_t *bamp;
+    unsigned int logical = sector;
 
     /* Tracks > 70 don't go into the (regular) BAM on 1571 */
     if ((track > NUM_TRACKS_1571) && (vdrive->image_format == VDRIVE_IMAGE_FORMAT_1571)) {
@@ -875,6 +1082,7 @@ int vdrive_bam_free_sector(vdrive_t *vdrive, unsigned int track,
     if (bamp && !(vdrive_bam_isset(vdrive, bamp, sector))) {
         vdrive_bam_set(vdrive, bamp, sector); /* set bit */
         vdrive_bam_sector_free(vdrive, bamp, track, 1); /* update count */
+        vdrive_bam_free_map_update(vdrive, track, logical, 1);
         return 1;
     }
 
@@ -968,6 +1176,7 @@ void vdrive_bam_clear_all(vdrive_t *vdrive)
                       "Unknown disk type %u.  Cannot clear BAM.",
                       vdrive->image_format);
     }
+    vdrive_bam_free_map_invalidate(vdrive);
 }
 
 /* FIXME:   Should be removed some day.
@@ -1520,6 +1729,10 @@ void vdrive_bam_setup_bam(vdrive_t *vdrive)
         vdrive->bam = NULL;
     }
 
+    /* the directory may have changed as well */
+    vdrive_dir_index_invalidate(vdrive);
+    vdrive_bam_free_map_invalidate(vdrive);
+
     /* set all state bits as invalid */
     for (i = 0; i < VDRIVE_BAM_MAX_STATES; i++) {
         vdrive->bam_state[i] = -1;
@@ -61,6 +61,7 @@ int vdrive_bam_allocate_sector(struct vdrive_s *vdrive, unsigned int track, unsi
 int vdrive_bam_is_sector_allocated(struct vdrive_s *vdrive, unsigned int track, unsigned int sector);
 
 void vdrive_bam_clear_all(struct vdrive_s *vdrive);
+void vdrive_bam_free_map_invalidate(struct vdrive_s *vdrive);
 void vdrive_bam_create_empty_bam(struct vdrive_s *vdrive, const char *name, uint8_t *id);
 int unsigned vdrive_bam_free_block_count(struct vdrive_s *vdrive);
 int vdrive_bam_free_sector(struct vdrive_s *vdrive, unsigned int track, unsigned int sector);
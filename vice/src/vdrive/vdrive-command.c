@@ -3040,6 +3040,7 @@ int vdrive_command_validate(vdrive_t *vdrive)
 bad:
     memcpy(vdrive->bam, oldbam, vdrive->bam_size);
     memcpy(vdrive->bam_state, oldbamstate, VDRIVE_BAM_MAX_STATES);
+    vdrive_bam_free_map_invalidate(vdrive);
 
 out:
     if (oldbam) {
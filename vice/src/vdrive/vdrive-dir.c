@@ -111,6 +111,342 @@ static unsigned int vdrive_dir_name_match(uint8_t *slot, uint8_t *nslot, int len
     return cbmdos_parse_wildcard_compare(nslot, &slot[SLOT_NAME_OFFSET]);
 }
 
+/* ------------------------------------------------------------------------- */
+/*
+ * Directory index.
+ *
+ * Looking up a file by name means walking the whole directory chain, which
+ * is slow on D1M/D4M/DHD images holding thousands of entries. The index
+ * keeps the names of the current directory in memory, hashed by name, so
+ * that exact names can be found without reading every directory sector.
+ * It is built on the first lookup, kept up to date by vdrive_write_sector()
+ * and thrown away whenever the BAM (and with it the directory) is set up
+ * again. Wildcard patterns still use the linear scan.
+ */
+
+#define DIR_INDEX_HASH_SIZE     1024    /* must be a power of two */
+#define DIR_INDEX_MAX_SECTORS   0x10000
+
+typedef struct vdrive_dir_index_entry_s {
+    uint8_t name[CBMDOS_SLOT_NAME_LENGTH]; /* name up to the first $a0 */
+    int used;                              /* slot holds a file */
+    int next;                              /* next entry in the hash chain */
+} vdrive_dir_index_entry_t;
+
+typedef struct vdrive_dir_index_s {
+    /* what the index was built for */
+    struct disk_image_s *image;
+    unsigned int offset;
+    unsigned int header_track;
+    unsigned int header_sector;
+    unsigned int dir_track;
+    unsigned int dir_sector;
+
+    unsigned int sectors;   /* directory sectors in the chain */
+    unsigned int size;      /* allocated directory sectors */
+    unsigned int *chain;    /* track << 8 | sector of each directory sector */
+    vdrive_dir_index_entry_t *entries; /* 8 per directory sector */
+    int hash[DIR_INDEX_HASH_SIZE];     /* first entry of each hash chain */
+
+    /* track/sector -> chain position, open addressing, 0 is empty */
+    unsigned int *ts_hash;
+    unsigned int ts_hash_size;
+} vdrive_dir_index_t;
+
+static void dir_index_key(uint8_t *key, const uint8_t *name)
+{
+    int i;
+
+    for (i = 0; i < CBMDOS_SLOT_NAME_LENGTH && name[i] != 0xa0; i++) {
+        key[i] = name[i];
+    }
+    for (; i < CBMDOS_SLOT_NAME_LENGTH; i++) {
+        key[i] = 0xa0;
+    }
+}
+
+static unsigned int dir_index_hash(const uint8_t *key)
+{
+    unsigned int h = 2166136261U;
+    int i;
+
+    for (i = 0; i < CBMDOS_SLOT_NAME_LENGTH; i++) {
+        h = (h ^ key[i]) * 16777619U;
+    }
+    return h & (DIR_INDEX_HASH_SIZE - 1);
+}
+
+static unsigned int dir_index_ts_slot(vdrive_dir_index_t *index, unsigned int ts)
+{
+    unsigned int i = (ts * 2654435761U) & (index->ts_hash_size - 1);
+
+    while (index->ts_hash[i] != 0
+           && index->chain[index->ts_hash[i] - 1] != ts) {
+        i = (i + 1) & (index->ts_hash_size - 1);
+    }
+    return i;
+}
+
+/* Returns the chain position of a directory sector or -1 */
+static int dir_index_find_sector(vdrive_dir_index_t *index,
+                                 unsigned int track, unsigned int sector)
+{
+    unsigned int i;
+
+    if (index->ts_hash_size == 0) {
+        return -1;
+    }
+    i = dir_index_ts_slot(index, (track << 8) | sector);
+    return (int)index->ts_hash[i] - 1;
+}
+
+static void dir_index_unlink(vdrive_dir_index_t *index, int e)
+{
+    int *p = &index->hash[dir_index_hash(index->entries[e].name)];
+
+    while (*p >= 0) {
+        if (*p == e) {
+            *p = index->entries[e].next;
+            break;
+        }
+        p = &index->entries[*p].next;
+    }
+}
+
+/* hash chains are kept in directory order, so the first hit is the one
+   the linear scan would find */
+static void dir_index_link(vdrive_dir_index_t *index, int e)
+{
+    int *p = &index->hash[dir_index_hash(index->entries[e].name)];
+
+    while (*p >= 0 && *p < e) {
+        p = &index->entries[*p].next;
+    }
+    index->entries[e].next = *p;
+    *p = e;
+}
+
+static void dir_index_set_slot(vdrive_dir_index_t *index, int e, const uint8_t *slot)
+{
+    vdrive_dir_index_entry_t *entry = &index->entries[e];
+
+    if (entry->used) {
+        dir_index_unlink(index, e);
+    }
+    entry->used = slot[SLOT_TYPE_OFFSET] ? 1 : 0;
+    dir_index_key(entry->name, &slot[SLOT_NAME_OFFSET]);
+    if (entry->used) {
+        dir_index_link(index, e);
+    }
+}
+
+/* Appends a directory sector to the chain, returns -1 on a loop */
+static int dir_index_add_sector(vdrive_dir_index_t *index, const uint8_t *buf,
+                                unsigned int track, unsigned int sector)
+{
+    unsigned int i, pos;
+
+    if (index->sectors >= DIR_INDEX_MAX_SECTORS
+        || dir_index_find_sector(index, track, sector) >= 0) {
+        return -1;
+    }
+
+    if (index->sectors == index->size) {
+        index->size = index->size ? index->size * 2 : 64;
+        index->chain = lib_realloc(index->chain, index->size * sizeof(unsigned int));
+        index->entries = lib_realloc(index->entries,
+                                     index->size * 8 * sizeof(vdrive_dir_index_entry_t));
+
+        /* rehash with the load factor kept below 1/2 */
+        lib_free(index->ts_hash);
+        index->ts_hash_size = index->size * 2;
+        index->ts_hash = lib_calloc(index->ts_hash_size, sizeof(unsigned int));
+        for (i = 0; i < index->sectors; i++) {
+            index->ts_hash[dir_index_ts_slot(index, index->chain[i])] = i + 1;
+        }
+    }
+
+    pos = index->sectors++;
+    index->chain[pos] = (track << 8) | sector;
+    index->ts_hash[dir_index_ts_slot(index, index->chain[pos])] = pos + 1;
+
+    for (i = 0; i < 8; i++) {
+        index->entries[pos * 8 + i].used = 0;
+        dir_index_set_slot(index, (int)(pos * 8 + i), &buf[i * 32]);
+    }
+    return 0;
+}
+
+static void dir_index_free(vdrive_dir_index_t *index)
+{
+    lib_free(index->chain);
+    lib_free(index->entries);
+    lib_free(index->ts_hash);
+    lib_free(index);
+}
+
+void vdrive_dir_index_invalidate(vdrive_t *vdrive)
+{
+    if (vdrive->dir_index != NULL) {
+        dir_index_free(vdrive->dir_index);
+        vdrive->dir_index = NULL;
+    }
+}
+
+static int dir_index_is_current(vdrive_t *vdrive, vdrive_dir_index_t *index)
+{
+    return index->image == vdrive->image
+           && index->offset == vdrive->current_offset
+           && index->header_track == vdrive->Header_Track
+           && index->header_sector == vdrive->Header_Sector
+           && index->dir_track == vdrive->Dir_Track
+           && index->dir_sector == vdrive->Dir_Sector;
+}
+
+/* Returns the index of the current directory, building it if needed */
+static vdrive_dir_index_t *dir_index_get(vdrive_t *vdrive)
+{
+    vdrive_dir_index_t *index = vdrive->dir_index;
+    uint8_t buf[256];
+    unsigned int t, s, i;
+
+    if (index != NULL) {
+        if (dir_index_is_current(vdrive, index)) {
+            return index;
+        }
+        vdrive_dir_index_invalidate(vdrive);
+    }
+
+    if (vdrive->image == NULL) {
+        return NULL;
+    }
+
+    /* same starting point as vdrive_dir_find_first_slot() */
+    if (vdrive_read_sector(vdrive, buf, vdrive->Header_Track, vdrive->Header_Sector) != 0) {
+        return NULL;
+    }
+    if (vdrive->image_format != VDRIVE_IMAGE_FORMAT_NP) {
+        t = vdrive->Dir_Track;
+        s = vdrive->Dir_Sector;
+    } else {
+        t = buf[0];
+        s = buf[1];
+    }
+
+    index = lib_calloc(1, sizeof(vdrive_dir_index_t));
+    index->image = vdrive->image;
+    index->offset = vdrive->current_offset;
+    index->header_track = vdrive->Header_Track;
+    index->header_sector = vdrive->Header_Sector;
+    index->dir_track = vdrive->Dir_Track;
+    index->dir_sector = vdrive->Dir_Sector;
+    for (i = 0; i < DIR_INDEX_HASH_SIZE; i++) {
+        index->hash[i] = -1;
+    }
+
+    while (t != 0) {
+        if (vdrive_read_sector(vdrive, buf, t, s) != 0
+            || dir_index_add_sector(index, buf, t, s) < 0) {
+            /* broken chain, leave it to the linear scan */
+            dir_index_free(index);
+            return NULL;
+        }
+        t = buf[0];
+        s = buf[1];
+    }
+
+#ifdef DEBUG_DRIVE
+    log_debug(LOG_DEFAULT, "DIR: index built, %u sectors", index->sectors);
+#endif
+    vdrive->dir_index = index;
+    return index;
+}
+
+/*
+ * Called for every sector written through vdrive_write_sector(), keeps the
+ * index in sync with created, renamed and scratched files.
+ */
+void vdrive_dir_index_update(vdrive_t *vdrive, const uint8_t *buf,
+                             unsigned int track, unsigned int sector)
+{
+    vdrive_dir_index_t *index = vdrive->dir_index;
+    unsigned int i, next;
+    int pos;
+
+    if (index == NULL) {
+        return;
+    }
+    if (!dir_index_is_current(vdrive, index)) {
+        vdrive_dir_index_invalidate(vdrive);
+        return;
+    }
+
+    pos = dir_index_find_sector(index, track, sector);
+    if (pos < 0) {
+        return;
+    }
+
+    for (i = 0; i < 8; i++) {
+        dir_index_set_slot(index, pos * 8 + (int)i, &buf[i * 32]);
+    }
+
+    /* the link changed; appending a sector is the common case when the
+       directory grows, anything else means starting over */
+    next = ((unsigned int)pos + 1 < index->sectors) ? index->chain[pos + 1] : 0;
+    if ((next >> 8) != buf[0] || (next != 0 && (next & 0xff) != buf[1])) {
+        static const uint8_t empty[256];
+
+        if (next != 0 || dir_index_add_sector(index, empty, buf[0], buf[1]) < 0) {
+            vdrive_dir_index_invalidate(vdrive);
+        }
+    }
+}
+
+/* An exact name can be looked up in the index, a wildcard can not */
+static int dir_index_usable(const vdrive_dir_context_t *dir)
+{
+    int i;
+
+    if (dir->find_length < 0) {
+        return 1;
+    }
+    if (dir->find_length == 0) {
+        return 0;
+    }
+    for (i = 0; i < CBMDOS_SLOT_NAME_LENGTH && dir->find_nslot[i] != 0xa0; i++) {
+        if (dir->find_nslot[i] == '*' || dir->find_nslot[i] == '?') {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* Returns the first candidate at or after the search position, or -1 */
+static int dir_index_next_candidate(vdrive_dir_index_t *index,
+                                    vdrive_dir_context_t *dir)
+{
+    uint8_t key[CBMDOS_SLOT_NAME_LENGTH];
+    int e;
+
+    if (dir->find_length < 0) {
+        for (e = (int)dir->find_pos; e < (int)index->sectors * 8; e++) {
+            if (!index->entries[e].used) {
+                return e;
+            }
+        }
+        return -1;
+    }
+
+    dir_index_key(key, dir->find_nslot);
+    for (e = index->hash[dir_index_hash(key)]; e >= 0; e = index->entries[e].next) {
+        if (e >= (int)dir->find_pos
+            && memcmp(index->entries[e].name, key, CBMDOS_SLOT_NAME_LENGTH) == 0) {
+            return e;
+        }
+    }
+    return -1;
+}
+
 void vdrive_dir_free_chain(vdrive_t *vdrive, int t, int s)
 {
     uint8_t buf[256];
@@ -225,6 +561,8 @@ void vdrive_dir_find_first_slot(vdrive_t *vdrive, const uint8_t *name,
     dir->vdrive = vdrive;
     dir->find_length = length;
     dir->find_type = type;
+    dir->find_indexed = dir_index_usable(dir);
+    dir->find_pos = 0;
 
     dir->track = vdrive->Header_Track;
     dir->sector = vdrive->Header_Sector;
@@ -262,6 +600,81 @@ static unsigned int date_to_int(int year, int month, int day, int hour, int minu
     return a;
 }
 
+/*
+ * Looks up the next matching slot through the directory index and positions
+ * `dir' on it like the linear scan would. Returns 1 if a slot was found, 0
+ * if there is none and -1 if the linear scan has to take over. When no free
+ * slot is left, `dir' ends up on the last directory sector so that the
+ * directory can be extended.
+ */
+static int vdrive_dir_index_find(vdrive_dir_context_t *dir)
+{
+    vdrive_t *vdrive = dir->vdrive;
+    vdrive_dir_index_t *index;
+    uint8_t buf[256];
+    uint8_t key[CBMDOS_SLOT_NAME_LENGTH];
+    uint8_t *slot;
+    unsigned int t, s, pos, date;
+    int e;
+
+    index = dir_index_get(vdrive);
+    if (index == NULL) {
+        return -1;
+    }
+
+    while ((e = dir_index_next_candidate(index, dir)) >= 0) {
+        pos = (unsigned int)e / 8;
+        t = index->chain[pos] >> 8;
+        s = index->chain[pos] & 0xff;
+        if (vdrive_read_sector(vdrive, buf, t, s) != 0) {
+            return -1;
+        }
+
+        slot = &buf[(e & 7) * 32];
+        dir_index_key(key, &slot[SLOT_NAME_OFFSET]);
+        if ((slot[SLOT_TYPE_OFFSET] ? 1 : 0) != index->entries[e].used
+            || memcmp(key, index->entries[e].name, CBMDOS_SLOT_NAME_LENGTH) != 0) {
+            /* the directory was changed behind our back */
+            vdrive_dir_index_invalidate(vdrive);
+            return -1;
+        }
+
+        dir->find_pos = (unsigned int)e + 1;
+        if (!vdrive_dir_name_match(slot, dir->find_nslot, dir->find_length,
+                                   dir->find_type)) {
+            continue;   /* same name, other file type */
+        }
+        date = date_to_int(slot[SLOT_GEOS_YEAR], slot[SLOT_GEOS_MONTH],
+            slot[SLOT_GEOS_DATE], slot[SLOT_GEOS_HOUR], slot[SLOT_GEOS_MINUTE]);
+        if (date < dir->time_low || date > dir->time_high) {
+            continue;
+        }
+
+        memcpy(dir->buffer, buf, 256);
+        dir->track = t;
+        dir->sector = s;
+        dir->slot = (unsigned int)e & 7;
+        return 1;
+    }
+
+    if (dir->find_length < 0) {
+        if (index->sectors == 0) {
+            return -1;
+        }
+        t = index->chain[index->sectors - 1] >> 8;
+        s = index->chain[index->sectors - 1] & 0xff;
+        if (vdrive_read_sector(vdrive, buf, t, s) != 0 || buf[0] != 0) {
+            vdrive_dir_index_invalidate(vdrive);
+            return -1;
+        }
+        memcpy(dir->buffer, buf, 256);
+        dir->track = t;
+        dir->sector = s;
+        dir->slot = 7;
+    }
+    return 0;
+}
+
 uint8_t *vdrive_dir_find_next_slot(vdrive_dir_context_t *dir)
 {
     static uint8_t return_slot[32];
@@ -275,6 +688,23 @@ uint8_t *vdrive_dir_find_next_slot(vdrive_dir_context_t *dir)
     log_debug(LOG_DEFAULT, "DIR: vdrive_dir_find_next_slot start (t:%u/s:%u) #%u",
             dir->track, dir->sector, dir->slot);
 #endif
+
+    if (dir->find_indexed) {
+        switch (vdrive_dir_index_find(dir)) {
+            case 1:
+                memcpy(return_slot, &dir->buffer[dir->slot * 32], 32);
+                return return_slot;
+            case 0:
+                if (dir->find_length >= 0) {
+                    return NULL;
+                }
+                break;  /* extend the directory below */
+            default:
+                dir->find_indexed = 0;
+                break;
+        }
+    }
+
     /*
      * Loop all directory blocks starting from track 18, sector 1 (1541).
      */
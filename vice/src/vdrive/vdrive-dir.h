@@ -58,6 +58,7 @@
 #define PSLOT_NAME            5
 
 struct vdrive_s;
+struct vdrive_dir_index_s;
 struct cbmdos_cmd_parse_plus_s;
 struct bufferinfo_s;
 
@@ -71,6 +72,8 @@ typedef struct vdrive_dir_context_s {
     unsigned int sector;
     unsigned int time_low;
     unsigned int time_high;
+    int find_indexed;      /* search is answered by the directory index */
+    unsigned int find_pos; /* next directory position the index looks at */
     struct vdrive_s *vdrive;
 } vdrive_dir_context_t;
 
@@ -84,6 +87,8 @@ int vdrive_dir_filetype(const uint8_t *name, int length);
 void vdrive_dir_remove_slot(vdrive_dir_context_t *dir);
 void vdrive_dir_create_slot(struct bufferinfo_s *p, uint8_t *realname, int reallength, int filetype);
 void vdrive_dir_free_chain(struct vdrive_s *vdrive, int t, int s);
+void vdrive_dir_index_invalidate(struct vdrive_s *vdrive);
+void vdrive_dir_index_update(struct vdrive_s *vdrive, const uint8_t *buf, unsigned int track, unsigned int sector);
 void vdrive_dir_updatetime(struct vdrive_s *vdrive, uint8_t *slot);
 uint8_t *vdrive_dir_part_find_next_slot(vdrive_dir_context_t *dir);
 int vdrive_dir_part_next_directory(struct vdrive_s *vdrive, struct bufferinfo_s *b);
@@ -171,6 +171,7 @@ void vdrive_device_shutdown(vdrive_t *vdrive)
     bufferinfo_t *p;
 
     if (vdrive != NULL) {
+        vdrive_dir_index_invalidate(vdrive);
         /* de-init buffers */
         for (i = 0; i < 16; i++) {
             p = &(vdrive->buffers[i]);
@@ -348,6 +349,7 @@ void vdrive_detach_image(disk_image_t *image, unsigned int unit,
     }
 
     disk_image_detach_log(image, vdrive_log, unit, drive);
+    vdrive_dir_index_invalidate(vdrive);
 
     /* shutdown everything on that drive */
     if (vdrive->haspt) {
@@ -989,6 +991,9 @@ int vdrive_write_sector(vdrive_t *vdrive, const uint8_t *buf, unsigned int track
     ui_display_drive_track(vdrive->unit - 8, 0, dadr.track * 2);
 #endif
     ret = disk_image_write_sector(vdrive->image, buf, &dadr);
+    if (ret == 0) {
+        vdrive_dir_index_update(vdrive, buf, track, sector);
+    }
 
 #ifdef DEBUG_DRIVE
     log_debug(LOG_DEFAULT, "VDRIVE: write_sector %u %u = %d", dadr.track, dadr.sector, ret);
@@ -1010,6 +1015,7 @@ int vdrive_write_sector_physical(vdrive_t *vdrive, const uint8_t *buf, unsigned
     disk_addr_t dadr;
     dadr.track = track;
     dadr.sector = sector;
+    vdrive_dir_index_invalidate(vdrive);
     return disk_image_write_sector(vdrive->image, buf, &dadr);
 }
 
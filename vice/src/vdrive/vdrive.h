@@ -64,6 +64,10 @@
 
 #define VDRIVE_BAM_MAX_STATES    33
 
+/* size of the free sector mirror of the BAM */
+#define VDRIVE_BAM_MAP_TRACKS    256
+#define VDRIVE_BAM_MAP_WORDS     (256 / 32)
+
 #define WRITE_BLOCK 512
 
 #define SET_LO_HI(p, val)               \
@@ -185,8 +189,17 @@ typedef struct vdrive_s {
 
     unsigned int bam_size;
     uint8_t *bam;              /* Disk header blk (if any) followed by BAM blocks */
+
+    /* Free sectors of the BAM mirrored as native words, one bit per sector,
+       built per track when the allocator first looks at it */
+    uint32_t bam_free_map[VDRIVE_BAM_MAP_TRACKS][VDRIVE_BAM_MAP_WORDS];
+    unsigned int bam_free_count[VDRIVE_BAM_MAP_TRACKS];
+    uint8_t bam_free_valid[VDRIVE_BAM_MAP_TRACKS];
     bufferinfo_t buffers[16];
 
+    /* Name hash of the current directory, built on first lookup */
+    struct vdrive_dir_index_s *dir_index;
+
     /* Memory read command buffer.  */
     uint8_t mem_buf[256];
     unsigned int mem_length;
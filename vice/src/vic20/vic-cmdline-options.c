@@ -65,7 +65,8 @@ static const cmdline_option_t cmdline_options[] =
 
 int vic_cmdline_options_init(void)
 {
-    if (raster_cmdline_options_chip_init("VIC", vic.video_chip_cap) < 0) {
+    if (raster_cmdline_options_chip_init("VIC", vic.video_chip_cap) < 0
+        || raster_cmdline_options_chip_async_init("VIC") < 0) {
         return -1;
     }
 
@@ -29,6 +29,7 @@
 
 #include <string.h>
 
+#include "raster-async.h"
 #include "raster-cache-fill.h"
 #include "raster-cache-text-std.h"
 #include "raster-cache.h"
@@ -38,6 +39,16 @@
 #include "victypes.h"
 #include "vic-draw.h"
 
+/* The drawing code reads the VIC state through this pointer, so the raster
+   lines can be drawn from a copy of it on a separate thread.  Everything it
+   reads is in the VIC state, so nothing needs to be captured.  */
+static vic_t *vic_draw_state = &vic;
+
+const raster_async_chip_t vic_draw_async_chip = {
+    &vic, sizeof(vic_t), (void **)&vic_draw_state, 0, NULL, NULL
+};
+
+#define vic (*vic_draw_state)
 
 /* Here comes the part that actually repaints each raster line.  This table is
    used to speed up the drawing. */
@@ -27,6 +27,10 @@
 #ifndef VICE_VIC_DRAW_H
 #define VICE_VIC_DRAW_H
 
+struct raster_async_chip_s;
+
+extern const struct raster_async_chip_s vic_draw_async_chip;
+
 void vic_draw_init(void);
 
 #endif
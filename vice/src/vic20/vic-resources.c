@@ -33,6 +33,7 @@
 #include "machine.h"
 #include "raster-resources.h"
 #include "resources.h"
+#include "vic-draw.h"
 #include "vic-resources.h"
 #include "vic.h"
 #include "victypes.h"
@@ -100,7 +101,8 @@ int vic_resources_init(void)
 
     vic.video_chip_cap = &video_chip_cap;
 
-    if (raster_resources_chip_init("VIC", &vic.raster, &video_chip_cap) < 0) {
+    if (raster_resources_chip_init("VIC", &vic.raster, &video_chip_cap) < 0
+        || raster_resources_chip_async_init("VIC", &vic.raster, &vic_draw_async_chip) < 0) {
         return -1;
     }
 
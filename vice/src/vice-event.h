@@ -95,6 +95,12 @@ void event_record_attach_in_list(event_list_state_t *list, unsigned int unit, un
                                  const char *filename, unsigned int read_only);
 void event_record_attach_image(unsigned int unit, unsigned int drive, const char *filename, unsigned int read_only);
 
+void event_reverse_start(void);
+void event_reverse_stop(void);
+void event_reverse_trim(CLOCK clk);
+void event_reverse_playback_start(CLOCK clk);
+void event_reverse_playback_stop(void);
+
 int event_snapshot_read_module(struct snapshot_s *s, int event_mode);
 int event_snapshot_write_module(struct snapshot_s *s, int event_mode);
 
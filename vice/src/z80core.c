@@ -96,10 +96,12 @@ static void z80core_reset(void)
 
 #define opcode_t uint32_t
 
+#ifndef FETCH_OPCODE
 #define FETCH_OPCODE(o) ((o) = (LOAD(z80_reg_pc)               \
                                 | (LOAD(z80_reg_pc + 1) << 8)  \
                                 | (LOAD(z80_reg_pc + 2) << 16) \
                                 | (LOAD(z80_reg_pc + 3) << 24)))
+#endif
 
 #define p0 (opcode & 0xff)
 #define p1 ((opcode >> 8) & 0xff)
@@ -700,6 +702,33 @@ static void export_registers(void)
 
 /* ------------------------------------------------------------------------- */
 
+/* Profiler hooks; the including file defines PROFILER to the profiler_cpu_t
+   of the CPU.  The call site is passed as the address of the call plus 2,
+   like the 6502 JSR does.  */
+
+#ifdef PROFILER
+#define CHECK_PROFILE_INTERRUPT(dest_addr, handler)                                          \
+    do {                                                                                     \
+        profile_int(PROFILER, dest_addr, handler, reg_sp, CLK - profiling_clock_start);     \
+    } while (0)
+
+#define CHECK_PROFILE_CALL(dest_addr)                                          \
+    do {                                                                       \
+        profile_jsr(PROFILER, dest_addr, (uint16_t)(z80_reg_pc + 2), reg_sp); \
+    } while (0)
+
+#define CHECK_PROFILE_RET()                \
+    do {                                   \
+        profile_rtx(PROFILER, reg_sp);     \
+    } while (0)
+#else
+#define CHECK_PROFILE_INTERRUPT(dest_addr, handler)
+#define CHECK_PROFILE_CALL(dest_addr)
+#define CHECK_PROFILE_RET()
+#endif
+
+/* ------------------------------------------------------------------------- */
+
 /* Interrupt handling.  */
 
 /* FIXME: Only IM 1 is really supported; don't trust others or their timing. */
@@ -739,6 +768,7 @@ static void export_registers(void)
                     JUMP(jumpdst);                                                        \
                     CLK_ADD(CLK, 6);                                                      \
                 }                                                                         \
+                CHECK_PROFILE_INTERRUPT(jumpdst, 0xfffe);                                 \
                 interrupt_ack_irq(cpu_int_status);                                        \
             }                                                                             \
         }                                                                                 \
@@ -944,6 +974,7 @@ static void export_registers(void)
 
 #define CALL(reg_val, clk_inc1, clk_inc2, clk_inc3, pc_inc) \
     do {                                                    \
+        CHECK_PROFILE_CALL(reg_val);                        \
         INC_PC(pc_inc);                                     \
         CLK_ADD(CLK, clk_inc1);                             \
         --reg_sp;                                           \
@@ -1620,6 +1651,7 @@ static void export_registers(void)
     do {                                  \
         uint16_t tmp;                         \
                                           \
+        CHECK_PROFILE_RET();              \
         CLK_ADD(CLK, clk_inc1);           \
         tmp = LOAD(reg_sp);               \
         CLK_ADD(CLK, clk_inc2);           \
@@ -1643,6 +1675,7 @@ static void export_registers(void)
     do {                                \
         uint16_t tmp;                       \
                                         \
+        CHECK_PROFILE_RET();            \
         CLK_ADD(CLK, 4);                \
         tmp = LOAD(reg_sp);             \
         CLK_ADD(CLK, 4);                \
@@ -4027,6 +4060,9 @@ static void opcode_ed(uint8_t ip1, uint8_t ip2, uint8_t ip3, uint16_t ip12, uint
 static void z80_maincpu_loop(interrupt_cpu_status_t *cpu_int_status, alarm_context_t *cpu_alarm_context)
 {
     opcode_t opcode;
+#ifdef PROFILER
+    CLOCK profiling_clock_start;
+#endif
 
     import_registers();
 
@@ -4041,6 +4077,9 @@ static void z80_maincpu_loop(interrupt_cpu_status_t *cpu_int_status, alarm_conte
 
             pending_interrupt = cpu_int_status->global_pending_int;
             if (pending_interrupt != IK_NONE) {
+#ifdef PROFILER
+                profiling_clock_start = CLK;
+#endif
                 DO_INTERRUPT(pending_interrupt);
                 while (CLK >= alarm_context_next_pending_clk(cpu_alarm_context)) {
                     alarm_context_dispatch(cpu_alarm_context, CLK);
@@ -4060,6 +4099,13 @@ static void z80_maincpu_loop(interrupt_cpu_status_t *cpu_int_status, alarm_conte
             continue;
         }
 
+#ifdef PROFILER
+        profiling_clock_start = CLK;
+        if (PROFILER->profiling) {
+            profile_sample_start(PROFILER, z80_reg_pc);
+        }
+#endif
+
         SET_LAST_ADDR(z80_reg_pc);
 fetchmore:
         FETCH_OPCODE(opcode);
@@ -5018,6 +5064,12 @@ fetchmore:
                 break;
         }
 
+#ifdef PROFILER
+        if (PROFILER->profiling) {
+            profile_sample_finish(PROFILER, CLK - profiling_clock_start, 0 /* stolen_cycles */);
+        }
+#endif
+
         cpu_int_status->num_dma_per_opcode = 0;
         inst_mode = INST_NONE;
 